@@ -0,0 +1,172 @@
+// Asteroid belt scaling benchmark: renders the full scene (Renderer) with an
+// AsteroidBelt of each requested size in turn and prints, as JSON, frame
+// time percentiles per belt size, plus the GPU time of the asteroid pass and
+// the rocks and triangles actually drawn after culling.
+//
+// Run from the repository root (shaders/ and textures/ are loaded relative to it):
+//   ./AsteroidBench [--counts 10000,100000,1000000] [--frames 300] [--warmup 30] [--dt 0.016667]
+//                   [--width 1280] [--height 720] [--gpu-driven 1] [--out result.json]
+
+#include "../include/glad/glad.h"
+#include "../include/asteroid_belt.h"
+#include "../include/camera.h"
+#include "../include/frame_stats.h"
+#include "../include/gpu_timer.h"
+#include "../include/headless_context.h"
+#include "../include/renderer.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct BenchOptions
+{
+    std::vector<unsigned int> counts = {10000, 100000, 1000000};
+    int frames = 300;
+    int warmup = 30;
+    float dt = 1.0f / 60.0f;
+    int width = 1280;
+    int height = 720;
+    bool gpuDriven = true;
+    std::string out;
+};
+
+static std::vector<unsigned int> parseCounts(const char *list)
+{
+    std::vector<unsigned int> counts;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+        if (!item.empty())
+            counts.push_back((unsigned int)std::strtoul(item.c_str(), nullptr, 10));
+    }
+    return counts;
+}
+
+static BenchOptions parseArgs(int argc, char **argv)
+{
+    BenchOptions options;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::strcmp(argv[i], "--counts") == 0)
+            options.counts = parseCounts(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--frames") == 0)
+            options.frames = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--warmup") == 0)
+            options.warmup = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--dt") == 0)
+            options.dt = (float)std::atof(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--width") == 0)
+            options.width = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--height") == 0)
+            options.height = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--gpu-driven") == 0)
+            options.gpuDriven = std::atoi(argv[i + 1]) != 0;
+        else if (std::strcmp(argv[i], "--out") == 0)
+            options.out = argv[i + 1];
+        else
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+    }
+    return options;
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions options = parseArgs(argc, argv);
+
+    // 4.3 for the compute path; drivers without it still run the 3.3 one.
+    std::unique_ptr<HeadlessContext> context(new HeadlessContext(options.width, options.height, 4, 3));
+    if (!context->isValid())
+    {
+        context.reset();
+        context.reset(new HeadlessContext(options.width, options.height));
+    }
+    if (!context->isValid())
+        return -1;
+
+    glEnable(GL_DEPTH_TEST);
+
+    std::ostringstream runs;
+    bool gpuDriven = false;
+    {
+        Renderer renderer;
+        renderer.setGpuDriven(options.gpuDriven);
+        gpuDriven = renderer.isGpuDriven();
+        float aspect = (float)options.width / options.height;
+
+        for (unsigned int count : options.counts)
+        {
+            AsteroidBeltSettings settings;
+            settings.count = count;
+            auto buildStart = std::chrono::steady_clock::now();
+            renderer.setAsteroidBelt(settings);
+            glFinish();
+            double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+
+            // Every run replays the same frames from t = 0.
+            Camera camera(glm::vec3(0.0f, 5.0f, 20.0f));
+            SimulationState sim;
+            FrameStats stats;
+            GpuTimer gpuTimer(&stats);
+            renderer.setGpuTimer(&gpuTimer);
+
+            for (int frame = 0; frame < options.warmup + options.frames; ++frame)
+            {
+                bool measured = frame >= options.warmup;
+                auto start = std::chrono::steady_clock::now();
+                gpuTimer.beginFrame(measured);
+                renderer.setFrameStats(measured ? &stats : nullptr);
+
+                renderer.renderFrame(camera, sim, frame * options.dt, aspect);
+
+                gpuTimer.endFrame();
+                glFinish();
+                auto end = std::chrono::steady_clock::now();
+                if (measured)
+                    stats.record("frame_ms", std::chrono::duration<double, std::milli>(end - start).count());
+            }
+            gpuTimer.flush();
+            renderer.setGpuTimer(nullptr);
+            renderer.setFrameStats(nullptr);
+
+            const AsteroidBelt *belt = renderer.getAsteroidBelt();
+            runs << (runs.tellp() > 0 ? ",\n" : "\n")
+                 << "    {\"asteroids\": " << count
+                 << ", \"build_ms\": " << buildMs
+                 << ", \"gpu_bytes\": " << (belt ? belt->gpuBytes() : 0)
+                 << ", \"stats\": ";
+            stats.writeJson(runs);
+            runs << "}";
+            std::cerr << count << " asteroids: p50 " << stats.summarize("frame_ms").p50 << " ms" << std::endl;
+        }
+    }
+
+    std::ostringstream json;
+    json << "{\n"
+         << "  \"renderer\": \"" << (const char *)glGetString(GL_RENDERER) << "\",\n"
+         << "  \"width\": " << options.width << ",\n"
+         << "  \"height\": " << options.height << ",\n"
+         << "  \"frames\": " << options.frames << ",\n"
+         << "  \"warmup\": " << options.warmup << ",\n"
+         << "  \"dt\": " << options.dt << ",\n"
+         << "  \"gpu_driven\": " << (gpuDriven ? "true" : "false") << ",\n"
+         << "  \"runs\": [" << runs.str() << "\n  ]\n}\n";
+
+    if (options.out.empty())
+    {
+        std::cout << json.str();
+    }
+    else
+    {
+        std::ofstream file(options.out);
+        file << json.str();
+    }
+    return 0;
+}
@@ -0,0 +1,252 @@
+// Barnes-Hut benchmark: for each of --counts equal-mass bodies in a Plummer
+// sphere, builds a GravityOctree and computes every body's acceleration at
+// each opening angle in --thetas, with monopoles only and with quadrupoles,
+// and compares speed and accuracy against direct summation
+// (NBodySystem::computeAccelerations() with the widest SIMD kernel). Past
+// --direct-max bodies the direct time is extrapolated from its interaction
+// rate on that many, and the error is measured on --samples bodies. Also
+// checks that theta = 0 reproduces direct summation. Prints JSON. Needs no
+// GL context.
+//
+//   ./BarnesHutBench [--counts 10000,100000,1000000] [--thetas 0.3,0.5,0.7,1.0] [--samples 1000]
+//                    [--direct-max 20000] [--leaf-size 8] [--repeats 2] [--threads 0] [--out result.json]
+
+#include "../include/nbody.h"
+#include "../include/octree.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct BenchOptions
+{
+    std::vector<double> counts = {10000, 100000, 1000000};
+    std::vector<double> thetas = {0.3, 0.5, 0.7, 1.0};
+    std::size_t samples = 1000;
+    std::size_t directMax = 20000;
+    int leafSize = 8;
+    int repeats = 2;
+    unsigned int threads = 0;
+    std::string out;
+};
+
+static std::vector<double> parseList(const char *text)
+{
+    std::vector<double> values;
+    std::stringstream list(text);
+    std::string value;
+    while (std::getline(list, value, ','))
+        values.push_back(std::atof(value.c_str()));
+    return values;
+}
+
+static BenchOptions parseArgs(int argc, char **argv)
+{
+    BenchOptions options;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::strcmp(argv[i], "--counts") == 0)
+            options.counts = parseList(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--thetas") == 0)
+            options.thetas = parseList(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--samples") == 0)
+            options.samples = (std::size_t)std::strtoull(argv[i + 1], nullptr, 10);
+        else if (std::strcmp(argv[i], "--direct-max") == 0)
+            options.directMax = (std::size_t)std::strtoull(argv[i + 1], nullptr, 10);
+        else if (std::strcmp(argv[i], "--leaf-size") == 0)
+            options.leafSize = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--repeats") == 0)
+            options.repeats = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--threads") == 0)
+            options.threads = (unsigned int)std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--out") == 0)
+            options.out = argv[i + 1];
+        else
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+    }
+    return options;
+}
+
+/** @brief Best of @p repeats runs of @p fn, in milliseconds. */
+template <typename Fn>
+static double bestMs(int repeats, Fn fn)
+{
+    double best = 1e30;
+    for (int i = 0; i < std::max(repeats, 1); ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+struct Bodies
+{
+    std::vector<double> x, y, z, gm;
+};
+
+/** @brief A Plummer sphere of scale radius 1 and total gm 1, cut off at r = 20. */
+static Bodies plummer(std::size_t count)
+{
+    std::mt19937 random(3);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    Bodies bodies;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        double r;
+        do
+            r = 1.0 / std::sqrt(std::pow(std::max(unit(random), 1e-12), -2.0 / 3.0) - 1.0);
+        while (r > 20.0);
+        double cosTheta = 2.0 * unit(random) - 1.0;
+        double sinTheta = std::sqrt(1.0 - cosTheta * cosTheta);
+        double phi = 6.283185307179586 * unit(random);
+        bodies.x.push_back(r * sinTheta * std::cos(phi));
+        bodies.y.push_back(r * sinTheta * std::sin(phi));
+        bodies.z.push_back(r * cosTheta);
+        bodies.gm.push_back(1.0 / (double)count);
+    }
+    return bodies;
+}
+
+/** @brief The exact acceleration at body @p i, as the scalar direct kernel sums it. */
+static glm::dvec3 directAcceleration(const Bodies &bodies, std::size_t i)
+{
+    glm::dvec3 a(0.0);
+    for (std::size_t j = 0; j < bodies.gm.size(); ++j)
+    {
+        glm::dvec3 d(bodies.x[j] - bodies.x[i], bodies.y[j] - bodies.y[i], bodies.z[j] - bodies.z[i]);
+        double r2 = glm::dot(d, d);
+        if (r2 > 0.0)
+            a += bodies.gm[j] / (r2 * std::sqrt(r2)) * d;
+    }
+    return a;
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions options = parseArgs(argc, argv);
+
+    std::ostringstream json;
+    json << "{\n"
+         << "  \"leaf_size\": " << options.leafSize << ",\n"
+         << "  \"threads\": " << options.threads << ",\n"
+         << "  \"direct_kernel\": \"" << NBodySystem::kernelName(NBodySystem(NBodySettings()).kernel()) << "\",\n"
+         << "  \"runs\": [";
+
+    bool match = true;
+    double exactError = -1.0; // not checked: the first count is past --direct-max
+    for (std::size_t c = 0; c < options.counts.size(); ++c)
+    {
+        std::size_t count = std::max<std::size_t>((std::size_t)options.counts[c], 2);
+        Bodies bodies = plummer(count);
+
+        // Direct summation: measured, or extrapolated from its interaction rate
+        // on the first --direct-max bodies (the kernel's rate barely depends on n).
+        bool directMeasured = count <= options.directMax;
+        std::size_t directCount = directMeasured ? count : std::max<std::size_t>(options.directMax, 2);
+        NBodySettings directSettings;
+        directSettings.threads = options.threads;
+        NBodySystem direct(directSettings);
+        for (std::size_t i = 0; i < directCount; ++i)
+            direct.add(glm::dvec3(bodies.x[i], bodies.y[i], bodies.z[i]), glm::dvec3(0.0), bodies.gm[i]);
+        double measuredMs = bestMs(options.repeats, [&]() { direct.computeAccelerations(); });
+        double directMs = measuredMs * ((double)count * (double)count) / direct.interactionsPerEvaluation();
+
+        // Reference accelerations on an evenly spread sample (every body when the sample covers them).
+        std::size_t samples = std::min(options.samples, count);
+        std::vector<std::size_t> sampled(samples);
+        std::vector<glm::dvec3> reference(samples);
+        for (std::size_t s = 0; s < samples; ++s)
+        {
+            sampled[s] = s * count / samples;
+            reference[s] = directAcceleration(bodies, sampled[s]);
+        }
+
+        std::vector<double> ax(count), ay(count), az(count);
+        GravityOctree tree;
+        auto run = [&](double theta, bool quadrupole, double &buildMs, double &forceMs, std::vector<double> &errors)
+        {
+            OctreeSettings settings;
+            settings.openingAngle = theta;
+            settings.quadrupole = quadrupole;
+            settings.leafSize = options.leafSize;
+            settings.threads = options.threads;
+            buildMs = bestMs(options.repeats, [&]() { tree.build(bodies.x.data(), bodies.y.data(), bodies.z.data(), bodies.gm.data(), count, settings); });
+            forceMs = bestMs(options.repeats, [&]() { tree.accelerations(bodies.x.data(), bodies.y.data(), bodies.z.data(), ax.data(), ay.data(), az.data(), count); });
+            errors.clear();
+            for (std::size_t s = 0; s < samples; ++s)
+            {
+                glm::dvec3 a(ax[sampled[s]], ay[sampled[s]], az[sampled[s]]);
+                errors.push_back(glm::length(a - reference[s]) / glm::length(reference[s]));
+            }
+            std::sort(errors.begin(), errors.end());
+        };
+
+        // theta = 0 opens every cell: the tree must then agree with direct summation.
+        if (c == 0 && count <= options.directMax)
+        {
+            double buildMs, forceMs;
+            std::vector<double> errors;
+            run(0.0, false, buildMs, forceMs, errors);
+            exactError = errors.back();
+            match = exactError < 1e-12;
+        }
+
+        json << (c ? "," : "") << "\n    {\"bodies\": " << count << ", \"direct_ms\": " << directMs
+             << ", \"direct_measured\": " << (directMeasured ? "true" : "false") << ", \"samples\": " << samples << ", \"trees\": [";
+        bool first = true;
+        for (double theta : options.thetas)
+        {
+            for (int quadrupole = 0; quadrupole < 2; ++quadrupole)
+            {
+                double buildMs, forceMs;
+                std::vector<double> errors;
+                run(theta, quadrupole != 0, buildMs, forceMs, errors);
+                double squares = 0.0;
+                for (double error : errors)
+                    squares += error * error;
+
+                json << (first ? "" : ",") << "\n      {\"theta\": " << theta
+                     << ", \"quadrupole\": " << (quadrupole ? "true" : "false")
+                     << ", \"nodes\": " << tree.nodeCount()
+                     << ", \"build_ms\": " << buildMs
+                     << ", \"force_ms\": " << forceMs
+                     << ", \"interactions_per_body\": " << tree.lastInteractions() / (double)count
+                     << ", \"speedup\": " << directMs / (buildMs + forceMs)
+                     << ", \"rms_rel_error\": " << std::sqrt(squares / (double)errors.size())
+                     << ", \"p99_rel_error\": " << errors[std::min(errors.size() - 1, errors.size() * 99 / 100)]
+                     << ", \"max_rel_error\": " << errors.back() << "}";
+                first = false;
+            }
+        }
+        json << "\n    ]}";
+    }
+    json << "\n  ],\n"
+         << "  \"theta0_max_rel_error\": ";
+    if (exactError < 0.0)
+        json << "null";
+    else
+        json << exactError;
+    json << ",\n"
+         << "  \"match\": " << (match ? "true" : "false") << "\n}\n";
+
+    if (options.out.empty())
+    {
+        std::cout << json.str();
+    }
+    else
+    {
+        std::ofstream file(options.out);
+        file << json.str();
+    }
+    return match ? 0 : 1;
+}
@@ -0,0 +1,206 @@
+// Body update benchmark: times one per-frame transform update of --bodies
+// bodies (a sun, --planets planets around it and moons around those) with the
+// structure-of-arrays BodyState (updateBodyTransforms()) against the array of
+// CelestialBody structs it replaced, where the update walked whole bodies
+// (names, texture path, parent name, mesh) to read a few floats. Checks that
+// both produce the same model matrices and prints JSON. Needs no GL context.
+//
+//   ./BodyUpdateBench [--bodies 1000000] [--planets 1000] [--repeats 10] [--out result.json]
+
+#include "../include/body_state.h"
+#include "../include/glm/glm/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct BenchOptions
+{
+    std::size_t bodies = 1000000;
+    std::size_t planets = 1000;
+    int repeats = 10;
+    std::string out;
+};
+
+static BenchOptions parseArgs(int argc, char **argv)
+{
+    BenchOptions options;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::strcmp(argv[i], "--bodies") == 0)
+            options.bodies = (std::size_t)std::strtoull(argv[i + 1], nullptr, 10);
+        else if (std::strcmp(argv[i], "--planets") == 0)
+            options.planets = (std::size_t)std::strtoull(argv[i + 1], nullptr, 10);
+        else if (std::strcmp(argv[i], "--repeats") == 0)
+            options.repeats = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--out") == 0)
+            options.out = argv[i + 1];
+        else
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+    }
+    return options;
+}
+
+/**
+ * @brief CelestialBody as it was before the hot/cold split (the LodMesh as
+ * its two members), and the update that walked an array of them.
+ */
+struct LegacyBody
+{
+    std::string name;
+    float radius;
+    std::string texturePath;
+    bool isEmissive;
+
+    float orbitRadius;
+    float orbitSpeed;
+    float rotationSpeed;
+    glm::vec3 rotationAxis;
+    float orbitPhase = 0.0f;
+
+    std::optional<std::string> parentName;
+    int parentIndex = -1;
+
+    bool showOrbit = true;
+    glm::vec3 orbitColor = glm::vec3(0.8f);
+
+    unsigned int textureID = 0;
+    int textureLayer = 0;
+    glm::mat4 currentModelMatrix = glm::mat4(1.0f);
+    const void *lodChain = nullptr;
+    int lodLevel = 0;
+};
+
+static void legacyUpdate(std::vector<LegacyBody> &bodies, float t)
+{
+    for (auto &body : bodies)
+    {
+        glm::vec3 center(0.0f);
+        if (body.parentIndex >= 0)
+            center = glm::vec3(bodies[body.parentIndex].currentModelMatrix[3]);
+
+        float angle = t * body.orbitSpeed + body.orbitPhase;
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), center + body.orbitRadius * glm::vec3(std::cos(angle), 0.0f, std::sin(angle)));
+        if (body.rotationSpeed != 0.0f)
+            model = glm::rotate(model, t * body.rotationSpeed, body.rotationAxis);
+        body.currentModelMatrix = glm::scale(model, glm::vec3(body.radius));
+    }
+}
+
+/** @brief Best of @p repeats runs of @p fn, in milliseconds. */
+template <typename Fn>
+static double bestMs(int repeats, Fn fn)
+{
+    double best = 1e30;
+    for (int i = 0; i < std::max(repeats, 1); ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        fn(i);
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions options = parseArgs(argc, argv);
+    std::size_t count = std::max<std::size_t>(options.bodies, 1);
+    std::size_t planets = std::min(options.planets, count - 1);
+
+    // Parents before children, as resolveHierarchy() leaves them.
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::uniform_int_distribution<std::size_t> planet(1, std::max<std::size_t>(planets, 1));
+
+    std::vector<LegacyBody> legacy(count);
+    BodyState state;
+    state.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        bool isPlanet = i >= 1 && i <= planets;
+        int parent = i == 0 ? -1 : isPlanet || planets == 0 ? 0 : (int)planet(random);
+
+        BodyMotion motion;
+        motion.radius = i == 0 ? 2.0f : isPlanet ? 0.1f + 0.4f * unit(random) : 0.01f + 0.03f * unit(random);
+        motion.orbitRadius = i == 0 ? 0.0f : isPlanet ? 5.0f + 95.0f * unit(random) : 0.5f + 3.0f * unit(random);
+        motion.orbitSpeed = i == 0 ? 0.0f : 0.1f + 3.0f * unit(random);
+        motion.orbitPhase = 6.2831853f * unit(random);
+        motion.rotationSpeed = 2.0f * unit(random);
+        motion.rotationAxis = glm::normalize(glm::vec3(0.2f * unit(random), 1.0f, 0.2f * unit(random)));
+
+        std::size_t slot = state.add(motion);
+        state.parent[slot] = parent;
+
+        LegacyBody &body = legacy[i];
+        body.name = "Body " + std::to_string(i);
+        body.radius = motion.radius;
+        body.texturePath = isPlanet ? "textures/earth.jpg" : "textures/moon.jpg";
+        body.isEmissive = i == 0;
+        body.orbitRadius = motion.orbitRadius;
+        body.orbitSpeed = motion.orbitSpeed;
+        body.rotationSpeed = motion.rotationSpeed;
+        body.rotationAxis = motion.rotationAxis;
+        body.orbitPhase = motion.orbitPhase;
+        if (parent >= 0)
+            body.parentName = legacy[parent].name;
+        body.parentIndex = parent;
+    }
+
+    // A different time every repeat, so no run reuses the previous one's results.
+    const float dt = 1.0f / 60.0f;
+    double legacyMs = bestMs(options.repeats, [&](int i) { legacyUpdate(legacy, 1.0f + i * dt); });
+    double soaMs = bestMs(options.repeats, [&](int i) { updateBodyTransforms(state, 1.0f + i * dt); });
+
+    // Same time for both, then compare every matrix element.
+    float t = 1.0f + (std::max(options.repeats, 1) - 1) * dt;
+    legacyUpdate(legacy, t);
+    updateBodyTransforms(state, t);
+    double maxError = 0.0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        for (int column = 0; column < 4; ++column)
+        {
+            for (int row = 0; row < 4; ++row)
+                maxError = std::max(maxError, (double)std::abs(legacy[i].currentModelMatrix[column][row] - state.model[i][column][row]));
+        }
+    }
+    bool match = maxError < 1e-4;
+
+    std::size_t hotBytes = sizeof(std::int32_t) + 9 * sizeof(float); // parent, radius, orbit (3), spin, axis (3)
+    std::size_t outBytes = 3 * sizeof(float) + sizeof(glm::mat4);    // position, model
+    std::ostringstream json;
+    json << "{\n"
+         << "  \"bodies\": " << count << ",\n"
+         << "  \"planets\": " << planets << ",\n"
+         << "  \"repeats\": " << options.repeats << ",\n"
+         << "  \"legacy_body_bytes\": " << sizeof(LegacyBody) << ",\n"
+         << "  \"soa_bytes_read\": " << hotBytes << ",\n"
+         << "  \"soa_bytes_written\": " << outBytes << ",\n"
+         << "  \"legacy_ms\": " << legacyMs << ",\n"
+         << "  \"soa_ms\": " << soaMs << ",\n"
+         << "  \"legacy_mbodies_per_s\": " << count / (legacyMs * 1000.0) << ",\n"
+         << "  \"soa_mbodies_per_s\": " << count / (soaMs * 1000.0) << ",\n"
+         << "  \"speedup\": " << legacyMs / soaMs << ",\n"
+         << "  \"max_abs_error\": " << maxError << ",\n"
+         << "  \"match\": " << (match ? "true" : "false") << "\n}\n";
+
+    if (options.out.empty())
+    {
+        std::cout << json.str();
+    }
+    else
+    {
+        std::ofstream file(options.out);
+        file << json.str();
+    }
+    return match ? 0 : 1;
+}
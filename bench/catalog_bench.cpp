@@ -0,0 +1,371 @@
+// Catalog loading benchmark: writes a synthetic MPCORB-style fixed-width file
+// and a CSV file of --rows minor planets each (a header, and one malformed
+// line in the middle), then loads each with loadCatalog(): parsing it without
+// the binary image, parsing it and writing the image, and reading the image
+// back. Compares them with a plain serial loader (std::getline, std::stod,
+// KeplerPropagator::add()), which must give the same orbits bit for bit, and
+// the image with the parse. With --file, loads that catalog instead, checking
+// the image only. The files are read warm from the page cache. Prints JSON;
+// exits 1 on a mismatch. Needs no GL context.
+//
+//   ./CatalogBench [--rows 1000000] [--threads 0] [--repeats 3] [--dir /tmp] [--keep 0]
+//                  [--file MPCORB.DAT] [--out result.json]
+
+#include "../include/catalog.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct BenchOptions
+{
+    std::size_t rows = 1000000;
+    unsigned int threads = 0;
+    int repeats = 3;
+    std::string dir = "/tmp";
+    bool keep = false;
+    std::string file;
+    std::string out;
+};
+
+static BenchOptions parseArgs(int argc, char **argv)
+{
+    BenchOptions options;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::strcmp(argv[i], "--rows") == 0)
+            options.rows = (std::size_t)std::strtoull(argv[i + 1], nullptr, 10);
+        else if (std::strcmp(argv[i], "--threads") == 0)
+            options.threads = (unsigned int)std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--repeats") == 0)
+            options.repeats = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--dir") == 0)
+            options.dir = argv[i + 1];
+        else if (std::strcmp(argv[i], "--keep") == 0)
+            options.keep = std::atoi(argv[i + 1]) != 0;
+        else if (std::strcmp(argv[i], "--file") == 0)
+            options.file = argv[i + 1];
+        else if (std::strcmp(argv[i], "--out") == 0)
+            options.out = argv[i + 1];
+        else
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+    }
+    return options;
+}
+
+/** @brief Best of @p repeats runs of @p fn, in milliseconds. */
+template <typename Fn>
+static double bestMs(int repeats, Fn fn)
+{
+    double best = 1e30;
+    for (int i = 0; i < std::max(repeats, 1); ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+/** @brief One synthetic minor planet, as a catalog would print it. */
+struct Row
+{
+    char name[8];
+    double h, a, e, inclination, node, periapsis, meanAnomaly, meanMotion;
+    int year, month, day;
+};
+
+static char packedDigit(int value)
+{
+    return (char)(value < 10 ? '0' + value : 'A' + value - 10);
+}
+
+/** @brief Main-belt-like orbits with epochs spread over 2020-2025, 7-digit names. */
+static std::vector<Row> randomRows(std::size_t count)
+{
+    std::mt19937 random(3);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::vector<Row> rows(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        Row &row = rows[i];
+        std::snprintf(row.name, sizeof(row.name), "%07u", (unsigned int)(i + 1) % 10000000u);
+        row.h = 10.0 + 10.0 * unit(random);
+        row.a = 2.1 + 1.3 * unit(random);
+        row.e = 0.35 * unit(random);
+        row.inclination = 30.0 * unit(random);
+        row.node = 360.0 * unit(random);
+        row.periapsis = 360.0 * unit(random);
+        row.meanAnomaly = 360.0 * unit(random);
+        row.meanMotion = 0.9856076686 / (row.a * std::sqrt(row.a));
+        row.year = 2020 + (int)(6 * unit(random));
+        row.month = 1 + (int)(12 * unit(random));
+        row.day = 1 + (int)(28 * unit(random));
+    }
+    return rows;
+}
+
+static void writeMpcorb(const std::string &path, const std::vector<Row> &rows)
+{
+    std::ofstream file(path, std::ios::binary);
+    file << "MINOR PLANET CENTER ORBIT DATABASE (MPCORB)\n\n"
+         << "Des'n     H     G   Epoch     M        Peri.      Node       Incl.       e            n           a\n"
+         << std::string(202, '-') << "\n";
+    char line[256];
+    for (std::size_t i = 0; i < rows.size(); ++i)
+    {
+        const Row &row = rows[i];
+        char epoch[6] = {packedDigit(row.year / 100), (char)('0' + row.year / 10 % 10), (char)('0' + row.year % 10),
+                         packedDigit(row.month), packedDigit(row.day), '\0'};
+        std::snprintf(line, sizeof(line), "%-7s %5.2f  0.15 %5s %9.5f  %9.5f  %9.5f  %9.5f  %9.7f %11.8f %11.7f"
+                      "  0 MPO123456  1234  12 2001-2024 0.55 M-v 3Ek Pan        0000 (%s)",
+                      row.name, row.h, epoch, row.meanAnomaly, row.periapsis, row.node, row.inclination,
+                      row.e, row.meanMotion, row.a, row.name);
+        file << line << "\n";
+        if (i == rows.size() / 2)
+            file << std::string(40, ' ') << "malformed " << std::string(80, 'x') << "\n";
+    }
+}
+
+static double julianDate(int year, int month, int day)
+{
+    // Fliegel and Van Flandern's integer formula (noon), minus half a day for 0h.
+    long long jdn = day - 32075 + 1461LL * (year + 4800 + (month - 14) / 12) / 4 + 367LL * (month - 2 - (month - 14) / 12 * 12) / 12 -
+                    3LL * ((year + 4900 + (month - 14) / 12) / 100) / 4;
+    return (double)jdn - 0.5;
+}
+
+static void writeCsv(const std::string &path, const std::vector<Row> &rows)
+{
+    std::ofstream file(path, std::ios::binary);
+    file << "full_name,a,e,i,om,w,ma,epoch,n,H\r\n";
+    char line[256];
+    for (std::size_t i = 0; i < rows.size(); ++i)
+    {
+        const Row &row = rows[i];
+        std::snprintf(line, sizeof(line), "\"%s, synthetic\",%.10g,%.10g,%.10g,%.10g,%.10g,%.10g,%.1f,%.10g,%.3g\r\n",
+                      row.name, row.a, row.e, row.inclination, row.node, row.periapsis, row.meanAnomaly,
+                      julianDate(row.year, row.month, row.day), row.meanMotion, row.h);
+        file << line;
+        if (i == rows.size() / 2)
+            file << "\"broken\",2.5,0.1,,,,,,,\r\n";
+    }
+}
+
+/** @brief The elements loadCatalog() should produce, from catalog units (AU, degrees, days). */
+static OrbitalElements referenceElements(const double values[8], double epochJd, const CatalogSettings &settings)
+{
+    const double degrees = 3.14159265358979323846 / 180.0;
+    OrbitalElements elements;
+    elements.semiMajorAxis = values[0] * settings.unitsPerAu;
+    elements.eccentricity = values[1];
+    elements.inclination = values[2] * degrees;
+    elements.ascendingNode = values[3] * degrees;
+    elements.periapsis = values[4] * degrees;
+    elements.meanAnomaly = values[5] * degrees;
+    elements.epoch = (epochJd - settings.epochJd) * settings.secondsPerDay;
+    elements.meanMotion = values[6] * degrees / settings.secondsPerDay;
+    return elements;
+}
+
+static int unpack(char c)
+{
+    return c <= '9' ? c - '0' : c - 'A' + 10;
+}
+
+/** @brief The plain loader: one line at a time into std::string, std::stod, KeplerPropagator::add(). */
+static void referenceLoad(const std::string &path, bool csv, const CatalogSettings &settings, Catalog &catalog)
+{
+    catalog.orbits.clear();
+    catalog.names.clear();
+    catalog.absoluteMagnitude.clear();
+    std::ifstream file(path);
+    std::string line;
+    bool header = true;
+    while (std::getline(file, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (header)
+        {
+            header = csv ? false : line.compare(0, 5, "-----") != 0;
+            continue;
+        }
+        double values[8];
+        double epochJd;
+        Catalog::Name name = {};
+        try
+        {
+            if (csv)
+            {
+                std::vector<std::string> fields;
+                std::string field;
+                bool quoted = false;
+                for (char c : line)
+                {
+                    if (c == '"')
+                        quoted = !quoted;
+                    else if (c == ',' && !quoted)
+                    {
+                        fields.push_back(field);
+                        field.clear();
+                    }
+                    else
+                        field += c;
+                }
+                fields.push_back(field);
+                if (fields.size() != 10)
+                    continue;
+                for (int k = 0; k < 6; ++k)
+                    values[k] = std::stod(fields[1 + k]);
+                epochJd = std::stod(fields[7]);
+                values[6] = std::stod(fields[8]);
+                values[7] = std::stod(fields[9]);
+                std::strncpy(name.data(), fields[0].c_str(), name.size() - 1);
+            }
+            else
+            {
+                if (line.size() < 103)
+                    continue;
+                const int columns[6][2] = {{92, 11}, {70, 9}, {59, 9}, {48, 9}, {37, 9}, {26, 9}};
+                for (int k = 0; k < 6; ++k)
+                    values[k] = std::stod(line.substr(columns[k][0], columns[k][1]));
+                values[6] = std::stod(line.substr(80, 11));
+                values[7] = std::stod(line.substr(8, 5));
+                epochJd = julianDate(unpack(line[20]) * 100 + unpack(line[21]) * 10 + unpack(line[22]), unpack(line[23]), unpack(line[24]));
+                std::string designation = line.substr(0, 7);
+                designation.erase(designation.find_last_not_of(' ') + 1);
+                std::strncpy(name.data(), designation.c_str(), name.size() - 1);
+            }
+        }
+        catch (const std::exception &)
+        {
+            continue;
+        }
+        catalog.orbits.add(referenceElements(values, epochJd, settings));
+        catalog.names.push_back(name);
+        catalog.absoluteMagnitude.push_back((float)values[7]);
+    }
+}
+
+/** @brief Whether two catalogs hold the same orbits, names and magnitudes, bit for bit. */
+static bool sameCatalog(const Catalog &a, const Catalog &b)
+{
+    if (a.size() != b.size() || a.orbits.size() != b.orbits.size())
+        return false;
+    for (int c = 0; c < KeplerPropagator::kColumns; ++c)
+        if (a.size() && std::memcmp(a.orbits.column(c), b.orbits.column(c), a.size() * sizeof(double)) != 0)
+            return false;
+    for (std::size_t i = 0; i < a.size(); ++i)
+    {
+        float ha = a.absoluteMagnitude[i], hb = b.absoluteMagnitude[i];
+        if (a.names[i] != b.names[i] || !(ha == hb || (std::isnan(ha) && std::isnan(hb))))
+            return false;
+    }
+    return true;
+}
+
+static std::size_t fileBytes(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    return file ? (std::size_t)file.tellg() : 0;
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions options = parseArgs(argc, argv);
+
+    std::vector<std::string> paths;
+    if (options.file.empty())
+    {
+        std::vector<Row> rows = randomRows(options.rows);
+        paths.push_back(options.dir + "/catalog_bench.dat");
+        paths.push_back(options.dir + "/catalog_bench.csv");
+        writeMpcorb(paths[0], rows);
+        writeCsv(paths[1], rows);
+    }
+    else
+        paths.push_back(options.file);
+
+    std::ostringstream json;
+    json << "{\n"
+         << "  \"threads\": " << options.threads << ",\n"
+         << "  \"repeats\": " << options.repeats << ",\n"
+         << "  \"runs\": [";
+
+    bool match = true;
+    for (std::size_t p = 0; p < paths.size(); ++p)
+    {
+        const std::string &path = paths[p];
+        bool csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+        CatalogSettings settings;
+        settings.threads = options.threads;
+        std::remove((path + ".bin").c_str());
+
+        // Parsing only, then the first load that also writes the image, then loads from it.
+        Catalog parsed, imaged;
+        CatalogLoadStats parseStats, writeStats, imageStats;
+        settings.useImage = false;
+        double parseMs = bestMs(options.repeats, [&]() { loadCatalog(path, parsed, settings, &parseStats); });
+        settings.useImage = true;
+        bool loaded = loadCatalog(path, imaged, settings, &writeStats);
+        double imageMs = bestMs(options.repeats, [&]() { loadCatalog(path, imaged, settings, &imageStats); });
+        bool sameImage = loaded && writeStats.wroteImage && imageStats.fromImage && sameCatalog(parsed, imaged);
+        match = match && sameImage;
+
+        json << (p ? "," : "") << "\n    {\"file\": \"" << path << "\""
+             << ", \"bytes\": " << fileBytes(path)
+             << ", \"lines\": " << parseStats.lines
+             << ", \"orbits\": " << parsed.size()
+             << ", \"skipped\": " << parseStats.skipped
+             << ", \"load_threads\": " << parseStats.threads
+             << ", \"parse_ms\": " << parseMs
+             << ", \"parse_orbits_per_s\": " << parsed.size() / (parseMs * 1e-3)
+             << ", \"first_load_ms\": " << writeStats.ms
+             << ", \"image_ms\": " << imageMs
+             << ", \"image_bytes\": " << imageStats.bytes
+             << ", \"image_match\": " << (sameImage ? "true" : "false");
+
+        if (options.file.empty())
+        {
+            Catalog reference;
+            double referenceMs = bestMs(1, [&]() { referenceLoad(path, csv, settings, reference); });
+            bool sameReference = reference.size() == options.rows && sameCatalog(reference, parsed);
+            match = match && sameReference;
+            json << ", \"reference_ms\": " << referenceMs
+                 << ", \"reference_match\": " << (sameReference ? "true" : "false");
+        }
+        json << "}";
+        std::cerr << path << ": " << parsed.size() << " orbits, " << parseMs << " ms parsed, " << imageMs << " ms from the image" << std::endl;
+
+        if (!options.keep)
+        {
+            std::remove((path + ".bin").c_str());
+            if (options.file.empty())
+                std::remove(path.c_str());
+        }
+    }
+
+    json << "\n  ],\n"
+         << "  \"match\": " << (match ? "true" : "false") << "\n}\n";
+
+    if (options.out.empty())
+    {
+        std::cout << json.str();
+    }
+    else
+    {
+        std::ofstream file(options.out);
+        file << json.str();
+    }
+    return match ? 0 : 1;
+}
@@ -0,0 +1,483 @@
+// JPL ephemeris benchmark: writes a synthetic DE file in asc2eph's binary
+// layout (DE440's series: the same coefficients and granules per body) whose
+// Chebyshev coefficients interpolate Keplerian orbits, over --years, and reads
+// it with Ephemeris. Checks evaluate() against the orbits, state() against
+// evaluate(), sample() with every kernel the CPU supports against the scalar
+// one, record boundaries, epochs out of range and the same file in the other
+// byte order. Times evaluate() at random epochs against a reader that seeks
+// and reads each epoch's record, and sample() over sorted epochs (a trail)
+// and random ones. With --file, times a real DE file instead, checking
+// state() against evaluate() only. Prints JSON; exits 1 on a mismatch. Needs
+// no GL context.
+//
+//   ./EphemerisBench [--years 50] [--epochs 1000000] [--repeats 3] [--dir /tmp] [--keep 0]
+//                    [--file de440.bin] [--out result.json]
+
+#include "../include/ephemeris.h"
+#include "../include/kepler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct BenchOptions
+{
+    double years = 50.0;
+    std::size_t epochs = 1000000;
+    int repeats = 3;
+    std::string dir = "/tmp";
+    bool keep = false;
+    std::string file;
+    std::string out;
+};
+
+static BenchOptions parseArgs(int argc, char **argv)
+{
+    BenchOptions options;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::strcmp(argv[i], "--years") == 0)
+            options.years = std::atof(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--epochs") == 0)
+            options.epochs = (std::size_t)std::strtoull(argv[i + 1], nullptr, 10);
+        else if (std::strcmp(argv[i], "--repeats") == 0)
+            options.repeats = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--dir") == 0)
+            options.dir = argv[i + 1];
+        else if (std::strcmp(argv[i], "--keep") == 0)
+            options.keep = std::atoi(argv[i + 1]) != 0;
+        else if (std::strcmp(argv[i], "--file") == 0)
+            options.file = argv[i + 1];
+        else if (std::strcmp(argv[i], "--out") == 0)
+            options.out = argv[i + 1];
+        else
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+    }
+    return options;
+}
+
+/** @brief Best of @p repeats runs of @p fn, in milliseconds. */
+template <typename Fn>
+static double bestMs(int repeats, Fn fn)
+{
+    double best = 1e30;
+    for (int i = 0; i < std::max(repeats, 1); ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+static const double kAu = 149597870.7;
+static const double kEmrat = 81.3005682214972154;
+static const double kJ2000 = 2451545.0;
+static const double kRecordDays = 32.0;
+
+/** @brief A series of the synthetic file: DE440's pointer and an orbit in km and days (none for nutations and librations). */
+struct SyntheticSeries
+{
+    int offset, coefficients, granules;
+    double a, e, period; // au (km for the Moon), days
+};
+
+static const SyntheticSeries kSeries[13] = {
+    {3, 14, 4, 0.387, 0.2056, 87.97},       // Mercury
+    {171, 10, 2, 0.723, 0.0068, 224.70},    // Venus
+    {231, 13, 2, 1.000, 0.0167, 365.256},   // Earth-Moon barycentre
+    {309, 11, 1, 1.524, 0.0934, 686.98},    // Mars
+    {342, 8, 1, 5.203, 0.0484, 4332.59},    // Jupiter
+    {366, 7, 1, 9.537, 0.0539, 10759.22},   // Saturn
+    {387, 6, 1, 19.19, 0.0473, 30688.5},    // Uranus
+    {405, 6, 1, 30.07, 0.0086, 60182.0},    // Neptune
+    {423, 6, 1, 39.48, 0.2488, 90560.0},    // Pluto
+    {441, 13, 8, 384400.0, 0.0549, 27.3217}, // Moon
+    {753, 11, 2, 0.005, 0.0484, 4332.59},   // Sun, around the barycentre
+    {819, 10, 4, 0.0, 0.0, 0.0},            // nutations
+    {899, 10, 4, 0.0, 0.0, 0.0},            // librations
+};
+static const int kRecordDoubles = 899 - 1 + 3 * 10 * 4;
+
+/** @brief The orbit series @p i interpolates; t in days from J2000. */
+static glm::dvec3 truth(int i, double jd, glm::dvec3 *velocity = nullptr)
+{
+    const SyntheticSeries &s = kSeries[i];
+    OrbitalElements orbit;
+    orbit.semiMajorAxis = i == (int)EphemerisBody::Moon ? s.a : s.a * kAu;
+    orbit.eccentricity = s.e;
+    orbit.inclination = 0.02 * i;
+    orbit.ascendingNode = 0.7 * i;
+    orbit.periapsis = 1.3 * i;
+    orbit.meanAnomaly = 0.4 * i;
+    orbit.meanMotion = 6.283185307179586 / s.period;
+    glm::dvec3 position;
+    keplerState(orbit, jd - kJ2000, position, velocity);
+    return position;
+}
+
+/** @brief Fixed-width fields of the file, in either byte order. */
+struct Writer
+{
+    std::vector<unsigned char> bytes;
+    bool swap;
+
+    void put(std::size_t offset, const void *value, std::size_t size)
+    {
+        const unsigned char *from = (const unsigned char *)value;
+        for (std::size_t k = 0; k < size; ++k)
+            bytes[offset + k] = from[swap ? size - 1 - k : k];
+    }
+    void putInt(std::size_t offset, std::int32_t value) { put(offset, &value, 4); }
+    void putDouble(std::size_t offset, double value) { put(offset, &value, 8); }
+    void putText(std::size_t offset, const char *text, std::size_t width)
+    {
+        std::size_t length = std::strlen(text);
+        for (std::size_t k = 0; k < width; ++k)
+            bytes[offset + k] = k < length ? text[k] : ' ';
+    }
+};
+
+/** @brief Writes @p records records from @p start; every series fitted at its granule's Chebyshev nodes. */
+static bool writeSynthetic(const std::string &path, double start, std::size_t records, bool swap)
+{
+    const std::size_t recordBytes = kRecordDoubles * 8;
+    Writer writer{std::vector<unsigned char>((records + 2) * recordBytes, 0), swap};
+    writer.putText(0, "SYNTHETIC DE ephemeris (EphemerisBench)", 252);
+    const char *names[] = {"DENUM", "AU", "EMRAT", "CLIGHT"};
+    const double values[] = {440.0, kAu, kEmrat, 299792.458};
+    for (int i = 0; i < 400; ++i)
+        writer.putText(252 + i * 6, i < 4 ? names[i] : "", 6);
+    double end = start + records * kRecordDays;
+    writer.putDouble(2652, start);
+    writer.putDouble(2660, end);
+    writer.putDouble(2668, kRecordDays);
+    writer.putInt(2676, 4);
+    writer.putDouble(2680, kAu);
+    writer.putDouble(2688, kEmrat);
+    for (int i = 0; i < 12; ++i)
+    {
+        writer.putInt(2696 + i * 12, kSeries[i].offset);
+        writer.putInt(2696 + i * 12 + 4, kSeries[i].coefficients);
+        writer.putInt(2696 + i * 12 + 8, kSeries[i].granules);
+    }
+    writer.putInt(2840, 440);
+    writer.putInt(2844, kSeries[12].offset);
+    writer.putInt(2848, kSeries[12].coefficients);
+    writer.putInt(2852, kSeries[12].granules);
+    for (int i = 0; i < 4; ++i)
+        writer.putDouble(recordBytes + i * 8, values[i]);
+
+    for (std::size_t r = 0; r < records; ++r)
+    {
+        std::size_t base = (r + 2) * recordBytes;
+        double recordStart = start + r * kRecordDays;
+        writer.putDouble(base, recordStart);
+        writer.putDouble(base + 8, recordStart + kRecordDays);
+        for (int i = 0; i < 11; ++i)
+        {
+            const SyntheticSeries &s = kSeries[i];
+            int n = s.coefficients;
+            double granuleDays = kRecordDays / s.granules;
+            for (int g = 0; g < s.granules; ++g)
+            {
+                std::vector<glm::dvec3> nodes(n);
+                for (int j = 0; j < n; ++j)
+                {
+                    double x = std::cos(3.141592653589793 * (j + 0.5) / n);
+                    nodes[j] = truth(i, recordStart + g * granuleDays + (x + 1.0) * 0.5 * granuleDays);
+                }
+                for (int k = 0; k < n; ++k)
+                {
+                    glm::dvec3 c(0.0);
+                    for (int j = 0; j < n; ++j)
+                        c += nodes[j] * std::cos(3.141592653589793 * k * (j + 0.5) / n);
+                    c *= (k == 0 ? 1.0 : 2.0) / n;
+                    for (int component = 0; component < 3; ++component)
+                        writer.putDouble(base + ((s.offset - 1) + (g * 3 + component) * n + k) * 8, c[component]);
+                }
+            }
+        }
+    }
+    std::ofstream file(path, std::ios::binary);
+    file.write((const char *)writer.bytes.data(), (std::streamsize)writer.bytes.size());
+    return (bool)file;
+}
+
+/**
+ * @brief What a reader without the mapping does: for each epoch, seek to its
+ * record, read it, and evaluate every body's series on its own.
+ */
+struct NaiveReader
+{
+    FILE *file;
+    std::vector<double> record;
+
+    explicit NaiveReader(const std::string &path) : file(std::fopen(path.c_str(), "rb")), record(kRecordDoubles) {}
+    ~NaiveReader()
+    {
+        if (file)
+            std::fclose(file);
+    }
+
+    void evaluate(double start, double jd, glm::dvec3 *positions)
+    {
+        std::size_t r = (std::size_t)((jd - start) / kRecordDays);
+        std::fseek(file, (long)((r + 2) * kRecordDoubles * 8), SEEK_SET);
+        if (std::fread(record.data(), 8, kRecordDoubles, file) != (std::size_t)kRecordDoubles)
+            return;
+        for (int i = 0; i < 11; ++i)
+        {
+            const SyntheticSeries &s = kSeries[i];
+            double granuleDays = kRecordDays / s.granules;
+            int g = std::min((int)((jd - record[0]) / granuleDays), s.granules - 1);
+            double tc = 2.0 * (jd - record[0] - g * granuleDays) / granuleDays - 1.0;
+            const double *c = record.data() + (s.offset - 1) + g * 3 * s.coefficients;
+            for (int component = 0; component < 3; ++component)
+            {
+                double t0 = 1.0, t1 = tc, sum = c[component * s.coefficients] + c[component * s.coefficients + 1] * tc;
+                for (int k = 2; k < s.coefficients; ++k)
+                {
+                    double t2 = 2.0 * tc * t1 - t0;
+                    sum += c[component * s.coefficients + k] * t2;
+                    t0 = t1;
+                    t1 = t2;
+                }
+                positions[i][component] = sum;
+            }
+        }
+    }
+};
+
+static double relativeError(const glm::dvec3 &value, const glm::dvec3 &expected)
+{
+    return glm::length(value - expected) / std::max(glm::length(expected), 1.0);
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions options = parseArgs(argc, argv);
+    const NBodyKernel kernels[] = {NBodyKernel::Scalar, NBodyKernel::Avx2, NBodyKernel::Avx512};
+    bool synthetic = options.file.empty();
+    std::string path = synthetic ? options.dir + "/ephemeris_bench.bin" : options.file;
+    std::string swappedPath = options.dir + "/ephemeris_bench_swapped.bin";
+    std::size_t records = (std::size_t)std::ceil(options.years * 365.25 / kRecordDays);
+    double syntheticStart = kJ2000 - 0.5 * records * kRecordDays;
+    if (synthetic && !(records > 0 && writeSynthetic(path, syntheticStart, records, false) && writeSynthetic(swappedPath, syntheticStart, records, true)))
+    {
+        std::cerr << "ERROR::EPHEMERIS_BENCH: could not write " << path << std::endl;
+        return 1;
+    }
+
+    double openMs = 0.0;
+    {
+        openMs = bestMs(options.repeats, [&]() { Ephemeris ephemeris(path); });
+    }
+    Ephemeris ephemeris(path);
+    if (!ephemeris.isOpen())
+        return 1;
+    double start = ephemeris.startJd(), end = ephemeris.endJd();
+
+    std::mt19937 random(17);
+    std::uniform_real_distribution<double> epoch(start, end);
+    std::vector<double> randomEpochs(options.epochs), sortedEpochs(options.epochs);
+    for (std::size_t i = 0; i < options.epochs; ++i)
+    {
+        randomEpochs[i] = epoch(random);
+        sortedEpochs[i] = start + (end - start) * (double)i / (double)options.epochs;
+    }
+
+    bool match = true;
+    glm::dvec3 positions[kEphemerisBodies], velocities[kEphemerisBodies];
+
+    // The coefficients against the orbits they interpolate, and state() against evaluate().
+    double maxPositionError = 0.0, maxVelocityError = 0.0, maxStateDifference = 0.0;
+    for (std::size_t k = 0; k < std::min<std::size_t>(options.epochs, 20000); ++k)
+    {
+        double jd = randomEpochs[k];
+        match = match && ephemeris.evaluate(jd, positions, velocities);
+        for (int body = 0; body < kEphemerisBodies; ++body)
+        {
+            if (!ephemeris.has((EphemerisBody)body))
+                continue;
+            glm::dvec3 position, velocity;
+            ephemeris.state((EphemerisBody)body, jd, position, &velocity);
+            maxStateDifference = std::max(maxStateDifference, relativeError(position, positions[body]) + relativeError(velocity, velocities[body]));
+            if (!synthetic)
+                continue;
+            glm::dvec3 expected, expectedVelocity;
+            if (body == (int)EphemerisBody::Earth)
+            {
+                glm::dvec3 moonVelocity;
+                expected = truth((int)EphemerisBody::EarthMoon, jd, &expectedVelocity) - truth((int)EphemerisBody::Moon, jd, &moonVelocity) / (1.0 + kEmrat);
+                expectedVelocity -= moonVelocity / (1.0 + kEmrat);
+            }
+            else
+                expected = truth(body, jd, &expectedVelocity);
+            maxPositionError = std::max(maxPositionError, relativeError(positions[body], expected));
+            maxVelocityError = std::max(maxVelocityError, relativeError(velocities[body], expectedVelocity));
+        }
+    }
+    match = match && maxStateDifference < 1e-14;
+    if (synthetic)
+        match = match && maxPositionError < 1e-10 && maxVelocityError < 1e-8;
+
+    // Record boundaries are continuous, both ends are in range, past them is not.
+    double maxBoundaryJump = 0.0;
+    for (std::size_t r = 1; r < 64; ++r)
+    {
+        double boundary = start + r * ephemeris.recordDays();
+        if (boundary >= end)
+            break;
+        glm::dvec3 before, after;
+        ephemeris.state(EphemerisBody::Mercury, std::nextafter(boundary, start), before);
+        ephemeris.state(EphemerisBody::Mercury, boundary, after);
+        maxBoundaryJump = std::max(maxBoundaryJump, relativeError(before, after));
+    }
+    bool range = ephemeris.evaluate(start, positions) && ephemeris.evaluate(end, positions) &&
+                 !ephemeris.evaluate(start - 1.0, positions) && !ephemeris.evaluate(end + 1.0, positions);
+    match = match && range && maxBoundaryJump < 1e-9;
+
+    // The other byte order reads the same numbers.
+    bool swappedMatch = true;
+    if (synthetic)
+    {
+        Ephemeris swapped(swappedPath);
+        glm::dvec3 swappedPositions[kEphemerisBodies];
+        for (std::size_t k = 0; k < std::min<std::size_t>(options.epochs, 1000); ++k)
+        {
+            swappedMatch = swappedMatch && swapped.evaluate(randomEpochs[k], swappedPositions) && ephemeris.evaluate(randomEpochs[k], positions);
+            for (int body = 0; body < kEphemerisBodies; ++body)
+                swappedMatch = swappedMatch && swappedPositions[body] == positions[body];
+        }
+        match = match && swappedMatch && swapped.number() == 440 && swapped.constant("CLIGHT") == 299792.458;
+    }
+
+    double evaluateMs = bestMs(options.repeats, [&]() {
+        for (double jd : randomEpochs)
+            ephemeris.evaluate(jd, positions);
+    });
+    double naiveMs = 0.0;
+    if (synthetic)
+    {
+        NaiveReader naive(path);
+        naiveMs = bestMs(options.repeats, [&]() {
+            for (double jd : randomEpochs)
+                naive.evaluate(start, jd, positions);
+        });
+    }
+
+    std::ostringstream json;
+    json << "{\n"
+         << "  \"file\": \"" << (synthetic ? "synthetic" : options.file) << "\",\n"
+         << "  \"de\": " << ephemeris.number() << ",\n"
+         << "  \"start_jd\": " << start << ",\n"
+         << "  \"end_jd\": " << end << ",\n"
+         << "  \"epochs\": " << options.epochs << ",\n"
+         << "  \"repeats\": " << options.repeats << ",\n"
+         << "  \"open_ms\": " << openMs << ",\n"
+         << "  \"evaluate_ms\": " << evaluateMs << ",\n"
+         << "  \"evaluate_epochs_per_s\": " << options.epochs / (evaluateMs * 1e-3) << ",\n"
+         << "  \"naive_ms\": " << naiveMs << ",\n"
+         << "  \"sample\": [";
+
+    // sample() of the Moon (the most granules) and the Earth (two series), per kernel.
+    const EphemerisBody sampled[] = {EphemerisBody::Moon, EphemerisBody::Earth, EphemerisBody::Jupiter};
+    std::size_t n = options.epochs;
+    std::vector<double> x(n), y(n), z(n), vx(n), vy(n), vz(n);
+    std::vector<double> referenceX(n), referenceY(n), referenceZ(n), referenceVx(n), referenceVy(n), referenceVz(n);
+    bool first = true;
+    double maxKernelError = 0.0;
+    for (EphemerisBody body : sampled)
+    {
+        for (int order = 0; order < 2; ++order)
+        {
+            const std::vector<double> &epochs = order == 0 ? sortedEpochs : randomEpochs;
+            for (NBodyKernel kernel : kernels)
+            {
+                if (!isGravityKernelSupported(kernel))
+                    continue;
+                Ephemeris sampler(path, kernel);
+                std::size_t inRange = 0;
+                double sampleMs = bestMs(options.repeats, [&]() {
+                    inRange = sampler.sample(body, epochs.data(), n, x.data(), y.data(), z.data(), vx.data(), vy.data(), vz.data());
+                });
+                double positionMs = bestMs(options.repeats, [&]() { sampler.sample(body, epochs.data(), n, x.data(), y.data(), z.data()); });
+                sampler.sample(body, epochs.data(), n, x.data(), y.data(), z.data(), vx.data(), vy.data(), vz.data());
+                if (kernel == NBodyKernel::Scalar)
+                {
+                    referenceX = x;
+                    referenceY = y;
+                    referenceZ = z;
+                    referenceVx = vx;
+                    referenceVy = vy;
+                    referenceVz = vz;
+                    // The scalar kernel against state().
+                    for (std::size_t i = 0; i < n; i += std::max<std::size_t>(n / 1000, 1))
+                    {
+                        glm::dvec3 position;
+                        ephemeris.state(body, epochs[i], position);
+                        maxKernelError = std::max(maxKernelError, relativeError(glm::dvec3(x[i], y[i], z[i]), position));
+                    }
+                }
+                for (std::size_t i = 0; i < n; ++i)
+                {
+                    glm::dvec3 expected(referenceX[i], referenceY[i], referenceZ[i]);
+                    maxKernelError = std::max(maxKernelError, relativeError(glm::dvec3(x[i], y[i], z[i]), expected));
+                    glm::dvec3 expectedVelocity(referenceVx[i], referenceVy[i], referenceVz[i]);
+                    maxKernelError = std::max(maxKernelError, relativeError(glm::dvec3(vx[i], vy[i], vz[i]), expectedVelocity));
+                }
+                match = match && inRange == n;
+                json << (first ? "" : ",") << "\n    {\"body\": " << (int)body << ", \"epochs\": \"" << (order == 0 ? "sorted" : "random")
+                     << "\", \"kernel\": \"" << gravityKernelName(kernel) << "\""
+                     << ", \"state_ms\": " << sampleMs
+                     << ", \"position_ms\": " << positionMs
+                     << ", \"epochs_per_s\": " << n / (positionMs * 1e-3) << "}";
+                first = false;
+            }
+        }
+    }
+    match = match && maxKernelError < 1e-12;
+
+    // Out-of-range epochs are NaN and not counted.
+    double outside[] = {start - 10.0, start, 0.5 * (start + end), end, end + 10.0};
+    double ox[5], oy[5], oz[5];
+    std::size_t outsideCount = ephemeris.sample(EphemerisBody::Mars, outside, 5, ox, oy, oz);
+    match = match && outsideCount == 3 && std::isnan(ox[0]) && std::isnan(oz[4]) && !std::isnan(ox[1]) && !std::isnan(ox[3]);
+
+    json << "\n  ],\n"
+         << "  \"max_position_rel_error\": " << maxPositionError << ",\n"
+         << "  \"max_velocity_rel_error\": " << maxVelocityError << ",\n"
+         << "  \"max_state_difference\": " << maxStateDifference << ",\n"
+         << "  \"max_boundary_jump\": " << maxBoundaryJump << ",\n"
+         << "  \"max_kernel_rel_error\": " << maxKernelError << ",\n"
+         << "  \"range\": " << (range ? "true" : "false") << ",\n"
+         << "  \"swapped_match\": " << (swappedMatch ? "true" : "false") << ",\n"
+         << "  \"match\": " << (match ? "true" : "false") << "\n}\n";
+
+    if (synthetic && !options.keep)
+    {
+        std::remove(path.c_str());
+        std::remove(swappedPath.c_str());
+    }
+    if (options.out.empty())
+    {
+        std::cout << json.str();
+    }
+    else
+    {
+        std::ofstream file(options.out);
+        file << json.str();
+    }
+    return match ? 0 : 1;
+}
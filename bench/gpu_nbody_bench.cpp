@@ -0,0 +1,198 @@
+// GPU N-body benchmark: for each of --counts bodies, integrates a GpuNBody
+// Plummer cluster for --steps leapfrog steps on the GPU and times one step and
+// one draw of the cluster straight from its position buffer, next to one
+// direct-summation force evaluation of the same bodies on the CPU
+// (NBodySystem::computeAccelerations()). Then checks the GPU against the CPU:
+// --check-bodies bodies stepped --check-steps times by both from the same
+// start must end within float precision of each other. Prints JSON; exits 1
+// on a mismatch. Needs a GL 4.3 context (Mesa llvmpipe will do).
+//
+// Run from the repository root (shaders/ are loaded relative to it):
+//   ./GpuNBodyBench [--counts 1024,4096,16384] [--steps 10] [--check-bodies 2048] [--check-steps 20]
+//                   [--points 0] [--width 1280] [--height 720] [--out result.json]
+
+#include "../include/glad/glad.h"
+#include "../include/gpu_nbody.h"
+#include "../include/headless_context.h"
+#include "../include/nbody.h"
+#include "../include/glm/glm/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct BenchOptions
+{
+    std::vector<unsigned int> counts = {1024, 4096, 16384};
+    int steps = 10;
+    unsigned int checkBodies = 2048;
+    int checkSteps = 20;
+    bool points = false;
+    int width = 1280;
+    int height = 720;
+    std::string out;
+};
+
+static BenchOptions parseArgs(int argc, char **argv)
+{
+    BenchOptions options;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::strcmp(argv[i], "--counts") == 0)
+        {
+            options.counts.clear();
+            std::stringstream list(argv[i + 1]);
+            std::string count;
+            while (std::getline(list, count, ','))
+                options.counts.push_back((unsigned int)std::strtoul(count.c_str(), nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--steps") == 0)
+            options.steps = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--check-bodies") == 0)
+            options.checkBodies = (unsigned int)std::strtoul(argv[i + 1], nullptr, 10);
+        else if (std::strcmp(argv[i], "--check-steps") == 0)
+            options.checkSteps = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--points") == 0)
+            options.points = std::atoi(argv[i + 1]) != 0;
+        else if (std::strcmp(argv[i], "--width") == 0)
+            options.width = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--height") == 0)
+            options.height = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--out") == 0)
+            options.out = argv[i + 1];
+        else
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+    }
+    return options;
+}
+
+/** @brief Milliseconds of @p repeats runs of @p fn, each finished on the GPU, per run. */
+template <typename Fn>
+static double gpuMs(int repeats, Fn fn)
+{
+    glFinish();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < std::max(repeats, 1); ++i)
+        fn();
+    glFinish();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / std::max(repeats, 1);
+}
+
+/** @brief An NBodySystem with the same bodies, integrator and step as @p gpu. */
+static NBodySystem cpuCopy(const GpuNBody &gpu)
+{
+    NBodySettings settings;
+    settings.integrator = NBodyIntegrator::Leapfrog;
+    settings.dt = gpu.getSettings().dt;
+    settings.softening = gpu.getSettings().softening;
+    NBodySystem system(settings);
+    std::vector<glm::vec4> positions, velocities;
+    gpu.read(positions, velocities);
+    for (std::size_t i = 0; i < positions.size(); ++i)
+        system.add(glm::dvec3(positions[i]), glm::dvec3(velocities[i]), positions[i].w);
+    return system;
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions options = parseArgs(argc, argv);
+
+    HeadlessContext context(options.width, options.height, 4, 3);
+    if (!context.isValid() || !GpuNBody::isSupported())
+    {
+        std::cerr << "GpuNBodyBench needs a GL 4.3 context" << std::endl;
+        return -1;
+    }
+    glEnable(GL_DEPTH_TEST);
+
+    // Looking at the cluster from a few scale radii.
+    GpuNBodySettings base;
+    base.points = options.points;
+    glm::mat4 view = glm::lookAt(base.center + glm::vec3(0.0f, 2.0f, 8.0f), base.center, glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)options.width / options.height, 0.1f, 100.0f);
+
+    std::ostringstream json;
+    json << "{\n"
+         << "  \"renderer\": \"" << (const char *)glGetString(GL_RENDERER) << "\",\n"
+         << "  \"tile_size\": " << GpuNBody::kTileSize << ",\n"
+         << "  \"points\": " << (options.points ? "true" : "false") << ",\n"
+         << "  \"runs\": [";
+
+    for (std::size_t c = 0; c < options.counts.size(); ++c)
+    {
+        GpuNBodySettings settings = base;
+        settings.count = options.counts[c];
+        GpuNBody gpu(settings);
+        gpu.step(); // compiles the pipeline
+        double stepMs = gpuMs(options.steps, [&]() { gpu.step(); });
+        double drawMs = gpuMs(options.steps, [&]()
+        {
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            gpu.draw(view, projection, glm::vec3(0.0f), (float)options.height);
+        });
+
+        NBodySystem cpu = cpuCopy(gpu);
+        auto start = std::chrono::steady_clock::now();
+        cpu.computeAccelerations();
+        double cpuMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        double interactions = (double)settings.count * (double)settings.count;
+        json << (c ? "," : "") << "\n    {\"bodies\": " << settings.count
+             << ", \"step_ms\": " << stepMs
+             << ", \"interactions_per_s\": " << interactions / (stepMs * 1e-3)
+             << ", \"draw_ms\": " << drawMs
+             << ", \"cpu_force_ms\": " << cpuMs
+             << ", \"cpu_kernel\": \"" << NBodySystem::kernelName(cpu.kernel()) << "\""
+             << ", \"gpu_bytes\": " << gpu.gpuBytes() << "}";
+        std::cerr << settings.count << " bodies: " << stepMs << " ms per GPU step, " << cpuMs << " ms per CPU force evaluation" << std::endl;
+    }
+
+    // Same start, same steps: float on the GPU against double on the CPU.
+    GpuNBodySettings checkSettings = base;
+    checkSettings.count = options.checkBodies;
+    GpuNBody gpu(checkSettings);
+    NBodySystem cpu = cpuCopy(gpu);
+    for (int s = 0; s < options.checkSteps; ++s)
+    {
+        gpu.step();
+        cpu.step();
+    }
+    std::vector<glm::vec4> positions, velocities;
+    gpu.read(positions, velocities);
+    double positionError = 0.0, velocityError = 0.0, speed = 0.0;
+    for (std::size_t i = 0; i < positions.size(); ++i)
+    {
+        positionError = std::max(positionError, glm::length(glm::dvec3(positions[i]) - cpu.position(i)));
+        velocityError = std::max(velocityError, glm::length(glm::dvec3(velocities[i]) - cpu.velocity(i)));
+        speed = std::max(speed, glm::length(cpu.velocity(i)));
+    }
+    // Relative to the cluster's size and fastest body.
+    positionError /= checkSettings.scaleRadius;
+    velocityError /= std::max(speed, 1e-30);
+    bool match = positionError < 1e-4 && velocityError < 1e-3;
+
+    json << "\n  ],\n"
+         << "  \"check_bodies\": " << options.checkBodies << ",\n"
+         << "  \"check_steps\": " << options.checkSteps << ",\n"
+         << "  \"max_position_error\": " << positionError << ",\n"
+         << "  \"max_velocity_error\": " << velocityError << ",\n"
+         << "  \"match\": " << (match ? "true" : "false") << "\n}\n";
+
+    if (options.out.empty())
+    {
+        std::cout << json.str();
+    }
+    else
+    {
+        std::ofstream file(options.out);
+        file << json.str();
+    }
+    return match ? 0 : 1;
+}
@@ -0,0 +1,220 @@
+// Kepler propagation benchmark: for each of --counts random elliptic orbits,
+// times one KeplerPropagator::propagate() (positions, then positions and
+// velocities) with every kernel the CPU supports, for eccentricities up to
+// 0.3 and up to 0.97, and checks each kernel against the scalar one. Also
+// checks Kepler's equation itself on the scalar solver, the velocities against
+// a finite difference of the positions, and that evaluating --jump seconds
+// ahead costs the same as at t = 0. Prints JSON; exits 1 on a mismatch.
+// Needs no GL context.
+//
+//   ./KeplerBench [--counts 10000,100000,1000000] [--repeats 5] [--threads 0]
+//                 [--max-iterations 8] [--jump 1e9] [--out result.json]
+
+#include "../include/kepler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct BenchOptions
+{
+    std::vector<std::size_t> counts = {10000, 100000, 1000000};
+    int repeats = 5;
+    unsigned int threads = 0;
+    int maxIterations = 8;
+    double jump = 1e9;
+    std::string out;
+};
+
+static BenchOptions parseArgs(int argc, char **argv)
+{
+    BenchOptions options;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::strcmp(argv[i], "--counts") == 0)
+        {
+            options.counts.clear();
+            std::stringstream list(argv[i + 1]);
+            std::string count;
+            while (std::getline(list, count, ','))
+                options.counts.push_back((std::size_t)std::strtoull(count.c_str(), nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--repeats") == 0)
+            options.repeats = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--threads") == 0)
+            options.threads = (unsigned int)std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--max-iterations") == 0)
+            options.maxIterations = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--jump") == 0)
+            options.jump = std::atof(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--out") == 0)
+            options.out = argv[i + 1];
+        else
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+    }
+    return options;
+}
+
+/** @brief Best of @p repeats runs of @p fn, in milliseconds. */
+template <typename Fn>
+static double bestMs(int repeats, Fn fn)
+{
+    double best = 1e30;
+    for (int i = 0; i < std::max(repeats, 1); ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+/** @brief Orbits of a belt between 2 and 4 units around a central gm of 1, eccentricities uniform in [0, maxEccentricity]. */
+static std::vector<OrbitalElements> randomOrbits(std::size_t count, double maxEccentricity)
+{
+    std::mt19937 random(11);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::vector<OrbitalElements> orbits(count);
+    for (OrbitalElements &orbit : orbits)
+    {
+        orbit.semiMajorAxis = 2.0 + 2.0 * unit(random);
+        orbit.eccentricity = maxEccentricity * unit(random);
+        orbit.inclination = 0.5 * unit(random);
+        orbit.ascendingNode = 6.283185307179586 * unit(random);
+        orbit.periapsis = 6.283185307179586 * unit(random);
+        orbit.meanAnomaly = 6.283185307179586 * unit(random);
+        orbit.epoch = 100.0 * unit(random);
+        orbit.meanMotion = std::sqrt(1.0 / (orbit.semiMajorAxis * orbit.semiMajorAxis * orbit.semiMajorAxis));
+    }
+    return orbits;
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions options = parseArgs(argc, argv);
+    const NBodyKernel kernels[] = {NBodyKernel::Scalar, NBodyKernel::Avx2, NBodyKernel::Avx512};
+    const double maxEccentricities[] = {0.3, 0.97};
+
+    std::ostringstream json;
+    json << "{\n"
+         << "  \"repeats\": " << options.repeats << ",\n"
+         << "  \"threads\": " << options.threads << ",\n"
+         << "  \"max_iterations\": " << options.maxIterations << ",\n"
+         << "  \"runs\": [";
+
+    bool match = true;
+    bool firstRun = true;
+    for (std::size_t count : options.counts)
+    {
+        for (double maxEccentricity : maxEccentricities)
+        {
+            std::vector<OrbitalElements> orbits = randomOrbits(count, maxEccentricity);
+            std::vector<double> x(count), y(count), z(count), vx(count), vy(count), vz(count);
+            std::vector<double> referenceX, referenceY, referenceZ;
+
+            json << (firstRun ? "" : ",") << "\n    {\"orbits\": " << count << ", \"max_eccentricity\": " << maxEccentricity << ", \"kernels\": [";
+            firstRun = false;
+            bool first = true;
+            for (NBodyKernel kernel : kernels)
+            {
+                if (!isGravityKernelSupported(kernel))
+                    continue;
+                KeplerSettings settings;
+                settings.kernel = kernel;
+                settings.threads = options.threads;
+                settings.maxIterations = options.maxIterations;
+                KeplerPropagator propagator(settings);
+                propagator.reserve(count);
+                for (const OrbitalElements &orbit : orbits)
+                    propagator.add(orbit);
+
+                double positionMs = bestMs(options.repeats, [&]() { propagator.propagate(0.0, x.data(), y.data(), z.data()); });
+                double jumpMs = bestMs(options.repeats, [&]() { propagator.propagate(options.jump, x.data(), y.data(), z.data()); });
+                double stateMs = bestMs(options.repeats, [&]() {
+                    propagator.propagate(10.0, x.data(), y.data(), z.data(), vx.data(), vy.data(), vz.data());
+                });
+
+                // Against the scalar kernel, relative to the semi-major axis.
+                double maxError = 0.0;
+                if (referenceX.empty())
+                {
+                    referenceX = x;
+                    referenceY = y;
+                    referenceZ = z;
+                }
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    double dx = x[i] - referenceX[i], dy = y[i] - referenceY[i], dz = z[i] - referenceZ[i];
+                    maxError = std::max(maxError, std::sqrt(dx * dx + dy * dy + dz * dz) / orbits[i].semiMajorAxis);
+                }
+                match = match && maxError < 1e-12;
+
+                json << (first ? "" : ",") << "\n      {\"kernel\": \"" << gravityKernelName(kernel) << "\""
+                     << ", \"position_ms\": " << positionMs
+                     << ", \"orbits_per_s\": " << count / (positionMs * 1e-3)
+                     << ", \"jump_ms\": " << jumpMs
+                     << ", \"state_ms\": " << stateMs
+                     << ", \"max_rel_error\": " << maxError << "}";
+                first = false;
+            }
+            json << "\n    ]}";
+        }
+    }
+
+    // Kepler's equation on the scalar solver, over the whole range of e.
+    std::mt19937 random(5);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    double maxResidual = 0.0;
+    for (int k = 0; k < 1000000; ++k)
+    {
+        double m = 6.283185307179586 * (unit(random) - 0.5);
+        double e = 0.99 * unit(random);
+        double E = solveKepler(m, e, options.maxIterations);
+        maxResidual = std::max(maxResidual, std::abs(E - e * std::sin(E) - m));
+    }
+    match = match && maxResidual < 1e-14;
+
+    // Velocities against a central difference of the positions.
+    std::vector<OrbitalElements> orbits = randomOrbits(1000, 0.97);
+    KeplerPropagator propagator;
+    for (const OrbitalElements &orbit : orbits)
+        propagator.add(orbit);
+    const double h = 1e-4;
+    std::vector<double> x(1000), y(1000), z(1000), vx(1000), vy(1000), vz(1000);
+    std::vector<double> x0(1000), y0(1000), z0(1000), x1(1000), y1(1000), z1(1000);
+    propagator.propagate(5.0, x.data(), y.data(), z.data(), vx.data(), vy.data(), vz.data());
+    propagator.propagate(5.0 - h, x0.data(), y0.data(), z0.data());
+    propagator.propagate(5.0 + h, x1.data(), y1.data(), z1.data());
+    double maxVelocityError = 0.0;
+    for (std::size_t i = 0; i < orbits.size(); ++i)
+    {
+        glm::dvec3 velocity(vx[i], vy[i], vz[i]);
+        glm::dvec3 difference = glm::dvec3(x1[i] - x0[i], y1[i] - y0[i], z1[i] - z0[i]) / (2.0 * h);
+        maxVelocityError = std::max(maxVelocityError, glm::length(velocity - difference) / glm::length(velocity));
+    }
+    match = match && maxVelocityError < 1e-6;
+
+    json << "\n  ],\n"
+         << "  \"max_kepler_residual\": " << maxResidual << ",\n"
+         << "  \"max_velocity_rel_error\": " << maxVelocityError << ",\n"
+         << "  \"match\": " << (match ? "true" : "false") << "\n}\n";
+
+    if (options.out.empty())
+    {
+        std::cout << json.str();
+    }
+    else
+    {
+        std::ofstream file(options.out);
+        file << json.str();
+    }
+    return match ? 0 : 1;
+}
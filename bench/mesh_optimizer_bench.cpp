@@ -0,0 +1,201 @@
+// Mesh optimizer benchmark: builds the UV sphere at several tessellations in
+// three forms -- as generated (ring-by-ring list with pole degenerates),
+// optimized triangle list, optimized triangle strips with primitive restart --
+// and prints, per form, the simulated post-transform cache efficiency
+// (ACMR/ATVR, FIFO cache) and the measured GPU/CPU time of a draw, as JSON.
+//
+// Run from the repository root (shaders/ are loaded relative to it):
+//   ./MeshOptimizerBench [--draws 50] [--rounds 5] [--cache 16] [--width 512] [--height 512] [--out result.json]
+
+#include "../include/glad/glad.h"
+#include "../include/headless_context.h"
+#include "../include/mesh_optimizer.h"
+#include "../include/planet.h"
+#include "../include/shader.h"
+#include "glm/glm/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct BenchOptions
+{
+    int draws = 50;
+    int rounds = 5;
+    int cacheSize = 16;
+    int width = 512;
+    int height = 512;
+    std::string out;
+};
+
+static BenchOptions parseArgs(int argc, char **argv)
+{
+    BenchOptions options;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::strcmp(argv[i], "--draws") == 0)
+            options.draws = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--rounds") == 0)
+            options.rounds = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--cache") == 0)
+            options.cacheSize = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--width") == 0)
+            options.width = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--height") == 0)
+            options.height = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--out") == 0)
+            options.out = argv[i + 1];
+        else
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+    }
+    return options;
+}
+
+struct DrawTiming
+{
+    double gpuMs = 0.0; // median over rounds, per draw
+    double cpuMs = 0.0; // wall time including glFinish, per draw
+};
+
+/** @brief Draws @p mesh options.draws times per round and returns the median per-draw time. */
+static DrawTiming timeDraws(Planet &mesh, const BenchOptions &options)
+{
+    GLuint query;
+    glGenQueries(1, &query);
+
+    // One warm-up round so shader/driver setup isn't measured.
+    for (int i = 0; i < options.draws; ++i)
+        mesh.draw();
+    glFinish();
+
+    std::vector<double> gpu, cpu;
+    for (int round = 0; round < options.rounds; ++round)
+    {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glFinish();
+
+        auto cpuStart = std::chrono::steady_clock::now();
+        glBeginQuery(GL_TIME_ELAPSED, query);
+        for (int i = 0; i < options.draws; ++i)
+            mesh.draw();
+        glEndQuery(GL_TIME_ELAPSED);
+        glFinish();
+        auto cpuEnd = std::chrono::steady_clock::now();
+
+        GLuint64 elapsedNs = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsedNs);
+        gpu.push_back(elapsedNs / 1.0e6 / options.draws);
+        cpu.push_back(std::chrono::duration<double, std::milli>(cpuEnd - cpuStart).count() / options.draws);
+    }
+    glDeleteQueries(1, &query);
+
+    std::sort(gpu.begin(), gpu.end());
+    std::sort(cpu.begin(), cpu.end());
+    DrawTiming timing;
+    timing.gpuMs = gpu[gpu.size() / 2];
+    timing.cpuMs = cpu[cpu.size() / 2];
+    return timing;
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions options = parseArgs(argc, argv);
+    if (options.rounds < 1)
+        options.rounds = 1;
+
+    HeadlessContext context(options.width, options.height);
+    if (!context.isValid())
+        return -1;
+
+    glEnable(GL_DEPTH_TEST);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+    // The sun's shader: position + texcoord only, so the draw cost is dominated
+    // by vertex work and rasterization rather than lighting.
+    Shader shader("shaders/emissive.vert", "shaders/emissive.frag");
+    shader.use();
+    shader.setBool("compactVertices", false);
+    shader.setBool("instanced", false);
+    shader.setInt("bodyTextures", 0);
+    shader.setMat4("model", glm::mat4(1.0f));
+    shader.setMat4("view", glm::lookAt(glm::vec3(0.0f, 0.5f, 3.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+    shader.setMat4("projection", glm::perspective(glm::radians(45.0f), (float)options.width / options.height, 0.1f, 100.0f));
+
+    struct Variant
+    {
+        const char *name;
+        bool optimize;
+        bool strips;
+    };
+    const Variant variants[] = {
+        {"original", false, false},
+        {"optimized", true, false},
+        {"optimized_strips", true, true},
+    };
+    const unsigned int tessellations[] = {16, 32, 64, 128, 256};
+
+    std::ostringstream json;
+    json << "{\n"
+         << "  \"renderer\": \"" << (const char *)glGetString(GL_RENDERER) << "\",\n"
+         << "  \"width\": " << options.width << ",\n"
+         << "  \"height\": " << options.height << ",\n"
+         << "  \"draws\": " << options.draws << ",\n"
+         << "  \"rounds\": " << options.rounds << ",\n"
+         << "  \"fifo_cache_size\": " << options.cacheSize << ",\n"
+         << "  \"meshes\": [";
+
+    bool first = true;
+    for (unsigned int n : tessellations)
+    {
+        for (const Variant &variant : variants)
+        {
+            MeshOptions meshOptions;
+            meshOptions.optimize = variant.optimize;
+            meshOptions.triangleStrips = variant.strips;
+
+            auto buildStart = std::chrono::steady_clock::now();
+            MeshData mesh = generateUVSphere(1.0f, n, n);
+            prepareMesh(mesh, meshOptions);
+            double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+
+            MeshOptimizer::CacheStats cache = mesh.primitiveMode == GL_TRIANGLE_STRIP
+                ? MeshOptimizer::analyzeStripVertexCache(mesh.indices, mesh.positions.size(), mesh.restartIndex, options.cacheSize)
+                : MeshOptimizer::analyzeVertexCache(mesh.indices, mesh.positions.size(), options.cacheSize);
+
+            Planet planet(mesh, VertexFormat::Standard);
+            DrawTiming timing = timeDraws(planet, options);
+
+            json << (first ? "\n" : ",\n")
+                 << "    {\"rings\": " << n << ", \"sectors\": " << n
+                 << ", \"variant\": \"" << variant.name << "\""
+                 << ", \"vertices\": " << planet.getVertexCount()
+                 << ", \"indices\": " << planet.getIndexCount()
+                 << ", \"triangles\": " << planet.getTriangleCount()
+                 << ", \"index_bytes\": " << planet.getIndexCount() * (planet.getIndexType() == GL_UNSIGNED_SHORT ? 2 : 4)
+                 << ", \"acmr\": " << cache.acmr
+                 << ", \"atvr\": " << cache.atvr
+                 << ", \"build_ms\": " << buildMs
+                 << ", \"gpu_draw_ms\": " << timing.gpuMs
+                 << ", \"cpu_draw_ms\": " << timing.cpuMs << "}";
+            first = false;
+        }
+    }
+    json << "\n  ]\n}\n";
+
+    if (options.out.empty())
+    {
+        std::cout << json.str();
+    }
+    else
+    {
+        std::ofstream file(options.out);
+        file << json.str();
+    }
+    return 0;
+}
@@ -0,0 +1,194 @@
+// N-body benchmark: times one direct-summation force evaluation
+// (NBodySystem::computeAccelerations()) of --counts bodies, all massive (a
+// central mass and a disk on circular orbits around it), with every kernel
+// the CPU supports, checks each against the scalar one, then integrates a
+// small disk for --steps steps with both integrators and reports the energy
+// drift. Prints JSON. Needs no GL context.
+//
+//   ./NBodyBench [--counts 1024,4096,16384] [--repeats 5] [--threads 0]
+//                [--drift-bodies 64] [--steps 2000] [--dt 0.002] [--out result.json]
+
+#include "../include/nbody.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct BenchOptions
+{
+    std::vector<std::size_t> counts = {1024, 4096, 16384};
+    int repeats = 5;
+    unsigned int threads = 0;
+    std::size_t driftBodies = 64;
+    int steps = 2000;
+    double dt = 0.002;
+    std::string out;
+};
+
+static BenchOptions parseArgs(int argc, char **argv)
+{
+    BenchOptions options;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::strcmp(argv[i], "--counts") == 0)
+        {
+            options.counts.clear();
+            std::stringstream list(argv[i + 1]);
+            std::string count;
+            while (std::getline(list, count, ','))
+                options.counts.push_back((std::size_t)std::strtoull(count.c_str(), nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--repeats") == 0)
+            options.repeats = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--threads") == 0)
+            options.threads = (unsigned int)std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--drift-bodies") == 0)
+            options.driftBodies = (std::size_t)std::strtoull(argv[i + 1], nullptr, 10);
+        else if (std::strcmp(argv[i], "--steps") == 0)
+            options.steps = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--dt") == 0)
+            options.dt = std::atof(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--out") == 0)
+            options.out = argv[i + 1];
+        else
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+    }
+    return options;
+}
+
+/** @brief A central mass of gm 1 and count - 1 light bodies on circular orbits between r = 1 and 5. */
+static void buildDisk(NBodySystem &system, std::size_t count)
+{
+    std::mt19937 random(7);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    double diskGm = 1e-3 / (double)std::max<std::size_t>(count, 1);
+    system.clear();
+    system.add(glm::dvec3(0.0), glm::dvec3(0.0), 1.0);
+    for (std::size_t i = 1; i < count; ++i)
+    {
+        double r = 1.0 + 4.0 * unit(random);
+        double angle = 6.283185307179586 * unit(random);
+        double speed = std::sqrt(1.0 / r);
+        glm::dvec3 position(r * std::cos(angle), 0.02 * (unit(random) - 0.5), r * std::sin(angle));
+        glm::dvec3 velocity(-speed * std::sin(angle), 0.0, speed * std::cos(angle));
+        system.add(position, velocity, diskGm);
+    }
+}
+
+/** @brief Best of @p repeats runs of @p fn, in milliseconds. */
+template <typename Fn>
+static double bestMs(int repeats, Fn fn)
+{
+    double best = 1e30;
+    for (int i = 0; i < std::max(repeats, 1); ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions options = parseArgs(argc, argv);
+    const NBodyKernel kernels[] = {NBodyKernel::Scalar, NBodyKernel::Avx2, NBodyKernel::Avx512};
+
+    std::ostringstream json;
+    json << "{\n"
+         << "  \"repeats\": " << options.repeats << ",\n"
+         << "  \"threads\": " << options.threads << ",\n"
+         << "  \"forces\": [";
+    bool match = true;
+    for (std::size_t c = 0; c < options.counts.size(); ++c)
+    {
+        std::size_t count = std::max<std::size_t>(options.counts[c], 2);
+        json << (c ? "," : "") << "\n    {\"bodies\": " << count << ", \"kernels\": [";
+
+        std::vector<glm::dvec3> reference;
+        bool first = true;
+        for (NBodyKernel kernel : kernels)
+        {
+            if (!NBodySystem::isSupported(kernel))
+                continue;
+            NBodySettings settings;
+            settings.kernel = kernel;
+            settings.threads = options.threads;
+            NBodySystem system(settings);
+            buildDisk(system, count);
+            double ms = bestMs(options.repeats, [&]() { system.computeAccelerations(); });
+
+            // Relative to the largest acceleration, so bodies near the balance point of the disk do not dominate.
+            double maxError = 0.0, scale = 0.0;
+            if (reference.empty())
+            {
+                for (std::size_t i = 0; i < count; ++i)
+                    reference.push_back(system.acceleration(i));
+            }
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                scale = std::max(scale, glm::length(reference[i]));
+                maxError = std::max(maxError, glm::length(system.acceleration(i) - reference[i]));
+            }
+            double relativeError = scale > 0.0 ? maxError / scale : 0.0;
+            match = match && relativeError < 1e-12;
+
+            json << (first ? "" : ",") << "\n      {\"kernel\": \"" << NBodySystem::kernelName(kernel) << "\""
+                 << ", \"ms\": " << ms
+                 << ", \"minteractions_per_s\": " << system.interactionsPerEvaluation() / (ms * 1000.0)
+                 << ", \"max_rel_error\": " << relativeError << "}";
+            first = false;
+        }
+        json << "\n    ]}";
+    }
+    json << "\n  ],\n  \"drift\": [";
+
+    const NBodyIntegrator integrators[] = {NBodyIntegrator::Leapfrog, NBodyIntegrator::Yoshida4};
+    for (int k = 0; k < 2; ++k)
+    {
+        NBodySettings settings;
+        settings.integrator = integrators[k];
+        settings.dt = options.dt;
+        settings.softening = 0.01; // disk bodies pass close to each other
+        settings.threads = options.threads;
+        NBodySystem system(settings);
+        buildDisk(system, options.driftBodies);
+        double maxDrift = 0.0;
+        auto start = std::chrono::steady_clock::now();
+        for (int step = 0; step < options.steps; ++step)
+        {
+            system.step();
+            if ((step + 1) % 100 == 0 || step + 1 == options.steps)
+                maxDrift = std::max(maxDrift, system.energyDrift());
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        json << (k ? "," : "") << "\n    {\"integrator\": \"" << (k ? "yoshida4" : "leapfrog") << "\""
+             << ", \"bodies\": " << system.size()
+             << ", \"steps\": " << options.steps
+             << ", \"dt\": " << options.dt
+             << ", \"ms\": " << ms
+             << ", \"final_energy_drift\": " << system.energyDrift()
+             << ", \"max_energy_drift\": " << maxDrift << "}";
+    }
+    json << "\n  ],\n  \"match\": " << (match ? "true" : "false") << "\n}\n";
+
+    if (options.out.empty())
+    {
+        std::cout << json.str();
+    }
+    else
+    {
+        std::ofstream file(options.out);
+        file << json.str();
+    }
+    return match ? 0 : 1;
+}
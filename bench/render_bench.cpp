@@ -0,0 +1,297 @@
+// Headless render benchmark: draws the full sun/earth/moon/orbit/skybox frame
+// into an offscreen framebuffer for a fixed number of frames at a fixed
+// simulated time step and prints frame-time percentiles as JSON.
+//
+// Run from the repository root (shaders/ and textures/ are loaded relative to it):
+//   ./RenderBench --frames 600 --warmup 60 --dt 0.016667 --width 1280 --height 720 [--out result.json]
+//                 [--trace trace.json]   (CPU zones; build with -DENABLE_PROFILER)
+//                 [--gl-stats 1]         (per-frame GL call accounting, adds "gl_calls" to the JSON)
+//                 [--compact-vertices 1] (8-byte octahedral/unorm16 sphere vertices instead of 32-byte floats)
+//                 [--optimize-mesh 0]    (keep the generator's ring-by-ring triangle order and pole degenerates)
+//                 [--strips 1]           (sphere meshes as triangle strips with primitive restart)
+//                 [--lod 0]              (always draw the finest sphere mesh instead of per-body LOD selection)
+//                 [--lod-error-px 0.5]   (LOD silhouette error budget in pixels)
+//                 [--orbit-error-px 0.5] (orbit line tessellation error budget in pixels)
+//                 [--instancing 0]       (one draw call per body instead of one instanced draw per sphere mesh)
+//                 [--satellites 0]       (extra small bodies orbiting the Earth)
+//                 [--gpu-driven 1]       (compute-shader culling + multi-draw-indirect on GL 4.3+; 0: CPU path)
+//                 [--asteroids 0]        (rocks in an instanced asteroid belt, see bench/asteroid_bench.cpp)
+//                 [--catalog MPCORB.DAT] (the belt's rocks are that catalog's minor planets, the first --asteroids if given)
+//                 [--nbody 0]            (move the bodies by N-body gravity instead of analytic orbits, see bench/nbody_bench.cpp)
+//                 [--gpu-nbody 0]        (bodies in a star cluster integrated by a compute shader on GL 4.3+, see bench/gpu_nbody_bench.cpp)
+//                 [--ephemeris de440.bin] (place the planets, Sun and Moon from a JPL DE file instead of analytic orbits)
+//                 [--tle active.txt]     (draw a TLE catalogue's satellites around the Earth with SGP4, see bench/sgp4_bench.cpp)
+
+#include "../include/glad/glad.h"
+#include "../include/camera.h"
+#include "../include/catalog.h"
+#include "../include/frame_stats.h"
+#include "../include/gl_stats.h"
+#include "../include/gpu_timer.h"
+#include "../include/headless_context.h"
+#include "../include/profiler.h"
+#include "../include/renderer.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+struct BenchOptions
+{
+    int frames = 600;
+    int warmup = 60;
+    float dt = 1.0f / 60.0f;
+    int width = 1280;
+    int height = 720;
+    std::string out;
+    std::string trace;
+    bool glStats = false;
+    bool compactVertices = false;
+    bool optimizeMesh = true;
+    bool strips = false;
+    bool lod = true;
+    float lodErrorPx = 0.5f;
+    float orbitErrorPx = 0.5f;
+    bool instancing = true;
+    int satellites = 0;
+    bool gpuDriven = true;
+    int asteroids = 0;
+    std::string catalog;
+    bool nbody = false;
+    int gpuNBody = 0;
+    std::string ephemeris;
+    std::string tle;
+};
+
+static BenchOptions parseArgs(int argc, char **argv)
+{
+    BenchOptions options;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::strcmp(argv[i], "--frames") == 0)
+            options.frames = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--warmup") == 0)
+            options.warmup = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--dt") == 0)
+            options.dt = (float)std::atof(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--width") == 0)
+            options.width = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--height") == 0)
+            options.height = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--out") == 0)
+            options.out = argv[i + 1];
+        else if (std::strcmp(argv[i], "--trace") == 0)
+            options.trace = argv[i + 1];
+        else if (std::strcmp(argv[i], "--gl-stats") == 0)
+            options.glStats = std::atoi(argv[i + 1]) != 0;
+        else if (std::strcmp(argv[i], "--compact-vertices") == 0)
+            options.compactVertices = std::atoi(argv[i + 1]) != 0;
+        else if (std::strcmp(argv[i], "--optimize-mesh") == 0)
+            options.optimizeMesh = std::atoi(argv[i + 1]) != 0;
+        else if (std::strcmp(argv[i], "--strips") == 0)
+            options.strips = std::atoi(argv[i + 1]) != 0;
+        else if (std::strcmp(argv[i], "--lod") == 0)
+            options.lod = std::atoi(argv[i + 1]) != 0;
+        else if (std::strcmp(argv[i], "--lod-error-px") == 0)
+            options.lodErrorPx = (float)std::atof(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--orbit-error-px") == 0)
+            options.orbitErrorPx = (float)std::atof(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--instancing") == 0)
+            options.instancing = std::atoi(argv[i + 1]) != 0;
+        else if (std::strcmp(argv[i], "--satellites") == 0)
+            options.satellites = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--gpu-driven") == 0)
+            options.gpuDriven = std::atoi(argv[i + 1]) != 0;
+        else if (std::strcmp(argv[i], "--asteroids") == 0)
+            options.asteroids = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--catalog") == 0)
+            options.catalog = argv[i + 1];
+        else if (std::strcmp(argv[i], "--nbody") == 0)
+            options.nbody = std::atoi(argv[i + 1]) != 0;
+        else if (std::strcmp(argv[i], "--gpu-nbody") == 0)
+            options.gpuNBody = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--ephemeris") == 0)
+            options.ephemeris = argv[i + 1];
+        else if (std::strcmp(argv[i], "--tle") == 0)
+            options.tle = argv[i + 1];
+        else
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+    }
+    return options;
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions options = parseArgs(argc, argv);
+    PROFILE_THREAD_NAME("Main");
+
+    // 4.3 for the GPU-driven path; drivers without it still run the 3.3 one.
+    std::unique_ptr<HeadlessContext> context(new HeadlessContext(options.width, options.height, 4, 3));
+    if (!context->isValid())
+    {
+        context.reset();
+        context.reset(new HeadlessContext(options.width, options.height));
+    }
+    if (!context->isValid())
+        return -1;
+
+    if (options.glStats)
+        GLStats::install();
+
+    glEnable(GL_DEPTH_TEST);
+
+    FrameStats stats;
+    bool gpuDriven = false;
+    Catalog catalog;
+    CatalogLoadStats catalogStats;
+    int ephemerisNumber = 0;
+    std::size_t tleSatellites = 0;
+    {
+        MeshOptions meshOptions;
+        meshOptions.format = options.compactVertices ? VertexFormat::Compact : VertexFormat::Standard;
+        meshOptions.optimize = options.optimizeMesh;
+        meshOptions.triangleStrips = options.strips;
+        Renderer renderer(meshOptions);
+        LodSettings lodSettings;
+        lodSettings.enabled = options.lod;
+        lodSettings.maxErrorPx = options.lodErrorPx;
+        renderer.setLodSettings(lodSettings);
+        OrbitLineSettings orbitSettings;
+        orbitSettings.maxErrorPx = options.orbitErrorPx;
+        renderer.setOrbitLineSettings(orbitSettings);
+        renderer.setInstancing(options.instancing);
+        renderer.setGpuDriven(options.gpuDriven);
+        gpuDriven = renderer.isGpuDriven();
+        if (options.satellites > 0)
+            renderer.addEarthSatellites((unsigned int)options.satellites);
+        if (options.nbody)
+        {
+            NBodySettings nbodySettings;
+            nbodySettings.enabled = true;
+            renderer.setNBody(nbodySettings);
+        }
+        if (!options.catalog.empty())
+        {
+            if (!loadCatalog(options.catalog, catalog, CatalogSettings(), &catalogStats))
+                return -1;
+            AsteroidBeltSettings beltSettings;
+            beltSettings.count = options.asteroids > 0 ? (unsigned int)options.asteroids : (unsigned int)catalog.size();
+            beltSettings.catalog = &catalog;
+            renderer.setAsteroidBelt(beltSettings);
+        }
+        else if (options.asteroids > 0)
+        {
+            AsteroidBeltSettings beltSettings;
+            beltSettings.count = (unsigned int)options.asteroids;
+            renderer.setAsteroidBelt(beltSettings);
+        }
+        if (options.gpuNBody > 0)
+        {
+            GpuNBodySettings clusterSettings;
+            clusterSettings.count = (unsigned int)options.gpuNBody;
+            renderer.setGpuNBody(clusterSettings);
+        }
+        if (!options.ephemeris.empty())
+        {
+            if (!renderer.setEphemeris(options.ephemeris))
+                return -1;
+            ephemerisNumber = renderer.getEphemeris()->number();
+        }
+        if (!options.tle.empty())
+        {
+            if (!renderer.setSatelliteSwarm(options.tle))
+                return -1;
+            tleSatellites = renderer.getSatelliteSwarm()->size();
+        }
+        Camera camera(glm::vec3(0.0f, 5.0f, 20.0f));
+        SimulationState sim;
+        float aspect = (float)options.width / options.height;
+
+        // Per-pass GPU times are read back a few frames late so the CPU never waits on the GPU.
+        GpuTimer gpuTimer(&stats);
+        renderer.setGpuTimer(&gpuTimer);
+
+        int totalFrames = options.warmup + options.frames;
+        for (int frame = 0; frame < totalFrames; ++frame)
+        {
+            PROFILE_ZONE("Frame");
+            bool measured = frame >= options.warmup;
+            if (frame == options.warmup)
+                GLStats::resetTotals();
+
+            auto cpuStart = std::chrono::steady_clock::now();
+            gpuTimer.beginFrame(measured);
+            GLStats::beginFrame();
+            renderer.setFrameStats(measured ? &stats : nullptr);
+
+            renderer.renderFrame(camera, sim, frame * options.dt, aspect);
+
+            gpuTimer.endFrame();
+            glFlush();
+            auto cpuEnd = std::chrono::steady_clock::now();
+            GLStats::endFrame(measured ? &stats : nullptr);
+
+            if (measured)
+                stats.record("cpu_frame_ms", std::chrono::duration<double, std::milli>(cpuEnd - cpuStart).count());
+        }
+        gpuTimer.flush();
+        renderer.setGpuTimer(nullptr);
+        renderer.setFrameStats(nullptr);
+
+        if (gpuTimer.droppedFrames() > 0)
+            std::cerr << gpuTimer.droppedFrames() << " frames of GPU timings were not ready in time and were dropped" << std::endl;
+    }
+
+    if (!options.trace.empty() && !Profiler::writeChromeTrace(options.trace))
+        std::cerr << "CPU trace not written (build with -DENABLE_PROFILER)" << std::endl;
+
+    std::ostringstream json;
+    json << "{\n"
+         << "  \"renderer\": \"" << (const char *)glGetString(GL_RENDERER) << "\",\n"
+         << "  \"width\": " << options.width << ",\n"
+         << "  \"height\": " << options.height << ",\n"
+         << "  \"frames\": " << options.frames << ",\n"
+         << "  \"warmup\": " << options.warmup << ",\n"
+         << "  \"dt\": " << options.dt << ",\n"
+         << "  \"compact_vertices\": " << (options.compactVertices ? "true" : "false") << ",\n"
+         << "  \"optimize_mesh\": " << (options.optimizeMesh ? "true" : "false") << ",\n"
+         << "  \"strips\": " << (options.strips ? "true" : "false") << ",\n"
+         << "  \"lod\": " << (options.lod ? "true" : "false") << ",\n"
+         << "  \"lod_error_px\": " << options.lodErrorPx << ",\n"
+         << "  \"orbit_error_px\": " << options.orbitErrorPx << ",\n"
+         << "  \"instancing\": " << (options.instancing ? "true" : "false") << ",\n"
+         << "  \"satellites\": " << options.satellites << ",\n"
+         << "  \"gpu_driven\": " << (gpuDriven ? "true" : "false") << ",\n"
+         << "  \"asteroids\": " << options.asteroids << ",\n"
+         << "  \"catalog_orbits\": " << catalog.size() << ",\n"
+         << "  \"catalog_load_ms\": " << catalogStats.ms << ",\n"
+         << "  \"catalog_from_image\": " << (catalogStats.fromImage ? "true" : "false") << ",\n"
+         << "  \"nbody\": " << (options.nbody ? "true" : "false") << ",\n"
+         << "  \"gpu_nbody\": " << options.gpuNBody << ",\n"
+         << "  \"ephemeris_de\": " << ephemerisNumber << ",\n"
+         << "  \"tle_satellites\": " << tleSatellites << ",\n"
+         << "  \"stats\": ";
+    stats.writeJson(json);
+    if (GLStats::isInstalled())
+    {
+        json << ",\n  \"gl_calls\": ";
+        GLStats::writeJson(json);
+    }
+    json << "\n}\n";
+
+    if (options.out.empty())
+    {
+        std::cout << json.str();
+    }
+    else
+    {
+        std::ofstream file(options.out);
+        file << json.str();
+    }
+    return 0;
+}
@@ -0,0 +1,424 @@
+// SGP4 benchmark: checks Sgp4Propagator against the published test cases
+// (Vallado et al.'s 00005, and the resonant deep-space 08195 and 14128, to
+// the last printed digit; Spacetrack Report #3's 88888 and 11801, whose
+// older constants put them within 0.05 km), then
+// writes a synthetic three-line file of --satellites element sets (LEO, MEO,
+// GEO, Molniya and transfer orbits, with one malformed pair), loads it with
+// loadTwoLineElements() and times propagate() with every kernel the CPU
+// supports, checking each against the scalar one. Then times update() with
+// a --budget-ms budget frame after frame, positions() along the fitted
+// orbits, and how far those drift from a full solve 1 and 10 minutes later.
+// Prints JSON; exits 1 on a mismatch. Needs no GL context.
+//
+//   ./Sgp4Bench [--satellites 30000] [--repeats 5] [--threads 0] [--budget-ms 2]
+//               [--frames 60] [--dir /tmp] [--keep 0] [--out result.json]
+
+#include "../include/sgp4.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct BenchOptions
+{
+    std::size_t satellites = 30000;
+    int repeats = 5;
+    unsigned int threads = 0;
+    double budgetMs = 2.0;
+    int frames = 60;
+    std::string dir = "/tmp";
+    bool keep = false;
+    std::string out;
+};
+
+static BenchOptions parseArgs(int argc, char **argv)
+{
+    BenchOptions options;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::strcmp(argv[i], "--satellites") == 0)
+            options.satellites = (std::size_t)std::strtoull(argv[i + 1], nullptr, 10);
+        else if (std::strcmp(argv[i], "--repeats") == 0)
+            options.repeats = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--threads") == 0)
+            options.threads = (unsigned int)std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--budget-ms") == 0)
+            options.budgetMs = std::atof(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--frames") == 0)
+            options.frames = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--dir") == 0)
+            options.dir = argv[i + 1];
+        else if (std::strcmp(argv[i], "--keep") == 0)
+            options.keep = std::atoi(argv[i + 1]) != 0;
+        else if (std::strcmp(argv[i], "--out") == 0)
+            options.out = argv[i + 1];
+        else
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+    }
+    return options;
+}
+
+/** @brief Best of @p repeats runs of @p fn, in milliseconds. */
+template <typename Fn>
+static double bestMs(int repeats, Fn fn)
+{
+    double best = 1e30;
+    for (int i = 0; i < std::max(repeats, 1); ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+struct ReferenceCase
+{
+    const char *line1;
+    const char *line2;
+    double tolerance; // km
+    struct
+    {
+        double minutes, x, y, z;
+    } states[5];
+    int stateCount;
+};
+
+// Vallado et al. 2006 (tcppver.out) for 00005, 08195 (SDP4, half-day resonance) and 14128 (SDP4, one-day
+// resonance); Spacetrack Report #3 for 88888 (SGP4) and 11801 (SDP4).
+static const ReferenceCase kReferenceCases[] = {
+    {"1 00005U 58002B   00179.78495062  .00000023  00000-0  28098-4 0  4753",
+     "2 00005  34.2682 348.7242 1859667 331.7664  19.3264 10.82419157413667",
+     1e-5,
+     {{0.0, 7022.46529266, -1400.08296755, 0.03995155},
+      {360.0, -7154.03120202, -3783.17682504, -3536.19412294},
+      {720.0, -7134.59340119, 6531.68641334, 3260.27186483}},
+     3},
+    {"1 88888U          80275.98708465  .00073094  13844-3  66816-4 0    8",
+     "2 88888  72.8435 115.9689 0086731  52.6988 110.5714 16.05824518  105",
+     0.05,
+     {{0.0, 2328.97048951, -5995.22076416, 1719.97067261},
+      {360.0, 2456.10705566, -6071.93853760, 1222.89727783},
+      {720.0, 2567.56195068, -6112.50384522, 713.96397400},
+      {1080.0, 2663.09078980, -6115.48229980, 196.39640427},
+      {1440.0, 2742.55133057, -6079.67144775, -326.38095856}},
+     5},
+    {"1 11801U          80230.29629788  .01431103  00000-0  14311-1       13",
+     "2 11801  46.7916 230.4354 7318036  47.4722  10.4117  2.28537848    13",
+     0.05,
+     {{0.0, 7473.37066650, 428.95261765, 5828.74786377},
+      {360.0, -3305.22537232, 32410.86328125, -24697.17675781}},
+     2},
+    {"1 08195U 75081A   06176.33215444  .00000099  00000-0  11873-3 0   813",
+     "2 08195  64.1586 279.0717 6877146 264.7651  20.2257  2.00491383225656",
+     1e-5,
+     {{0.0, 2349.89483350, -14785.93811562, 0.02119378}},
+     1},
+    {"1 14128U 83058A   06176.02844893 -.00000158  00000-0  10000-3 0  9627",
+     "2 14128  11.4384  35.2134 0011562  26.4582 333.5652  0.98870114 46093",
+     1e-5,
+     {{0.0, 34747.57932696, 24502.37114079, -1.32832986},
+      {120.0, 18263.33439094, 38159.96004751, 4186.18304085}},
+     2},
+};
+
+/** @brief Appends the modulo-10 checksum to a 68-column element line. */
+static void appendChecksum(char *line)
+{
+    int sum = 0;
+    for (int i = 0; i < 68; ++i)
+        sum += line[i] == '-' ? 1 : (line[i] >= '0' && line[i] <= '9' ? line[i] - '0' : 0);
+    line[68] = (char)('0' + sum % 10);
+    line[69] = '\0';
+}
+
+/**
+ * @brief Writes @p count three-line element sets: 70% LEO, 10% MEO, 10% GEO,
+ * 5% Molniya and 5% geostationary transfer orbits, epochs over ten days of
+ * 2024, and one malformed pair after the first set.
+ */
+static bool writeElementFile(const std::string &path, std::size_t count)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    std::mt19937 random(3);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    char line1[80], line2[80];
+    for (std::size_t k = 0; k < count; ++k)
+    {
+        double kind = unit(random), inclination, eccentricity, revolutionsPerDay;
+        if (kind < 0.7)
+        {
+            inclination = 100.0 * unit(random);
+            eccentricity = 0.01 * unit(random);
+            revolutionsPerDay = 13.0 + 3.0 * unit(random);
+        }
+        else if (kind < 0.8)
+        {
+            inclination = 50.0 + 10.0 * unit(random);
+            eccentricity = 0.02 * unit(random);
+            revolutionsPerDay = 1.8 + 0.5 * unit(random);
+        }
+        else if (kind < 0.9)
+        {
+            inclination = 5.0 * unit(random);
+            eccentricity = 0.001 * unit(random);
+            revolutionsPerDay = 0.99 + 0.03 * unit(random);
+        }
+        else if (kind < 0.95)
+        {
+            inclination = 62.0 + 3.0 * unit(random);
+            eccentricity = 0.68 + 0.06 * unit(random);
+            revolutionsPerDay = 2.0 + 0.02 * unit(random);
+        }
+        else
+        {
+            inclination = 5.0 + 25.0 * unit(random);
+            eccentricity = 0.70 + 0.04 * unit(random);
+            revolutionsPerDay = 2.1 + 0.2 * unit(random);
+        }
+        int catalogNumber = (int)(k % 99999) + 1;
+        std::snprintf(line1, sizeof(line1), "1 %05dU 24001A   24%012.8f  .00000000  00000-0  %05d-4 0  999 ",
+                      catalogNumber, 270.0 + 10.0 * unit(random), (int)(10000.0 + 80000.0 * unit(random)));
+        std::snprintf(line2, sizeof(line2), "2 %05d %8.4f %8.4f %07d %8.4f %8.4f %11.8f%5d ",
+                      catalogNumber, inclination, 360.0 * unit(random), (int)(eccentricity * 1e7),
+                      360.0 * unit(random), 360.0 * unit(random), revolutionsPerDay, 1000);
+        appendChecksum(line1);
+        appendChecksum(line2);
+        file << "0 SAT " << k << "\n" << line1 << "\n" << line2 << "\n";
+        if (k == 0)
+            file << "1 99999U 24001A   24BAD.00000000  .00000000  00000-0  00000-0 0  9990\n"
+                 << "2 99999   0.0000   0.0000 0000000   0.0000   0.0000  1.00000000    10\n";
+    }
+    return (bool)file;
+}
+
+/** @brief Distance between states @p a and @p b of satellite @p i, with NaN against NaN as 0 and NaN against a number as infinity. */
+static double distance(const std::vector<double> *a, const std::vector<double> *b, std::size_t i)
+{
+    double d2 = 0.0;
+    bool aNaN = false, bNaN = false;
+    for (int c = 0; c < 3; ++c)
+    {
+        aNaN = aNaN || std::isnan(a[c][i]);
+        bNaN = bNaN || std::isnan(b[c][i]);
+        d2 += (a[c][i] - b[c][i]) * (a[c][i] - b[c][i]);
+    }
+    if (aNaN || bNaN)
+        return aNaN == bNaN ? 0.0 : INFINITY;
+    return std::sqrt(d2);
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions options = parseArgs(argc, argv);
+    const NBodyKernel kernels[] = {NBodyKernel::Scalar, NBodyKernel::Avx2, NBodyKernel::Avx512};
+    bool match = true;
+
+    std::ostringstream json;
+    json << "{\n"
+         << "  \"satellites\": " << options.satellites << ",\n"
+         << "  \"repeats\": " << options.repeats << ",\n"
+         << "  \"threads\": " << options.threads << ",\n"
+         << "  \"budget_ms\": " << options.budgetMs << ",\n"
+         << "  \"reference\": [";
+
+    // The published test cases, on every kernel.
+    bool firstCase = true;
+    for (const ReferenceCase &reference : kReferenceCases)
+    {
+        TwoLineElements elements;
+        bool parsed = parseTwoLineElements(reference.line1, reference.line2, elements);
+        double maxError = parsed ? 0.0 : INFINITY;
+        for (NBodyKernel kernel : kernels)
+        {
+            if (!parsed || !isGravityKernelSupported(kernel))
+                continue;
+            Sgp4Settings settings;
+            settings.kernel = kernel;
+            Sgp4Propagator propagator(settings);
+            if (!propagator.add(elements))
+            {
+                maxError = INFINITY;
+                continue;
+            }
+            for (int s = 0; s < reference.stateCount; ++s)
+            {
+                // A Julian date holds a time to about 40 microseconds only, which moves a satellite by
+                // up to 0.2 m; step the solution back over the rounding so only SGP4's error is left.
+                double jd = elements.epochJd + reference.states[s].minutes / 1440.0;
+                double rounding = ((jd - elements.epochJd) * 1440.0 - reference.states[s].minutes) * 60.0;
+                double x, y, z, vx, vy, vz;
+                propagator.propagate(jd, &x, &y, &z, &vx, &vy, &vz);
+                x -= vx * rounding;
+                y -= vy * rounding;
+                z -= vz * rounding;
+                double dx = x - reference.states[s].x, dy = y - reference.states[s].y, dz = z - reference.states[s].z;
+                double error = std::sqrt(dx * dx + dy * dy + dz * dz);
+                maxError = std::max(maxError, std::isnan(error) ? INFINITY : error);
+            }
+        }
+        match = match && maxError < reference.tolerance;
+        json << (firstCase ? "" : ",") << "\n    {\"satellite\": " << elements.catalogNumber
+             << ", \"max_error_km\": " << maxError << ", \"tolerance_km\": " << reference.tolerance << "}";
+        firstCase = false;
+    }
+    json << "\n  ],\n";
+
+    // The synthetic catalogue, through the loader.
+    const std::string path = options.dir + "/sgp4_bench.tle";
+    if (!writeElementFile(path, options.satellites))
+    {
+        std::cerr << "Could not write " << path << std::endl;
+        return 1;
+    }
+    std::vector<TwoLineElements> catalogue;
+    TleLoadStats stats;
+    double loadMs = bestMs(options.repeats, [&]() {
+        catalogue.clear();
+        loadTwoLineElements(path, catalogue, &stats);
+    });
+    if (!options.keep)
+        std::remove(path.c_str());
+    match = match && stats.sets == options.satellites && stats.skipped == 1;
+    json << "  \"load\": {\"sets\": " << stats.sets << ", \"skipped\": " << stats.skipped << ", \"ms\": " << loadMs << "},\n"
+         << "  \"kernels\": [";
+
+    // Every kernel against the scalar one, half a day after the epochs.
+    double jd = 0.0;
+    for (const TwoLineElements &elements : catalogue)
+        jd = std::max(jd, elements.epochJd);
+    jd += 0.5;
+    std::vector<double> state[6], reference[6];
+    bool first = true;
+    for (NBodyKernel kernel : kernels)
+    {
+        if (!isGravityKernelSupported(kernel))
+            continue;
+        Sgp4Settings settings;
+        settings.kernel = kernel;
+        settings.threads = options.threads;
+        Sgp4Propagator propagator(settings);
+        std::size_t added = propagator.add(catalogue);
+        const std::size_t count = propagator.size();
+        for (std::vector<double> &column : state)
+            column.assign(count, 0.0);
+        double positionMs = bestMs(options.repeats, [&]() {
+            propagator.propagate(jd, state[0].data(), state[1].data(), state[2].data());
+        });
+        double stateMs = bestMs(options.repeats, [&]() {
+            propagator.propagate(jd, state[0].data(), state[1].data(), state[2].data(),
+                                 state[3].data(), state[4].data(), state[5].data());
+        });
+        if (reference[0].empty())
+            for (int c = 0; c < 6; ++c)
+                reference[c] = state[c];
+
+        // Relative to the radius, and the same satellites failing.
+        double maxError = 0.0;
+        std::size_t failed = 0;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            double radius = std::sqrt(reference[0][i] * reference[0][i] + reference[1][i] * reference[1][i] + reference[2][i] * reference[2][i]);
+            double error = distance(state, reference, i);
+            maxError = std::max(maxError, std::isnan(radius) ? error : error / radius);
+            maxError = std::max(maxError, distance(state + 3, reference + 3, i) / std::max(radius, 1.0));
+            failed += std::isnan(state[0][i]) ? 1 : 0;
+        }
+        match = match && maxError < 1e-9;
+
+        json << (first ? "" : ",") << "\n    {\"kernel\": \"" << gravityKernelName(kernel) << "\""
+             << ", \"added\": " << added
+             << ", \"near_earth\": " << propagator.nearEarthCount()
+             << ", \"deep_space\": " << propagator.deepSpaceCount()
+             << ", \"failed\": " << failed
+             << ", \"position_ms\": " << positionMs
+             << ", \"satellites_per_s\": " << count / (positionMs * 1e-3)
+             << ", \"state_ms\": " << stateMs
+             << ", \"max_rel_error\": " << maxError << "}";
+        first = false;
+    }
+    json << "\n  ],\n";
+
+    // Budgeted updates a frame (a minute) apart, then the fitted orbits against full solves.
+    Sgp4Settings settings;
+    settings.threads = options.threads;
+    settings.budgetMs = options.budgetMs;
+    Sgp4Propagator propagator(settings);
+    propagator.add(catalogue);
+    const std::size_t count = propagator.size();
+    std::vector<double> x(count), y(count), z(count);
+    auto start = std::chrono::steady_clock::now();
+    std::size_t firstSolved = propagator.update(jd);
+    double firstUpdateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    double maxUpdateMs = 0.0, totalUpdateMs = 0.0;
+    std::size_t totalSolved = 0;
+    double frameJd = jd;
+    for (int frame = 0; frame < options.frames; ++frame)
+    {
+        frameJd += 1.0 / 86400.0; // a 60 Hz frame on SatelliteSwarm's clock, a minute per second
+        start = std::chrono::steady_clock::now();
+        totalSolved += propagator.update(frameJd);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        maxUpdateMs = std::max(maxUpdateMs, ms);
+        totalUpdateMs += ms;
+    }
+    double positionsMs = bestMs(options.repeats, [&]() { propagator.positions(frameJd, x.data(), y.data(), z.data()); });
+
+    // A fresh unbudgeted fit, evaluated where it was fitted and 1 and 10 minutes on.
+    propagator.setBudget(0.0);
+    propagator.update(jd);
+    const double driftMinutes[] = {0.0, 1.0, 10.0};
+    json << "  \"update\": {\"first_solved\": " << firstSolved
+         << ", \"first_ms\": " << firstUpdateMs
+         << ", \"frames\": " << options.frames
+         << ", \"mean_solved\": " << (options.frames > 0 ? (double)totalSolved / options.frames : 0.0)
+         << ", \"mean_ms\": " << (options.frames > 0 ? totalUpdateMs / options.frames : 0.0)
+         << ", \"max_ms\": " << maxUpdateMs
+         << ", \"solved_per_ms\": " << (totalUpdateMs > 0.0 ? totalSolved / totalUpdateMs : 0.0)
+         << ", \"positions_ms\": " << positionsMs << "},\n"
+         << "  \"osculating_drift\": [";
+    for (double minutes : driftMinutes)
+    {
+        std::vector<double> fitted[3] = {std::vector<double>(count), std::vector<double>(count), std::vector<double>(count)};
+        propagator.positions(jd + minutes / 1440.0, fitted[0].data(), fitted[1].data(), fitted[2].data());
+        propagator.propagate(jd + minutes / 1440.0, state[0].data(), state[1].data(), state[2].data());
+        std::vector<double> errors;
+        errors.reserve(count);
+        for (std::size_t i = 0; i < count; ++i)
+            if (!std::isnan(state[0][i]))
+                errors.push_back(distance(fitted, state, i));
+        std::sort(errors.begin(), errors.end());
+        double median = errors.empty() ? 0.0 : errors[errors.size() / 2];
+        double maximum = errors.empty() ? 0.0 : errors.back();
+        if (minutes == 0.0)
+            match = match && maximum < 1e-3;
+        json << (minutes == 0.0 ? "" : ",") << "\n    {\"minutes\": " << minutes
+             << ", \"median_km\": " << median << ", \"max_km\": " << maximum << "}";
+    }
+
+    json << "\n  ],\n"
+         << "  \"match\": " << (match ? "true" : "false") << "\n}\n";
+
+    if (options.out.empty())
+    {
+        std::cout << json.str();
+    }
+    else
+    {
+        std::ofstream file(options.out);
+        file << json.str();
+    }
+    return match ? 0 : 1;
+}
@@ -0,0 +1,126 @@
+// Sphere tessellation comparison: for the UV sphere, icosphere and cube-sphere
+// generators at increasing detail, prints triangle/vertex counts and the
+// maximum geometric error against the true sphere (sphereMaxRadialError(),
+// which bounds how far the silhouette can sit inside the true outline) as
+// JSON; the error is also given in pixels for a sphere drawn with a
+// screen-space radius of --radius-px.
+// Ends with the cheapest tessellation of each generator under --max-error-px.
+//
+// CPU only, no GL context needed:
+//   ./SphereErrorBench [--radius-px 540] [--max-error-px 0.5] [--out result.json]
+
+#include "../include/planet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct BenchOptions
+{
+    float radiusPx = 540.0f; // a sphere filling the height of a 1080p view
+    float maxErrorPx = 0.5f;
+    std::string out;
+};
+
+static BenchOptions parseArgs(int argc, char **argv)
+{
+    BenchOptions options;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::strcmp(argv[i], "--radius-px") == 0)
+            options.radiusPx = (float)std::atof(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--max-error-px") == 0)
+            options.maxErrorPx = (float)std::atof(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--out") == 0)
+            options.out = argv[i + 1];
+        else
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+    }
+    return options;
+}
+
+struct Sample
+{
+    const char *generator;
+    std::string detail;
+    size_t triangles;
+    size_t vertices;
+    double maxError;
+};
+
+int main(int argc, char **argv)
+{
+    BenchOptions options = parseArgs(argc, argv);
+
+    // Same preparation the renderer applies (degenerate pole triangles removed).
+    MeshOptions meshOptions;
+    std::vector<Sample> samples;
+    auto measure = [&](const char *generator, const std::string &detail, MeshData mesh)
+    {
+        prepareMesh(mesh, meshOptions);
+        samples.push_back(Sample{generator, detail, mesh.indices.size() / 3, mesh.positions.size(), sphereMaxRadialError(mesh)});
+    };
+
+    for (unsigned int n : {8u, 12u, 16u, 24u, 32u, 48u, 64u, 96u, 128u, 192u, 256u})
+        measure("uv", std::to_string(n) + "x" + std::to_string(n), generateUVSphere(1.0f, n, n));
+    for (unsigned int subdivisions = 0; subdivisions <= 7; ++subdivisions)
+        measure("icosphere", std::to_string(subdivisions), generateIcosphere(1.0f, subdivisions));
+    for (unsigned int segments : {1u, 2u, 3u, 4u, 6u, 8u, 12u, 16u, 24u, 32u, 48u, 64u, 96u})
+        measure("cubesphere", std::to_string(segments), generateCubeSphere(1.0f, segments));
+
+    std::ostringstream json;
+    json << "{\n"
+         << "  \"radius_px\": " << options.radiusPx << ",\n"
+         << "  \"max_error_px\": " << options.maxErrorPx << ",\n"
+         << "  \"meshes\": [";
+    for (size_t i = 0; i < samples.size(); ++i)
+    {
+        const Sample &sample = samples[i];
+        json << (i ? ",\n" : "\n")
+             << "    {\"generator\": \"" << sample.generator << "\", \"detail\": \"" << sample.detail << "\""
+             << ", \"triangles\": " << sample.triangles
+             << ", \"vertices\": " << sample.vertices
+             << ", \"max_error\": " << sample.maxError
+             << ", \"error_px\": " << sample.maxError * options.radiusPx << "}";
+    }
+    json << "\n  ],\n"
+         << "  \"cheapest_within_max_error\": {";
+
+    bool first = true;
+    for (const char *generator : {"uv", "icosphere", "cubesphere"})
+    {
+        const Sample *best = nullptr;
+        for (const Sample &sample : samples)
+        {
+            if (std::strcmp(sample.generator, generator) == 0 && sample.maxError * options.radiusPx <= options.maxErrorPx &&
+                (!best || sample.triangles < best->triangles))
+                best = &sample;
+        }
+
+        json << (first ? "\n" : ",\n") << "    \"" << generator << "\": ";
+        if (best)
+            json << "{\"detail\": \"" << best->detail << "\", \"triangles\": " << best->triangles
+                 << ", \"error_px\": " << best->maxError * options.radiusPx << "}";
+        else
+            json << "null";
+        first = false;
+    }
+    json << "\n  }\n}\n";
+
+    if (options.out.empty())
+    {
+        std::cout << json.str();
+    }
+    else
+    {
+        std::ofstream file(options.out);
+        file << json.str();
+    }
+    return 0;
+}
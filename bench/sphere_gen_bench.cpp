@@ -0,0 +1,233 @@
+// UV sphere generation benchmark: sweeps rings x sectors and times, per size,
+// the original per-vertex sin/cos loop plus interleaving (the baseline),
+// generateUVSphere() on trig tables, writeUVSphere() into a preallocated
+// interleaved buffer on one thread and on --threads threads, and, with a GL
+// context, Planet construction through the mapped-buffer path. Every output
+// is checked bit for bit against the baseline. Prints JSON.
+//
+//   ./SphereGenBench [--min 64] [--max 2048] [--threads 0] [--repeats 5] [--no-gl] [--out result.json]
+// (sizes double from --min to --max; --threads 0 uses one per hardware thread)
+
+#include "../include/glad/glad.h"
+#include "../include/headless_context.h"
+#include "../include/planet.h"
+#include "../include/sphere_generator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct BenchOptions
+{
+    unsigned int minSize = 64;
+    unsigned int maxSize = 2048;
+    unsigned int threads = 0;
+    int repeats = 5;
+    bool gl = true;
+    std::string out;
+};
+
+static BenchOptions parseArgs(int argc, char **argv)
+{
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--no-gl") == 0)
+            options.gl = false;
+        else if (i + 1 >= argc)
+            std::cerr << "Missing value for option: " << argv[i] << std::endl;
+        else if (std::strcmp(argv[i], "--min") == 0)
+            options.minSize = (unsigned int)std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--max") == 0)
+            options.maxSize = (unsigned int)std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--threads") == 0)
+            options.threads = (unsigned int)std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--repeats") == 0)
+            options.repeats = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--out") == 0)
+            options.out = argv[++i];
+        else
+            std::cerr << "Unknown option: " << argv[i++] << std::endl;
+    }
+    return options;
+}
+
+/**
+ * @brief The generator as it was before the trig tables: sin/cos per vertex
+ * and push_back into separate arrays, then the interleave Planet::upload()
+ * does. The reference every other path must match bit for bit.
+ */
+static void legacyUVSphere(float radius, unsigned int rings, unsigned int sectors,
+                           std::vector<float> &interleaved, std::vector<unsigned int> &indices)
+{
+    std::vector<glm::vec3> vertices, normals;
+    std::vector<glm::vec2> texCoords;
+    float const R = 1.0f / (float)(rings - 1);
+    float const S = 1.0f / (float)(sectors - 1);
+
+    vertices.reserve(rings * sectors);
+    texCoords.reserve(rings * sectors);
+    normals.reserve(rings * sectors);
+    for (unsigned int r = 0; r < rings; ++r)
+    {
+        for (unsigned int s = 0; s < sectors; ++s)
+        {
+            float phi = glm::pi<float>() * r * R;
+            float theta = 2 * glm::pi<float>() * s * S;
+            float y = sin(-glm::pi<float>() / 2 + phi);
+            float x = cos(theta) * sin(phi);
+            float z = sin(theta) * sin(phi);
+            texCoords.push_back(glm::vec2(1.0f - (s * S), r * R));
+            vertices.push_back(glm::vec3(x, y, z) * radius);
+            normals.push_back(glm::vec3(x, y, z));
+        }
+    }
+
+    indices.clear();
+    indices.reserve((rings - 1) * (sectors - 1) * 6);
+    for (unsigned int r = 0; r < rings - 1; ++r)
+    {
+        for (unsigned int s = 0; s < sectors - 1; ++s)
+        {
+            indices.push_back(r * sectors + s);
+            indices.push_back(r * sectors + (s + 1));
+            indices.push_back((r + 1) * sectors + (s + 1));
+            indices.push_back(r * sectors + s);
+            indices.push_back((r + 1) * sectors + (s + 1));
+            indices.push_back((r + 1) * sectors + s);
+        }
+    }
+
+    interleaved.clear();
+    interleaved.reserve(vertices.size() * 8);
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        interleaved.insert(interleaved.end(), {vertices[i].x, vertices[i].y, vertices[i].z,
+                                               normals[i].x, normals[i].y, normals[i].z,
+                                               texCoords[i].x, texCoords[i].y});
+    }
+}
+
+/** @brief Best of @p repeats runs of @p fn, in milliseconds. */
+template <typename Fn>
+static double bestMs(int repeats, Fn fn)
+{
+    double best = 1e30;
+    for (int i = 0; i < std::max(repeats, 1); ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+static bool sameBits(const void *a, const void *b, size_t bytes)
+{
+    return std::memcmp(a, b, bytes) == 0;
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions options = parseArgs(argc, argv);
+    unsigned int threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    const float radius = 1.0f;
+
+    std::unique_ptr<HeadlessContext> context;
+    if (options.gl)
+    {
+        context.reset(new HeadlessContext(64, 64));
+        if (!context->isValid())
+            context.reset();
+    }
+
+    std::ostringstream rows;
+    bool allMatch = true;
+    for (unsigned int size = std::max(options.minSize, 2u); size <= options.maxSize; size *= 2)
+    {
+        unsigned int rings = size, sectors = size;
+        size_t vertexCount = uvSphereVertexCount(rings, sectors);
+        size_t indexCount = uvSphereIndexCount(rings, sectors);
+
+        std::vector<float> reference;
+        std::vector<unsigned int> referenceIndices;
+        double legacyMs = bestMs(options.repeats, [&]
+                                 { legacyUVSphere(radius, rings, sectors, reference, referenceIndices); });
+
+        MeshData mesh;
+        double tablesMs = bestMs(options.repeats, [&]
+                                 { mesh = generateUVSphere(radius, rings, sectors); });
+        bool tablesMatch = mesh.indices == referenceIndices;
+        for (size_t i = 0; i < vertexCount && tablesMatch; ++i)
+        {
+            const float *expected = &reference[i * 8];
+            tablesMatch = sameBits(&mesh.positions[i], expected, 3 * sizeof(float)) &&
+                          sameBits(&mesh.normals[i], expected + 3, 3 * sizeof(float)) &&
+                          sameBits(&mesh.texCoords[i], expected + 6, 2 * sizeof(float));
+        }
+
+        std::vector<StandardVertex> vertices(vertexCount);
+        std::vector<unsigned int> indices(indexCount);
+        double directMs = bestMs(options.repeats, [&]
+                                 { writeUVSphere(radius, rings, sectors, vertices.data(), indices.data(), 1); });
+        bool directMatch = indices == referenceIndices && sameBits(vertices.data(), reference.data(), reference.size() * sizeof(float));
+
+        std::fill(vertices.begin(), vertices.end(), StandardVertex());
+        std::fill(indices.begin(), indices.end(), 0u);
+        double threadedMs = bestMs(options.repeats, [&]
+                                   { writeUVSphere(radius, rings, sectors, vertices.data(), indices.data(), threads); });
+        bool threadedMatch = indices == referenceIndices && sameBits(vertices.data(), reference.data(), reference.size() * sizeof(float));
+
+        allMatch = allMatch && tablesMatch && directMatch && threadedMatch;
+        rows << (rows.tellp() > 0 ? ",\n" : "\n")
+             << "    {\"rings\": " << rings << ", \"sectors\": " << sectors
+             << ", \"vertices\": " << vertexCount
+             << ", \"legacy_ms\": " << legacyMs
+             << ", \"tables_ms\": " << tablesMs
+             << ", \"direct_1t_ms\": " << directMs
+             << ", \"direct_mt_ms\": " << threadedMs
+             << ", \"mvertices_per_s_mt\": " << vertexCount / (threadedMs * 1000.0);
+
+        if (context)
+        {
+            // Prepared mesh + interleave + glBufferData against writing into the mapped buffers.
+            MeshOptions unoptimized;
+            unoptimized.optimize = false;
+            double uploadCopyMs = bestMs(options.repeats, [&]
+                                         { Planet planet(generateUVSphere(radius, rings, sectors), VertexFormat::Standard); glFinish(); });
+            double uploadMappedMs = bestMs(options.repeats, [&]
+                                           { Planet planet(radius, rings, sectors, unoptimized); glFinish(); });
+            rows << ", \"planet_copy_ms\": " << uploadCopyMs
+                 << ", \"planet_mapped_ms\": " << uploadMappedMs;
+        }
+        rows << ", \"bit_exact\": " << (tablesMatch && directMatch && threadedMatch ? "true" : "false") << "}";
+    }
+
+    std::ostringstream json;
+    json << "{\n"
+         << "  \"threads\": " << threads << ",\n"
+         << "  \"gl\": " << (context ? "true" : "false") << ",\n"
+         << "  \"repeats\": " << options.repeats << ",\n"
+         << "  \"all_bit_exact\": " << (allMatch ? "true" : "false") << ",\n"
+         << "  \"sizes\": [" << rows.str() << "\n  ]\n}\n";
+
+    if (options.out.empty())
+    {
+        std::cout << json.str();
+    }
+    else
+    {
+        std::ofstream file(options.out);
+        file << json.str();
+    }
+    return allMatch ? 0 : 1;
+}
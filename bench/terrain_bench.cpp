@@ -0,0 +1,195 @@
+// Terrain benchmark: flies a camera from high orbit down to the surface of a
+// unit planet drawn with PlanetTerrain (CDLOD chunks over streamed height
+// tiles) and prints, as JSON, frame time percentiles plus a trace of chunks,
+// triangles and tile residency/streaming along the descent.
+//
+// Run from the repository root (shaders/ and textures/ are loaded relative to it):
+//   ./TerrainBench [--frames 600] [--width 1280] [--height 720] [--max-level 10] [--tile-budget 256]
+//                  [--uploads 8] [--tiles dir] [--start-altitude 3] [--end-altitude 0.001] [--out result.json]
+
+#include "../include/glad/glad.h"
+#include "../include/frame_stats.h"
+#include "../include/headless_context.h"
+#include "../include/shader.h"
+#include "../include/terrain.h"
+#include "../include/texture.h"
+#include "glm/glm/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+struct BenchOptions
+{
+    int frames = 600;
+    int width = 1280;
+    int height = 720;
+    int maxLevel = 10;
+    int tileBudget = 256;
+    int uploads = 8;
+    std::string tiles;
+    float startAltitude = 3.0f;
+    float endAltitude = 0.001f;
+    std::string out;
+};
+
+static BenchOptions parseArgs(int argc, char **argv)
+{
+    BenchOptions options;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::strcmp(argv[i], "--frames") == 0)
+            options.frames = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--width") == 0)
+            options.width = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--height") == 0)
+            options.height = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--max-level") == 0)
+            options.maxLevel = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--tile-budget") == 0)
+            options.tileBudget = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--uploads") == 0)
+            options.uploads = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--tiles") == 0)
+            options.tiles = argv[i + 1];
+        else if (std::strcmp(argv[i], "--start-altitude") == 0)
+            options.startAltitude = (float)std::atof(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--end-altitude") == 0)
+            options.endAltitude = (float)std::atof(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--out") == 0)
+            options.out = argv[i + 1];
+        else
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+    }
+    return options;
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions options = parseArgs(argc, argv);
+    if (options.frames < 2)
+        options.frames = 2;
+
+    HeadlessContext context(options.width, options.height);
+    if (!context.isValid())
+        return -1;
+
+    glEnable(GL_DEPTH_TEST);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+    Shader shader("shaders/terrain.vert", "shaders/terrain.frag");
+    unsigned int texture = loadTexture("textures/earth.jpg");
+
+    TerrainSettings settings;
+    settings.source.directory = options.tiles;
+    settings.maxLevel = options.maxLevel;
+    settings.tileBudget = (std::size_t)std::max(options.tileBudget, 0);
+    settings.uploadsPerFrame = (std::size_t)std::max(options.uploads, 0);
+
+    auto buildStart = std::chrono::steady_clock::now();
+    PlanetTerrain terrain(settings);
+    double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+
+    GLuint query;
+    glGenQueries(1, &query);
+
+    FrameStats stats;
+    std::ostringstream trace;
+    const glm::vec3 up = glm::normalize(glm::vec3(0.3f, 0.8f, 0.5f));
+    const glm::vec3 forward = glm::normalize(glm::cross(up, glm::vec3(0.0f, 0.0f, 1.0f)));
+    std::size_t totalUploads = 0;
+
+    for (int frame = 0; frame < options.frames; ++frame)
+    {
+        // Exponential descent, so every quadtree level gets a similar share of frames;
+        // the view tilts from straight down towards the horizon as the camera gets low.
+        float progress = frame / (float)(options.frames - 1);
+        float altitude = options.startAltitude * std::pow(options.endAltitude / options.startAltitude, progress);
+        glm::vec3 eye = up * (1.0f + altitude);
+        glm::vec3 target = glm::normalize(up + forward * std::min(4.0f * altitude, 1.0f));
+
+        float nearPlane = glm::clamp(0.5f * (altitude - settings.source.heightScale), 0.0005f, 0.1f);
+        glm::mat4 view = glm::lookAt(eye, target, forward);
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)options.width / options.height, nearPlane, 100.0f);
+        glm::mat4 model(1.0f);
+
+        auto cpuStart = std::chrono::steady_clock::now();
+        terrain.update(eye, projection * view * model);
+        auto updateEnd = std::chrono::steady_clock::now();
+
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glBeginQuery(GL_TIME_ELAPSED, query);
+        shader.use();
+        shader.setInt("ourTexture", 0);
+        shader.setBool("isShadowed", false);
+        shader.setVec3("lightPos", glm::vec3(10.0f, 10.0f, 10.0f));
+        shader.setMat4("model", model);
+        shader.setMat4("view", view);
+        shader.setMat4("projection", projection);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        terrain.draw(shader);
+        glEndQuery(GL_TIME_ELAPSED);
+        glFinish();
+        auto cpuEnd = std::chrono::steady_clock::now();
+
+        GLuint64 elapsedNs = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsedNs);
+
+        const TerrainStats &terrainStats = terrain.getStats();
+        totalUploads += terrainStats.uploads;
+        stats.record("cpu_update_ms", std::chrono::duration<double, std::milli>(updateEnd - cpuStart).count());
+        stats.record("cpu_frame_ms", std::chrono::duration<double, std::milli>(cpuEnd - cpuStart).count());
+        stats.record("gpu_frame_ms", elapsedNs / 1.0e6);
+        stats.record("chunks", (double)terrainStats.chunks);
+        stats.record("triangles", (double)terrainStats.triangles);
+        stats.record("pending_tiles", (double)terrainStats.pendingTiles);
+
+        if (frame % std::max(options.frames / 30, 1) == 0 || frame == options.frames - 1)
+        {
+            trace << (trace.tellp() > 0 ? ",\n" : "\n")
+                  << "    {\"frame\": " << frame
+                  << ", \"altitude\": " << altitude
+                  << ", \"chunks\": " << terrainStats.chunks
+                  << ", \"triangles\": " << terrainStats.triangles
+                  << ", \"deepest_level\": " << terrainStats.deepestLevel
+                  << ", \"resident_tiles\": " << terrainStats.residentTiles
+                  << ", \"pending_tiles\": " << terrainStats.pendingTiles
+                  << ", \"uploads\": " << terrainStats.uploads << "}";
+        }
+    }
+    glDeleteQueries(1, &query);
+
+    std::ostringstream json;
+    json << "{\n"
+         << "  \"renderer\": \"" << (const char *)glGetString(GL_RENDERER) << "\",\n"
+         << "  \"width\": " << options.width << ",\n"
+         << "  \"height\": " << options.height << ",\n"
+         << "  \"frames\": " << options.frames << ",\n"
+         << "  \"max_level\": " << terrain.getSettings().maxLevel << ",\n"
+         << "  \"tile_budget\": " << terrain.getSettings().tileBudget << ",\n"
+         << "  \"uploads_per_frame\": " << terrain.getSettings().uploadsPerFrame << ",\n"
+         << "  \"gpu_bytes\": " << terrain.getStats().gpuBytes << ",\n"
+         << "  \"build_ms\": " << buildMs << ",\n"
+         << "  \"total_uploads\": " << totalUploads << ",\n"
+         << "  \"stats\": ";
+    stats.writeJson(json);
+    json << ",\n  \"descent\": [" << trace.str() << "\n  ]\n}\n";
+
+    if (options.out.empty())
+    {
+        std::cout << json.str();
+    }
+    else
+    {
+        std::ofstream file(options.out);
+        file << json.str();
+    }
+    return 0;
+}
@@ -0,0 +1,153 @@
+#ifndef ASTEROID_BELT_H
+#define ASTEROID_BELT_H
+
+#include "glad/glad.h"
+#include "glm/glm/glm.hpp"
+#include "gl43.h"
+#include "catalog.h"
+#include "shader.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+/** @brief Population, orbit distribution and LOD thresholds of an AsteroidBelt. */
+struct AsteroidBeltSettings
+{
+    unsigned int count = 0;
+    float innerRadius = 13.0f;     // semi-major axes are uniform in [innerRadius, outerRadius]
+    float outerRadius = 18.0f;
+    float maxEccentricity = 0.12f;
+    float maxInclination = 0.08f;  // radians from the XZ plane
+    float minSize = 0.004f;        // rock radius range, scene units (the Earth is 0.5)
+    float maxSize = 0.03f;
+    float maxSpin = 2.0f;          // tumbling rate range is [0, maxSpin] radians per second
+    float gm = 1000.0f;            // mean motion sqrt(gm / a^3): 1 rad/s at the Earth's orbit radius of 10
+    float lodRadiusPx[2] = {8.0f, 2.5f}; // projected radius above which level 0 / level 1 are drawn
+    float cullRadiusPx = 0.3f;     // rocks smaller than this on screen are skipped
+    float maxDistance = 100.0f;    // rocks further than this from the camera are skipped
+    unsigned int variants = 4;     // distinct rock shapes
+    unsigned int seed = 1;
+    // If set, the rocks are the catalog's first count orbits instead of random
+    // ones, sized by absolute magnitude; gm must match its scale (the default
+    // does for the default CatalogSettings). Only read by the constructor.
+    const Catalog *catalog = nullptr;
+};
+
+/**
+ * @brief One rock's orbit and shape, 20 bytes. The angles are unorm16
+ * fractions of their range (eccentricity of [0, 1), inclination of [0, pi],
+ * the two longitudes of [0, 2 pi)), size a unorm16 fraction of
+ * AsteroidBeltSettings::maxSize and spin a unorm8 fraction of maxSpin.
+ */
+struct AsteroidElements
+{
+    float semiMajorAxis;
+    float meanAnomaly;              // at t = 0, radians
+    std::uint16_t eccentricity;
+    std::uint16_t inclination;
+    std::uint16_t ascendingNode;    // longitude of the ascending node
+    std::uint16_t periapsis;        // argument of periapsis
+    std::uint16_t size;
+    std::uint8_t spin;
+    std::uint8_t variant;           // rock shape
+};
+
+/** @brief Rocks and triangles drawn, as read back from the GPU. */
+struct AsteroidStats
+{
+    std::size_t rocks = 0;
+    std::size_t triangles = 0;
+};
+
+/**
+ * @brief An asteroid belt of up to millions of rocks around the origin,
+ * every rock an instance of one of a few rock meshes.
+ *
+ * Only the orbital elements live on the GPU (AsteroidElements, uploaded
+ * once); positions are solved from Kepler's equation in a shader at the
+ * time passed to draw(), so nothing is uploaded per frame. Each rock shape
+ * has three levels (subdivided icosahedra of 320, 80 and 20 triangles),
+ * chosen by the rock's projected radius; rocks out of the frustum, further
+ * than maxDistance or under cullRadiusPx are skipped.
+ *
+ * On GL 4.3 (GL43::isAvailable()) a compute shader (shaders/asteroid_cull.comp)
+ * places, culls and bins the rocks into one DrawElementsIndirectCommand per
+ * (shape, level), and the belt is one glMultiDrawElementsIndirect. On 3.3,
+ * each (shape, level) is one glDrawElementsInstanced over all rocks of that
+ * shape and the vertex shader places them and collapses the ones culled or
+ * belonging to another level.
+ */
+class AsteroidBelt
+{
+public:
+    static const int kLevels = 3;
+
+    explicit AsteroidBelt(const AsteroidBeltSettings &settings);
+    ~AsteroidBelt();
+
+    AsteroidBelt(const AsteroidBelt &) = delete;
+    AsteroidBelt &operator=(const AsteroidBelt &) = delete;
+
+    /**
+     * @brief Draws the belt at time @p t (seconds) into the bound framebuffer.
+     * @param fovY vertical field of view in radians
+     * @param gpuDriven false keeps the 3.3 path on a 4.3 context
+     */
+    void draw(float t, const glm::mat4 &view, const glm::mat4 &projection, const glm::vec3 &eye,
+              float fovY, float viewportHeight, const glm::vec3 &lightPos, bool gpuDriven = true);
+
+    /**
+     * @brief Rocks and triangles the compute path drew two frames ago, read
+     * back without waiting on the GPU; empty on the 3.3 path, which only
+     * knows what it submitted.
+     */
+    AsteroidStats takeStats();
+
+    const AsteroidBeltSettings &getSettings() const { return settings; }
+    std::size_t size() const { return elements.size(); }
+    /** @brief Bytes of GPU memory held: meshes, elements and (GL 4.3) per-frame instance buffers. */
+    std::size_t gpuBytes() const;
+
+private:
+    struct Level
+    {
+        GLuint firstIndex; // into the shared 16-bit index buffer, whose indices are absolute
+        GLuint indexCount;
+    };
+
+    void buildMeshes();
+    void generateElements();
+    void catalogElements(std::size_t i, float brightest, std::mt19937 &random, AsteroidElements &rock) const;
+    void cull(float t, const glm::mat4 &viewProjection, const glm::vec3 &eye, float fovY, float viewportHeight);
+
+    AsteroidBeltSettings settings;
+    std::vector<AsteroidElements> elements; // sorted by variant
+    std::vector<GLuint> variantFirst;       // first rock of each variant, plus the total
+    std::vector<Level> levels;              // variant-major: variant * kLevels + level
+    float rockBound = 1.0f;                 // largest vertex distance of any rock mesh (unit size)
+
+    Shader shader;
+    std::unique_ptr<Shader> cullShader; // only when GL43::isAvailable()
+
+    GLuint meshVBO = 0;
+    GLuint meshEBO = 0;
+    GLuint elementBuffer = 0;
+    GLuint fallbackVAO = 0; // elements as instance attributes 6-9
+
+    // GL 4.3 path
+    GLuint indirectVAO = 0; // placements as instance attributes 4-5
+    GLuint commandBuffer = 0;
+    GLuint rockCommandBuffer = 0;
+    GLuint cursorBuffer = 0;
+    GLuint instanceBuffer = 0;
+    GLuint readbackBuffers[2] = {0, 0};
+    std::vector<DrawElementsIndirectCommand> commandTemplate;
+    unsigned long long frame = 0;
+    bool readbackValid[2] = {false, false};
+    AsteroidStats readbackStats;
+};
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef BODY_STATE_H
+#define BODY_STATE_H
+
+#include "glm/glm/glm.hpp"
+#include "kepler.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Stable id of a body, returned by addBody() (scenario.h). Unlike its
+ * slot in the arrays below, it does not change when the bodies are reordered.
+ */
+using BodyHandle = std::uint32_t;
+const BodyHandle kNoBody = 0xffffffffu;
+
+/** @brief How a body moves: the parameters updateBodyTransforms() reads every frame. */
+struct BodyMotion
+{
+    float radius = 1.0f;
+    float orbitRadius = 0.0f;                    // semi-major axis
+    float orbitSpeed = 0.0f;                     // mean motion, radians per second
+    float orbitPhase = 0.0f;                     // mean anomaly at t = 0 (radians)
+    float rotationSpeed = 0.0f;                  // radians per second
+    glm::vec3 rotationAxis = glm::vec3(0, 1, 0);
+    float gm = 0.0f;                             // G * mass, for NBodySystem (nbody.h); 0: pulls nothing
+    float orbitEccentricity = 0.0f;              // with the angles below, as in OrbitalElements (kepler.h)
+    float orbitInclination = 0.0f;
+    float orbitAscendingNode = 0.0f;
+    float orbitPeriapsis = 0.0f;
+};
+
+/**
+ * @brief The per-frame ("hot") state of every body as a structure of arrays,
+ * indexed by slot: one contiguous array per parameter, so the update streams
+ * through the floats it needs instead of whole bodies. Names, textures and
+ * meshes (the "cold" data) are in CelestialBody, at the same slot.
+ */
+struct BodyState
+{
+    std::vector<std::int32_t> parent; // slot of the parent, -1 for a root; always below the body's own slot
+    std::vector<float> radius;
+    std::vector<float> orbitRadius;
+    std::vector<float> orbitSpeed;
+    std::vector<float> orbitPhase;
+    std::vector<float> orbitEccentricity, orbitInclination, orbitAscendingNode, orbitPeriapsis;
+    std::vector<float> rotationSpeed;
+    std::vector<float> axisX, axisY, axisZ; // unit rotation axis
+    std::vector<float> gm;
+
+    // Written by updateBodyTransforms().
+    std::vector<float> positionX, positionY, positionZ;
+    std::vector<glm::mat4> model;
+
+    std::size_t size() const { return radius.size(); }
+
+    /** @brief Appends a root body at rest at the origin; @return its slot. */
+    std::size_t add(const BodyMotion &motion);
+
+    void reserve(std::size_t count);
+
+    /** @brief Reorders every array so that slot i holds what was at slot order[i]. Does not remap parent. */
+    void permute(const std::vector<std::size_t> &order);
+
+    glm::vec3 position(std::size_t slot) const { return glm::vec3(positionX[slot], positionY[slot], positionZ[slot]); }
+};
+
+/**
+ * @brief The orbit of the body at @p slot around its parent, with
+ * orbitSpeed as the mean motion (negative: backwards along the orbit).
+ */
+OrbitalElements bodyOrbit(const BodyState &state, std::size_t slot);
+
+/**
+ * @brief Sets every body's position and model matrix for time @p t in one
+ * pass in slot order: the body follows its orbit (bodyOrbit()) around its
+ * parent's position (the origin for a root), spins by t * rotationSpeed about
+ * its axis and is scaled by radius. Circular orbits in the xz plane are
+ * plain circles; the others go through keplerState().
+ */
+void updateBodyTransforms(BodyState &state, float t);
+
+/** @brief Model matrices only, for positions set by something else (e.g. writeToBodies() in nbody.h). */
+void updateBodyModels(BodyState &state, float t);
+
+#endif
@@ -2,7 +2,7 @@
 #define CAMERA_H
 
 #include "glad/glad.h"
-#include "glm\glm\glm.hpp"
+#include "glm/glm/glm.hpp"
 #include "glm/glm/gtc/matrix_transform.hpp"
 
 #include <vector>
@@ -0,0 +1,82 @@
+#ifndef CATALOG_H
+#define CATALOG_H
+
+#include "kepler.h"
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+enum class CatalogFormat
+{
+    Auto,   // Csv for a .csv file, Mpcorb otherwise
+    Mpcorb, // the Minor Planet Center's fixed-width MPCORB.DAT
+    Csv     // comma-separated with a header row naming the columns (see loadCatalog())
+};
+
+/** @brief How loadCatalog() reads a catalog and maps it into the scene. */
+struct CatalogSettings
+{
+    CatalogFormat format = CatalogFormat::Auto;
+    unsigned int threads = 0;                           // 0: one per hardware thread
+    double unitsPerAu = 10.0;                           // the Earth's orbit radius in the scene
+    double secondsPerDay = 6.283185307179586 / 365.25;  // the scene's year is the Earth's 2 pi s orbit
+    double epochJd = 2451545.0;                         // Julian date at scene time 0 (J2000)
+    bool useImage = true;                               // read and write the binary image at imagePath
+    std::string imagePath;                              // "": the catalog's path plus ".bin"
+};
+
+/**
+ * @brief Minor planets read by loadCatalog(): their orbits, in scene units
+ * and seconds from settings.epochJd, and per orbit (same index) its name and
+ * absolute magnitude H.
+ */
+struct Catalog
+{
+    using Name = std::array<char, 16>; // NUL-padded; longer names are cut
+
+    KeplerPropagator orbits;
+    std::vector<Name> names;
+    std::vector<float> absoluteMagnitude; // NaN when the catalog has none
+
+    std::size_t size() const { return names.size(); }
+};
+
+/** @brief What one loadCatalog() did. */
+struct CatalogLoadStats
+{
+    std::size_t bytes = 0;     // of the file parsed or the image read
+    std::size_t lines = 0;     // parsed lines, 0 from the image
+    std::size_t skipped = 0;   // lines that were not an orbit (headers, blank or malformed)
+    unsigned int threads = 0;
+    bool fromImage = false;
+    bool wroteImage = false;
+    double ms = 0.0;
+};
+
+/**
+ * @brief Replaces @p catalog with the orbits in the file at @p path.
+ *
+ * The file is memory-mapped and cut into one chunk per thread at line
+ * boundaries. Each thread counts its chunk's orbit lines, then parses them
+ * straight into their final slots of catalog.orbits (KeplerPropagator::set())
+ * with allocation-free number parsing; a malformed line that looked like an
+ * orbit closes its gap afterwards. MPCORB lines are read by column: packed
+ * designation, H, packed epoch, M, argument of periapsis, node, inclination,
+ * e, n (degrees per day) and a (AU); the header up to the dashed line is
+ * skipped. CSV headers name the columns: name (or full_name, designation,
+ * pdes), a, e, i, om (or node), w (or peri), ma (or m), epoch (Julian date)
+ * and optionally n and H; n defaults to Gauss's k / a^1.5.
+ *
+ * With settings.useImage the result is also written to a binary image that
+ * holds the propagator's arrays as they are in memory, and later loads of
+ * the same file (size and modification time) with the same settings map
+ * that instead and copy it, parsing nothing.
+ *
+ * @return false if the file cannot be read; the catalog is then empty
+ */
+bool loadCatalog(const std::string &path, Catalog &catalog, const CatalogSettings &settings = CatalogSettings(),
+                 CatalogLoadStats *stats = nullptr);
+
+#endif
@@ -0,0 +1,164 @@
+#ifndef EPHEMERIS_H
+#define EPHEMERIS_H
+
+#include "body_state.h"
+#include "gravity_kernel.h"
+#include "mapped_file.h"
+#include "glm/glm/glm.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+/** @brief The bodies of a JPL DE ephemeris, in the file's order. */
+enum class EphemerisBody
+{
+    Mercury,
+    Venus,
+    EarthMoon, // the Earth-Moon barycentre
+    Mars,
+    Jupiter,
+    Saturn,
+    Uranus,
+    Neptune,
+    Pluto,
+    Moon,      // geocentric, as the file stores it
+    Sun,
+    Earth,     // not stored: EarthMoon - Moon / (1 + earthMoonRatio())
+    Count
+};
+
+const int kEphemerisBodies = (int)EphemerisBody::Count;
+
+/**
+ * @brief A JPL Development Ephemeris (DE405, DE430, DE440, ...) in the binary
+ * form JPL's asc2eph writes, read in place from a memory mapping.
+ *
+ * The file is one header record, one record of constants and then fixed-size
+ * records of Chebyshev coefficients, each covering the same number of days,
+ * so the record of an epoch is found by one division. Each body's series
+ * splits a record into granules of equal length with their own coefficients.
+ * Positions are kilometres and velocities kilometres per day, in the ICRF
+ * (equatorial) frame, relative to the solar system barycentre except the
+ * Moon's; epochs are TDB Julian dates. A file in the other byte order is
+ * read swapped into memory instead of mapped.
+ */
+class Ephemeris
+{
+public:
+    /** @param kernel SIMD width of sample(), as NBodySettings::kernel */
+    explicit Ephemeris(const std::string &path, NBodyKernel kernel = NBodyKernel::Auto);
+    ~Ephemeris();
+
+    Ephemeris(const Ephemeris &) = delete;
+    Ephemeris &operator=(const Ephemeris &) = delete;
+
+    bool isOpen() const { return records > 0; }
+    int number() const { return deNumber; }
+    double startJd() const { return start; }
+    double endJd() const { return end; }
+    double recordDays() const { return span; }
+    double au() const { return auKm; }                    // kilometres
+    double earthMoonRatio() const { return emrat; }       // Earth's mass over the Moon's
+    bool has(EphemerisBody body) const;
+    /** @return the header constant called @p name (e.g. "GM1", "CLIGHT"), or @p fallback */
+    double constant(const char *name, double fallback = 0.0) const;
+    NBodyKernel kernel() const { return activeKernel; }
+
+    /** @return false if @p jd is outside [startJd(), endJd()] or the body is not in the file */
+    bool state(EphemerisBody body, double jd, glm::dvec3 &position, glm::dvec3 *velocity = nullptr) const;
+
+    /**
+     * @brief Every body at one epoch (kEphemerisBodies of each; the ones not in
+     * the file are zero). The Chebyshev polynomials are evaluated once for
+     * each granule length and dotted with every body's coefficients.
+     */
+    bool evaluate(double jd, glm::dvec3 *positions, glm::dvec3 *velocities = nullptr) const;
+
+    /**
+     * @brief One body at @p count epochs, written as structure-of-arrays
+     * (velocities if @p vx, @p vy and @p vz are given). Consecutive epochs
+     * in the same granule share its coefficients and are evaluated 4 (AVX2)
+     * or 8 (AVX-512) at a time, so sorted epochs (trails, event searches)
+     * are fastest. Epochs out of range are NaN.
+     * @return the number of epochs in range
+     */
+    std::size_t sample(EphemerisBody body, const double *jd, std::size_t count, double *x, double *y, double *z,
+                       double *vx = nullptr, double *vy = nullptr, double *vz = nullptr) const;
+
+    /** @brief Maximum coefficients per component this reader evaluates. */
+    static const int kMaxCoefficients = 32;
+
+private:
+    /** @brief Where one body's series lives in a record: 1-based offset, coefficients per component, granules. */
+    struct Series
+    {
+        int offset = 0;
+        int coefficients = 0;
+        int granules = 0;
+    };
+
+    /** @brief The coefficients of @p body's granule holding @p jd, its start and length in days. */
+    const double *locate(int body, double jd, double &granuleStart, double &granuleDays) const;
+    std::size_t sampleSeries(int body, const double *jd, std::size_t count, double *x, double *y, double *z,
+                             double *vx, double *vy, double *vz) const;
+
+    std::unique_ptr<MappedFile> file;
+    std::vector<double> swapped; // the records, when the file is in the other byte order
+    const double *data = nullptr; // record 0
+    std::size_t recordDoubles = 0;
+    std::size_t records = 0;      // coefficient records, from record 2 on
+    Series series[kEphemerisBodies - 1];
+    double start = 0.0, end = 0.0, span = 0.0;
+    double auKm = 0.0, emrat = 0.0;
+    int deNumber = 0;
+    std::vector<std::string> constantNames;
+    std::vector<double> constantValues;
+    NBodyKernel activeKernel;
+};
+
+/** @brief How EphemerisBodies maps ephemeris positions into the scene. */
+struct EphemerisSceneSettings
+{
+    double epochJd = 2451545.0;                        // Julian date at scene time 0 (J2000)
+    double secondsPerDay = 6.283185307179586 / 365.25; // the scene's year is the Earth's 2 pi s orbit
+    double unitsPerAu = 10.0;                          // the Earth's orbit radius in the scene
+    double satelliteScale = 80.0;                      // moons' distances from their planet are stretched by this (the real Moon would sit inside the Earth)
+};
+
+/** @brief Ecliptic J2000 axes of an ICRF vector, in scene order (x, y up, z), as OrbitalElements use. */
+glm::dvec3 ephemerisToScene(const glm::dvec3 &icrf);
+
+/**
+ * @brief Moves the scene bodies named after ephemeris bodies ("Sun",
+ * "Mercury", ..., "Earth", "Moon", "Pluto") to their ephemeris positions.
+ *
+ * Each moves relative to its scene parent by the ephemeris vector from the
+ * parent's ephemeris body (from the Sun when the parent has none), scaled to
+ * scene units; bodies without an ephemeris body keep their analytic orbit
+ * around their moved parent. Epochs outside the file leave the analytic
+ * orbits alone.
+ */
+class EphemerisBodies
+{
+public:
+    /** @param names every body's name, by slot; rebuild when the slots change */
+    EphemerisBodies(const Ephemeris &ephemeris, const std::vector<std::string> &names, const BodyState &state,
+                    const EphemerisSceneSettings &settings = EphemerisSceneSettings());
+
+    /** @brief After updateBodyTransforms(): moves the bodies to time @p t and rebuilds their model matrices. */
+    bool apply(BodyState &state, float t);
+
+    std::size_t mapped() const { return mappedCount; }
+
+private:
+    const Ephemeris &ephemeris;
+    EphemerisSceneSettings settings;
+    std::vector<int> bodies;    // slot -> EphemerisBody, or -1
+    std::vector<int> reference; // slot -> the EphemerisBody its offset is measured from
+    std::vector<glm::vec3> shift; // per slot, scratch for apply()
+    std::size_t mappedCount = 0;
+};
+
+#endif
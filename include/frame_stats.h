@@ -0,0 +1,43 @@
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Collects named series of per-frame samples (milliseconds, counts, ...)
+ * and reduces them to percentiles for the benchmark JSON output.
+ */
+class FrameStats
+{
+public:
+    struct Summary
+    {
+        std::size_t count = 0;
+        double mean = 0.0;
+        double p50 = 0.0;
+        double p95 = 0.0;
+        double p99 = 0.0;
+        double max = 0.0;
+    };
+
+    /** @brief Appends one sample to @p series, creating the series on first use. */
+    void record(const std::string &series, double value);
+    /** @brief Drops every sample but keeps the series names (and their order). */
+    void clear();
+
+    /** @brief Nearest-rank percentiles of @p series; an empty Summary if it does not exist. */
+    Summary summarize(const std::string &series) const;
+
+    /** @brief Writes `{"series": {"count":..,"mean":..,"p50":..,"p95":..,"p99":..,"max":..}, ...}`. */
+    void writeJson(std::ostream &out) const;
+
+private:
+    // Insertion-ordered so the JSON output is stable between runs.
+    std::vector<std::pair<std::string, std::vector<double>>> series;
+};
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include "glm/glm/glm.hpp"
+
+/**
+ * @brief The six clip planes (left, right, bottom, top, near, far) of
+ * @p clip in the space it maps from, as (normal, d) with the inside where
+ * dot(normal, p) + d >= 0: sums and differences of the matrix's rows
+ * (Gribb/Hartmann). The normals are not normalized.
+ */
+inline void extractFrustumPlanes(const glm::mat4 &clip, glm::vec4 planes[6])
+{
+    glm::vec4 row0(clip[0][0], clip[1][0], clip[2][0], clip[3][0]);
+    glm::vec4 row1(clip[0][1], clip[1][1], clip[2][1], clip[3][1]);
+    glm::vec4 row2(clip[0][2], clip[1][2], clip[2][2], clip[3][2]);
+    glm::vec4 row3(clip[0][3], clip[1][3], clip[2][3], clip[3][3]);
+    planes[0] = row3 + row0;
+    planes[1] = row3 - row0;
+    planes[2] = row3 + row1;
+    planes[3] = row3 - row1;
+    planes[4] = row3 + row2;
+    planes[5] = row3 - row2;
+}
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef GL43_H
+#define GL43_H
+
+#include "glad/glad.h"
+
+// The bundled glad is generated for OpenGL 3.3 core. These are the few 4.2/4.3
+// entry points and enums the GPU-driven path needs, declared the way glad
+// declares its own so a regenerated 4.3 glad simply replaces them.
+#ifndef GL_VERSION_4_3
+#define GL_COMPUTE_SHADER 0x91B9
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#define GL_PRIMITIVE_RESTART_FIXED_INDEX 0x8D69
+#define GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT 0x00000001
+#define GL_COMMAND_BARRIER_BIT 0x00000040
+#define GL_BUFFER_UPDATE_BARRIER_BIT 0x00000200
+#define GL_SHADER_STORAGE_BARRIER_BIT 0x00002000
+
+typedef void (APIENTRYP PFNGLDISPATCHCOMPUTEPROC)(GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z);
+typedef void (APIENTRYP PFNGLMEMORYBARRIERPROC)(GLbitfield barriers);
+typedef void (APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void *indirect, GLsizei drawcount, GLsizei stride);
+
+GLAPI PFNGLDISPATCHCOMPUTEPROC glad_glDispatchCompute;
+#define glDispatchCompute glad_glDispatchCompute
+GLAPI PFNGLMEMORYBARRIERPROC glad_glMemoryBarrier;
+#define glMemoryBarrier glad_glMemoryBarrier
+GLAPI PFNGLMULTIDRAWELEMENTSINDIRECTPROC glad_glMultiDrawElementsIndirect;
+#define glMultiDrawElementsIndirect glad_glMultiDrawElementsIndirect
+#endif
+
+/** @brief One record of a GL_DRAW_INDIRECT_BUFFER for glMultiDrawElementsIndirect (20 bytes). */
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+/**
+ * @brief Loader for the entry points above. Call after gladLoadGLLoader()
+ * with the same proc address function; safe on a 3.3 context, where
+ * isAvailable() then stays false and callers keep to the 3.3 path.
+ */
+namespace GL43
+{
+    bool load(GLADloadproc load);
+    /** @brief The context is 4.3 or newer and every entry point above was found. */
+    bool isAvailable();
+}
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef GL_STATS_H
+#define GL_STATS_H
+
+#include "glad/glad.h"
+#include "frame_stats.h"
+
+#include <ostream>
+
+/**
+ * @brief Optional GL call accounting layer over the glad function table.
+ *
+ * install() swaps the glad_gl* pointers of the draw, state, uniform, upload and
+ * object lifetime entry points for counting wrappers that forward to the
+ * driver. Nothing is intercepted (and nothing costs anything) until it is
+ * called. Each wrapper also shadows the GL state it touches, so calls that
+ * re-bind the current program/VAO/texture/buffer or re-upload an unchanged
+ * uniform value are reported as redundant.
+ *
+ * Must be called after gladLoadGLLoader() on the thread that owns the context.
+ */
+namespace GLStats
+{
+    void install();
+    bool isInstalled();
+
+    /** @brief Resets the per-frame counters. */
+    void beginFrame();
+    /**
+     * @brief Records this frame's counters into @p stats as gl_draw_calls,
+     * gl_state_changes, gl_redundant_state_changes, gl_uniform_uploads,
+     * gl_vertices_submitted, gl_redundant_uniform_uploads, gl_inactive_uniform_uploads,
+     * gl_uniform_location_lookups, gl_uploads (buffer and texture), gl_bytes_uploaded,
+     * gl_objects_created, gl_objects_deleted and gl_program_links.
+     */
+    void endFrame(FrameStats *stats);
+
+    /** @brief Restarts the totals reported by writeJson() (e.g. after warm-up frames). */
+    void resetTotals();
+
+    /**
+     * @brief Writes per-entry-point totals since install() or resetTotals() as
+     * `{"glUseProgram": {"calls": N, "redundant": M}, ...}` (only functions that were called).
+     */
+    void writeJson(std::ostream &out);
+}
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef GPU_NBODY_H
+#define GPU_NBODY_H
+
+#include "glad/glad.h"
+#include "glm/glm/glm.hpp"
+#include "gl43.h"
+#include "instanced_point_mesh.h"
+#include "shader.h"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/** @brief Initial cluster, time step and look of a GpuNBody. */
+struct GpuNBodySettings
+{
+    unsigned int count = 0;      // bodies; at most 16M (65535 work groups of kTileSize)
+    glm::vec3 center = glm::vec3(0.0f, 6.0f, -24.0f); // the cluster starts as a Plummer sphere around here
+    float scaleRadius = 1.5f;    // Plummer scale radius, scene units; bodies are cut off at 10x
+    float totalGm = 2.0f;        // G times the cluster's mass, split equally between the bodies
+    float dt = 1.0f / 240.0f;    // fixed step in simulated seconds
+    float softening = 0.05f;     // Plummer softening length; 0: exact 1/r^2
+    int maxSteps = 64;           // advanceTo() takes at most this many steps per call
+    float bodySize = 0.02f;      // drawn sphere radius, scene units
+    bool points = false;         // draw each body as one point of its projected size instead of a sphere
+    unsigned int seed = 1;
+};
+
+/**
+ * @brief Self-gravitating star cluster or debris cloud integrated and drawn
+ * entirely on the GPU (GL 4.3, isSupported()).
+ *
+ * Positions (xyz and gm), velocities and accelerations live in three vec4
+ * shader storage buffers, uploaded once. Each leapfrog step is two dispatches
+ * of shaders/nbody.comp over one invocation per body: a half kick and drift
+ * in place, then the direct O(n^2) force sum and the second half kick. The
+ * force sum goes in tiles of kTileSize bodies: every work group stages one
+ * tile in shared memory, each invocation loading one body, and all of them
+ * sum against it before moving on, so each position is read from the buffer
+ * once per work group instead of once per invocation. Precision is float.
+ *
+ * draw() binds the position buffer itself as the instance attribute of one
+ * instanced sphere (or point) draw (InstancedPointMesh): bodies never go
+ * through the CPU. read()
+ * does, for checking against NBodySystem. The cluster only feels itself, not
+ * the scene's bodies.
+ */
+class GpuNBody
+{
+public:
+    static const unsigned int kTileSize = 256; // local_size_x of shaders/nbody.comp
+
+    static bool isSupported() { return GL43::isAvailable(); }
+
+    explicit GpuNBody(const GpuNBodySettings &settings);
+    ~GpuNBody();
+
+    GpuNBody(const GpuNBody &) = delete;
+    GpuNBody &operator=(const GpuNBody &) = delete;
+
+    /** @brief One step of settings.dt (backwards if @p direction < 0). */
+    void step(int direction = 1);
+
+    /**
+     * @brief Steps until time() is within half a step of @p t, forwards or
+     * backwards, at most settings.maxSteps.
+     * @return the number of steps taken
+     */
+    int advanceTo(double t);
+
+    /** @brief Draws the bodies at their current positions into the bound framebuffer. */
+    void draw(const glm::mat4 &view, const glm::mat4 &projection, const glm::vec3 &lightPos, float viewportHeight);
+
+    /** @brief Copies the current state back (x, y, z, gm and vx, vy, vz, 0); waits for the GPU. */
+    void read(std::vector<glm::vec4> &positions, std::vector<glm::vec4> &velocities) const;
+
+    double time() const { return currentTime; }
+    std::size_t size() const { return settings.count; }
+    const GpuNBodySettings &getSettings() const { return settings; }
+    /** @brief The vec4 (x, y, z, gm) buffer, for other passes to draw from. */
+    GLuint positionBuffer() const { return buffers[0]; }
+    std::size_t gpuBytes() const;
+
+private:
+    void generateCluster(std::vector<glm::vec4> &positions, std::vector<glm::vec4> &velocities) const;
+    void dispatch(int stage, float dt);
+
+    GpuNBodySettings settings;
+    Shader stepShader;
+
+    GLuint buffers[3] = {0, 0, 0}; // positions, velocities, accelerations
+    std::unique_ptr<InstancedPointMesh> mesh; // draws buffers[0]
+
+    double currentTime = 0.0;
+};
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include "glad/glad.h"
+#include "frame_stats.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief Per-pass GPU timing from GL_TIMESTAMP queries, without pipeline stalls.
+ *
+ * Each frame brackets its passes with glQueryCounter timestamps taken from a
+ * pool of query objects. The pool holds `latency` frames; a frame's results are
+ * read back only when its slot comes around again, i.e. `latency` frames later,
+ * by which time the GPU has normally finished it. Results that are still not
+ * available then are dropped rather than waited on.
+ *
+ * Readback feeds the FrameStats sink with "gpu_frame_ms" (first to last
+ * timestamp of the frame) and one "gpu_<pass>_ms" series per pass name;
+ * passes that run several times in one frame are summed.
+ */
+class GpuTimer
+{
+public:
+    explicit GpuTimer(FrameStats *sink, int latency = 4);
+    ~GpuTimer();
+
+    GpuTimer(const GpuTimer &) = delete;
+    GpuTimer &operator=(const GpuTimer &) = delete;
+
+    /** @brief Reads back the oldest frame in flight and starts a new one. */
+    void beginFrame(bool record = true);
+    void endFrame();
+
+    /** @brief Pass names must be string literals (only the pointer is kept). */
+    void beginPass(const char *name);
+    void endPass();
+
+    /** @brief Blocks until every frame in flight has been read back (end of a benchmark run). */
+    void flush();
+
+    /** @brief Frames whose results were not ready after `latency` frames. */
+    int droppedFrames() const { return dropped; }
+
+private:
+    struct PassQuery
+    {
+        const char *name;
+        unsigned int begin;
+        unsigned int end;
+    };
+
+    struct FrameSlot
+    {
+        std::vector<unsigned int> pool;   // query objects owned by this slot, grown on demand
+        std::vector<PassQuery> passes;
+        unsigned int frameBegin = 0;
+        unsigned int frameEnd = 0;
+        int used = 0;
+        bool pending = false;
+        bool record = false;
+    };
+
+    unsigned int nextQuery(FrameSlot &slot);
+    void readBack(FrameSlot &slot, bool wait);
+
+    FrameStats *stats;
+    std::vector<FrameSlot> slots;
+    std::vector<int> openPasses;   // indices into the current slot's passes
+    std::vector<std::pair<const char *, double>> passTotals;
+    int current = 0;
+    int dropped = 0;
+};
+
+/** @brief RAII helper: times one pass when a GpuTimer is attached, no-op otherwise. */
+class GpuPass
+{
+public:
+    GpuPass(GpuTimer *gpuTimer, const char *name) : timer(gpuTimer)
+    {
+        if (timer)
+            timer->beginPass(name);
+    }
+    ~GpuPass()
+    {
+        if (timer)
+            timer->endPass();
+    }
+
+    GpuPass(const GpuPass &) = delete;
+    GpuPass &operator=(const GpuPass &) = delete;
+
+private:
+    GpuTimer *timer;
+};
+
+#endif
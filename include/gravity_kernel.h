@@ -0,0 +1,61 @@
+#ifndef GRAVITY_KERNEL_H
+#define GRAVITY_KERNEL_H
+
+#include <cstddef>
+
+/** @brief Pairwise force kernel; Auto picks the widest the CPU supports. */
+enum class NBodyKernel
+{
+    Auto,
+    Scalar,
+    Avx2,  // 4 doubles per instruction, FMA
+    Avx512 // 8 doubles per instruction
+};
+
+/** @brief Bodies that pull, as structure-of-arrays. */
+struct GravitySources
+{
+    const double *x, *y, *z, *gm;
+    std::size_t count;
+};
+
+/** @brief Octree cells that pull: centre of mass, gm and traceless quadrupole, as structure-of-arrays. */
+struct GravityCells
+{
+    const double *x, *y, *z, *gm;
+    const double *xx, *yy, *zz, *xy, *xz, *yz;
+    std::size_t count;
+};
+
+/** @brief Bodies that are pulled: positions read, accelerations added to. */
+struct GravityTargets
+{
+    const double *x, *y, *z;
+    double *ax, *ay, *az;
+};
+
+/**
+ * @brief Adds to targets [begin, end) the pull of every source:
+ * a_i += sum_j gm_j d / (|d|^2 + softening2)^(3/2), d = source j - target i,
+ * skipping a source where |d|^2 + softening2 is 0 (the target itself).
+ * Sources go in tiles of 512 that stay in L1 while the targets run against
+ * them; the SIMD kernels take 4 (AVX2) or 8 (AVX-512) targets per
+ * instruction against one source at a time. Shared by NBodySystem and
+ * GravityOctree. @p kernel must be resolved (resolveGravityKernel()).
+ */
+void accumulateGravity(NBodyKernel kernel, const GravityTargets &targets, std::size_t begin, std::size_t end,
+                       const GravitySources &sources, double softening2);
+
+/**
+ * @brief As accumulateGravity(), for cells: adds the monopole and quadrupole
+ * pull of each (GravityOctree in octree.h). No cell may sit on a target.
+ */
+void accumulateCellGravity(NBodyKernel kernel, const GravityTargets &targets, std::size_t begin, std::size_t end,
+                           const GravityCells &cells, double softening2);
+
+bool isGravityKernelSupported(NBodyKernel kernel);
+/** @brief Auto: the widest kernel this CPU supports; an unsupported one: Scalar. */
+NBodyKernel resolveGravityKernel(NBodyKernel kernel);
+const char *gravityKernelName(NBodyKernel kernel);
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef HEADLESS_CONTEXT_H
+#define HEADLESS_CONTEXT_H
+
+#include "glad/glad.h"
+
+/**
+ * @brief Window-less OpenGL context for benchmarks and render-farm nodes.
+ *
+ * Uses EGL with a surfaceless display (EGL_MESA_platform_surfaceless, falling
+ * back to the default display + EGL_KHR_surfaceless_context), so it runs on
+ * Mesa llvmpipe without X11 or a GPU. Rendering goes into an offscreen
+ * framebuffer object of the requested size, which stays bound. The GL 4.3
+ * entry points are loaded too when the context provides them (GL43::isAvailable()).
+ */
+class HeadlessContext
+{
+public:
+    HeadlessContext(int width, int height, int glMajor = 3, int glMinor = 3);
+    ~HeadlessContext();
+
+    HeadlessContext(const HeadlessContext &) = delete;
+    HeadlessContext &operator=(const HeadlessContext &) = delete;
+
+    /** @brief True when the context is current, glad is loaded and the FBO is complete. */
+    bool isValid() const { return valid; }
+
+    /** @brief Binds the offscreen framebuffer and sets the viewport to cover it. */
+    void bindFramebuffer();
+
+    int width;
+    int height;
+
+private:
+    void *display = nullptr;
+    void *context = nullptr;
+    unsigned int fbo = 0;
+    unsigned int colorRbo = 0;
+    unsigned int depthRbo = 0;
+    bool valid = false;
+};
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef INDIRECT_RENDERER_H
+#define INDIRECT_RENDERER_H
+
+#include "glad/glad.h"
+#include "glm/glm/glm.hpp"
+#include "gl43.h"
+#include "lod.h"
+#include "mesh_cache.h"
+#include "shader.h"
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief GPU-driven sphere rendering for GL 4.3+: frustum culling and LOD
+ * selection in a compute shader (shaders/cull_bodies.comp), one
+ * glMultiDrawElementsIndirect per pass.
+ *
+ * Every level of every LodChain in use is copied once into a shared vertex
+ * and index buffer (32-bit indices, one VAO). Each frame, add() collects the
+ * bodies; cull() uploads them and dispatches one invocation per body, which
+ * picks the LOD level (same rule and hysteresis as LodMesh::select(), the
+ * level kept per body index across frames, so bodies should be added in a
+ * stable order) and appends the body's PlanetInstance to the indirect command
+ * of that level. draw() then submits all levels of a pass in one call.
+ *
+ * Pass 0 is drawn with the emissive shader, pass 1 with the lit one; both
+ * read PlanetInstance attributes, like InstanceBatch.
+ */
+class IndirectRenderer
+{
+public:
+    static const int kPasses = 2;
+
+    /** @brief The context is 4.3+ with the entry points loaded (see GL43::load()). */
+    static bool isSupported() { return GL43::isAvailable(); }
+
+    IndirectRenderer();
+    ~IndirectRenderer();
+
+    IndirectRenderer(const IndirectRenderer &) = delete;
+    IndirectRenderer &operator=(const IndirectRenderer &) = delete;
+
+    void clear() { bodies.clear(); }
+
+    /**
+     * @brief Queues a body for this frame's cull(). @p center / @p radius is
+     * the bounding sphere used for culling and LOD, @p pass 0 (emissive) or 1 (lit).
+     */
+    void add(const LodMesh &mesh, const glm::mat4 &model, const glm::vec3 &center, float radius, int textureLayer, int pass);
+    std::size_t size() const { return bodies.size(); }
+
+    /**
+     * @brief Uploads the queued bodies and runs culling and LOD selection on
+     * the GPU. @p fovY in radians; LOD as in LodMesh::select().
+     */
+    void cull(MeshCache &meshes, const glm::mat4 &viewProjection, const glm::vec3 &eye,
+              float fovY, float viewportHeight, const LodSettings &lodSettings);
+
+    /**
+     * @brief Draws the bodies of @p pass that survived cull() in one
+     * glMultiDrawElementsIndirect; @p shader must be in use with its
+     * view/projection uniforms set.
+     */
+    void draw(int pass, const Shader &shader);
+
+    /**
+     * @brief Triangles drawn two frames ago, read back from the command buffer
+     * without waiting on the GPU (per-frame stats).
+     */
+    std::size_t takeTriangleCount();
+
+private:
+    struct Level
+    {
+        float maxError;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint indexCount;
+        GLuint triangles;
+    };
+
+    // std430 layout of Body in cull_bodies.comp (96 bytes).
+    struct GpuBody
+    {
+        glm::mat4 model;
+        glm::vec4 sphere;
+        GLuint chain;
+        GLuint pass;
+        float textureLayer;
+        GLuint padding;
+    };
+
+    int chainIndex(const LodChain *chain);
+    void buildMeshPool(MeshCache &meshes);
+
+    Shader cullShader;
+
+    std::vector<const LodChain *> chains;
+    std::vector<GLuint> chainFirstLevel;
+    std::vector<Level> levels;
+    bool poolDirty = true;
+    GLenum primitiveMode = GL_TRIANGLES;
+    VertexFormat poolFormat = VertexFormat::Standard;
+
+    std::vector<GpuBody> bodies;
+    std::vector<DrawElementsIndirectCommand> commands;
+    bool passUsed[kPasses] = {};
+
+    GLuint vao = 0;
+    GLuint vertexBuffer = 0;
+    GLuint indexBuffer = 0;
+    GLuint bodyBuffer = 0;
+    GLuint chainBuffer = 0;
+    GLuint errorBuffer = 0;
+    GLuint commandBuffer = 0;
+    GLuint instanceBuffer = 0;
+    GLuint bodyLevelBuffer = 0;
+    GLuint readbackBuffers[2] = {0, 0};
+    std::size_t bodyLevelCount = 0;
+    std::size_t instanceCapacity = 0;
+    std::size_t bodyCapacity = 0;
+    unsigned long long frame = 0;
+    std::vector<DrawElementsIndirectCommand> readbackCommands[2];
+};
+
+#endif
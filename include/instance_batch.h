@@ -0,0 +1,56 @@
+#ifndef INSTANCE_BATCH_H
+#define INSTANCE_BATCH_H
+
+#include "glad/glad.h"
+#include "glm/glm/glm.hpp"
+#include "mesh_cache.h"
+#include "shader.h"
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief The sphere instances of one shader pass, drawn with one
+ * glDrawElementsInstanced per distinct mesh (i.e. per LOD level).
+ *
+ * add() only appends to a CPU array. draw() groups the instances by mesh,
+ * streams them all into one buffer (orphaned and refilled every frame) and
+ * issues one instanced draw per group; the shader reads the model matrix and
+ * texture array layer from the PlanetInstance attributes when its `instanced`
+ * uniform is set. With instancing off, draw() falls back to one draw per
+ * instance through the `model` and `textureLayer` uniforms.
+ */
+class InstanceBatch
+{
+public:
+    InstanceBatch() = default;
+    ~InstanceBatch();
+
+    InstanceBatch(const InstanceBatch &) = delete;
+    InstanceBatch &operator=(const InstanceBatch &) = delete;
+
+    void clear() { entries.clear(); }
+    void add(MeshHandle mesh, const glm::mat4 &model, int textureLayer);
+    std::size_t size() const { return entries.size(); }
+
+    /**
+     * @brief Draws every instance added since clear() with @p shader, which
+     * must be in use with its view/projection uniforms set.
+     * @return draw calls issued
+     */
+    std::size_t draw(MeshCache &meshes, const Shader &shader, bool instanced = true);
+
+private:
+    struct Entry
+    {
+        MeshHandle mesh;
+        PlanetInstance instance;
+    };
+
+    std::vector<Entry> entries;
+    std::vector<PlanetInstance> upload;
+    GLuint buffer = 0;
+    std::size_t capacity = 0; // instances the buffer holds
+};
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef INSTANCED_POINT_MESH_H
+#define INSTANCED_POINT_MESH_H
+
+#include "glad/glad.h"
+#include "glm/glm/glm.hpp"
+#include "shader.h"
+
+#include <cstddef>
+
+/**
+ * @brief Draws one small sphere (or one point of its projected size) at each
+ * position of a vec4 buffer, with shaders/nbody.vert and asteroid.frag, on
+ * GL 3.3.
+ *
+ * The buffer is bound as instance attribute 4 and only its xyz is read; it
+ * stays the caller's, who fills it however suits (GpuNBody integrates it in
+ * place as a storage buffer, SatelliteSwarm maps and writes it each frame).
+ * The sphere is an 80-triangle icosphere whose positions double as normals.
+ */
+class InstancedPointMesh
+{
+public:
+    explicit InstancedPointMesh(GLuint instanceBuffer);
+    ~InstancedPointMesh();
+
+    InstancedPointMesh(const InstancedPointMesh &) = delete;
+    InstancedPointMesh &operator=(const InstancedPointMesh &) = delete;
+
+    /** @brief Draws the first @p count instances, @p size units in radius, into the bound framebuffer. */
+    void draw(const glm::mat4 &view, const glm::mat4 &projection, const glm::vec3 &lightPos, float viewportHeight,
+              float size, bool points, std::size_t count);
+
+    /** @brief The sphere's vertex and index buffers, not the instance buffer. */
+    std::size_t gpuBytes() const;
+
+private:
+    Shader shader;
+    GLuint meshVBO = 0;
+    GLuint meshEBO = 0;
+    GLsizei meshIndexCount = 0;
+    GLuint vao = 0;
+};
+
+#endif
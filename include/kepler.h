@@ -0,0 +1,124 @@
+#ifndef KEPLER_H
+#define KEPLER_H
+
+#include "gravity_kernel.h"
+#include "glm/glm/glm.hpp"
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Classical elements of an elliptic two-body orbit. Angles are in
+ * radians; the reference plane is the scene's xz plane (y up) with +x the
+ * reference direction, so an orbit of zero inclination moves from +x towards
+ * +z like the planets (ecliptic x, y, z are the scene's x, z, y).
+ */
+struct OrbitalElements
+{
+    double semiMajorAxis = 1.0;
+    double eccentricity = 0.0;  // [0, 1)
+    double inclination = 0.0;
+    double ascendingNode = 0.0; // longitude of the ascending node
+    double periapsis = 0.0;     // argument of periapsis
+    double meanAnomaly = 0.0;   // at epoch
+    double epoch = 0.0;         // seconds
+    double meanMotion = 1.0;    // radians per second; sqrt(gm / a^3) around a central gm
+};
+
+struct KeplerSettings
+{
+    NBodyKernel kernel = NBodyKernel::Auto; // SIMD width, as NBodySettings::kernel
+    unsigned int threads = 0;               // 0: one per hardware thread
+    int maxIterations = 8;                  // Halley iterations per body at most; 3 are typical below e = 0.9
+};
+
+/**
+ * @brief Solves Kepler's equation M = E - e sin E for the eccentric anomaly E,
+ * with Danby's starter E = M + 0.85 e sign(M) (M reduced to [-pi, pi]) and
+ * Halley iterations until the step is under 1e-8 (the next would be under
+ * 1e-20), at most @p maxIterations. Optionally returns sin E and cos E.
+ */
+double solveKepler(double meanAnomaly, double eccentricity, int maxIterations = 8, double *sinE = nullptr, double *cosE = nullptr);
+
+/**
+ * @brief Unit vectors, in scene coordinates, towards the periapsis (P) and
+ * 90 degrees further along the motion (Q); the orbit's normal is P x Q.
+ */
+void perifocalBasis(double inclination, double ascendingNode, double periapsis, glm::dvec3 &p, glm::dvec3 &q);
+
+/** @brief Position (and velocity) at time @p t relative to the focus. */
+void keplerState(const OrbitalElements &elements, double t, glm::dvec3 &position, glm::dvec3 *velocity = nullptr);
+
+/**
+ * @brief The osculating elements, with epoch @p t, of a state relative to a
+ * focus of gravitational parameter @p gm: the inverse of keplerState(). The
+ * node of an equatorial orbit and the periapsis of a circular one are zero.
+ * @return false, leaving @p elements alone, unless the orbit is elliptic
+ */
+bool osculatingElements(const glm::dvec3 &position, const glm::dvec3 &velocity, double gm, double t, OrbitalElements &elements);
+
+/**
+ * @brief Analytic two-body propagation of many elliptic orbits at once.
+ *
+ * The elements are kept as structure-of-arrays doubles, with what every
+ * evaluation needs precomputed (semi-minor axis, P and Q). Each propagate()
+ * solves Kepler's equation for every orbit at the requested time: mean
+ * anomaly from the epoch, Danby's starter and Halley iterations, 4 (AVX2) or
+ * 8 (AVX-512) orbits per instruction with a polynomial sine and cosine, until
+ * every lane's step is under 1e-8 or settings.maxIterations. The work is split
+ * over up to settings.threads threads. Any epoch is evaluated directly, so
+ * jumping a century costs the same as stepping a frame.
+ */
+class KeplerPropagator
+{
+public:
+    explicit KeplerPropagator(const KeplerSettings &settings = KeplerSettings());
+
+    /** @return the orbit's index */
+    std::size_t add(const OrbitalElements &elements);
+    void reserve(std::size_t count);
+    void clear();
+    /** @brief Grows or shrinks to @p count orbits; new ones are the default elements until set(). */
+    void resize(std::size_t count);
+    std::size_t size() const { return semiMajorAxis.size(); }
+
+    /** @brief Replaces orbit @p i; threads may set different orbits at once. */
+    void set(std::size_t i, const OrbitalElements &elements);
+    OrbitalElements elements(std::size_t i) const;
+
+    /**
+     * @brief The kColumns arrays of size() doubles that hold the orbits, for
+     * saving them as an image and restoring it (resize(), then copy every
+     * column) without recomputing anything.
+     */
+    static const int kColumns = 15;
+    double *column(int c) { return columns()[c]->data(); }
+    const double *column(int c) const { return const_cast<KeplerPropagator *>(this)->columns()[c]->data(); }
+
+    /**
+     * @brief Writes every orbit's position relative to its focus at time @p t,
+     * and its velocity if @p vx, @p vy and @p vz are given.
+     */
+    void propagate(double t, double *x, double *y, double *z,
+                   double *vx = nullptr, double *vy = nullptr, double *vz = nullptr) const;
+
+    NBodyKernel kernel() const { return activeKernel; }
+    const KeplerSettings &getSettings() const { return settings; }
+
+private:
+    KeplerSettings settings;
+    NBodyKernel activeKernel;
+
+    // Read by every propagate().
+    std::vector<double> meanAnomaly, epoch, meanMotion;
+    std::vector<double> eccentricity, semiMajorAxis, semiMinorAxis;
+    std::vector<double> px, py, pz, qx, qy, qz;
+
+    // Kept for elements() only.
+    std::vector<double> inclination, ascendingNode, periapsis;
+
+    std::array<std::vector<double> *, kColumns> columns();
+};
+
+#endif
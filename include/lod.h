@@ -0,0 +1,49 @@
+#ifndef LOD_H
+#define LOD_H
+
+#include "mesh_cache.h"
+#include "glm/glm/glm.hpp"
+
+/** @brief Screen-space error budget for discrete LOD selection. */
+struct LodSettings
+{
+    bool enabled = true;      // false: always the finest level
+    float maxErrorPx = 0.5f;  // allowed silhouette error in pixels
+    float hysteresis = 0.25f; // switch finer above maxErrorPx * (1 + h), coarser below maxErrorPx * (1 - h)
+};
+
+/**
+ * @brief Radius in pixels of the screen-space disc covered by a sphere at
+ * @p center seen from @p eye with a vertical field of view @p fovY (radians).
+ */
+float projectedRadiusPx(const glm::vec3 &center, float radius, const glm::vec3 &eye, float fovY, float viewportHeight);
+
+/**
+ * @brief A body's mesh slot: a LodChain plus the level currently selected.
+ *
+ * select() picks the coarsest level whose error, scaled by the projected
+ * radius, stays within the pixel budget. The hysteresis band keeps a body
+ * hovering around a switching distance from alternating between two levels.
+ */
+class LodMesh
+{
+public:
+    LodMesh() = default;
+    explicit LodMesh(const LodChain *lodChain) : chain(lodChain) {}
+
+    explicit operator bool() const { return chain && !chain->levels.empty(); }
+
+    /** @brief Updates the selected level for a body covering @p radiusPx pixels and returns its mesh. */
+    MeshHandle select(float radiusPx, const LodSettings &settings);
+
+    /** @brief The mesh of the selected level (the finest until select() is called). */
+    MeshHandle current() const { return *this ? chain->levels[level].mesh : MeshHandle(); }
+    int currentLevel() const { return level; }
+    const LodChain *getChain() const { return chain; }
+
+private:
+    const LodChain *chain = nullptr;
+    int level = 0;
+};
+
+#endif
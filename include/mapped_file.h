@@ -0,0 +1,35 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief A whole file mapped read-only into memory (mmap, or a file mapping
+ * on Windows), for readers that parse or index large files in place.
+ * isOpen() is true for an empty file too; data() is then null.
+ */
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool isOpen() const { return opened; }
+    const char *data() const { return (const char *)view; }
+    std::size_t size() const { return bytes; }
+
+private:
+#ifdef _WIN32
+    void *file = nullptr;
+    void *mapping = nullptr;
+#endif
+    void *view = nullptr;
+    std::size_t bytes = 0;
+    bool opened = false;
+};
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include "planet.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+/** @brief Index of a mesh inside a MeshCache; default-constructed handles are empty. */
+struct MeshHandle
+{
+    int id = -1;
+
+    explicit operator bool() const { return id >= 0; }
+    bool operator==(const MeshHandle &other) const { return id == other.id; }
+    bool operator!=(const MeshHandle &other) const { return id != other.id; }
+};
+
+/** @brief Sphere generator behind a cached mesh (see generateUVSphere() and friends in planet.h). */
+enum class SphereType
+{
+    UV,
+    Icosphere,
+    CubeSphere
+};
+
+/** @brief One level of a LodChain: a mesh and its sphereMaxRadialError(). */
+struct LodLevel
+{
+    MeshHandle mesh;
+    float maxError;
+};
+
+/** @brief The same sphere at decreasing tessellation, finest level first. */
+struct LodChain
+{
+    std::vector<LodLevel> levels;
+};
+
+/**
+ * @brief Owns one unit-radius sphere mesh per generator and tessellation and hands them out by handle.
+ *
+ * Bodies of any size share a mesh: the radius goes into the model matrix
+ * (glm::scale), so changing a body's size never creates or deletes GL
+ * objects. Meshes live until the cache is destroyed; handles stay valid for
+ * the cache's lifetime.
+ */
+class MeshCache
+{
+public:
+    explicit MeshCache(const MeshOptions &meshOptions = MeshOptions()) : options(meshOptions) {}
+
+    /** @brief Layout shared by every mesh in the cache; shaders need it for `compactVertices`. */
+    VertexFormat vertexFormat() const { return options.format; }
+    const MeshOptions &meshOptions() const { return options; }
+
+    /** @brief Returns the unit sphere with this tessellation, building it on first request. */
+    MeshHandle acquireSphere(unsigned int rings, unsigned int sectors);
+    MeshHandle acquireIcosphere(unsigned int subdivisions);
+    MeshHandle acquireCubeSphere(unsigned int segments);
+
+    /**
+     * @brief UV sphere LOD chain from finestRings x finestRings down to 8x8,
+     * each level with ~3/4 of the previous rings and sectors. The chain is
+     * owned by the cache and shared by every caller asking for the same finest level.
+     */
+    const LodChain *acquireSphereLod(unsigned int finestRings);
+
+    Planet &get(MeshHandle handle);
+    /** @brief Geometric error of the mesh relative to the unit sphere (see sphereMaxRadialError()). */
+    float maxError(MeshHandle handle) const { return entries[handle.id].maxError; }
+    void draw(MeshHandle handle);
+    /** @brief One instanced draw of @p instanceCount PlanetInstance records (see Planet::drawInstanced()). */
+    void drawInstanced(MeshHandle handle, GLuint instanceBuffer, GLintptr offset, GLsizei instanceCount);
+
+    /** @brief Triangles drawn through draw() since the last call (per-frame stats). */
+    std::size_t takeTriangleCount();
+
+    /** @brief Number of distinct meshes (= GL vertex arrays) held. */
+    std::size_t size() const { return entries.size(); }
+
+private:
+    /** @brief `a`/`b` are the generator's tessellation parameters (rings/sectors, subdivisions, segments). */
+    MeshHandle acquire(SphereType type, unsigned int a, unsigned int b);
+
+    struct Entry
+    {
+        SphereType type;
+        unsigned int a;
+        unsigned int b;
+        std::unique_ptr<Planet> mesh;
+        float maxError;
+    };
+
+    MeshOptions options;
+    std::vector<Entry> entries;
+    std::vector<std::pair<unsigned int, std::unique_ptr<LodChain>>> lodChains;
+    std::size_t trianglesDrawn = 0;
+};
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include "glm/glm/glm.hpp"
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Index/vertex buffer optimization passes run on freshly generated meshes.
+ *
+ * Typical order: removeDegenerateTriangles -> optimizeVertexCache ->
+ * optimizeVertexFetch (+ remapVertices on every attribute array) ->
+ * optionally buildTriangleStrips.
+ */
+namespace MeshOptimizer
+{
+    /** @brief Post-transform cache efficiency of a triangle list. */
+    struct CacheStats
+    {
+        float acmr = 0.0f;   // average cache miss ratio: vertex shader runs per triangle (0.5 is ideal for a grid)
+        float atvr = 0.0f;   // average transformed vertex ratio: shader runs per referenced vertex (1.0 is ideal)
+    };
+
+    /**
+     * @brief Drops triangles that repeat an index or whose corners coincide in
+     * space (an edge shorter than 1e-5 of the longest one), such as the
+     * zero-area fans around the poles of a UV sphere.
+     * @return number of triangles removed.
+     */
+    std::size_t removeDegenerateTriangles(std::vector<unsigned int> &indices, const std::vector<glm::vec3> &positions);
+
+    /**
+     * @brief Reorders triangles for a post-transform vertex cache (Forsyth's
+     * linear-speed algorithm with an LRU cache of @p cacheSize entries).
+     */
+    void optimizeVertexCache(std::vector<unsigned int> &indices, std::size_t vertexCount, unsigned int cacheSize = 32);
+
+    /**
+     * @brief Renumbers vertices in order of first use so vertex fetch walks memory
+     * linearly; vertices no triangle references are dropped.
+     * @return remap table, old index -> new index (~0u for dropped vertices).
+     * Apply it to every attribute array with remapVertices().
+     */
+    std::vector<unsigned int> optimizeVertexFetch(std::vector<unsigned int> &indices, std::size_t vertexCount);
+
+    /** @brief Applies a remap table from optimizeVertexFetch() to one attribute array. */
+    template <typename T>
+    void remapVertices(std::vector<T> &vertices, const std::vector<unsigned int> &remap)
+    {
+        std::size_t newCount = 0;
+        for (unsigned int target : remap)
+        {
+            if (target != ~0u && target + 1 > newCount)
+                newCount = target + 1;
+        }
+
+        std::vector<T> remapped(newCount);
+        for (std::size_t i = 0; i < remap.size() && i < vertices.size(); ++i)
+        {
+            if (remap[i] != ~0u)
+                remapped[remap[i]] = vertices[i];
+        }
+        vertices.swap(remapped);
+    }
+
+    /**
+     * @brief Greedy stripifier: converts a triangle list into triangle strips
+     * separated by @p restartIndex (for GL_PRIMITIVE_RESTART), preserving
+     * winding and following the list order so cache locality is kept.
+     */
+    std::vector<unsigned int> buildTriangleStrips(const std::vector<unsigned int> &indices, unsigned int restartIndex);
+
+    /** @brief Simulates a FIFO post-transform cache of @p cacheSize entries over a triangle list. */
+    CacheStats analyzeVertexCache(const std::vector<unsigned int> &indices, std::size_t vertexCount, unsigned int cacheSize = 16);
+
+    /** @brief Same, for a strip index buffer with restarts. */
+    CacheStats analyzeStripVertexCache(const std::vector<unsigned int> &strips, std::size_t vertexCount,
+                                       unsigned int restartIndex, unsigned int cacheSize = 16);
+}
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef NBODY_H
+#define NBODY_H
+
+#include "body_state.h"
+#include "gravity_kernel.h"
+#include "octree.h"
+#include "glm/glm/glm.hpp"
+
+#include <cstddef>
+#include <vector>
+
+enum class NBodyIntegrator
+{
+    Leapfrog, // kick-drift-kick, 2nd order, one force evaluation per step
+    Yoshida4  // three leapfrog substeps (Yoshida 1990), 4th order, three force evaluations per step
+};
+
+enum class NBodySolver
+{
+    Direct,   // every pair, O(n^2)
+    BarnesHut // GravityOctree (octree.h), O(n log n), approximate
+};
+
+struct NBodySettings
+{
+    bool enabled = false; // for Renderer::setNBody(): false keeps the analytic orbits
+    NBodyIntegrator integrator = NBodyIntegrator::Yoshida4;
+    NBodyKernel kernel = NBodyKernel::Auto;
+    double dt = 1.0 / 480.0;  // fixed step in simulated seconds
+    double softening = 0.0;   // Plummer softening length; 0: exact 1/r^2
+    unsigned int threads = 0; // 0: one per hardware thread
+    int maxSteps = 4096;      // advanceTo() takes at most this many steps per call
+    NBodySolver solver = NBodySolver::Direct;
+    double openingAngle = 0.5; // BarnesHut: see OctreeSettings
+    bool quadrupole = true;    // BarnesHut: see OctreeSettings
+};
+
+/**
+ * @brief Gravitational N-body integrator by direct summation, or by a
+ * Barnes-Hut octree (settings.solver) for large counts.
+ *
+ * Positions, velocities and accelerations are structure-of-arrays doubles.
+ * Each force evaluation sums, for every body, the pull of every body with
+ * gm > 0 (bodies with gm = 0 are test particles: pulled, never pulling) with
+ * accumulateGravity() (gravity_kernel.h), on up to settings.threads threads
+ * split over the targets. With BarnesHut the massive bodies go into a GravityOctree
+ * rebuilt every evaluation instead.
+ *
+ * The integrators are symplectic: energy is not conserved exactly but its
+ * error stays bounded instead of drifting, which energyDrift() reports.
+ */
+class NBodySystem
+{
+public:
+    explicit NBodySystem(const NBodySettings &settings = NBodySettings());
+
+    /** @param gm gravitational parameter G * mass; 0 for a test particle. @return the body's index */
+    std::size_t add(const glm::dvec3 &position, const glm::dvec3 &velocity, double gm);
+    void clear();
+    std::size_t size() const { return x.size(); }
+    std::size_t massiveCount() const;
+
+    /** @brief One step of settings.dt (backwards if @p direction < 0). */
+    void step(int direction = 1);
+
+    /**
+     * @brief Steps until time() is within half a step of @p t, forwards or
+     * backwards (the integrators are time-reversible), at most settings.maxSteps.
+     * @return the number of steps taken
+     */
+    int advanceTo(double t);
+
+    double time() const { return currentTime; }
+    glm::dvec3 position(std::size_t i) const { return glm::dvec3(x[i], y[i], z[i]); }
+    glm::dvec3 velocity(std::size_t i) const { return glm::dvec3(vx[i], vy[i], vz[i]); }
+    /** @brief As of the last computeAccelerations(). */
+    glm::dvec3 acceleration(std::size_t i) const { return glm::dvec3(ax[i], ay[i], az[i]); }
+
+    /** @brief G times the total energy of the massive bodies (kinetic + potential); O(n^2). */
+    double energy() const;
+    /** @brief |energy() - E0| / |E0|, E0 being the energy at the first step after the last add(). */
+    double energyDrift() const;
+
+    /** @brief Recomputes every acceleration; what step() does once per leapfrog substep. */
+    void computeAccelerations();
+    /**
+     * @brief Interactions per computeAccelerations(): bodies x massive bodies
+     * for Direct; for BarnesHut, the cells and bodies the last one summed.
+     */
+    double interactionsPerEvaluation() const;
+
+    /** @brief The kernel settings.kernel resolves to on this CPU (Direct only). */
+    NBodyKernel kernel() const { return activeKernel; }
+    static bool isSupported(NBodyKernel kernel);
+    static const char *kernelName(NBodyKernel kernel);
+
+private:
+    void kickDriftKick(double dt);
+    void gatherSources();
+
+    NBodySettings settings;
+    NBodyKernel activeKernel;
+
+    std::vector<double> x, y, z;
+    std::vector<double> vx, vy, vz;
+    std::vector<double> ax, ay, az;
+    std::vector<double> gm;
+
+    // Massive bodies, copied before each evaluation.
+    std::vector<double> sourceX, sourceY, sourceZ, sourceGm;
+    std::size_t sourceCount = 0;
+    GravityOctree tree; // BarnesHut: rebuilt from the sources every evaluation
+
+    double currentTime = 0.0;
+    bool accelerationsValid = false;
+    double initialEnergy = 0.0;
+    bool initialEnergyValid = false;
+};
+
+/**
+ * @brief Fills @p system with the bodies of @p state at t = 0: positions and
+ * velocities on their orbits (bodyOrbit()), with the mean motion the parent's
+ * gm gives at that semi-major axis (or the analytic orbitSpeed around a
+ * massless parent), with the massive bodies' net momentum removed. Body i of
+ * the system is slot i.
+ */
+void initializeFromBodies(NBodySystem &system, BodyState &state);
+
+/** @brief Copies the system's positions into state.position* (slot i = body i) and rebuilds the model matrices. */
+void writeToBodies(const NBodySystem &system, BodyState &state, float t);
+
+#endif
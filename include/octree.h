@@ -0,0 +1,112 @@
+#ifndef OCTREE_H
+#define OCTREE_H
+
+#include "glm/glm/glm.hpp"
+#include "gravity_kernel.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct OctreeSettings
+{
+    double openingAngle = 0.5; // theta: smaller is more accurate and slower; 0 opens every cell (direct summation); at most ~1.15
+    bool quadrupole = true;    // add each accepted cell's quadrupole term, not just its monopole
+    int leafSize = 8;          // a cell with at most this many bodies is not split
+    double softening = 0.0;    // Plummer softening length, as NBodySettings::softening
+    unsigned int threads = 0;  // 0: one per hardware thread
+    NBodyKernel kernel = NBodyKernel::Auto;
+};
+
+/**
+ * @brief One octree cell: what the traversal reads for every cell it visits.
+ * The cells are stored in depth-first order, so a cell's subtree is the skip
+ * cells starting at itself and its first child, if any, is the next cell.
+ */
+struct OctreeNode
+{
+    double x, y, z;        // centre of mass
+    double gm;
+    double openRadius2;    // the cell is accepted as a whole from farther than sqrt(openRadius2)
+    std::uint32_t skip;    // cells in this subtree, itself included
+    std::uint32_t first;   // first of its bodies in Morton order
+    std::uint32_t count;   // number of bodies
+    std::uint32_t isLeaf;
+};
+
+/** @brief Traceless quadrupole sum(gm (3 r r^T - |r|^2 I)) about a cell's centre of mass. */
+struct OctreeQuadrupole
+{
+    double xx, yy, zz, xy, xz, yz;
+};
+
+/**
+ * @brief Barnes-Hut gravity: O(n log n) accelerations from an octree of the
+ * massive bodies, each distant cell standing in for all its bodies.
+ *
+ * build() gives every body a 63-bit Morton code within the bounding cube and
+ * radix-sorts them (on threads), so every cell's bodies are one contiguous
+ * range. The subtrees below the top two levels are built on threads too, each
+ * into its own array, then spliced: skip counts are relative, so nothing needs
+ * renumbering. Cells are 56 bytes with their quadrupoles in a separate array,
+ * read only for accepted cells.
+ *
+ * accelerations() sorts the targets by Morton code too and walks the tree
+ * once per group of 32 consecutive ones, with no stack (accept: jump skip
+ * cells; open: step into the first child). A cell is accepted if it is beyond
+ * l / theta + |centre of mass - cell centre| (l the cell size) from the
+ * group's bounding box, which also keeps any cell holding a target open for
+ * theta < 2/sqrt(3). The accepted cells and the bodies of opened leaves form
+ * one list summed for the whole group by accumulateGravity() (gravity_kernel.h),
+ * then the accepted cells' quadrupoles. Threads take groups as they go.
+ */
+class GravityOctree
+{
+public:
+    void build(const double *x, const double *y, const double *z, const double *gm, std::size_t count,
+               const OctreeSettings &settings);
+
+    /** @brief Sets a[i] to the acceleration at (x[i], y[i], z[i]) for @p count targets (need not be the built bodies). */
+    void accelerations(const double *x, const double *y, const double *z, double *ax, double *ay, double *az,
+                       std::size_t count) const;
+
+    std::size_t nodeCount() const { return nodes.size(); }
+    std::size_t bodyCount() const { return bodyGm.size(); }
+    /** @brief Target-cell and target-body interactions summed by the last accelerations(). */
+    double lastInteractions() const { return interactions; }
+
+private:
+    struct BuildRange
+    {
+        std::uint32_t begin, end;
+        int level;
+        glm::dvec3 corner;
+    };
+
+    void buildSubtree(std::vector<OctreeNode> &out, std::vector<OctreeQuadrupole> &outQuadrupoles, const BuildRange &range) const;
+    int childRanges(const BuildRange &range, BuildRange children[8]) const;
+    void finishLeaf(OctreeNode &node, OctreeQuadrupole &quadrupole, const BuildRange &range) const;
+    void finishInternal(std::vector<OctreeNode> &out, std::vector<OctreeQuadrupole> &outQuadrupoles, std::size_t index,
+                        const std::size_t *children, int childCount, const BuildRange &range) const;
+    std::size_t assemble(const BuildRange &range, std::vector<std::vector<OctreeNode>> &taskNodes,
+                         std::vector<std::vector<OctreeQuadrupole>> &taskQuadrupoles, std::size_t &nextTask);
+    void collectTasks(const BuildRange &range, std::vector<BuildRange> &tasks) const;
+
+    std::uint64_t mortonCode(double x, double y, double z) const;
+    double cellSize(int level) const { return rootSize / (double)(1u << level); }
+
+    OctreeSettings settings;
+    glm::dvec3 rootCorner = glm::dvec3(0.0);
+    double rootSize = 1.0;
+
+    std::vector<OctreeNode> nodes;
+    std::vector<OctreeQuadrupole> quadrupoles; // quadrupoles[i] belongs to nodes[i]
+
+    // The bodies in Morton order, with their codes.
+    std::vector<std::uint64_t> codes;
+    std::vector<double> bodyX, bodyY, bodyZ, bodyGm;
+
+    mutable double interactions = 0.0;
+};
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef ORBIT_LINES_H
+#define ORBIT_LINES_H
+
+#include "glad/glad.h"
+#include "glm/glm/glm.hpp"
+#include "shader.h"
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief A Keplerian ellipse around a parent body. The parent's position is
+ * not stored: it is set every frame through OrbitLines::setParentPosition().
+ */
+struct OrbitPath
+{
+    int parent = 0;                           // slot in OrbitLines::setParentPosition()
+    float semiMajorAxis = 1.0f;
+    float eccentricity = 0.0f;
+    glm::vec3 periapsis = glm::vec3(1, 0, 0); // unit direction from the parent to periapsis
+    glm::vec3 normal = glm::vec3(0, -1, 0);   // unit angular momentum direction (-y: moving from +x towards +z, like the planets)
+    glm::vec3 color = glm::vec3(1.0f);
+};
+
+/** @brief Screen-space error budget for orbit line tessellation. */
+struct OrbitLineSettings
+{
+    float maxErrorPx = 0.5f;     // allowed distance in pixels between a segment and the ellipse
+    int maxSegmentsPerArc = 256; // rounded up to a power of two; an arc the camera is on gets that many
+};
+
+/**
+ * @brief Every orbit line of the scene in one multi-draw, tessellated per arc
+ * from its projected error.
+ *
+ * Each orbit is cut into kArcs arcs of equal eccentric anomaly. Every frame,
+ * draw() frustum-culls the orbits and their arcs and gives each visible arc the
+ * fewest segments (a power of two) whose chord error, projected at the arc's
+ * nearest distance to the camera, stays within OrbitLineSettings::maxErrorPx.
+ * The bound uses the ellipse's curvature over the arc, so an eccentric orbit
+ * gets its segments around periapsis and apoapsis and few along its flat sides.
+ *
+ * The vertices are not stored anywhere: shaders/orbit.vert decodes the orbit,
+ * the arc and the segment count from gl_VertexID and reads the orbit's shape
+ * from a texture buffer uploaded only when an orbit is added or changed. What
+ * moves every frame (the parents' positions) goes in a uniform array, so
+ * drawing costs no buffer upload and the vertex count follows what is visible
+ * rather than the number of orbits.
+ */
+class OrbitLines
+{
+public:
+    static const int kMaxParents = 32; // size of `parentPositions` in orbit.vert
+    static const int kArcs = 16;       // arcs per orbit; 0 and pi (periapsis, apoapsis) are arc ends
+
+    OrbitLines();
+    ~OrbitLines();
+
+    OrbitLines(const OrbitLines &) = delete;
+    OrbitLines &operator=(const OrbitLines &) = delete;
+
+    /** @return the orbit's index, for set() */
+    std::size_t add(const OrbitPath &orbit);
+    void set(std::size_t index, const OrbitPath &orbit);
+    void clear();
+    std::size_t size() const { return orbits.size(); }
+
+    void setParentPosition(int parent, const glm::vec3 &position);
+
+    void setSettings(const OrbitLineSettings &lineSettings) { settings = lineSettings; }
+
+    /**
+     * @brief Selects the arcs and their tessellation for this view and draws
+     * them with @p shader (shaders/orbit.vert/.frag), which must be in use
+     * with its view/projection uniforms set. Uses texture unit 0.
+     */
+    void draw(const Shader &shader, const glm::mat4 &viewProjection, const glm::vec3 &eye, float fovY, float viewportHeight);
+
+    /** @brief Arcs and line vertices of the last draw(). */
+    std::size_t getArcCount() const { return firsts.size(); }
+    std::size_t getVertexCount() const { return vertexCount; }
+
+private:
+    // One orbit in the texture buffer read by orbit.vert: three RGBA32F texels.
+    struct OrbitRecord
+    {
+        glm::vec3 periapsis;   // scaled by the semi-major axis
+        float eccentricity;
+        glm::vec3 minorAxis;   // scaled by the semi-minor axis
+        float parent;
+        glm::vec3 color;
+        float padding;
+    };
+
+    void upload();
+
+    std::vector<OrbitPath> orbits;
+    std::vector<OrbitRecord> records;
+    glm::vec3 parentPositions[kMaxParents];
+    OrbitLineSettings settings;
+
+    // Rebuilt by every draw(), kept to reuse their storage.
+    std::vector<GLint> firsts;
+    std::vector<GLsizei> counts;
+    std::size_t vertexCount = 0;
+
+    GLuint vao = 0; // no attributes: orbit.vert only reads gl_VertexID
+    GLuint orbitBuffer = 0;
+    GLuint orbitTexture = 0;
+    bool dirty = false;
+};
+
+#endif
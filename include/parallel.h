@@ -0,0 +1,78 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief The fork/join helpers the CPU solvers split their loops with.
+ *
+ * Threads are started per call and joined before returning, the calling
+ * thread taking the first share; there is no pool. Starting a thread costs
+ * tens of microseconds, so each caller gives threadCount() the least work
+ * per thread worth that (in its own units: orbits, bodies, bytes, ...) and
+ * small calls stay on the calling thread.
+ */
+namespace Parallel
+{
+    /**
+     * @return @p requested threads (0: one per hardware thread), but no more
+     * than leave each at least @p minWorkPerThread of @p work; at least 1
+     */
+    inline unsigned int threadCount(unsigned int requested, std::size_t work, std::size_t minWorkPerThread)
+    {
+        unsigned int threads = requested ? requested : std::max(1u, std::thread::hardware_concurrency());
+        return (unsigned int)std::max<std::size_t>(1, std::min<std::size_t>(threads, work / std::max<std::size_t>(minWorkPerThread, 1)));
+    }
+
+    /** @brief Runs fn(0) .. fn(count - 1), each on its own thread but fn(0), which runs on this one. */
+    template <typename Fn>
+    void parallelFor(unsigned int count, Fn fn)
+    {
+        std::vector<std::thread> workers;
+        workers.reserve(count > 0 ? count - 1 : 0);
+        for (unsigned int i = 1; i < count; ++i)
+            workers.emplace_back(fn, i);
+        if (count > 0)
+            fn(0u);
+        for (std::thread &worker : workers)
+            worker.join();
+    }
+
+    /** @brief Runs fn(thread, begin, end) over @p threads even slices of [0, count). */
+    template <typename Fn>
+    void parallelSlices(unsigned int threads, std::size_t count, Fn fn)
+    {
+        parallelFor(threads, [&](unsigned int t) { fn(t, count * t / threads, count * (t + 1) / threads); });
+    }
+
+    /**
+     * @brief Runs work(n) for n in [0, chunks) on up to @p threads threads,
+     * each claiming the next n when it is free, for work that costs unevenly.
+     * With a @p deadline, threads stop claiming once it has passed.
+     * @return how many ran: always a prefix of the chunks
+     */
+    template <typename Fn>
+    std::size_t runChunks(std::size_t chunks, unsigned int threads, Fn work,
+                          const std::chrono::steady_clock::time_point *deadline = nullptr)
+    {
+        std::atomic<std::size_t> next(0);
+        parallelFor(std::max(threads, 1u), [&](unsigned int)
+        {
+            while (!deadline || std::chrono::steady_clock::now() < *deadline)
+            {
+                std::size_t n = next.fetch_add(1);
+                if (n >= chunks)
+                    return;
+                work(n);
+            }
+        });
+        return std::min(next.load(), chunks);
+    }
+}
+
+#endif
@@ -1,23 +1,155 @@
 #ifndef PLANET_H
 #define PLANET_H
 
-#include "glad\glad.h"
+#include "glad/glad.h"
 #include <vector>
-#include "glm\glm\glm.hpp"
-#include "glm\glm\gtc\constants.hpp"
+#include "glm/glm/glm.hpp"
+#include "glm/glm/gtc/constants.hpp"
+
+/**
+ * @brief Vertex layout of a Planet's VBO.
+ *
+ * Standard: float position(3) + normal(3) + texcoord(2), 32 bytes per vertex.
+ * Compact:  snorm16 octahedral normal(2) at location 3 + unorm16 texcoord(2)
+ *           at location 2, 8 bytes per vertex. Location 0 is left disabled and
+ *           the shaders rebuild the position from the normal, so it is only
+ *           used for unit-radius spheres (size comes from the model matrix);
+ *           other radii fall back to Standard.
+ * Shaders select the decode path with the `compactVertices` uniform.
+ */
+enum class VertexFormat
+{
+    Standard,
+    Compact
+};
+
+/** @brief How a Planet's mesh is built and laid out on the GPU. */
+struct MeshOptions
+{
+    VertexFormat format = VertexFormat::Standard;
+    bool optimize = true;        // drop degenerate pole triangles, reorder for the vertex cache and vertex fetch
+    bool triangleStrips = false; // GL_TRIANGLE_STRIP with primitive restart instead of GL_TRIANGLES
+};
+
+/** @brief Bytes per vertex of @p format. */
+GLsizei vertexStride(VertexFormat format);
+
+/** @brief Enables and points the vertex attributes of @p format at the bound VAO's GL_ARRAY_BUFFER. */
+void setVertexAttributes(VertexFormat format);
+
+/**
+ * @brief Per-instance vertex data of an instanced Planet draw (80 bytes):
+ * the model matrix at locations 4-7 and the body's texture array layer at
+ * location 8, both with divisor 1.
+ */
+struct PlanetInstance
+{
+    glm::mat4 model;
+    float textureLayer;
+    float padding[3];
+};
+
+/** @brief CPU-side sphere mesh between generation and upload. */
+struct MeshData
+{
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> texCoords;
+    std::vector<unsigned int> indices;   // triangle list, or strips separated by restartIndex
+    GLenum primitiveMode = GL_TRIANGLES;
+    GLuint restartIndex = 0xFFFFFFFFu;
+};
+
+/** @brief The original ring-by-ring UV sphere, including the zero-area triangles at both poles. */
+MeshData generateUVSphere(float radius, unsigned int rings, unsigned int sectors);
+
+/**
+ * @brief Subdivided icosahedron, 20 * 4^subdivisions near-equal triangles.
+ * Texture coordinates are equirectangular like the UV sphere's; vertices on
+ * the u seam and at the poles are duplicated so no triangle wraps around the
+ * texture (seam copies have u > 1 and rely on GL_REPEAT).
+ */
+MeshData generateIcosphere(float radius, unsigned int subdivisions);
+
+/**
+ * @brief Spherified cube with segments x segments quads per face, 12 * segments^2 triangles.
+ * Each face has its own vertices and texture coordinates into a 3x2 atlas:
+ * +X -X +Y on the top row of the image, -Y +Z -Z on the bottom row, each face
+ * oriented as for GL_TEXTURE_CUBE_MAP (so cube map face images can be tiled as is).
+ */
+MeshData generateCubeSphere(float radius, unsigned int segments);
+
+/**
+ * @brief Corner and edge vectors of cube face @p face (GL_TEXTURE_CUBE_MAP_POSITIVE_X + i
+ * order and orientation): the cube point of face coordinates (s, t) in [0,1] is origin + s * u + t * v.
+ */
+void cubeFaceBasis(int face, glm::vec3 &origin, glm::vec3 &u, glm::vec3 &v);
+
+/** @brief Unit-sphere direction of face coordinates (s, t) on the spherified cube of generateCubeSphere(). */
+glm::vec3 cubeSphereDirection(int face, float s, float t);
+
+/**
+ * @brief Largest radial gap, 1 - |p| over every point p of every triangle, of
+ * a mesh whose vertices lie on the unit sphere. Bounds how far the silhouette
+ * falls inside the true outline: times the projected radius it is the error in pixels.
+ */
+float sphereMaxRadialError(const MeshData &mesh);
+
+/**
+ * @brief Applies MeshOptions::optimize and MeshOptions::triangleStrips to a
+ * generated mesh (the vertex format is applied at upload).
+ */
+void prepareMesh(MeshData &mesh, const MeshOptions &options);
 
 class Planet
 {
 public:
-    Planet(float radius, unsigned int rings, unsigned int sectors);
+    /**
+     * @brief Builds and uploads a UV sphere. With options.optimize off and
+     * the Standard triangle-list layout, the mesh is written by writeUVSphere()
+     * straight into the mapped GL buffers, with no intermediate arrays.
+     */
+    Planet(float radius, unsigned int rings, unsigned int sectors, const MeshOptions &options = MeshOptions());
+    /**
+     * @brief Uploads an already prepared mesh. Compact needs a unit sphere
+     * (positions equal to normals) with texture coordinates in [0,1], and falls back to Standard otherwise.
+     */
+    Planet(const MeshData &mesh, VertexFormat vertexFormat);
     ~Planet();
+    Planet(const Planet &) = delete;
+    Planet &operator=(const Planet &) = delete;
     void draw();
+    /**
+     * @brief Draws @p instanceCount copies in one call, reading PlanetInstance
+     * records from @p instanceBuffer starting at byte @p offset.
+     */
+    void drawInstanced(GLuint instanceBuffer, GLintptr offset, GLsizei instanceCount);
+
+    VertexFormat getVertexFormat() const { return format; }
+    unsigned int getVertexCount() const { return vertexCount; }
+    unsigned int getIndexCount() const { return indexCount; }
+    /** @brief Triangles actually rasterized per draw (strip restarts and degenerates excluded). */
+    unsigned int getTriangleCount() const { return triangleCount; }
+    GLenum getPrimitiveMode() const { return primitiveMode; }
+    GLenum getIndexType() const { return indexType; }
+    GLuint getRestartIndex() const { return restartIndex; }
+    GLuint getVertexBuffer() const { return VBO; }
+    GLuint getIndexBuffer() const { return EBO; }
 
 private:
+    void upload(const MeshData &mesh);
+    void uploadUVSphere(float radius, unsigned int rings, unsigned int sectors);
+
     unsigned int VAO;
     unsigned int VBO;
     unsigned int EBO;
+    unsigned int vertexCount;
     unsigned int indexCount;
+    unsigned int triangleCount;
+    GLenum indexType;     // GL_UNSIGNED_SHORT whenever every index (and the restart index) fits in 16 bits
+    GLenum primitiveMode; // GL_TRIANGLES, or GL_TRIANGLE_STRIP with primitive restart
+    GLuint restartIndex;
+    VertexFormat format;
 };
 
 #endif
@@ -0,0 +1,76 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Low-overhead CPU instrumentation with chrome://tracing / Perfetto export.
+ *
+ * Zones are RAII objects that record {name, start, duration} into a fixed-size
+ * ring buffer owned by the calling thread, so recording never locks or
+ * allocates. Zone names must be string literals (only the pointer is stored).
+ *
+ * Everything is compiled out unless the build defines ENABLE_PROFILER
+ * (e.g. `g++ -DENABLE_PROFILER ...`): PROFILE_ZONE then expands to nothing
+ * and writeChromeTrace() reports that profiling is disabled.
+ *
+ *     void Planet::draw()
+ *     {
+ *         PROFILE_ZONE("Planet::draw");
+ *         ...
+ *     }
+ */
+namespace Profiler
+{
+    /** @brief Number of zones each thread keeps before the oldest are overwritten. */
+    constexpr std::uint32_t kEventsPerThread = 1 << 16;
+
+    /** @brief Nanoseconds since the profiler epoch (first use in the process). */
+    std::uint64_t nowNs();
+
+    /** @brief Appends a finished zone to the calling thread's ring buffer. */
+    void recordZone(const char *name, std::uint64_t startNs, std::uint64_t endNs);
+
+    /** @brief Labels the calling thread in the exported trace. */
+    void setThreadName(const char *name);
+
+    /**
+     * @brief Writes every zone still held in the ring buffers as Chrome trace
+     * event JSON (load it in chrome://tracing or ui.perfetto.dev). Safe while
+     * other threads keep recording; zones they overwrite during the export
+     * are left out rather than torn.
+     * @return false if the file could not be written or profiling is compiled out.
+     */
+    bool writeChromeTrace(const std::string &path);
+}
+
+#ifdef ENABLE_PROFILER
+
+class ProfileZone
+{
+public:
+    explicit ProfileZone(const char *zoneName) : name(zoneName), start(Profiler::nowNs()) {}
+    ~ProfileZone() { Profiler::recordZone(name, start, Profiler::nowNs()); }
+
+    ProfileZone(const ProfileZone &) = delete;
+    ProfileZone &operator=(const ProfileZone &) = delete;
+
+private:
+    const char *name;
+    std::uint64_t start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone_, __LINE__)(name)
+#define PROFILE_THREAD_NAME(name) Profiler::setThreadName(name)
+
+#else
+
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_THREAD_NAME(name) ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,210 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include "glad/glad.h"
+#include "glm/glm/glm.hpp"
+#include "shader.h"
+#include "camera.h"
+#include "mesh_cache.h"
+#include "scenario.h"
+#include "lod.h"
+#include "terrain.h"
+#include "instance_batch.h"
+#include "indirect_renderer.h"
+#include "asteroid_belt.h"
+#include "orbit_lines.h"
+#include "nbody.h"
+#include "gpu_nbody.h"
+#include "ephemeris.h"
+#include "satellite_swarm.h"
+
+#include <memory>
+#include <vector>
+
+class GpuTimer;
+class FrameStats;
+
+/**
+ * @brief Time-control and eclipse state. Written by the keyboard handler in the
+ * windowed build, left at its defaults by the headless benchmark.
+ */
+struct SimulationState
+{
+    bool eclipseMode = false;        // كسوف
+    bool lunarEclipseMode = false;   // خسوف
+    bool isFrozen = false;
+    float frozenTime = 0.0f;
+    float speedFactor = 1.0f;
+};
+
+/**
+ * @brief Owns every GL resource of the solar system scene and draws one frame of it.
+ *
+ * Shared by the GLFW window (src/main.cpp) and the headless benchmark
+ * (bench/render_bench.cpp) so both exercise exactly the same passes.
+ * Must be constructed after a GL 3.3 core context is current and glad is
+ * loaded; GL43::load() beforehand enables the GPU-driven path on 4.3+.
+ */
+class Renderer
+{
+public:
+    /**
+     * @param meshOptions how every sphere mesh is built: vertex layout
+     * (VertexFormat::Compact is ~4x smaller), cache optimization, strips.
+     */
+    explicit Renderer(const MeshOptions &meshOptions = MeshOptions());
+    ~Renderer();
+
+    /**
+     * @brief Advances the animation to @p currentFrame seconds and draws the
+     * sun, planets, orbits and skybox into the currently bound framebuffer.
+     */
+    void renderFrame(Camera &camera, SimulationState &sim, float currentFrame, float aspect);
+
+    /** @brief Attaches a GPU timer that brackets the sun/planets/orbits/skybox passes (nullptr detaches). */
+    void setGpuTimer(GpuTimer *timer) { gpuTimer = timer; }
+
+    /**
+     * @brief Records the sphere triangles and orbit line vertices drawn each
+     * frame as "triangles" and "orbit_vertices", and with an N-body system the
+     * steps it took and its energy drift as "nbody_steps" and
+     * "nbody_energy_drift", and with a GPU N-body cluster its steps as
+     * "gpu_nbody_steps" (nullptr stops recording).
+     */
+    void setFrameStats(FrameStats *stats) { frameStats = stats; }
+
+    /** @brief Pixel error budget and hysteresis for per-body mesh LOD selection. */
+    void setLodSettings(const LodSettings &settings) { lodSettings = settings; }
+
+    /** @brief Pixel error budget for orbit line tessellation. */
+    void setOrbitLineSettings(const OrbitLineSettings &settings) { orbitLines.setSettings(settings); }
+
+    /**
+     * @brief Close-range terrain for the Earth and the Moon: tiles are read
+     * from `<source.directory>/earth` and `/moon`. Takes effect for terrains
+     * not created yet, i.e. before either body is first approached.
+     */
+    void setTerrainSettings(const TerrainSettings &settings) { terrainSettings = settings; }
+
+    /** @brief false: always draw the Planet meshes, however close the camera gets. */
+    void setTerrainEnabled(bool enabled) { terrainEnabled = enabled; }
+
+    /**
+     * @brief true (default): each pass draws all its bodies with one instanced
+     * draw per sphere mesh; false: one draw per body, for comparison.
+     */
+    void setInstancing(bool enabled) { instancing = enabled; }
+
+    /**
+     * @brief true (default): on a GL 4.3+ context, sphere bodies are culled and
+     * LOD-selected by a compute shader and drawn with one multi-draw-indirect
+     * per pass (IndirectRenderer); ignored on 3.3, which keeps the CPU path.
+     */
+    void setGpuDriven(bool enabled) { gpuDriven = enabled; }
+    bool isGpuDriven() const { return gpuDriven && indirect; }
+
+    /** @brief Adds @p count small satellites orbiting the Earth (see addSatellites() in scenario.h). */
+    void addEarthSatellites(unsigned int count);
+
+    /**
+     * @brief Replaces the asteroid belt (none by default) with a new one of
+     * settings.count rocks; a count of 0 removes it. Uses the compute path
+     * when isGpuDriven().
+     */
+    void setAsteroidBelt(const AsteroidBeltSettings &settings);
+    const AsteroidBelt *getAsteroidBelt() const { return asteroids.get(); }
+
+    /**
+     * @brief settings.enabled: the bodies are moved by an NBodySystem started
+     * from their analytic orbits at t = 0 (initializeFromBodies()), stepped to
+     * each frame's time, instead of by those orbits; false (default) goes back
+     * to the analytic orbits. Restarts the system at t = 0 either way.
+     */
+    void setNBody(const NBodySettings &settings);
+    const NBodySystem *getNBody() const { return nbody.get(); }
+
+    /**
+     * @brief Replaces the GPU N-body cluster (none by default) with a new one
+     * of settings.count bodies, stepped to each frame's time and drawn from
+     * its own buffers; a count of 0 removes it. Needs GL 4.3
+     * (GpuNBody::isSupported()); ignored otherwise.
+     */
+    void setGpuNBody(const GpuNBodySettings &settings);
+    const GpuNBody *getGpuNBody() const { return gpuNBody.get(); }
+
+    /**
+     * @brief Moves the bodies named after ephemeris bodies to their positions
+     * in the JPL DE file at @p path (see EphemerisBodies) whenever the frame's
+     * time is inside it, instead of their analytic orbits; an empty path goes
+     * back to the orbits. Not used while setNBody() is enabled.
+     * @return false if the file could not be read
+     */
+    bool setEphemeris(const std::string &path, const EphemerisSceneSettings &settings = EphemerisSceneSettings());
+    const Ephemeris *getEphemeris() const { return ephemeris.get(); }
+
+    /**
+     * @brief Replaces the catalogue satellites (none by default) with the
+     * element sets of the two- or three-line file at @p path, propagated
+     * with SGP4 and drawn around the Earth (see SatelliteSwarm); an empty
+     * path removes them.
+     * @return false if the file could not be read or SGP4 took none of its sets
+     */
+    bool setSatelliteSwarm(const std::string &path, const SatelliteSwarmSettings &settings = SatelliteSwarmSettings());
+    const SatelliteSwarm *getSatelliteSwarm() const { return satellites.get(); }
+
+private:
+    Shader sunShader;
+    Shader planetShader;
+    Shader skyboxShader;
+    Shader orbitShader;
+    Shader terrainShader;
+
+    unsigned int sunTex;
+    unsigned int earthTex;
+    unsigned int moonTex;
+    unsigned int cubemapTexture;
+
+    unsigned int skyboxVAO, skyboxVBO;
+    OrbitLines orbitLines;
+
+    void buildBodyTextures();
+    void findBodies();
+    void startNBody();
+
+    MeshCache meshes;
+    LodSettings lodSettings;
+
+    // Every body's texture as one layer of bodyTextures (CelestialBody::textureLayer).
+    unsigned int bodyTextures = 0;
+    bool instancing = true;
+    InstanceBatch sunInstances;    // emissive bodies
+    InstanceBatch planetInstances; // lit bodies
+    bool gpuDriven = true;
+    std::unique_ptr<IndirectRenderer> indirect; // only when IndirectRenderer::isSupported()
+    std::unique_ptr<AsteroidBelt> asteroids;
+    NBodySettings nbodySettings;
+    std::unique_ptr<NBodySystem> nbody; // only when nbodySettings.enabled
+    std::unique_ptr<GpuNBody> gpuNBody;
+    EphemerisSceneSettings ephemerisSettings;
+    std::unique_ptr<Ephemeris> ephemeris;
+    std::unique_ptr<EphemerisBodies> ephemerisBodies; // rebuilt by findBodies()
+    std::unique_ptr<SatelliteSwarm> satellites;
+
+    // Created the first time their body is close enough (see TerrainSettings::minRadiusPx).
+    TerrainSettings terrainSettings;
+    bool terrainEnabled = true;
+    std::unique_ptr<PlanetTerrain> earthTerrain;
+    std::unique_ptr<PlanetTerrain> moonTerrain;
+
+    Scenario scenario;
+    // Set by findBodies() whenever bodies are added, not looked up per frame.
+    BodyHandle sunBody = kNoBody;
+    BodyHandle earthBody = kNoBody;
+    BodyHandle moonBody = kNoBody;
+    std::vector<int> orbitParents; // body slot of each orbitLines parent slot
+
+    GpuTimer *gpuTimer = nullptr;
+    FrameStats *frameStats = nullptr;
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef SATELLITE_SWARM_H
+#define SATELLITE_SWARM_H
+
+#include "glad/glad.h"
+#include "glm/glm/glm.hpp"
+#include "instanced_point_mesh.h"
+#include "sgp4.h"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/** @brief Clock and look of a SatelliteSwarm. */
+struct SatelliteSwarmSettings
+{
+    Sgp4Settings sgp4 = {NBodyKernel::Auto, 0, 2.0, 1.0}; // SIMD width, threads, the per-frame SGP4 budget (ms) and oldest fit (min)
+    double epochJd = 0.0;                                 // UTC Julian date at scene time 0; 0: the newest element set's epoch
+    double secondsPerDay = 1440.0;                        // a minute of orbit per scene second: a low orbit takes 90 s
+    float size = 0.004f;                                  // drawn radius, scene units
+    bool points = true;                                   // draw each satellite as one point of its projected size instead of a sphere
+};
+
+/**
+ * @brief Earth satellites from two-line element sets, propagated with SGP4
+ * (Sgp4Propagator) and drawn around the scene's Earth as one instanced
+ * sphere or point draw (InstancedPointMesh), on GL 3.3.
+ *
+ * Each update() re-solves SGP4 for as many satellites as the budget allows
+ * and moves the rest along their osculating orbits (none fitted more than
+ * sgp4.maxAgeMinutes ago), then writes every position straight into a
+ * mapped vec4 instance buffer: TEME kilometres scaled so the WGS-72 radius
+ * is the Earth's drawn radius, with TEME's pole along the Earth's rotation
+ * axis and its x axis towards the scene's +x.
+ * Satellites that have decayed sit at the Earth's centre, out of sight.
+ *
+ * The swarm keeps its own clock: at the ephemeris scene's day per 60 Hz
+ * frame every fit would be stale every frame. At a minute per second, the
+ * 2 ms budget goes round 30k satellites in about 11 frames, 11 s of orbit.
+ */
+class SatelliteSwarm
+{
+public:
+    explicit SatelliteSwarm(const std::vector<TwoLineElements> &elements, const SatelliteSwarmSettings &settings = SatelliteSwarmSettings());
+    ~SatelliteSwarm();
+
+    SatelliteSwarm(const SatelliteSwarm &) = delete;
+    SatelliteSwarm &operator=(const SatelliteSwarm &) = delete;
+
+    /** @brief Moves the satellites to scene time @p t around an Earth at @p earthPosition of @p earthRadius, its pole along @p earthAxis. */
+    void update(float t, const glm::vec3 &earthPosition, const glm::vec3 &earthAxis, float earthRadius);
+
+    /** @brief Draws the satellites as of the last update() into the bound framebuffer. */
+    void draw(const glm::mat4 &view, const glm::mat4 &projection, const glm::vec3 &lightPos, float viewportHeight);
+
+    std::size_t size() const { return sgp4.size(); }
+    /** @brief Satellites the last update() solved with SGP4. */
+    std::size_t lastSolved() const { return solvedCount; }
+    /** @brief The UTC Julian date of the last update(). */
+    double julianDate() const { return currentJd; }
+    const Sgp4Propagator &propagator() const { return sgp4; }
+    const SatelliteSwarmSettings &getSettings() const { return settings; }
+
+private:
+    SatelliteSwarmSettings settings;
+    Sgp4Propagator sgp4;
+    std::vector<double> x, y, z; // TEME kilometres, scratch for update()
+
+    GLuint instanceBuffer = 0;
+    std::unique_ptr<InstancedPointMesh> mesh; // draws instanceBuffer
+
+    std::size_t solvedCount = 0;
+    double currentJd = 0.0;
+};
+
+#endif
@@ -5,67 +5,101 @@
 #include <vector>
 #include <optional>
 #include <memory>
+#include <cstdint>
+#include <unordered_map>
 #include "glm/glm/glm.hpp"
 #include "glad/glad.h"
-#include "planet.h"
+#include "mesh_cache.h"
+#include "lod.h"
+#include "body_state.h"
 
-class Planet;
 class Shader;
 
+/**
+ * @brief A body's cold data: what is read when it is created, looked up or
+ * queued for drawing, not by the per-frame update. Its motion and transform
+ * are in Scenario::state, at the same slot.
+ */
 struct CelestialBody
 {
     std::string name;
-    float radius;
     std::string texturePath;
-    bool isEmissive;
+    bool isEmissive = false;
 
-    // Animation parameters
-    float orbitRadius;
-    float orbitSpeed;
-    float rotationSpeed;
-    glm::vec3 rotationAxis;
-
-    // Hierarchy
+    // Hierarchy (resolved to BodyState::parent by resolveHierarchy())
     std::optional<std::string> parentName;
 
-    // Rendering data (initialized later)
+    // Orbit line around the parent (see OrbitLines)
+    bool showOrbit = true;
+    glm::vec3 orbitColor = glm::vec3(0.8f);
+
+    // Rendering data (initialized later). The mesh is a LOD chain of shared
+    // unit spheres; BodyMotion::radius is applied through the model matrix.
     unsigned int textureID = 0;
-    glm::mat4 currentModelMatrix = glm::mat4(1.0f);
-    std::unique_ptr<Planet> mesh = nullptr;
+    int textureLayer = 0; // layer of texturePath in the renderer's body texture array
+    LodMesh mesh;
 
-    CelestialBody(std::string n, float r, std::string tex, bool emissive,
-                  float orbRad, float orbSpd, float rotSpd, glm::vec3 rotAx,
-                  std::optional<std::string> parent)
-        : name(std::move(n)), radius(r), texturePath(std::move(tex)), isEmissive(emissive),
-          orbitRadius(orbRad), orbitSpeed(orbSpd), rotationSpeed(rotSpd),
-          rotationAxis(rotAx), parentName(std::move(parent)) {}
+    CelestialBody(std::string n, std::string tex, bool emissive, std::optional<std::string> parent)
+        : name(std::move(n)), texturePath(std::move(tex)), isEmissive(emissive), parentName(std::move(parent)) {}
 
     // Explicitly default the default constructor (needed due to other constructors)
     CelestialBody() = default;
 
-    // Explicitly define/default special member functions because we have unique_ptr
+    // Bodies are moved into Scenario::bodies, never copied
     ~CelestialBody();
     CelestialBody(const CelestialBody &) = delete;
     CelestialBody &operator=(const CelestialBody &) = delete;
     CelestialBody(CelestialBody &&) = default;
     CelestialBody &operator=(CelestialBody &&) = default;
-
-    void render()
-    {
-        if (mesh)
-        {
-            glBindTexture(GL_TEXTURE_2D, textureID);
-            mesh->draw();
-        }
-    }
 };
 
+/**
+ * @brief Every body, split by slot into cold CelestialBody records and hot
+ * BodyState arrays. Slots change when resolveHierarchy() reorders the bodies;
+ * keep a BodyHandle (from addBody() or findBody()) to refer to one across that.
+ */
 struct Scenario
 {
-    std::vector<CelestialBody> bodies;
+    std::vector<CelestialBody> bodies; // by slot
+    BodyState state;                   // by slot
+    std::vector<BodyHandle> handles;   // slot -> handle
+    std::vector<std::uint32_t> slots;  // handle -> slot
+    std::unordered_map<std::string, BodyHandle> names; // interned: each name once, to the first body added with it
+
     glm::vec3 initialCameraPos;
     glm::vec3 lightPos;
     glm::vec3 lightColor;
 };
-Scenario loadScenario_SolarSystemBasic();
+
+/** @brief Appends @p body moving by @p motion; call resolveHierarchy() before the next update. */
+BodyHandle addBody(Scenario &scenario, CelestialBody body, const BodyMotion &motion);
+
+/** @return the handle of the body called @p name, or kNoBody */
+BodyHandle findBody(const Scenario &scenario, const std::string &name);
+
+/** @return @p body's current slot in Scenario::bodies and Scenario::state, or -1 for kNoBody */
+inline int bodySlot(const Scenario &scenario, BodyHandle body)
+{
+    return body == kNoBody ? -1 : (int)scenario.slots[body];
+}
+
+Scenario loadScenario_SolarSystemBasic(MeshCache &meshes);
+
+/**
+ * @brief Adds @p count small moon-textured satellites around the body named
+ * @p parentName, with orbit radii, speeds, phases and sizes drawn from a
+ * fixed-seed generator (the same @p seed gives the same swarm).
+ */
+void addSatellites(Scenario &scenario, MeshCache &meshes, const std::string &parentName, unsigned int count, unsigned int seed = 1);
+
+/**
+ * @brief Orders the bodies so that every body comes after its parent and sets
+ * BodyState::parent from parentName, so that the update needs no name
+ * lookups. The loader and addSatellites() call it after adding bodies.
+ * A body whose parent is missing (or part of a cycle) is treated as a root.
+ */
+void resolveHierarchy(Scenario &scenario);
+
+/** @brief updateBodyTransforms() on scenario.state; requires resolveHierarchy() since the last addBody(). */
+void updateTransforms(Scenario &scenario, float t);
 #endif
@@ -0,0 +1,149 @@
+#ifndef SGP4_H
+#define SGP4_H
+
+#include "gravity_kernel.h"
+#include "kepler.h"
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+struct Sgp4DeepSpace;
+
+/** @brief The earth's equatorial radius SGP4 works in (WGS-72), kilometres. */
+const double kSgp4EarthRadiusKm = 6378.135;
+
+/**
+ * @brief The mean elements of one NORAD two-line element set, in the units
+ * SGP4 takes: radians, radians per minute and earth radii^-1 for B*.
+ */
+struct TwoLineElements
+{
+    std::array<char, 25> name = {}; // the title line of a three-line set, else empty
+    int catalogNumber = 0;
+    double epochJd = 0.0;           // UTC Julian date
+    double bstar = 0.0;
+    double inclination = 0.0;
+    double ascendingNode = 0.0;
+    double eccentricity = 0.0;
+    double periapsis = 0.0;
+    double meanAnomaly = 0.0;
+    double meanMotion = 0.0;        // Kozai mean motion, radians per minute
+};
+
+/** @brief Parses the two data lines of an element set. @return false if a field is malformed */
+bool parseTwoLineElements(const char *line1, const char *line2, TwoLineElements &elements);
+
+struct TleLoadStats
+{
+    std::size_t sets = 0;    // element sets parsed
+    std::size_t skipped = 0; // line pairs that did not parse
+};
+
+/**
+ * @brief Appends every element set of a two- or three-line file (CelesTrak's
+ * and Space-Track's formats, with or without title lines, "\n" or "\r\n"),
+ * read from a memory mapping.
+ * @return false if the file cannot be read
+ */
+bool loadTwoLineElements(const std::string &path, std::vector<TwoLineElements> &elements, TleLoadStats *stats = nullptr);
+
+struct Sgp4Settings
+{
+    NBodyKernel kernel = NBodyKernel::Auto; // SIMD width of the near-Earth solver, as NBodySettings::kernel
+    unsigned int threads = 0;               // 0: one per hardware thread
+    double budgetMs = 0.0;                  // update() stops starting chunks after this; 0: no limit
+    double maxAgeMinutes = 1.0;             // update() re-solves fits older than this, budget or not; 0: no limit
+};
+
+/**
+ * @brief Batched SGP4/SDP4 (Spacetrack Report #3, with Vallado et al.'s 2006
+ * revisions and WGS-72 constants, as the element sets are fitted) for tens of
+ * thousands of Earth satellites.
+ *
+ * Near-Earth satellites (periods under 225 minutes) are kept as
+ * structure-of-arrays doubles with every term that does not depend on time
+ * precomputed, and solved 4 (AVX2) or 8 (AVX-512) at a time; deep-space ones
+ * need the lunar-solar and resonance terms of SDP4 and are solved one at a
+ * time. Satellites are numbered near-Earth first, then deep-space, each in
+ * add() order. Positions are kilometres and velocities kilometres per second
+ * in the TEME frame of each element set; a satellite that has decayed or
+ * whose elements went out of range is NaN.
+ *
+ * For drawing, update() re-solves as many satellites as settings.budgetMs
+ * allows, oldest first, in chunks handed to up to settings.threads threads,
+ * and fits each solved state with its osculating two-body orbit;
+ * positions() moves every satellite along that orbit. Fits more than
+ * settings.maxAgeMinutes of simulated time old are re-solved whatever the
+ * budget, so no satellite drifts by more than that long's perturbations
+ * (tens of metres a minute, typically).
+ */
+class Sgp4Propagator
+{
+public:
+    explicit Sgp4Propagator(const Sgp4Settings &settings = Sgp4Settings());
+    ~Sgp4Propagator();
+
+    Sgp4Propagator(const Sgp4Propagator &) = delete;
+    Sgp4Propagator &operator=(const Sgp4Propagator &) = delete;
+
+    /** @return false, adding nothing, if SGP4 rejects the elements (hyperbolic, or decayed at epoch) */
+    bool add(const TwoLineElements &elements);
+    /** @return the number of element sets added */
+    std::size_t add(const std::vector<TwoLineElements> &elements);
+    void clear();
+
+    std::size_t size() const { return nearEarthCount() + deepSpaceCount(); }
+    std::size_t nearEarthCount() const { return nearEarth[0].size(); }
+    std::size_t deepSpaceCount() const;
+    /** @brief The elements of satellite @p i, in the numbering above. */
+    const TwoLineElements &elements(std::size_t i) const;
+    /** @return the latest element set epoch, or 0 */
+    double latestEpochJd() const;
+
+    /**
+     * @brief Solves every satellite at UTC Julian date @p jd, over the
+     * threads, and writes their TEME states (velocities if @p vx, @p vy and
+     * @p vz are given).
+     */
+    void propagate(double jd, double *x, double *y, double *z,
+                   double *vx = nullptr, double *vy = nullptr, double *vz = nullptr) const;
+
+    /**
+     * @brief Re-solves satellites at @p jd until settings.budgetMs has passed
+     * (every satellite on the first call after add() or with no budget),
+     * continuing from where the last call stopped, and past the budget any
+     * solved more than settings.maxAgeMinutes from @p jd.
+     * @return the number of satellites solved
+     */
+    std::size_t update(double jd);
+
+    /** @brief Every satellite's TEME position at @p jd along its last fitted orbit (the Earth's centre until one). */
+    void positions(double jd, double *x, double *y, double *z) const;
+
+    NBodyKernel kernel() const { return activeKernel; }
+    const Sgp4Settings &getSettings() const { return settings; }
+    void setBudget(double budgetMs) { settings.budgetMs = budgetMs; }
+
+    /** @brief Doubles per near-Earth satellite. */
+    static const int kNearEarthColumns = 36;
+
+private:
+    void solveRange(std::size_t begin, std::size_t end, double jd, double *x, double *y, double *z,
+                    double *vx, double *vy, double *vz) const;
+
+    Sgp4Settings settings;
+    NBodyKernel activeKernel;
+    std::array<std::vector<double>, kNearEarthColumns> nearEarth;
+    std::vector<Sgp4DeepSpace> deep; // the full SDP4 state of each deep-space satellite
+    std::vector<TwoLineElements> nearEarthSources;
+
+    KeplerPropagator osculating; // TEME positions in scene order (x, z, y), time in minutes from J2000
+    std::vector<double> solved;  // update()'s states, 6 per satellite
+    std::vector<double> fitJd;   // the Julian date each chunk was last solved at
+    std::size_t cursor = 0;      // the next chunk update() solves
+    bool fitted = false;
+};
+
+#endif
@@ -12,6 +12,8 @@ class Shader
 public:
     unsigned int ID;
     Shader(const char *vertexPath, const char *fragmentPath);
+    /** @brief Compute program (needs a GL 4.3 context, see GL43::isAvailable()). */
+    explicit Shader(const char *computePath);
     void use();
 
     /** @brief Sets a boolean uniform. */
@@ -28,6 +30,8 @@ public:
     void setMat3(const std::string &name, const glm::mat3 &mat) const;
     /** @brief Sets a mat4 uniform (using glm::mat4). */
     void setMat4(const std::string &name, const glm::mat4 &mat) const;
+    /** @brief Sets a vec4[] uniform from @p count glm::vec4 values. */
+    void setVec4Array(const std::string &name, const glm::vec4 *values, int count) const;
 
 private:
     void checkCompileErrors(unsigned int shader, std::string type);
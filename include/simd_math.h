@@ -0,0 +1,88 @@
+#ifndef SIMD_MATH_H
+#define SIMD_MATH_H
+
+// Vector sine and cosine shared by the SIMD kernels of the propagators
+// (kepler.cpp, sgp4.cpp). Define SIMD_MATH_X86 when the target has them.
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SIMD_MATH_X86 1
+
+namespace simd
+{
+    // sin and cos for |x| up to a few pi: x = q pi/2 + r with |r| <= pi/4
+    // (pi/2 in two parts, so q pi/2 is exact for small q), fdlibm's minimax
+    // polynomials for sin r and cos r, then swapped and negated by quadrant.
+    const double kTwoOverPi = 0.63661977236758134308;
+    const double kPiOver2Hi = 1.57079632673412561417e+00;
+    const double kPiOver2Lo = 6.07710050650619224932e-11;
+    const double kSin[6] = {-1.66666666666666324348e-01, 8.33333333332248946124e-03, -1.98412698298579493134e-04,
+                            2.75573137070700676789e-06, -2.50507602534068634195e-08, 1.58969099521155010221e-10};
+    const double kCos[6] = {4.16666666666666019037e-02, -1.38888888888741095749e-03, 2.48015872894767294178e-05,
+                            -2.75573143513906633035e-07, 2.08757232129817482790e-09, -1.13596475577881948265e-11};
+
+    __attribute__((target("avx2,fma")))
+    inline void sinCos4(__m256d x, __m256d &s, __m256d &c)
+    {
+        const int nearest = _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC;
+        __m256d q = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(kTwoOverPi)), nearest);
+        __m256d r = _mm256_fnmadd_pd(q, _mm256_set1_pd(kPiOver2Hi), x);
+        r = _mm256_fnmadd_pd(q, _mm256_set1_pd(kPiOver2Lo), r);
+        __m256d z = _mm256_mul_pd(r, r);
+
+        __m256d ps = _mm256_set1_pd(kSin[5]), pc = _mm256_set1_pd(kCos[5]);
+        for (int k = 4; k >= 0; --k)
+        {
+            ps = _mm256_fmadd_pd(ps, z, _mm256_set1_pd(kSin[k]));
+            pc = _mm256_fmadd_pd(pc, z, _mm256_set1_pd(kCos[k]));
+        }
+        __m256d sinR = _mm256_fmadd_pd(_mm256_mul_pd(r, z), ps, r);
+        __m256d cosR = _mm256_fmadd_pd(_mm256_mul_pd(z, z), pc, _mm256_fnmadd_pd(_mm256_set1_pd(0.5), z, _mm256_set1_pd(1.0)));
+
+        // Quadrant q mod 4: sin is (sin r, cos r, -sin r, -cos r), cos is (cos r, -sin r, -cos r, sin r).
+        __m256d quadrant = _mm256_fnmadd_pd(_mm256_set1_pd(4.0), _mm256_floor_pd(_mm256_mul_pd(q, _mm256_set1_pd(0.25))), q);
+        __m256d one = _mm256_cmp_pd(quadrant, _mm256_set1_pd(1.0), _CMP_EQ_OQ);
+        __m256d two = _mm256_cmp_pd(quadrant, _mm256_set1_pd(2.0), _CMP_EQ_OQ);
+        __m256d three = _mm256_cmp_pd(quadrant, _mm256_set1_pd(3.0), _CMP_EQ_OQ);
+        __m256d odd = _mm256_or_pd(one, three);
+        __m256d sign = _mm256_set1_pd(-0.0);
+        s = _mm256_xor_pd(_mm256_blendv_pd(sinR, cosR, odd), _mm256_and_pd(_mm256_or_pd(two, three), sign));
+        c = _mm256_xor_pd(_mm256_blendv_pd(cosR, sinR, odd), _mm256_and_pd(_mm256_or_pd(one, two), sign));
+    }
+
+    // The maskz forms of roundscale: GCC 12's unmasked one reads an
+    // undefined vector and warns.
+    __attribute__((target("avx512f")))
+    inline void sinCos8(__m512d x, __m512d &s, __m512d &c)
+    {
+        const int nearest = _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC;
+        __m512d q = _mm512_maskz_roundscale_pd(0xff, _mm512_mul_pd(x, _mm512_set1_pd(kTwoOverPi)), nearest);
+        __m512d r = _mm512_fnmadd_pd(q, _mm512_set1_pd(kPiOver2Hi), x);
+        r = _mm512_fnmadd_pd(q, _mm512_set1_pd(kPiOver2Lo), r);
+        __m512d z = _mm512_mul_pd(r, r);
+
+        __m512d ps = _mm512_set1_pd(kSin[5]), pc = _mm512_set1_pd(kCos[5]);
+        for (int k = 4; k >= 0; --k)
+        {
+            ps = _mm512_fmadd_pd(ps, z, _mm512_set1_pd(kSin[k]));
+            pc = _mm512_fmadd_pd(pc, z, _mm512_set1_pd(kCos[k]));
+        }
+        __m512d sinR = _mm512_fmadd_pd(_mm512_mul_pd(r, z), ps, r);
+        __m512d cosR = _mm512_fmadd_pd(_mm512_mul_pd(z, z), pc, _mm512_fnmadd_pd(_mm512_set1_pd(0.5), z, _mm512_set1_pd(1.0)));
+
+        // As sinCos4().
+        __m512d quadrant = _mm512_fnmadd_pd(_mm512_set1_pd(4.0), _mm512_maskz_roundscale_pd(0xff, _mm512_mul_pd(q, _mm512_set1_pd(0.25)), _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC), q);
+        __mmask8 one = _mm512_cmp_pd_mask(quadrant, _mm512_set1_pd(1.0), _CMP_EQ_OQ);
+        __mmask8 two = _mm512_cmp_pd_mask(quadrant, _mm512_set1_pd(2.0), _CMP_EQ_OQ);
+        __mmask8 three = _mm512_cmp_pd_mask(quadrant, _mm512_set1_pd(3.0), _CMP_EQ_OQ);
+        __mmask8 odd = one | three;
+        __m512d zero = _mm512_setzero_pd();
+        s = _mm512_mask_blend_pd(odd, sinR, cosR);
+        s = _mm512_mask_sub_pd(s, two | three, zero, s);
+        c = _mm512_mask_blend_pd(odd, cosR, sinR);
+        c = _mm512_mask_sub_pd(c, one | two, zero, c);
+    }
+}
+#endif
+
+#endif
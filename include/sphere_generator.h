@@ -0,0 +1,60 @@
+#ifndef SPHERE_GENERATOR_H
+#define SPHERE_GENERATOR_H
+
+#include <cstddef>
+#include <vector>
+
+/** @brief One vertex of VertexFormat::Standard: position, normal, texture coordinates (32 bytes). */
+struct StandardVertex
+{
+    float position[3];
+    float normal[3];
+    float texCoord[2];
+};
+
+/**
+ * @brief The trigonometry of a rings x sectors UV sphere, one entry per ring
+ * and per sector: the unit normal of vertex (r, s) is (sectorCos[s] *
+ * ringRadius[r], ringY[r], sectorSin[s] * ringRadius[r]), products rounded to
+ * float, and its texture coordinates are (sectorU[s], ringV[r]). The products
+ * are formed in double, as the original per-vertex sin/cos loop did.
+ */
+struct UVSphereTables
+{
+    std::vector<float> ringY;
+    std::vector<double> ringRadius;
+    std::vector<float> ringV;
+    std::vector<double> sectorCos;
+    std::vector<double> sectorSin;
+    std::vector<float> sectorU;
+};
+
+/** @brief Tables evaluating exactly the expressions of the original per-vertex loop. */
+UVSphereTables buildUVSphereTables(unsigned int rings, unsigned int sectors);
+
+inline std::size_t uvSphereVertexCount(unsigned int rings, unsigned int sectors)
+{
+    return (std::size_t)rings * sectors;
+}
+
+inline std::size_t uvSphereIndexCount(unsigned int rings, unsigned int sectors)
+{
+    return rings < 2 || sectors < 2 ? 0 : (std::size_t)(rings - 1) * (sectors - 1) * 6;
+}
+
+/**
+ * @brief Writes generateUVSphere()'s mesh, bit for bit, as interleaved
+ * vertices and an index list into caller-owned memory (typically mapped GL
+ * buffers), with no intermediate arrays.
+ *
+ * Vertices are computed four sectors at a time with SSE where available.
+ * Rings are split across up to @p threads threads (0: one per hardware
+ * thread), each with at least 64k vertices' worth of work. Either output may
+ * be nullptr to skip it; 16-bit indices need fewer than 65536 vertices.
+ */
+void writeUVSphere(float radius, unsigned int rings, unsigned int sectors,
+                   StandardVertex *vertices, unsigned int *indices, unsigned int threads = 0);
+void writeUVSphere(float radius, unsigned int rings, unsigned int sectors,
+                   StandardVertex *vertices, unsigned short *indices, unsigned int threads = 0);
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef TERRAIN_H
+#define TERRAIN_H
+
+#include "glad/glad.h"
+#include "glm/glm/glm.hpp"
+#include "shader.h"
+#include "tile_streamer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/** @brief Quadtree depth, streaming and memory limits of a PlanetTerrain. */
+struct TerrainSettings
+{
+    TileSourceSettings source;       // height tile files and procedural fallback
+    int maxLevel = 10;               // deepest quadtree level; level L chunks are (pi/2) / 2^L radians wide
+    float lodDistanceRatio = 3.0f;   // a level-L chunk is used within lodDistanceRatio * its width of the camera
+    std::size_t tileBudget = 256;    // height tiles resident on the GPU (kTileSamples^2 RGBA32F each)
+    std::size_t uploadsPerFrame = 8; // streamed tiles uploaded per update()
+    float minRadiusPx = 300.0f;      // below this projected radius the body keeps its Planet mesh
+};
+
+/** @brief What the last update() selected and what the streamer is doing. */
+struct TerrainStats
+{
+    std::size_t chunks = 0;
+    std::size_t triangles = 0;
+    std::size_t residentTiles = 0;
+    std::size_t pendingTiles = 0;
+    std::size_t uploads = 0;
+    std::size_t gpuBytes = 0;
+    int deepestLevel = 0;
+};
+
+/**
+ * @brief CDLOD quadtree terrain over the six faces of the spherified cube
+ * (the mapping of generateCubeSphere()) for a body drawn at close range.
+ *
+ * Every chunk is the same 32x32 grid, displaced in the vertex shader by its
+ * height tile. update() walks the quadtrees: a chunk is split while the
+ * camera is within range of its children, and vertices in the outer part of
+ * a chunk's range morph onto the next coarser grid, so neighbouring levels
+ * meet without cracks or popping. Height tiles are streamed by a TileStreamer
+ * into a fixed-size texture array, least recently used first out; a chunk
+ * whose tile is not resident yet draws with the closest resident ancestor.
+ *
+ * All geometry is in the body's unit-sphere space; the model matrix passed
+ * to draw() places and scales it like the body's Planet mesh.
+ */
+class PlanetTerrain
+{
+public:
+    explicit PlanetTerrain(const TerrainSettings &settings = TerrainSettings());
+    ~PlanetTerrain();
+
+    PlanetTerrain(const PlanetTerrain &) = delete;
+    PlanetTerrain &operator=(const PlanetTerrain &) = delete;
+
+    /**
+     * @brief Uploads finished tiles and selects this frame's chunks.
+     * @param cameraLocal camera position in the body's unit-sphere space
+     * @param localToClip projection * view * model, for frustum culling
+     */
+    void update(const glm::vec3 &cameraLocal, const glm::mat4 &localToClip);
+
+    /**
+     * @brief Draws the chunks chosen by the last update() with @p shader
+     * (shaders/terrain.vert/.frag), which must be in use with its model, view,
+     * projection and lighting uniforms set. Binds the height tiles to texture
+     * unit @p tileUnit.
+     */
+    void draw(Shader &shader, int tileUnit = 1);
+
+    const TerrainSettings &getSettings() const { return settings; }
+    const TerrainStats &getStats() const { return stats; }
+
+private:
+    struct TileSlot
+    {
+        TileKey key;
+        bool used = false;
+        bool pinned = false;
+        std::uint64_t lastUsed = 0;
+        float minHeight = 0.0f;
+        float maxHeight = 0.0f;
+    };
+
+    struct Chunk
+    {
+        TileKey key;             // node whose grid is drawn
+        int quadrant;            // 0-3: only that quarter of the grid, -1: all of it
+        int layer;               // texture array layer of the height tile used
+        glm::vec3 tileTransform; // node uv -> tile uv: scale, offset.xy (identity unless an ancestor's tile stands in)
+    };
+
+    struct NodeBounds
+    {
+        glm::vec3 boxMin, boxMax; // local-space box, all elevations included
+        glm::vec3 axis;           // direction of the node's centre
+        float angle;              // cone half-angle around axis covering the node
+    };
+
+    void selectNode(const TileKey &key);
+    void addChunk(const TileKey &key, int quadrant);
+    NodeBounds nodeBounds(const TileKey &key) const;
+    bool nodeVisible(const NodeBounds &bounds) const;
+    int uploadTile(const HeightTile &tile);
+    int residentLayer(const TileKey &key);
+
+    TerrainSettings settings;
+    TileStreamer streamer;
+
+    GLuint tileArray = 0;
+    GLuint gridVAO = 0;
+    GLuint gridEBO = 0;
+    GLsizei quadrantIndexCount = 0;
+
+    std::vector<TileSlot> slots;
+    std::unordered_map<std::uint64_t, int> slotOfTile;
+    std::vector<float> ranges; // ranges[L]: distance within which level L chunks are used
+    std::vector<Chunk> chunks;
+    glm::vec3 cameraPosition = glm::vec3(0.0f);
+    glm::vec4 frustumPlanes[6];
+    float horizonAngle = 0.0f;
+    std::uint64_t frame = 0;
+    TerrainStats stats;
+};
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef TEXTURE_H
+#define TEXTURE_H
+
+#include "glad/glad.h"
+#include <string>
+#include <vector>
+
+/** @brief Loads a 2D texture from disk (flipped vertically) and generates its mipmaps. */
+unsigned int loadTexture(const char *path);
+
+/**
+ * @brief Loads 2D images (flipped vertically, like loadTexture()) into the
+ * layers of one RGBA8 GL_TEXTURE_2D_ARRAY with mipmaps, in @p paths order.
+ * Images of different sizes are scaled to the largest width and height.
+ * A layer whose file fails to load is left black.
+ */
+unsigned int loadTextureArray(const std::vector<std::string> &paths);
+
+/** @brief Loads the six faces of a cubemap (+X, -X, +Y, -Y, +Z, -Z order). */
+unsigned int loadCubemap(std::vector<std::string> faces);
+
+#endif
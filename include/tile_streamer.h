@@ -0,0 +1,115 @@
+#ifndef TILE_STREAMER_H
+#define TILE_STREAMER_H
+
+#include "glm/glm/glm.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+/** @brief Quads per terrain chunk edge; a height tile holds kTileQuads + 1 samples per edge. */
+const int kTileQuads = 32;
+const int kTileSamples = kTileQuads + 1;
+
+/** @brief A quadtree node on one cube face: level 0 covers the face, level L is a 2^L x 2^L grid. */
+struct TileKey
+{
+    int face = 0;
+    int level = 0;
+    int x = 0;
+    int y = 0;
+
+    std::uint64_t packed() const
+    {
+        return ((std::uint64_t)face << 61) | ((std::uint64_t)level << 56) | ((std::uint64_t)x << 28) | (std::uint64_t)y;
+    }
+    TileKey parent() const { return TileKey{face, level - 1, x / 2, y / 2}; }
+    TileKey child(int i) const { return TileKey{face, level + 1, x * 2 + (i & 1), y * 2 + (i >> 1)}; }
+    bool operator==(const TileKey &other) const { return packed() == other.packed(); }
+};
+
+/**
+ * @brief One node's samples, kTileSamples^2 RGBA floats: r is the elevation as
+ * a fraction of the radius (the surface is direction * (1 + r)), gba the
+ * surface normal in the body's unit-sphere space.
+ */
+struct HeightTile
+{
+    TileKey key;
+    std::vector<float> texels;
+    float minHeight = 0.0f;
+    float maxHeight = 0.0f;
+};
+
+/** @brief Where height tiles come from. */
+struct TileSourceSettings
+{
+    /**
+     * Tiles are read from `<directory>/<face>/<level>/<x>_<y>.r16`: little-endian
+     * uint16 heights, (kTileSamples + 2)^2 of them including a one-sample border
+     * for normals, mapped linearly to [-heightScale, heightScale]. Samples at
+     * positions shared with the parent tile must hold the same heights (point
+     * sampled, not filtered) so chunk borders stay watertight. Tiles that are
+     * missing, and every tile when the directory is empty, are generated from
+     * fractal noise instead.
+     */
+    std::string directory;
+    unsigned int seed = 1;
+    float heightScale = 0.01f;
+};
+
+/**
+ * @brief Loads and generates height tiles on a worker thread.
+ *
+ * The render thread queues tiles with request() and collects finished ones
+ * with takeCompleted(); it never blocks on I/O. Requests are served newest
+ * first, since the camera has usually moved on from older ones, and the
+ * oldest are dropped when more than kMaxQueued are waiting.
+ */
+class TileStreamer
+{
+public:
+    static const std::size_t kMaxQueued = 512;
+
+    explicit TileStreamer(const TileSourceSettings &settings);
+    ~TileStreamer();
+
+    TileStreamer(const TileStreamer &) = delete;
+    TileStreamer &operator=(const TileStreamer &) = delete;
+
+    /** @brief Queues a tile unless it is already queued, being built or waiting to be taken. */
+    void request(const TileKey &key);
+
+    /** @brief Moves up to @p maxTiles finished tiles to the caller. */
+    std::vector<HeightTile> takeCompleted(std::size_t maxTiles);
+
+    /** @brief Builds a tile on the calling thread (used for the always-resident root tiles). */
+    HeightTile load(const TileKey &key) const;
+
+    /** @brief Tiles queued or in flight. */
+    std::size_t pendingCount() const;
+
+private:
+    void workerLoop();
+    bool readTileFile(const TileKey &key, std::vector<float> &heights) const;
+    float proceduralHeight(const glm::vec3 &direction) const;
+
+    TileSourceSettings settings;
+    int permutation[512];
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<TileKey> queue;
+    std::unordered_set<std::uint64_t> pending;
+    std::vector<HeightTile> completed;
+    bool stopping = false;
+    std::thread worker;
+};
+
+#endif
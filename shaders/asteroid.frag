@@ -0,0 +1,21 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 Normal;
+in vec3 FragPos;
+flat in float Tint;
+
+uniform vec3 lightPos;
+
+void main()
+{
+    vec3 rockColor = vec3(0.45, 0.41, 0.37) * Tint;
+    vec3 ambient = 0.1 * rockColor;
+
+    vec3 lightDir = normalize(lightPos - FragPos);
+    float diff = max(dot(normalize(Normal), lightDir), 0.0);
+    vec3 sunLightColor = vec3(1.0, 0.97, 0.9);
+    vec3 diffuse = diff * sunLightColor * rockColor;
+
+    FragColor = vec4(ambient + diffuse, 1.0);
+}
@@ -0,0 +1,121 @@
+#version 330 core
+// Rocks of AsteroidBelt (asteroid_belt.h), one instance per rock.
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+// GL 4.3 path (`placed`): written by asteroid_cull.comp for the visible rocks
+layout (location = 4) in vec4 aPositionSize;
+layout (location = 5) in vec4 aAxisAngle;
+// 3.3 path: the AsteroidElements themselves
+layout (location = 6) in vec2 aOrbit;  // semi-major axis, mean anomaly at t = 0
+layout (location = 7) in vec4 aAngles; // eccentricity, inclination, node, periapsis (unorm)
+layout (location = 8) in float aSize;  // unorm of maxSize
+layout (location = 9) in float aSpin;  // unorm of maxSpin
+
+out vec3 Normal;
+out vec3 FragPos;
+flat out float Tint;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+uniform bool placed;
+uniform float time;
+uniform float gm;
+uniform float maxSize;
+uniform float maxSpin;
+uniform float rockBound;
+
+// 3.3 path culling and LOD, as in asteroid_cull.comp
+uniform int level;
+uniform vec3 cameraPos;
+uniform float tanHalfFovY;
+uniform float viewportHeight;
+uniform vec2 lodRadiusPx;
+uniform float cullRadiusPx;
+uniform float maxDistance;
+
+const float PI = 3.14159265;
+
+// Same as orbitPosition() in asteroid_cull.comp
+vec3 orbitPosition(float a, float meanAnomaly0, vec4 angles, float t)
+{
+    float e = angles.x;
+    float inclination = angles.y * PI;
+    float node = angles.z * 2.0 * PI;
+    float periapsis = angles.w * 2.0 * PI;
+
+    // Kepler's equation M = E - e sin E, by Newton's method from E = M + e sin M
+    float M = mod(meanAnomaly0 + sqrt(gm / (a * a * a)) * t, 2.0 * PI);
+    float E = M + e * sin(M);
+    for (int k = 0; k < 3; ++k)
+        E -= (E - e * sin(E) - M) / (1.0 - e * cos(E));
+    vec2 p = a * vec2(cos(E) - e, sqrt(1.0 - e * e) * sin(E));
+
+    // Perifocal to ecliptic (z up) frame, then z becomes the scene's y
+    float x1 = cos(periapsis) * p.x - sin(periapsis) * p.y;
+    float y1 = sin(periapsis) * p.x + cos(periapsis) * p.y;
+    float y2 = y1 * cos(inclination);
+    vec3 ecliptic = vec3(cos(node) * x1 - sin(node) * y2, sin(node) * x1 + cos(node) * y2, y1 * sin(inclination));
+    return ecliptic.xzy;
+}
+
+// Same as spinAxisAngle() in asteroid_cull.comp: tumbling axis picked from the orbit angles
+vec4 spinAxisAngle(vec4 angles, float meanAnomaly0, float spin, float t)
+{
+    vec3 axis = normalize(vec3(cos(angles.z * 37.0), 1.5, sin(angles.w * 53.0)));
+    return vec4(axis, meanAnomaly0 + spin * maxSpin * t);
+}
+
+// Same as projectedRadiusPx() in src/lod.cpp
+float projectedRadiusPx(vec3 center, float radius)
+{
+    float distance = length(center - cameraPos);
+    if (distance <= radius)
+        return viewportHeight;
+    float tanAngle = radius / sqrt(distance * distance - radius * radius);
+    return tanAngle / tanHalfFovY * viewportHeight * 0.5;
+}
+
+// Rodrigues' rotation of v by axisAngle.w radians around axisAngle.xyz
+vec3 rotate(vec3 v, vec4 axisAngle)
+{
+    float c = cos(axisAngle.w), s = sin(axisAngle.w);
+    vec3 k = axisAngle.xyz;
+    return v * c + cross(k, v) * s + k * dot(k, v) * (1.0 - c);
+}
+
+void main()
+{
+    vec3 center;
+    float size;
+    vec4 axisAngle;
+    if (placed)
+    {
+        center = aPositionSize.xyz;
+        size = aPositionSize.w;
+        axisAngle = aAxisAngle;
+    }
+    else
+    {
+        center = orbitPosition(aOrbit.x, aOrbit.y, aAngles, time);
+        size = aSize * maxSize;
+        axisAngle = spinAxisAngle(aAngles, aOrbit.y, aSpin, time);
+
+        // Culled, or drawn by another level's draw call: behind the far plane
+        float radiusPx = projectedRadiusPx(center, size * rockBound);
+        int rockLevel = radiusPx >= lodRadiusPx.x ? 0 : (radiusPx >= lodRadiusPx.y ? 1 : 2);
+        if (rockLevel != level || radiusPx < cullRadiusPx || length(center - cameraPos) > maxDistance)
+        {
+            Normal = vec3(0.0);
+            FragPos = vec3(0.0);
+            Tint = 0.0;
+            gl_Position = vec4(0.0, 0.0, 2.0, 1.0);
+            return;
+        }
+    }
+
+    FragPos = center + size * rotate(aPos, axisAngle);
+    Normal = rotate(aNormal, axisAngle);
+    Tint = 0.8 + 0.35 * axisAngle.x;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
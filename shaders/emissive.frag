@@ -2,12 +2,14 @@
 out vec4 FragColor;
 
 in vec2 TexCoord;
+flat in float TextureLayer;
 
-uniform sampler2D ourTexture;
+// Every body's texture, one layer each
+uniform sampler2DArray bodyTextures;
 
 void main()
 {
     // The sun is emissive, so we just sample its texture
     // and don't apply any lighting.
-    FragColor = texture(ourTexture, TexCoord);
+    FragColor = texture(bodyTextures, vec3(TexCoord, TextureLayer));
 }
@@ -2,15 +2,39 @@
 layout (location = 0) in vec3 aPos;
 // Location 1 (aNormal) is unused but exists in the Planet VAO
 layout (location = 2) in vec2 aTexCoord;
+// Location 3 only exists in the compact Planet VAO (see VertexFormat in planet.h):
+// a snorm16 octahedral normal that is also the position on the unit sphere
+layout (location = 3) in vec2 aOctNormal;
+// Locations 4-8 are per instance (PlanetInstance in planet.h): read when
+// `instanced` is set, otherwise the model and textureLayer uniforms apply
+layout (location = 4) in mat4 aInstanceModel;
+layout (location = 8) in float aTextureLayer;
 
 out vec2 TexCoord;
+flat out float TextureLayer;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+uniform bool compactVertices;
+uniform bool instanced;
+uniform float textureLayer;
+
+// Inverse of the octahedral encoding in src/planet.cpp
+vec3 octDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(e.x >= 0.0 ? 1.0 : -1.0, e.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
+
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    vec3 position = compactVertices ? octDecode(aOctNormal) : aPos;
+    mat4 bodyModel = instanced ? aInstanceModel : model;
+    gl_Position = projection * view * bodyModel * vec4(position, 1.0);
     TexCoord = aTexCoord;
+    TextureLayer = instanced ? aTextureLayer : textureLayer;
 }
@@ -3,8 +3,10 @@ out vec4 FragColor;
 
 in vec2 TexCoord;
 in vec3 FragPos;
+flat in float TextureLayer;
 
-uniform sampler2D ourTexture;
+// Every body's texture, one layer each
+uniform sampler2DArray bodyTextures;
 
 uniform bool isShadowed;
 
@@ -13,7 +15,7 @@ uniform vec3 viewPos;
 
 void main()
 {
-    vec3 texColor = texture(ourTexture, TexCoord).rgb;
+    vec3 texColor = texture(bodyTextures, vec3(TexCoord, TextureLayer)).rgb;
 
     vec3 ambient = 0.1 * texColor;
 
@@ -0,0 +1,34 @@
+#version 330 core
+// InstancedPointMesh (instanced_point_mesh.h): the bodies of GpuNBody or the satellites of
+// SatelliteSwarm, one instance per body, shaded by asteroid.frag.
+layout (location = 0) in vec3 aPos;        // unit sphere; also its normal
+layout (location = 4) in vec4 aPositionGm; // the compute shader's position buffer, or the swarm's positions
+
+out vec3 Normal;
+out vec3 FragPos;
+flat out float Tint;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 lightPos;
+uniform float bodySize;
+uniform bool points;
+uniform float pointScale; // viewport height * projection[1][1]
+
+void main()
+{
+    Tint = 0.8 + 0.5 * fract(float(gl_InstanceID) * 0.618034);
+    if (points)
+    {
+        // A point faces the light: no normal to shade by.
+        FragPos = aPositionGm.xyz;
+        Normal = lightPos - FragPos;
+        gl_Position = projection * view * vec4(FragPos, 1.0);
+        gl_PointSize = max(1.0, bodySize * pointScale / gl_Position.w);
+        return;
+    }
+
+    FragPos = aPositionGm.xyz + bodySize * aPos;
+    Normal = aPos;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
@@ -1,9 +1,9 @@
 #version 330 core
 out vec4 FragColor;
 
-uniform vec3 color;
+flat in vec3 Color;
 
 void main()
 {
-    FragColor = vec4(color, 1.0);
-}
\ No newline at end of file
+    FragColor = vec4(Color, 1.0);
+}
@@ -1,10 +1,36 @@
 #version 330 core
-layout(location = 0) in vec3 aPos;
+// Orbit lines (OrbitLines in orbit_lines.h), no vertex buffer: each draw of the
+// multi-draw is one arc, a line strip of n + 1 vertices whose IDs are
+// arcSlot * arcStride + 2n + i, i = 0..n, with n a power of two.
+uniform samplerBuffer orbits; // three texels per orbit, OrbitRecord in orbit_lines.h
+uniform int arcsPerOrbit;
+uniform int arcStride;
+
+flat out vec3 Color;
 
 uniform mat4 view;
 uniform mat4 projection;
 
+uniform vec3 parentPositions[32];
+
 void main()
 {
-    gl_Position = projection * view * vec4(aPos, 1.0);
-}
\ No newline at end of file
+    int arcSlot = gl_VertexID / arcStride;
+    int local = gl_VertexID - arcSlot * arcStride;
+    int segments = 1;
+    while (4 * segments <= local) // local is in [2n, 3n]
+        segments *= 2;
+    int orbit = arcSlot / arcsPerOrbit;
+    int arc = arcSlot - orbit * arcsPerOrbit;
+
+    vec4 periapsis = texelFetch(orbits, 3 * orbit);     // xyz: periapsis direction * semi-major axis, w: eccentricity
+    vec4 minorAxis = texelFetch(orbits, 3 * orbit + 1); // xyz: in-plane perpendicular * semi-minor axis, w: parent slot
+    vec4 color = texelFetch(orbits, 3 * orbit + 2);
+
+    // Both ends of an arc boundary compute float(arc) + 1.0 exactly: no cracks.
+    float E = 6.28318531 * (float(arc) + float(local - 2 * segments) / float(segments)) / float(arcsPerOrbit);
+    vec3 center = parentPositions[int(minorAxis.w)] - periapsis.w * periapsis.xyz;
+    vec3 position = center + cos(E) * periapsis.xyz + sin(E) * minorAxis.xyz;
+    Color = color.rgb;
+    gl_Position = projection * view * vec4(position, 1.0);
+}
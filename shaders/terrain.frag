@@ -0,0 +1,50 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 FragPos;
+in vec3 Normal;
+in vec3 Direction;
+
+uniform sampler2D ourTexture;
+
+uniform bool isShadowed;
+
+uniform vec3 lightPos;
+
+const float PI = 3.14159265359;
+
+void main()
+{
+    // Equirectangular lookup matching the Planet meshes' texture coordinates.
+    // Longitude is also computed shifted by half a turn and whichever has no
+    // jump between neighbouring pixels is used, hiding the u = 0/1 seam (the
+    // epsilon keeps the choice the same across a pixel quad away from it).
+    vec3 n = normalize(Direction);
+    float u = 1.0 - atan(n.z, n.x) / (2.0 * PI);
+    float uShifted = fract(u + 0.5) - 0.5;
+    u = fract(u);
+    u = fwidth(u) < fwidth(uShifted) - 0.001 ? u : uShifted;
+    float v = acos(clamp(-n.y, -1.0, 1.0)) / PI;
+
+    vec3 texColor = texture(ourTexture, vec2(u, v)).rgb;
+
+    vec3 ambient = 0.1 * texColor;
+
+    vec3 result;
+
+    if(!isShadowed)
+    {
+        vec3 lightDir = normalize(lightPos - FragPos);
+        float diff = max(dot(normalize(Normal), lightDir), 0.0);
+        vec3 sunLightColor = vec3(1.0, 0.97, 0.9);
+        vec3 diffuse = diff * sunLightColor * texColor;
+
+        result = ambient + diffuse;
+    }
+    else
+    {
+        result = ambient;
+    }
+
+    FragColor = vec4(result, 1.0);
+}
@@ -0,0 +1,55 @@
+#version 330 core
+// Quadtree terrain chunk (PlanetTerrain in include/terrain.h). There are no
+// vertex attributes: gl_VertexID indexes a 33x33 grid over the node.
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec3 Direction;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+uniform int face;
+uniform vec2 nodeOrigin;     // face coordinates of the node's corner
+uniform float nodeSize;      // face coordinates covered by the node
+uniform vec2 morphRange;     // camera distances where morphing to the coarser grid starts / completes
+uniform float tileLayer;
+uniform vec3 tileTransform;  // node uv -> height tile uv: scale, offset
+uniform sampler2DArray heightTiles;
+uniform vec3 cameraLocal;    // camera in the body's unit-sphere space
+
+const float kQuads = 32.0;
+
+// Same faces and cube-to-sphere mapping as cubeFaceBasis() / cubeSphereDirection() in src/planet.cpp
+const vec3 faceOrigins[6] = vec3[6](vec3(1, 1, 1), vec3(-1, 1, -1), vec3(-1, 1, -1), vec3(-1, -1, 1), vec3(-1, 1, 1), vec3(1, 1, -1));
+const vec3 faceUs[6] = vec3[6](vec3(0, 0, -2), vec3(0, 0, 2), vec3(2, 0, 0), vec3(2, 0, 0), vec3(2, 0, 0), vec3(-2, 0, 0));
+const vec3 faceVs[6] = vec3[6](vec3(0, -2, 0), vec3(0, -2, 0), vec3(0, 0, 2), vec3(0, 0, -2), vec3(0, -2, 0), vec3(0, -2, 0));
+
+vec3 cubeSphereDirection(vec2 st)
+{
+    vec3 p = faceOrigins[face] + st.x * faceUs[face] + st.y * faceVs[face];
+    vec3 p2 = p * p;
+    return normalize(p * sqrt(max(vec3(0.0), vec3(1.0) - p2.yzx / 2.0 - p2.zxy / 2.0 + p2.yzx * p2.zxy / 3.0)));
+}
+
+void main()
+{
+    vec2 grid = vec2(gl_VertexID % 33, gl_VertexID / 33);
+
+    // CDLOD morph: odd grid lines slide onto the even ones as the camera
+    // distance goes through morphRange, so at the far end of its range the
+    // chunk matches the coarser neighbour it borders.
+    float distanceToCamera = distance(cameraLocal, cubeSphereDirection(nodeOrigin + grid / kQuads * nodeSize));
+    float morph = clamp((distanceToCamera - morphRange.x) / (morphRange.y - morphRange.x), 0.0, 1.0);
+    grid -= fract(grid * 0.5) * 2.0 * morph;
+
+    vec3 direction = cubeSphereDirection(nodeOrigin + grid / kQuads * nodeSize);
+    vec2 tileUV = grid / kQuads * tileTransform.x + tileTransform.yz;
+    vec4 height = textureLod(heightTiles, vec3((tileUV * kQuads + 0.5) / (kQuads + 1.0), tileLayer), 0.0);
+
+    FragPos = vec3(model * vec4(direction * (1.0 + height.r), 1.0));
+    Normal = mat3(model) * height.gba;
+    Direction = direction;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
@@ -0,0 +1,479 @@
+#include "../include/asteroid_belt.h"
+#include "../include/frustum.h"
+#include "../include/planet.h"
+#include "../include/mesh_optimizer.h"
+#include "../include/profiler.h"
+#include "../include/glm/glm/gtc/constants.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <random>
+#include <tuple>
+
+namespace
+{
+    // Placement of one visible rock, written by asteroid_cull.comp (std430, 32 bytes).
+    struct RockPlacement
+    {
+        glm::vec4 positionSize;
+        glm::vec4 axisAngle;
+    };
+
+    /**
+     * @brief A rock: the unit sphere pushed in and out by a few smooth lobes
+     * and stretched along its axes. It depends on the direction only, so
+     * every level of a variant has the same outline.
+     */
+    struct RockShape
+    {
+        glm::vec3 stretch;
+        glm::vec3 lobeDirections[6];
+        float lobeHeights[6];
+
+        glm::vec3 point(const glm::vec3 &direction) const
+        {
+            float radius = 1.0f;
+            for (int k = 0; k < 6; ++k)
+                radius += lobeHeights[k] * std::exp(8.0f * (glm::dot(direction, lobeDirections[k]) - 1.0f));
+            return direction * radius * stretch;
+        }
+    };
+
+    RockShape makeRockShape(std::mt19937 &random)
+    {
+        std::uniform_real_distribution<float> stretch(0.65f, 1.15f);
+        std::uniform_real_distribution<float> height(-0.3f, 0.25f);
+        std::normal_distribution<float> axis(0.0f, 1.0f);
+
+        RockShape shape;
+        shape.stretch = glm::vec3(stretch(random) + 0.2f, stretch(random), stretch(random) - 0.1f);
+        for (int k = 0; k < 6; ++k)
+        {
+            shape.lobeDirections[k] = glm::normalize(glm::vec3(axis(random), axis(random), axis(random)) + glm::vec3(1e-4f));
+            shape.lobeHeights[k] = height(random);
+        }
+        return shape;
+    }
+
+    std::uint16_t unorm16(float value)
+    {
+        return (std::uint16_t)std::lround(glm::clamp(value, 0.0f, 1.0f) * 65535.0f);
+    }
+
+    std::uint8_t unorm8(float value)
+    {
+        return (std::uint8_t)std::lround(glm::clamp(value, 0.0f, 1.0f) * 255.0f);
+    }
+}
+
+AsteroidBelt::AsteroidBelt(const AsteroidBeltSettings &beltSettings)
+    : settings(beltSettings),
+      shader("shaders/asteroid.vert", "shaders/asteroid.frag")
+{
+    PROFILE_ZONE("AsteroidBelt::AsteroidBelt");
+
+    settings.variants = glm::clamp(settings.variants, 1u, 255u); // AsteroidElements::variant, 16-bit indices
+    buildMeshes();
+    generateElements();
+
+    glGenBuffers(1, &elementBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, elementBuffer);
+    glBufferData(GL_ARRAY_BUFFER, elements.size() * sizeof(AsteroidElements), elements.empty() ? nullptr : elements.data(), GL_STATIC_DRAW);
+
+    // 3.3 path: the elements themselves are the instance attributes; their
+    // pointers are set per variant in draw().
+    glGenVertexArrays(1, &fallbackVAO);
+    glBindVertexArray(fallbackVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, meshVBO);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *)(3 * sizeof(float)));
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshEBO);
+    for (GLuint location = 6; location <= 9; ++location)
+    {
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+    glBindVertexArray(0);
+
+    if (GL43::isAvailable())
+    {
+        cullShader.reset(new Shader("shaders/asteroid_cull.comp"));
+
+        // Worst case every rock is visible: one placement and one command index per rock.
+        GLuint *buffers[] = {&commandBuffer, &rockCommandBuffer, &cursorBuffer, &instanceBuffer, &readbackBuffers[0], &readbackBuffers[1]};
+        for (GLuint *buffer : buffers)
+            glGenBuffers(1, buffer);
+
+        for (const Level &level : levels)
+        {
+            DrawElementsIndirectCommand command;
+            command.count = level.indexCount;
+            command.instanceCount = 0;
+            command.firstIndex = level.firstIndex;
+            command.baseVertex = 0;
+            command.baseInstance = 0;
+            commandTemplate.push_back(command);
+        }
+        std::size_t commandBytes = commandTemplate.size() * sizeof(DrawElementsIndirectCommand);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, commandBytes, commandTemplate.data(), GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, cursorBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, commandTemplate.size() * sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, rockCommandBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, std::max<std::size_t>(elements.size(), 1) * sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, instanceBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, std::max<std::size_t>(elements.size(), 1) * sizeof(RockPlacement), nullptr, GL_DYNAMIC_DRAW);
+        for (GLuint readback : readbackBuffers)
+        {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, readback);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, commandBytes, nullptr, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        glGenVertexArrays(1, &indirectVAO);
+        glBindVertexArray(indirectVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, meshVBO);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *)(3 * sizeof(float)));
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshEBO);
+        // Each command's baseInstance selects its slice of instanceBuffer.
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(RockPlacement), (void *)offsetof(RockPlacement, positionSize));
+        glVertexAttribDivisor(4, 1);
+        glEnableVertexAttribArray(5);
+        glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(RockPlacement), (void *)offsetof(RockPlacement, axisAngle));
+        glVertexAttribDivisor(5, 1);
+        glBindVertexArray(0);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+AsteroidBelt::~AsteroidBelt()
+{
+    GLuint vertexArrays[] = {fallbackVAO, indirectVAO};
+    glDeleteVertexArrays(2, vertexArrays);
+    GLuint buffers[] = {meshVBO, meshEBO, elementBuffer, commandBuffer, rockCommandBuffer, cursorBuffer,
+                        instanceBuffer, readbackBuffers[0], readbackBuffers[1]};
+    glDeleteBuffers(9, buffers);
+    glDeleteProgram(shader.ID);
+    if (cullShader)
+        glDeleteProgram(cullShader->ID);
+}
+
+void AsteroidBelt::buildMeshes()
+{
+    PROFILE_ZONE("AsteroidBelt::buildMeshes");
+
+    std::vector<float> vertices; // position(3) + normal(3)
+    std::vector<unsigned short> indices;
+    std::mt19937 random(settings.seed);
+    rockBound = 0.0f;
+
+    for (unsigned int variant = 0; variant < settings.variants; ++variant)
+    {
+        RockShape shape = makeRockShape(random);
+        for (int level = 0; level < kLevels; ++level)
+        {
+            MeshData sphere = generateIcosphere(1.0f, (unsigned int)(kLevels - 1 - level));
+
+            // The icosphere duplicates its texture seam and pole vertices;
+            // rocks are untextured, so weld them back for smooth normals.
+            std::map<std::tuple<float, float, float>, unsigned int> welded;
+            std::vector<unsigned int> remap(sphere.positions.size());
+            std::vector<glm::vec3> positions;
+            for (std::size_t i = 0; i < sphere.positions.size(); ++i)
+            {
+                const glm::vec3 &p = sphere.positions[i];
+                auto inserted = welded.emplace(std::make_tuple(p.x, p.y, p.z), (unsigned int)positions.size());
+                if (inserted.second)
+                    positions.push_back(shape.point(p));
+                remap[i] = inserted.first->second;
+            }
+            std::vector<unsigned int> triangles(sphere.indices.size());
+            for (std::size_t i = 0; i < triangles.size(); ++i)
+                triangles[i] = remap[sphere.indices[i]];
+
+            std::vector<glm::vec3> normals(positions.size(), glm::vec3(0.0f));
+            for (std::size_t i = 0; i + 2 < triangles.size(); i += 3)
+            {
+                const glm::vec3 &a = positions[triangles[i]], &b = positions[triangles[i + 1]], &c = positions[triangles[i + 2]];
+                glm::vec3 faceNormal = glm::cross(b - a, c - a); // area-weighted
+                for (int corner = 0; corner < 3; ++corner)
+                    normals[triangles[i + corner]] += faceNormal;
+            }
+
+            MeshOptimizer::optimizeVertexCache(triangles, positions.size());
+            std::vector<unsigned int> order = MeshOptimizer::optimizeVertexFetch(triangles, positions.size());
+            MeshOptimizer::remapVertices(positions, order);
+            MeshOptimizer::remapVertices(normals, order);
+
+            unsigned int baseVertex = (unsigned int)(vertices.size() / 6);
+            Level meshLevel;
+            meshLevel.firstIndex = (GLuint)indices.size();
+            meshLevel.indexCount = (GLuint)triangles.size();
+            levels.push_back(meshLevel);
+            for (std::size_t i = 0; i < positions.size(); ++i)
+            {
+                glm::vec3 n = glm::normalize(normals[i]);
+                vertices.insert(vertices.end(), {positions[i].x, positions[i].y, positions[i].z, n.x, n.y, n.z});
+                rockBound = std::max(rockBound, glm::length(positions[i]));
+            }
+            for (unsigned int index : triangles)
+                indices.push_back((unsigned short)(baseVertex + index));
+        }
+    }
+
+    glGenBuffers(1, &meshVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, meshVBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    glGenBuffers(1, &meshEBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshEBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned short), indices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void AsteroidBelt::generateElements()
+{
+    PROFILE_ZONE("AsteroidBelt::generateElements");
+
+    std::mt19937 random(settings.seed * 7919u + 1u);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const float twoPi = 2.0f * glm::pi<float>();
+    float inner2 = settings.innerRadius * settings.innerRadius;
+    float outer2 = settings.outerRadius * settings.outerRadius;
+    float brightest = std::numeric_limits<float>::infinity(); // the largest catalog rock's H
+    if (settings.catalog)
+    {
+        settings.count = (unsigned int)std::min<std::size_t>(settings.count, settings.catalog->size());
+        for (std::size_t i = 0; i < settings.count; ++i)
+            brightest = std::min(brightest, settings.catalog->absoluteMagnitude[i]);
+    }
+
+    // Contiguous per variant, so the 3.3 path draws each shape's rocks as one range.
+    elements.resize(settings.count);
+    variantFirst.clear();
+    std::size_t next = 0;
+    for (unsigned int variant = 0; variant < settings.variants; ++variant)
+    {
+        variantFirst.push_back((GLuint)next);
+        std::size_t count = settings.count / settings.variants + (variant < settings.count % settings.variants ? 1 : 0);
+        for (std::size_t i = 0; i < count; ++i, ++next)
+        {
+            AsteroidElements &rock = elements[next];
+            if (settings.catalog)
+            {
+                catalogElements(i * settings.variants + variant, brightest, random, rock);
+                rock.variant = (std::uint8_t)variant;
+                continue;
+            }
+            // Uniform density over the annulus, mostly small rocks.
+            rock.semiMajorAxis = std::sqrt(inner2 + unit(random) * (outer2 - inner2));
+            rock.meanAnomaly = unit(random) * twoPi;
+            rock.eccentricity = unorm16(unit(random) * settings.maxEccentricity);
+            rock.inclination = unorm16(unit(random) * settings.maxInclination / glm::pi<float>());
+            rock.ascendingNode = unorm16(unit(random));
+            rock.periapsis = unorm16(unit(random));
+            float u = unit(random);
+            float size = settings.minSize * std::pow(settings.maxSize / settings.minSize, u * u);
+            rock.size = unorm16(size / settings.maxSize);
+            rock.spin = unorm8(unit(random));
+            rock.variant = (std::uint8_t)variant;
+        }
+    }
+    variantFirst.push_back((GLuint)next);
+}
+
+void AsteroidBelt::catalogElements(std::size_t i, float brightest, std::mt19937 &random, AsteroidElements &rock) const
+{
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const double twoPi = 2.0 * glm::pi<double>();
+    OrbitalElements orbit = settings.catalog->orbits.elements(i);
+    double meanAnomaly = std::fmod(orbit.meanAnomaly - orbit.meanMotion * orbit.epoch, twoPi); // at t = 0
+    rock.semiMajorAxis = (float)orbit.semiMajorAxis;
+    rock.meanAnomaly = (float)(meanAnomaly < 0.0 ? meanAnomaly + twoPi : meanAnomaly);
+    rock.eccentricity = unorm16((float)orbit.eccentricity);
+    rock.inclination = unorm16((float)(orbit.inclination / glm::pi<double>()));
+    rock.ascendingNode = unorm16((float)(std::fmod(orbit.ascendingNode + twoPi, twoPi) / twoPi));
+    rock.periapsis = unorm16((float)(std::fmod(orbit.periapsis + twoPi, twoPi) / twoPi));
+    // Diameter goes as 10^(-H / 5) at a fixed albedo; the brightest rock gets maxSize.
+    float h = settings.catalog->absoluteMagnitude[i];
+    float size = std::isnan(h) ? settings.minSize : std::max(settings.minSize, settings.maxSize * std::pow(10.0f, (brightest - h) / 5.0f));
+    rock.size = unorm16(size / settings.maxSize);
+    rock.spin = unorm8(unit(random));
+}
+
+void AsteroidBelt::cull(float t, const glm::mat4 &viewProjection, const glm::vec3 &eye, float fovY, float viewportHeight)
+{
+    PROFILE_ZONE("AsteroidBelt::cull");
+
+    // Counts of the cull() before last, whose copy the GPU has normally finished.
+    int slot = (int)(frame % 2);
+    if (readbackValid[slot])
+    {
+        std::vector<DrawElementsIndirectCommand> counts(commandTemplate.size());
+        glBindBuffer(GL_COPY_READ_BUFFER, readbackBuffers[slot]);
+        glGetBufferSubData(GL_COPY_READ_BUFFER, 0, counts.size() * sizeof(DrawElementsIndirectCommand), counts.data());
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        readbackStats = AsteroidStats();
+        for (const DrawElementsIndirectCommand &command : counts)
+        {
+            readbackStats.rocks += command.instanceCount;
+            readbackStats.triangles += (std::size_t)command.instanceCount * command.count / 3;
+        }
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, commandTemplate.size() * sizeof(DrawElementsIndirectCommand), commandTemplate.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glm::vec4 frustumPlanes[6];
+    extractFrustumPlanes(viewProjection, frustumPlanes);
+
+    Shader &cs = *cullShader;
+    cs.use();
+    glUniform1ui(glGetUniformLocation(cs.ID, "rockCount"), (GLuint)elements.size());
+    glUniform1ui(glGetUniformLocation(cs.ID, "commandCount"), (GLuint)commandTemplate.size());
+    glUniform1ui(glGetUniformLocation(cs.ID, "levelCount"), (GLuint)kLevels);
+    cs.setFloat("time", t);
+    cs.setFloat("gm", settings.gm);
+    cs.setFloat("maxSize", settings.maxSize);
+    cs.setFloat("maxSpin", settings.maxSpin);
+    cs.setFloat("rockBound", rockBound);
+    cs.setVec4Array("frustumPlanes", frustumPlanes, 6);
+    cs.setVec3("cameraPos", eye);
+    cs.setFloat("tanHalfFovY", std::tan(fovY * 0.5f));
+    cs.setFloat("viewportHeight", viewportHeight);
+    glUniform2f(glGetUniformLocation(cs.ID, "lodRadiusPx"), settings.lodRadiusPx[0], settings.lodRadiusPx[1]);
+    cs.setFloat("cullRadiusPx", settings.cullRadiusPx);
+    cs.setFloat("maxDistance", settings.maxDistance);
+
+    GLuint bindings[] = {elementBuffer, commandBuffer, rockCommandBuffer, cursorBuffer, instanceBuffer};
+    for (GLuint i = 0; i < 5; ++i)
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i, bindings[i]);
+
+    // One invocation per rock, over a 2D grid of groups past the 65535 limit of one dimension.
+    GLuint groups = (GLuint)((elements.size() + 63) / 64);
+    GLuint groupsX = std::min<GLuint>(groups, 65535u);
+    GLuint groupsY = (groups + groupsX - 1) / groupsX;
+
+    // Stage 0 places every rock, culls it, picks its level and counts it into
+    // its (shape, level) command; stage 1 turns the counts into each command's
+    // slice of instanceBuffer; stage 2 places the visible rocks again and
+    // writes them into their slice.
+    GLint stage = glGetUniformLocation(cs.ID, "stage");
+    glUniform1i(stage, 0);
+    glDispatchCompute(groupsX, groupsY, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    glUniform1i(stage, 1);
+    glDispatchCompute(1, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    glUniform1i(stage, 2);
+    glDispatchCompute(groupsX, groupsY, 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    glBindBuffer(GL_COPY_READ_BUFFER, commandBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, readbackBuffers[slot]);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, commandTemplate.size() * sizeof(DrawElementsIndirectCommand));
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    readbackValid[slot] = true;
+    ++frame;
+}
+
+void AsteroidBelt::draw(float t, const glm::mat4 &view, const glm::mat4 &projection, const glm::vec3 &eye,
+                        float fovY, float viewportHeight, const glm::vec3 &lightPos, bool gpuDriven)
+{
+    PROFILE_ZONE("AsteroidBelt::draw");
+    if (elements.empty())
+        return;
+
+    bool useCompute = gpuDriven && cullShader;
+    if (useCompute)
+        cull(t, projection * view, eye, fovY, viewportHeight);
+
+    shader.use();
+    shader.setBool("placed", useCompute);
+    shader.setFloat("time", t);
+    shader.setFloat("gm", settings.gm);
+    shader.setFloat("maxSize", settings.maxSize);
+    shader.setFloat("maxSpin", settings.maxSpin);
+    shader.setFloat("rockBound", rockBound);
+    shader.setMat4("view", view);
+    shader.setMat4("projection", projection);
+    shader.setVec3("lightPos", lightPos);
+
+    if (useCompute)
+    {
+        glBindVertexArray(indirectVAO);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, nullptr, (GLsizei)commandTemplate.size(), 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        glBindVertexArray(0);
+        return;
+    }
+
+    // 3.3: every rock goes through every level's draw of its shape; the
+    // vertex shader keeps it in one of them at most.
+    shader.setVec3("cameraPos", eye);
+    shader.setFloat("tanHalfFovY", std::tan(fovY * 0.5f));
+    shader.setFloat("viewportHeight", viewportHeight);
+    glUniform2f(glGetUniformLocation(shader.ID, "lodRadiusPx"), settings.lodRadiusPx[0], settings.lodRadiusPx[1]);
+    shader.setFloat("cullRadiusPx", settings.cullRadiusPx);
+    shader.setFloat("maxDistance", settings.maxDistance);
+
+    glBindVertexArray(fallbackVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, elementBuffer);
+    GLsizei stride = sizeof(AsteroidElements);
+    for (unsigned int variant = 0; variant < settings.variants; ++variant)
+    {
+        GLsizei rocks = (GLsizei)(variantFirst[variant + 1] - variantFirst[variant]);
+        if (rocks == 0)
+            continue;
+        std::size_t first = (std::size_t)variantFirst[variant] * stride;
+        glVertexAttribPointer(6, 2, GL_FLOAT, GL_FALSE, stride, (void *)(first + offsetof(AsteroidElements, semiMajorAxis)));
+        glVertexAttribPointer(7, 4, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void *)(first + offsetof(AsteroidElements, eccentricity)));
+        glVertexAttribPointer(8, 1, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void *)(first + offsetof(AsteroidElements, size)));
+        glVertexAttribPointer(9, 1, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void *)(first + offsetof(AsteroidElements, spin)));
+        for (int level = 0; level < kLevels; ++level)
+        {
+            const Level &mesh = levels[variant * kLevels + level];
+            shader.setInt("level", level);
+            glDrawElementsInstanced(GL_TRIANGLES, (GLsizei)mesh.indexCount, GL_UNSIGNED_SHORT,
+                                    (void *)(mesh.firstIndex * sizeof(unsigned short)), rocks);
+        }
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+AsteroidStats AsteroidBelt::takeStats()
+{
+    AsteroidStats stats = readbackStats;
+    readbackStats = AsteroidStats();
+    return stats;
+}
+
+std::size_t AsteroidBelt::gpuBytes() const
+{
+    std::size_t bytes = elements.size() * sizeof(AsteroidElements);
+    GLint size = 0;
+    for (GLuint buffer : {meshVBO, meshEBO})
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+        bytes += (std::size_t)size;
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    if (cullShader)
+        bytes += elements.size() * (sizeof(RockPlacement) + sizeof(GLuint))
+                 + commandTemplate.size() * (3 * sizeof(DrawElementsIndirectCommand) + sizeof(GLuint));
+    return bytes;
+}
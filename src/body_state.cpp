@@ -0,0 +1,163 @@
+#include "../include/body_state.h"
+#include "../include/profiler.h"
+
+#include <cmath>
+
+std::size_t BodyState::add(const BodyMotion &motion)
+{
+    glm::vec3 axis = glm::length(motion.rotationAxis) > 0.0f ? glm::normalize(motion.rotationAxis) : glm::vec3(0, 1, 0);
+    parent.push_back(-1);
+    radius.push_back(motion.radius);
+    orbitRadius.push_back(motion.orbitRadius);
+    orbitSpeed.push_back(motion.orbitSpeed);
+    orbitPhase.push_back(motion.orbitPhase);
+    orbitEccentricity.push_back(motion.orbitEccentricity);
+    orbitInclination.push_back(motion.orbitInclination);
+    orbitAscendingNode.push_back(motion.orbitAscendingNode);
+    orbitPeriapsis.push_back(motion.orbitPeriapsis);
+    rotationSpeed.push_back(motion.rotationSpeed);
+    axisX.push_back(axis.x);
+    axisY.push_back(axis.y);
+    axisZ.push_back(axis.z);
+    gm.push_back(motion.gm);
+    positionX.push_back(0.0f);
+    positionY.push_back(0.0f);
+    positionZ.push_back(0.0f);
+    model.push_back(glm::mat4(1.0f));
+    return radius.size() - 1;
+}
+
+void BodyState::reserve(std::size_t count)
+{
+    parent.reserve(count);
+    radius.reserve(count);
+    orbitRadius.reserve(count);
+    orbitSpeed.reserve(count);
+    orbitPhase.reserve(count);
+    orbitEccentricity.reserve(count);
+    orbitInclination.reserve(count);
+    orbitAscendingNode.reserve(count);
+    orbitPeriapsis.reserve(count);
+    rotationSpeed.reserve(count);
+    axisX.reserve(count);
+    axisY.reserve(count);
+    axisZ.reserve(count);
+    gm.reserve(count);
+    positionX.reserve(count);
+    positionY.reserve(count);
+    positionZ.reserve(count);
+    model.reserve(count);
+}
+
+namespace
+{
+    template <typename T>
+    void permuteArray(std::vector<T> &values, const std::vector<std::size_t> &order)
+    {
+        std::vector<T> permuted(values.size());
+        for (std::size_t i = 0; i < order.size(); ++i)
+            permuted[i] = values[order[i]];
+        values.swap(permuted);
+    }
+}
+
+void BodyState::permute(const std::vector<std::size_t> &order)
+{
+    permuteArray(parent, order);
+    permuteArray(radius, order);
+    permuteArray(orbitRadius, order);
+    permuteArray(orbitSpeed, order);
+    permuteArray(orbitPhase, order);
+    permuteArray(orbitEccentricity, order);
+    permuteArray(orbitInclination, order);
+    permuteArray(orbitAscendingNode, order);
+    permuteArray(orbitPeriapsis, order);
+    permuteArray(rotationSpeed, order);
+    permuteArray(axisX, order);
+    permuteArray(axisY, order);
+    permuteArray(axisZ, order);
+    permuteArray(gm, order);
+    permuteArray(positionX, order);
+    permuteArray(positionY, order);
+    permuteArray(positionZ, order);
+    permuteArray(model, order);
+}
+
+namespace
+{
+    // translate * rotate(spin, axis) * scale(radius), written out: the
+    // rotation's columns (Rodrigues) scaled by the radius, then the position.
+    inline void writeModel(const BodyState &state, std::size_t i, float t, float px, float py, float pz, glm::mat4 &m)
+    {
+        float spin = t * state.rotationSpeed[i];
+        float c = std::cos(spin), s = std::sin(spin), k = 1.0f - c;
+        float ax = state.axisX[i], ay = state.axisY[i], az = state.axisZ[i];
+        float scale = state.radius[i];
+        m[0] = glm::vec4((c + k * ax * ax) * scale, (k * ax * ay + s * az) * scale, (k * ax * az - s * ay) * scale, 0.0f);
+        m[1] = glm::vec4((k * ay * ax - s * az) * scale, (c + k * ay * ay) * scale, (k * ay * az + s * ax) * scale, 0.0f);
+        m[2] = glm::vec4((k * az * ax + s * ay) * scale, (k * az * ay - s * ax) * scale, (c + k * az * az) * scale, 0.0f);
+        m[3] = glm::vec4(px, py, pz, 1.0f);
+    }
+}
+
+OrbitalElements bodyOrbit(const BodyState &state, std::size_t slot)
+{
+    OrbitalElements orbit;
+    orbit.semiMajorAxis = state.orbitRadius[slot];
+    orbit.eccentricity = state.orbitEccentricity[slot];
+    orbit.inclination = state.orbitInclination[slot];
+    orbit.ascendingNode = state.orbitAscendingNode[slot];
+    orbit.periapsis = state.orbitPeriapsis[slot];
+    orbit.meanAnomaly = state.orbitPhase[slot];
+    orbit.meanMotion = state.orbitSpeed[slot];
+    return orbit;
+}
+
+void updateBodyTransforms(BodyState &state, float t)
+{
+    PROFILE_ZONE("updateBodyTransforms");
+    const std::size_t count = state.size();
+    const std::int32_t *parent = state.parent.data();
+    float *x = state.positionX.data();
+    float *y = state.positionY.data();
+    float *z = state.positionZ.data();
+    glm::mat4 *model = state.model.data();
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        float px, py, pz;
+        if (state.orbitEccentricity[i] == 0.0f && state.orbitInclination[i] == 0.0f)
+        {
+            float angle = t * state.orbitSpeed[i] + state.orbitPhase[i] + (state.orbitAscendingNode[i] + state.orbitPeriapsis[i]);
+            float r = state.orbitRadius[i];
+            px = r * std::cos(angle);
+            py = 0.0f;
+            pz = r * std::sin(angle);
+        }
+        else
+        {
+            glm::dvec3 position;
+            keplerState(bodyOrbit(state, i), t, position);
+            px = (float)position.x;
+            py = (float)position.y;
+            pz = (float)position.z;
+        }
+        if (parent[i] >= 0)
+        {
+            px += x[parent[i]];
+            py += y[parent[i]];
+            pz += z[parent[i]];
+        }
+        x[i] = px;
+        y[i] = py;
+        z[i] = pz;
+        writeModel(state, i, t, px, py, pz, model[i]);
+    }
+}
+
+void updateBodyModels(BodyState &state, float t)
+{
+    PROFILE_ZONE("updateBodyModels");
+    for (std::size_t i = 0; i < state.size(); ++i)
+        writeModel(state, i, t, state.positionX[i], state.positionY[i], state.positionZ[i], state.model[i]);
+}
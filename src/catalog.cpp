@@ -0,0 +1,657 @@
+#include "../include/catalog.h"
+#include "../include/mapped_file.h"
+#include "../include/parallel.h"
+#include "../include/profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+#include <sys/stat.h>
+
+namespace
+{
+    const double kPi = 3.14159265358979323846;
+    const double kDegrees = kPi / 180.0;
+    const double kGauss = 0.01720209895; // Gauss's gravitational constant, radians per day at 1 AU
+
+    // Parallel::threadCount()'s minimum; a megabyte is ~5000 MPCORB lines.
+    const std::size_t kMinBytesPerThread = 1 << 20;
+
+    /**
+     * @brief The binary image: this header, then count names, count H values
+     * (padded to 8 bytes) and KeplerPropagator::kColumns columns of count
+     * doubles, all in the writing machine's byte order.
+     */
+    struct ImageHeader
+    {
+        char magic[8];
+        std::uint64_t count;
+        std::uint64_t sourceSize;
+        std::int64_t sourceTime;
+        double unitsPerAu;
+        double secondsPerDay;
+        double epochJd;
+        std::uint32_t format;
+        std::uint32_t columns;
+    };
+
+    const char kImageMagic[8] = {'G', 'L', 'M', 'C', 'A', 'T', '1', '\n'};
+
+    std::size_t imageBytes(std::size_t count)
+    {
+        std::size_t magnitudeBytes = (count * sizeof(float) + 7) & ~(std::size_t)7;
+        return sizeof(ImageHeader) + count * sizeof(Catalog::Name) + magnitudeBytes + count * sizeof(double) * KeplerPropagator::kColumns;
+    }
+
+    bool isSpace(char c)
+    {
+        return c == ' ' || c == '\t';
+    }
+
+    /**
+     * @brief Parses the decimal number in [begin, end), spaces around it
+     * allowed, and nothing else. Rounds exactly like strtod: up to 19
+     * significant digits and a power of ten of at most 22 are exact doubles,
+     * so their product or quotient is rounded once (Clinger's fast path);
+     * anything longer goes to strtod through a stack copy.
+     */
+    bool parseNumber(const char *begin, const char *end, double &value)
+    {
+        static const double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                         1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+        while (begin < end && isSpace(*begin))
+            ++begin;
+        while (end > begin && isSpace(end[-1]))
+            --end;
+        const char *c = begin;
+        bool negative = c < end && *c == '-';
+        if (c < end && (*c == '-' || *c == '+'))
+            ++c;
+
+        std::uint64_t mantissa = 0;
+        int significant = 0, digits = 0, exponent = 0;
+        for (; c < end && *c >= '0' && *c <= '9'; ++c, ++digits)
+        {
+            if (mantissa == 0 && *c == '0')
+                continue;
+            if (significant++ < 19)
+                mantissa = mantissa * 10 + (std::uint64_t)(*c - '0');
+            else
+                ++exponent;
+        }
+        if (c < end && *c == '.')
+        {
+            for (++c; c < end && *c >= '0' && *c <= '9'; ++c, ++digits)
+            {
+                if (mantissa == 0 && *c == '0')
+                {
+                    --exponent;
+                    continue;
+                }
+                if (significant++ < 19)
+                {
+                    mantissa = mantissa * 10 + (std::uint64_t)(*c - '0');
+                    --exponent;
+                }
+            }
+        }
+        if (digits == 0)
+            return false;
+        if (c < end && (*c == 'e' || *c == 'E'))
+        {
+            ++c;
+            bool negativeExponent = c < end && *c == '-';
+            if (c < end && (*c == '-' || *c == '+'))
+                ++c;
+            int power = 0;
+            if (c == end || *c < '0' || *c > '9')
+                return false;
+            for (; c < end && *c >= '0' && *c <= '9'; ++c)
+                power = std::min(power * 10 + (*c - '0'), 100000);
+            exponent += negativeExponent ? -power : power;
+        }
+        if (c != end)
+            return false;
+
+        if (significant <= 19 && mantissa <= (std::uint64_t(1) << 53) && exponent >= -22 && exponent <= 22)
+        {
+            value = exponent < 0 ? (double)mantissa / powers[-exponent] : (double)mantissa * powers[exponent];
+            value = negative ? -value : value;
+            return true;
+        }
+        char copy[64];
+        std::size_t length = (std::size_t)(end - begin);
+        if (length >= sizeof(copy))
+            return false;
+        std::memcpy(copy, begin, length);
+        copy[length] = '\0';
+        value = std::strtod(copy, nullptr);
+        return true;
+    }
+
+    /** @brief Days from 1970-01-01 to a proleptic Gregorian date (Hinnant's days_from_civil). */
+    long long daysFromCivil(long long year, unsigned month, unsigned day)
+    {
+        year -= month <= 2;
+        long long era = (year >= 0 ? year : year - 399) / 400;
+        unsigned yearOfEra = (unsigned)(year - era * 400);
+        unsigned dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+        return era * 146097 + (long long)dayOfEra - 719468;
+    }
+
+    /** @brief '1'-'9' are 1-9 and 'A'-'V' 10-31, as in MPC packed dates; -1 otherwise. */
+    int packedDigit(char c)
+    {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'A' && c <= 'V')
+            return c - 'A' + 10;
+        return -1;
+    }
+
+    /** @brief Julian date of an MPC packed epoch such as K24AH (2024 October 17, 0h TT). */
+    bool parsePackedEpoch(const char *packed, double &jd)
+    {
+        int century = packedDigit(packed[0]);
+        int decade = packedDigit(packed[1]), year = packedDigit(packed[2]);
+        int month = packedDigit(packed[3]), day = packedDigit(packed[4]);
+        if (century < 10 || decade < 0 || decade > 9 || year < 0 || year > 9 || month < 1 || month > 12 || day < 1)
+            return false;
+        jd = (double)daysFromCivil(century * 100 + decade * 10 + year, (unsigned)month, (unsigned)day) + 2440587.5;
+        return true;
+    }
+
+    /** @brief The text in [begin, end) without spaces or quotes around it, cut to fit a name. */
+    void copyName(const char *begin, const char *end, Catalog::Name &name)
+    {
+        while (begin < end && (isSpace(*begin) || *begin == '"'))
+            ++begin;
+        while (end > begin && (isSpace(end[-1]) || end[-1] == '"'))
+            --end;
+        std::size_t length = std::min((std::size_t)(end - begin), name.size() - 1);
+        std::memcpy(name.data(), begin, length);
+        std::memset(name.data() + length, 0, name.size() - length);
+    }
+
+    /** @brief One orbit as the catalogs give it: AU, degrees, degrees per day and Julian dates. */
+    struct RawOrbit
+    {
+        double a, e, inclination, node, periapsis, meanAnomaly, epochJd;
+        double meanMotion; // NaN: from a
+    };
+
+    bool toScene(const RawOrbit &raw, const CatalogSettings &settings, OrbitalElements &elements)
+    {
+        if (!(raw.a > 0.0) || !(raw.e >= 0.0) || !(raw.e < 1.0)) // KeplerPropagator is elliptic only
+            return false;
+        double radiansPerDay = std::isnan(raw.meanMotion) ? kGauss / (raw.a * std::sqrt(raw.a)) : raw.meanMotion * kDegrees;
+        elements.semiMajorAxis = raw.a * settings.unitsPerAu;
+        elements.eccentricity = raw.e;
+        elements.inclination = raw.inclination * kDegrees;
+        elements.ascendingNode = raw.node * kDegrees;
+        elements.periapsis = raw.periapsis * kDegrees;
+        elements.meanAnomaly = raw.meanAnomaly * kDegrees;
+        elements.epoch = (raw.epochJd - settings.epochJd) * settings.secondsPerDay;
+        elements.meanMotion = radiansPerDay / settings.secondsPerDay;
+        return true;
+    }
+
+    const std::size_t kMpcorbMinLength = 103; // through the semi-major axis
+
+    bool parseMpcorb(const char *line, std::size_t length, RawOrbit &raw, float &magnitude)
+    {
+        if (length < kMpcorbMinLength)
+            return false;
+        double h;
+        magnitude = parseNumber(line + 8, line + 13, h) ? (float)h : std::numeric_limits<float>::quiet_NaN();
+        return parsePackedEpoch(line + 20, raw.epochJd) &&
+               parseNumber(line + 26, line + 35, raw.meanAnomaly) &&
+               parseNumber(line + 37, line + 46, raw.periapsis) &&
+               parseNumber(line + 48, line + 57, raw.node) &&
+               parseNumber(line + 59, line + 68, raw.inclination) &&
+               parseNumber(line + 70, line + 79, raw.e) &&
+               parseNumber(line + 80, line + 91, raw.meanMotion) &&
+               parseNumber(line + 92, line + 103, raw.a);
+    }
+
+    enum CsvField
+    {
+        kName, kA, kE, kInclination, kNode, kPeriapsis, kMeanAnomaly, kEpoch, kMeanMotion, kMagnitude, kFieldCount
+    };
+
+    /** @brief Which CSV column (0-based) holds each CsvField, -1 for none. */
+    struct CsvLayout
+    {
+        int column[kFieldCount];
+        int columns = 0; // in the header
+    };
+
+    /**
+     * @brief Calls fn(index, begin, end) for each comma-separated field of the
+     * line; commas inside double quotes do not separate.
+     */
+    template <typename Fn>
+    void forEachField(const char *line, std::size_t length, Fn fn)
+    {
+        const char *end = line + length;
+        const char *begin = line;
+        bool quoted = false;
+        int index = 0;
+        for (const char *c = line; c < end; ++c)
+        {
+            if (*c == '"')
+                quoted = !quoted;
+            else if (*c == ',' && !quoted)
+            {
+                fn(index++, begin, c);
+                begin = c + 1;
+            }
+        }
+        fn(index, begin, end);
+    }
+
+    bool parseCsvHeader(const char *line, std::size_t length, CsvLayout &layout)
+    {
+        static const char *const names[kFieldCount][5] = {
+            {"name", "full_name", "designation", "pdes", nullptr},
+            {"a", nullptr}, {"e", nullptr}, {"i", "incl", nullptr}, {"om", "node", nullptr},
+            {"w", "peri", nullptr}, {"ma", "m", nullptr}, {"epoch", nullptr}, {"n", nullptr}, {"h", nullptr}};
+        std::fill(layout.column, layout.column + kFieldCount, -1);
+        layout.columns = 0;
+        forEachField(line, length, [&](int index, const char *begin, const char *end)
+        {
+            layout.columns = index + 1;
+            while (begin < end && (isSpace(*begin) || *begin == '"'))
+                ++begin;
+            while (end > begin && (isSpace(end[-1]) || end[-1] == '"'))
+                --end;
+            char lower[16];
+            std::size_t n = (std::size_t)(end - begin);
+            if (n >= sizeof(lower))
+                return;
+            for (std::size_t k = 0; k < n; ++k)
+                lower[k] = (char)std::tolower((unsigned char)begin[k]);
+            lower[n] = '\0';
+            for (int field = 0; field < kFieldCount; ++field)
+                for (int k = 0; names[field][k]; ++k)
+                    if (layout.column[field] < 0 && std::strcmp(lower, names[field][k]) == 0)
+                        layout.column[field] = index;
+        });
+        for (int field = kA; field <= kEpoch; ++field)
+            if (layout.column[field] < 0)
+                return false;
+        return true;
+    }
+
+    bool parseCsv(const char *line, std::size_t length, const CsvLayout &layout, RawOrbit &raw, float &magnitude, Catalog::Name &name)
+    {
+        double values[kFieldCount];
+        bool present[kFieldCount] = {};
+        const char *nameBegin = line, *nameEnd = line;
+        forEachField(line, length, [&](int index, const char *begin, const char *end)
+        {
+            for (int field = 0; field < kFieldCount; ++field)
+            {
+                if (layout.column[field] != index)
+                    continue;
+                if (field == kName)
+                {
+                    nameBegin = begin;
+                    nameEnd = end;
+                }
+                else
+                    present[field] = parseNumber(begin, end, values[field]);
+            }
+        });
+        for (int field = kA; field <= kEpoch; ++field)
+            if (!present[field])
+                return false;
+        raw.a = values[kA];
+        raw.e = values[kE];
+        raw.inclination = values[kInclination];
+        raw.node = values[kNode];
+        raw.periapsis = values[kPeriapsis];
+        raw.meanAnomaly = values[kMeanAnomaly];
+        raw.epochJd = values[kEpoch];
+        raw.meanMotion = present[kMeanMotion] ? values[kMeanMotion] : std::numeric_limits<double>::quiet_NaN();
+        magnitude = present[kMagnitude] ? (float)values[kMagnitude] : std::numeric_limits<float>::quiet_NaN();
+        copyName(nameBegin, nameEnd, name);
+        return true;
+    }
+
+    /** @brief Calls fn(line, length) for each line in [begin, end), without its line break. */
+    template <typename Fn>
+    void forEachLine(const char *begin, const char *end, Fn fn)
+    {
+        while (begin < end)
+        {
+            const char *newline = (const char *)std::memchr(begin, '\n', (std::size_t)(end - begin));
+            const char *lineEnd = newline ? newline : end;
+            std::size_t length = (std::size_t)(lineEnd - begin);
+            if (length > 0 && begin[length - 1] == '\r')
+                --length;
+            fn(begin, length);
+            begin = newline ? newline + 1 : end;
+        }
+    }
+
+    bool isBlank(const char *line, std::size_t length)
+    {
+        for (std::size_t k = 0; k < length; ++k)
+            if (!isSpace(line[k]))
+                return false;
+        return true;
+    }
+
+    /** @brief A thread's share of the file, whole lines. */
+    struct Chunk
+    {
+        const char *begin;
+        const char *end;
+        std::size_t first = 0;      // slot of its first orbit
+        std::size_t candidates = 0; // lines that look like orbits
+        std::size_t parsed = 0;     // orbits written from slot first on
+        std::size_t lines = 0;
+    };
+
+    std::vector<Chunk> splitLines(const char *begin, const char *end, unsigned int count)
+    {
+        std::vector<Chunk> chunks;
+        const char *start = begin;
+        for (unsigned int i = 1; i <= count && start < end; ++i)
+        {
+            const char *stop = i == count ? end : begin + (std::size_t)(end - begin) * i / count;
+            if (stop < start)
+                stop = start;
+            const char *newline = stop < end ? (const char *)std::memchr(stop, '\n', (std::size_t)(end - stop)) : nullptr;
+            stop = newline ? newline + 1 : end;
+            Chunk chunk;
+            chunk.begin = start;
+            chunk.end = stop;
+            chunks.push_back(chunk);
+            start = stop;
+        }
+        return chunks;
+    }
+
+    CatalogFormat resolveFormat(const std::string &path, CatalogFormat format)
+    {
+        if (format != CatalogFormat::Auto)
+            return format;
+        std::string extension = path.size() >= 4 ? path.substr(path.size() - 4) : std::string();
+        for (char &c : extension)
+            c = (char)std::tolower((unsigned char)c);
+        return extension == ".csv" ? CatalogFormat::Csv : CatalogFormat::Mpcorb;
+    }
+
+    bool sourceIdentity(const std::string &path, std::uint64_t &size, std::int64_t &time)
+    {
+        struct stat info;
+        if (::stat(path.c_str(), &info) != 0)
+            return false;
+        size = (std::uint64_t)info.st_size;
+        time = (std::int64_t)info.st_mtime;
+        return true;
+    }
+
+    ImageHeader makeHeader(std::size_t count, std::uint64_t sourceSize, std::int64_t sourceTime, CatalogFormat format, const CatalogSettings &settings)
+    {
+        ImageHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, kImageMagic, sizeof(kImageMagic));
+        header.count = count;
+        header.sourceSize = sourceSize;
+        header.sourceTime = sourceTime;
+        header.unitsPerAu = settings.unitsPerAu;
+        header.secondsPerDay = settings.secondsPerDay;
+        header.epochJd = settings.epochJd;
+        header.format = (std::uint32_t)format;
+        header.columns = KeplerPropagator::kColumns;
+        return header;
+    }
+
+    /** @brief Fills @p catalog from the image if it was written for this source and these settings. */
+    bool readImage(const std::string &imagePath, const ImageHeader &expected, Catalog &catalog, unsigned int threads, CatalogLoadStats &stats)
+    {
+        PROFILE_ZONE("readImage");
+        MappedFile image(imagePath);
+        if (!image.isOpen() || image.size() < sizeof(ImageHeader))
+            return false;
+        ImageHeader header;
+        std::memcpy(&header, image.data(), sizeof(header));
+        std::size_t count = (std::size_t)header.count;
+        if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 || header.sourceSize != expected.sourceSize ||
+            header.sourceTime != expected.sourceTime || header.unitsPerAu != expected.unitsPerAu ||
+            header.secondsPerDay != expected.secondsPerDay || header.epochJd != expected.epochJd ||
+            header.format != expected.format || header.columns != expected.columns || image.size() != imageBytes(count))
+            return false;
+
+        catalog.orbits.resize(count);
+        catalog.names.resize(count);
+        catalog.absoluteMagnitude.resize(count);
+        const char *names = image.data() + sizeof(ImageHeader);
+        const char *magnitudes = names + count * sizeof(Catalog::Name);
+        const char *columns = magnitudes + ((count * sizeof(float) + 7) & ~(std::size_t)7);
+
+        // Every thread copies its slice of every array.
+        unsigned int threadsUsed = Parallel::threadCount(threads, image.size(), kMinBytesPerThread);
+        Parallel::parallelFor(threadsUsed, [&](unsigned int t)
+        {
+            std::size_t begin = count * t / threadsUsed, end = count * (t + 1) / threadsUsed;
+            std::memcpy(catalog.names.data() + begin, names + begin * sizeof(Catalog::Name), (end - begin) * sizeof(Catalog::Name));
+            std::memcpy(catalog.absoluteMagnitude.data() + begin, magnitudes + begin * sizeof(float), (end - begin) * sizeof(float));
+            for (int c = 0; c < KeplerPropagator::kColumns; ++c)
+                std::memcpy(catalog.orbits.column(c) + begin, columns + (c * count + begin) * sizeof(double), (end - begin) * sizeof(double));
+        });
+        stats.bytes = image.size();
+        stats.threads = threadsUsed;
+        stats.fromImage = true;
+        return true;
+    }
+
+    /** @brief Writes the image next to its final path and renames it there, so a reader never sees half of one. */
+    bool writeImage(const std::string &imagePath, const ImageHeader &header, const Catalog &catalog)
+    {
+        PROFILE_ZONE("writeImage");
+        std::size_t count = catalog.size();
+        std::string temporaryPath = imagePath + ".tmp";
+        {
+            std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+            if (!file)
+                return false;
+            file.write((const char *)&header, sizeof(header));
+            file.write((const char *)catalog.names.data(), (std::streamsize)(count * sizeof(Catalog::Name)));
+            file.write((const char *)catalog.absoluteMagnitude.data(), (std::streamsize)(count * sizeof(float)));
+            const char padding[8] = {};
+            file.write(padding, (std::streamsize)(((count * sizeof(float) + 7) & ~(std::size_t)7) - count * sizeof(float)));
+            for (int c = 0; c < KeplerPropagator::kColumns; ++c)
+                file.write((const char *)catalog.orbits.column(c), (std::streamsize)(count * sizeof(double)));
+            if (!file)
+            {
+                file.close();
+                std::remove(temporaryPath.c_str());
+                return false;
+            }
+        }
+        std::remove(imagePath.c_str()); // rename() does not replace on Windows
+        return std::rename(temporaryPath.c_str(), imagePath.c_str()) == 0;
+    }
+
+    /** @brief Moves orbits [from, from + count) down to slot @p to of every array. */
+    void moveOrbits(Catalog &catalog, std::size_t from, std::size_t to, std::size_t count)
+    {
+        for (int c = 0; c < KeplerPropagator::kColumns; ++c)
+            std::memmove(catalog.orbits.column(c) + to, catalog.orbits.column(c) + from, count * sizeof(double));
+        std::memmove(catalog.names.data() + to, catalog.names.data() + from, count * sizeof(Catalog::Name));
+        std::memmove(catalog.absoluteMagnitude.data() + to, catalog.absoluteMagnitude.data() + from, count * sizeof(float));
+    }
+}
+
+bool loadCatalog(const std::string &path, Catalog &catalog, const CatalogSettings &settings, CatalogLoadStats *statsOut)
+{
+    PROFILE_ZONE("loadCatalog");
+    auto start = std::chrono::steady_clock::now();
+    CatalogLoadStats stats;
+    catalog.orbits.clear();
+    catalog.names.clear();
+    catalog.absoluteMagnitude.clear();
+
+    CatalogFormat format = resolveFormat(path, settings.format);
+    std::string imagePath = settings.imagePath.empty() ? path + ".bin" : settings.imagePath;
+    std::uint64_t sourceSize = 0;
+    std::int64_t sourceTime = 0;
+    if (!sourceIdentity(path, sourceSize, sourceTime))
+    {
+        std::cerr << "ERROR::CATALOG: could not open '" << path << "'" << std::endl;
+        return false;
+    }
+    ImageHeader header = makeHeader(0, sourceSize, sourceTime, format, settings);
+    if (settings.useImage && readImage(imagePath, header, catalog, settings.threads, stats))
+    {
+        stats.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (statsOut)
+            *statsOut = stats;
+        return true;
+    }
+
+    MappedFile file(path);
+    if (!file.isOpen())
+    {
+        std::cerr << "ERROR::CATALOG: could not map '" << path << "'" << std::endl;
+        return false;
+    }
+    const char *begin = file.data(), *end = file.data() + file.size();
+
+    // The header: MPCORB's ends with a line of dashes, a CSV's is its first line.
+    CsvLayout layout;
+    std::size_t headerLines = 0;
+    if (format == CatalogFormat::Mpcorb)
+    {
+        const char *search = begin;
+        const char *limit = begin + std::min<std::size_t>(file.size(), 1 << 16);
+        for (std::size_t line = 1; search < limit; ++line)
+        {
+            const char *newline = (const char *)std::memchr(search, '\n', (std::size_t)(end - search));
+            if (end - search >= 5 && std::memcmp(search, "-----", 5) == 0)
+            {
+                headerLines = line;
+                begin = newline ? newline + 1 : end;
+                break;
+            }
+            search = newline ? newline + 1 : end;
+        }
+    }
+    else
+    {
+        const char *newline = begin < end ? (const char *)std::memchr(begin, '\n', (std::size_t)(end - begin)) : nullptr;
+        const char *headerEnd = newline ? newline : end;
+        std::size_t length = (std::size_t)(headerEnd - begin);
+        if (length > 0 && begin[length - 1] == '\r')
+            --length;
+        if (!parseCsvHeader(begin, length, layout))
+        {
+            std::cerr << "ERROR::CATALOG: '" << path << "' has no CSV header naming a, e, i, om, w, ma and epoch" << std::endl;
+            return false;
+        }
+        headerLines = 1;
+        begin = newline ? newline + 1 : end;
+    }
+
+    auto looksLikeOrbit = [format](const char *line, std::size_t length)
+    {
+        return format == CatalogFormat::Mpcorb ? length >= kMpcorbMinLength : !isBlank(line, length);
+    };
+    unsigned int threads = Parallel::threadCount(settings.threads, (std::size_t)(end - begin), kMinBytesPerThread);
+    std::vector<Chunk> chunks = splitLines(begin, end, threads);
+    threads = (unsigned int)chunks.size();
+
+    // Pass 1: which lines look like orbits, so every chunk knows its first slot.
+    {
+        PROFILE_ZONE("Count orbit lines");
+        Parallel::parallelFor(threads, [&](unsigned int t)
+        {
+            Chunk &chunk = chunks[t];
+            forEachLine(chunk.begin, chunk.end, [&](const char *line, std::size_t length)
+            {
+                ++chunk.lines;
+                if (looksLikeOrbit(line, length))
+                    ++chunk.candidates;
+            });
+        });
+    }
+    std::size_t total = 0;
+    for (Chunk &chunk : chunks)
+    {
+        chunk.first = total;
+        total += chunk.candidates;
+    }
+    catalog.orbits.resize(total);
+    catalog.names.resize(total);
+    catalog.absoluteMagnitude.resize(total);
+
+    // Pass 2: parse straight into the slots.
+    {
+        PROFILE_ZONE("Parse orbit lines");
+        Parallel::parallelFor(threads, [&](unsigned int t)
+        {
+            Chunk &chunk = chunks[t];
+            forEachLine(chunk.begin, chunk.end, [&](const char *line, std::size_t length)
+            {
+                if (!looksLikeOrbit(line, length))
+                    return;
+                RawOrbit raw;
+                float magnitude;
+                std::size_t slot = chunk.first + chunk.parsed;
+                bool parsed = format == CatalogFormat::Mpcorb
+                                  ? parseMpcorb(line, length, raw, magnitude)
+                                  : parseCsv(line, length, layout, raw, magnitude, catalog.names[slot]);
+                OrbitalElements elements;
+                if (!parsed || !toScene(raw, settings, elements))
+                    return;
+                if (format == CatalogFormat::Mpcorb)
+                    copyName(line, line + 7, catalog.names[slot]);
+                catalog.orbits.set(slot, elements);
+                catalog.absoluteMagnitude[slot] = magnitude;
+                ++chunk.parsed;
+            });
+        });
+    }
+
+    // Lines that looked like orbits but were not leave gaps at chunk ends.
+    std::size_t count = 0;
+    stats.lines = headerLines;
+    for (const Chunk &chunk : chunks)
+    {
+        if (chunk.first != count)
+            moveOrbits(catalog, chunk.first, count, chunk.parsed);
+        count += chunk.parsed;
+        stats.lines += chunk.lines;
+    }
+    catalog.orbits.resize(count);
+    catalog.names.resize(count);
+    catalog.absoluteMagnitude.resize(count);
+    stats.skipped = stats.lines - count;
+    stats.bytes = file.size();
+    stats.threads = threads;
+
+    if (settings.useImage)
+    {
+        stats.wroteImage = writeImage(imagePath, makeHeader(count, sourceSize, sourceTime, format, settings), catalog);
+        if (!stats.wroteImage)
+            std::cerr << "Warning: could not write the catalog image '" << imagePath << "'" << std::endl;
+    }
+    stats.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (statsOut)
+        *statsOut = stats;
+    return true;
+}
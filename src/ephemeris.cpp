@@ -0,0 +1,596 @@
+#include "../include/ephemeris.h"
+#include "../include/profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define EPHEMERIS_X86_KERNELS 1
+#endif
+
+namespace
+{
+    // Offsets into the header record (asc2eph's record 1).
+    const std::size_t kTitleBytes = 3 * 84;
+    const std::size_t kNamesOffset = kTitleBytes;           // 400 names of 6 characters
+    const std::size_t kRangeOffset = kNamesOffset + 400 * 6; // start, end and record days
+    const std::size_t kConstantCountOffset = kRangeOffset + 3 * 8;
+    const std::size_t kAuOffset = kConstantCountOffset + 4;
+    const std::size_t kEmratOffset = kAuOffset + 8;
+    const std::size_t kPointerOffset = kEmratOffset + 8;    // 12 series of (offset, coefficients, granules)
+    const std::size_t kNumberOffset = kPointerOffset + 12 * 3 * 4;
+    const std::size_t kLibrationOffset = kNumberOffset + 4;
+    const std::size_t kExtraNamesOffset = kLibrationOffset + 3 * 4; // names past the 400th, then two more series
+
+    // Obliquity of the J2000 ecliptic (84381.448 arcseconds), which the DE
+    // ephemerides' ICRF axes are rotated by to get ecliptic ones.
+    const double kObliquity = 84381.448 / 3600.0 * 3.14159265358979323846 / 180.0;
+
+    std::uint32_t swap32(std::uint32_t v)
+    {
+        return (v >> 24) | ((v >> 8) & 0xff00u) | ((v << 8) & 0xff0000u) | (v << 24);
+    }
+
+    std::uint64_t swap64(std::uint64_t v)
+    {
+        return ((std::uint64_t)swap32((std::uint32_t)v) << 32) | swap32((std::uint32_t)(v >> 32));
+    }
+
+    int readInt(const char *bytes, std::size_t offset, bool swap)
+    {
+        std::uint32_t v;
+        std::memcpy(&v, bytes + offset, 4);
+        v = swap ? swap32(v) : v;
+        std::int32_t result;
+        std::memcpy(&result, &v, 4);
+        return result;
+    }
+
+    double readDouble(const char *bytes, std::size_t offset, bool swap)
+    {
+        std::uint64_t v;
+        std::memcpy(&v, bytes + offset, 8);
+        v = swap ? swap64(v) : v;
+        double result;
+        std::memcpy(&result, &v, 8);
+        return result;
+    }
+
+    std::string readName(const char *bytes, std::size_t offset)
+    {
+        std::string name(bytes + offset, 6);
+        name.erase(name.find_last_not_of(' ') + 1);
+        return name;
+    }
+
+    /** @brief Where a sample() run writes: positions and (optionally) velocities. */
+    struct Outputs
+    {
+        double *x, *y, *z, *vx, *vy, *vz;
+    };
+
+    using RunKernel = void (*)(const double *, int, double, double, const double *, std::size_t, const Outputs &);
+
+    /** @brief sum(c[k] * v[k]) in four independent partial sums, which the compiler can keep in vector registers. */
+    double dot(const double *c, const double *v, int n)
+    {
+        double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+        int k = 0;
+        for (; k + 4 <= n; k += 4)
+        {
+            s0 += c[k] * v[k];
+            s1 += c[k + 1] * v[k + 1];
+            s2 += c[k + 2] * v[k + 2];
+            s3 += c[k + 3] * v[k + 3];
+        }
+        for (; k < n; ++k)
+            s0 += c[k] * v[k];
+        return (s0 + s1) + (s2 + s3);
+    }
+
+    /** @brief T_k(tc) and, if @p d is given, T_k'(tc) for k < n. */
+    void chebyshevBasis(double tc, int n, double *t, double *d)
+    {
+        t[0] = 1.0;
+        t[1] = tc;
+        for (int k = 2; k < n; ++k)
+            t[k] = 2.0 * tc * t[k - 1] - t[k - 2];
+        if (!d)
+            return;
+        d[0] = 0.0;
+        d[1] = 1.0;
+        for (int k = 2; k < n; ++k)
+            d[k] = 2.0 * t[k - 1] + 2.0 * tc * d[k - 1] - d[k - 2];
+    }
+
+    /** @brief One epoch of a three-component series: @p c holds n x, n y and n z coefficients. */
+    void evaluateSeries(const double *c, int n, const double *t, const double *d, double rate, glm::dvec3 &position, glm::dvec3 *velocity)
+    {
+        position = glm::dvec3(dot(c, t, n), dot(c + n, t, n), dot(c + 2 * n, t, n));
+        if (velocity)
+            *velocity = glm::dvec3(dot(c, d, n), dot(c + n, d, n), dot(c + 2 * n, d, n)) * rate;
+    }
+
+    void scalarRun(const double *c, int n, double granuleStart, double granuleDays, const double *jd, std::size_t count, const Outputs &out)
+    {
+        double t[Ephemeris::kMaxCoefficients], d[Ephemeris::kMaxCoefficients];
+        double toUnit = 2.0 / granuleDays;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            chebyshevBasis((jd[i] - granuleStart) * toUnit - 1.0, n, t, out.vx ? d : nullptr);
+            glm::dvec3 position, velocity;
+            evaluateSeries(c, n, t, d, toUnit, position, out.vx ? &velocity : nullptr);
+            out.x[i] = position.x;
+            out.y[i] = position.y;
+            out.z[i] = position.z;
+            if (out.vx)
+            {
+                out.vx[i] = velocity.x;
+                out.vy[i] = velocity.y;
+                out.vz[i] = velocity.z;
+            }
+        }
+    }
+
+#ifdef EPHEMERIS_X86_KERNELS
+    // Epochs of one granule: every lane is an epoch, every coefficient a
+    // broadcast. The basis is built once per lane group and shared by x, y, z.
+    __attribute__((target("avx2,fma")))
+    void avx2Run(const double *c, int n, double granuleStart, double granuleDays, const double *jd, std::size_t count, const Outputs &out)
+    {
+        __m256d t[Ephemeris::kMaxCoefficients], d[Ephemeris::kMaxCoefficients];
+        const __m256d start = _mm256_set1_pd(granuleStart);
+        const __m256d toUnit = _mm256_set1_pd(2.0 / granuleDays);
+        const __m256d one = _mm256_set1_pd(1.0);
+        std::size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m256d tc = _mm256_fmsub_pd(_mm256_sub_pd(_mm256_loadu_pd(jd + i), start), toUnit, one);
+            __m256d tc2 = _mm256_add_pd(tc, tc);
+            t[0] = one;
+            t[1] = tc;
+            for (int k = 2; k < n; ++k)
+                t[k] = _mm256_fmsub_pd(tc2, t[k - 1], t[k - 2]);
+            if (out.vx)
+            {
+                d[0] = _mm256_setzero_pd();
+                d[1] = one;
+                for (int k = 2; k < n; ++k)
+                    d[k] = _mm256_sub_pd(_mm256_fmadd_pd(tc2, d[k - 1], _mm256_add_pd(t[k - 1], t[k - 1])), d[k - 2]);
+            }
+            double *positions[3] = {out.x, out.y, out.z};
+            double *velocities[3] = {out.vx, out.vy, out.vz};
+            for (int component = 0; component < 3; ++component)
+            {
+                const double *coefficients = c + component * n;
+                __m256d p = _mm256_setzero_pd(), v = _mm256_setzero_pd();
+                for (int k = 0; k < n; ++k)
+                    p = _mm256_fmadd_pd(_mm256_set1_pd(coefficients[k]), t[k], p);
+                _mm256_storeu_pd(positions[component] + i, p);
+                if (out.vx)
+                {
+                    for (int k = 1; k < n; ++k)
+                        v = _mm256_fmadd_pd(_mm256_set1_pd(coefficients[k]), d[k], v);
+                    _mm256_storeu_pd(velocities[component] + i, _mm256_mul_pd(v, toUnit));
+                }
+            }
+        }
+        Outputs rest = {out.x + i, out.y + i, out.z + i, out.vx ? out.vx + i : nullptr, out.vy ? out.vy + i : nullptr, out.vz ? out.vz + i : nullptr};
+        scalarRun(c, n, granuleStart, granuleDays, jd + i, count - i, rest);
+    }
+
+    __attribute__((target("avx512f")))
+    void avx512Run(const double *c, int n, double granuleStart, double granuleDays, const double *jd, std::size_t count, const Outputs &out)
+    {
+        __m512d t[Ephemeris::kMaxCoefficients], d[Ephemeris::kMaxCoefficients];
+        const __m512d start = _mm512_set1_pd(granuleStart);
+        const __m512d toUnit = _mm512_set1_pd(2.0 / granuleDays);
+        const __m512d one = _mm512_set1_pd(1.0);
+        std::size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            __m512d tc = _mm512_fmsub_pd(_mm512_sub_pd(_mm512_loadu_pd(jd + i), start), toUnit, one);
+            __m512d tc2 = _mm512_add_pd(tc, tc);
+            t[0] = one;
+            t[1] = tc;
+            for (int k = 2; k < n; ++k)
+                t[k] = _mm512_fmsub_pd(tc2, t[k - 1], t[k - 2]);
+            if (out.vx)
+            {
+                d[0] = _mm512_setzero_pd();
+                d[1] = one;
+                for (int k = 2; k < n; ++k)
+                    d[k] = _mm512_sub_pd(_mm512_fmadd_pd(tc2, d[k - 1], _mm512_add_pd(t[k - 1], t[k - 1])), d[k - 2]);
+            }
+            double *positions[3] = {out.x, out.y, out.z};
+            double *velocities[3] = {out.vx, out.vy, out.vz};
+            for (int component = 0; component < 3; ++component)
+            {
+                const double *coefficients = c + component * n;
+                __m512d p = _mm512_setzero_pd(), v = _mm512_setzero_pd();
+                for (int k = 0; k < n; ++k)
+                    p = _mm512_fmadd_pd(_mm512_set1_pd(coefficients[k]), t[k], p);
+                _mm512_storeu_pd(positions[component] + i, p);
+                if (out.vx)
+                {
+                    for (int k = 1; k < n; ++k)
+                        v = _mm512_fmadd_pd(_mm512_set1_pd(coefficients[k]), d[k], v);
+                    _mm512_storeu_pd(velocities[component] + i, _mm512_mul_pd(v, toUnit));
+                }
+            }
+        }
+        Outputs rest = {out.x + i, out.y + i, out.z + i, out.vx ? out.vx + i : nullptr, out.vy ? out.vy + i : nullptr, out.vz ? out.vz + i : nullptr};
+        avx2Run(c, n, granuleStart, granuleDays, jd + i, count - i, rest);
+    }
+#endif
+
+    RunKernel selectKernel(NBodyKernel kernel)
+    {
+#ifdef EPHEMERIS_X86_KERNELS
+        if (kernel == NBodyKernel::Avx512)
+            return avx512Run;
+        if (kernel == NBodyKernel::Avx2)
+            return avx2Run;
+#endif
+        return scalarRun;
+    }
+
+    const char *const kBodyNames[kEphemerisBodies] = {"Mercury", "Venus", nullptr, "Mars", "Jupiter", "Saturn",
+                                                      "Uranus", "Neptune", "Pluto", "Moon", "Sun", "Earth"};
+}
+
+Ephemeris::Ephemeris(const std::string &path, NBodyKernel kernel)
+    : file(new MappedFile(path))
+{
+    PROFILE_ZONE("Ephemeris::Ephemeris");
+    activeKernel = resolveGravityKernel(kernel);
+    const char *bytes = file->data();
+    if (!file->isOpen() || file->size() < kExtraNamesOffset + 6 * 4)
+    {
+        std::cerr << "ERROR::EPHEMERIS: could not read '" << path << "'" << std::endl;
+        return;
+    }
+
+    // The byte order is whichever gives a sensible constant count and record length.
+    bool swap = false;
+    for (int attempt = 0; attempt < 2; ++attempt, swap = true)
+    {
+        int constants = readInt(bytes, kConstantCountOffset, swap);
+        double days = readDouble(bytes, kRangeOffset + 16, swap);
+        if (constants > 0 && constants < 10000 && days > 0.0 && days < 100000.0)
+            break;
+        if (attempt == 1)
+        {
+            std::cerr << "ERROR::EPHEMERIS: '" << path << "' is not a binary JPL DE file" << std::endl;
+            return;
+        }
+    }
+    start = readDouble(bytes, kRangeOffset, swap);
+    end = readDouble(bytes, kRangeOffset + 8, swap);
+    span = readDouble(bytes, kRangeOffset + 16, swap);
+    int constantCount = readInt(bytes, kConstantCountOffset, swap);
+    auKm = readDouble(bytes, kAuOffset, swap);
+    emrat = readDouble(bytes, kEmratOffset, swap);
+    deNumber = readInt(bytes, kNumberOffset, swap);
+
+    // Record length in doubles: the end of the last series. Nutations have two
+    // components, TT-TDB one, everything else three. DE430 and later add the
+    // lunar mantle and TT-TDB series after the names past the 400th; older
+    // files have zeros there.
+    int pointers[15][3] = {};
+    for (int i = 0; i < 12; ++i)
+        for (int k = 0; k < 3; ++k)
+            pointers[i][k] = readInt(bytes, kPointerOffset + (i * 3 + k) * 4, swap);
+    for (int k = 0; k < 3; ++k)
+        pointers[12][k] = readInt(bytes, kLibrationOffset + k * 4, swap);
+    std::size_t extraOffset = kExtraNamesOffset + (std::size_t)std::max(constantCount - 400, 0) * 6;
+    if (extraOffset + 6 * 4 <= file->size())
+        for (int i = 13; i < 15; ++i)
+            for (int k = 0; k < 3; ++k)
+                pointers[i][k] = readInt(bytes, extraOffset + ((i - 13) * 3 + k) * 4, swap);
+    const int components[15] = {3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 2, 3, 3, 1};
+    for (int candidate = 15; candidate >= 13 && !recordDoubles; candidate -= 2)
+    {
+        std::size_t doubles = 0;
+        for (int i = 0; i < candidate; ++i)
+            if (pointers[i][0] > 0 && pointers[i][1] > 0 && pointers[i][1] <= 64 && pointers[i][2] > 0 && pointers[i][2] <= 64)
+                doubles = std::max(doubles, (std::size_t)(pointers[i][0] - 1 + components[i] * pointers[i][1] * pointers[i][2]));
+        // The first coefficient record must start at the file's first epoch.
+        if (doubles >= 2 && file->size() >= 3 * doubles * 8 && readDouble(bytes, 2 * doubles * 8, swap) == start)
+            recordDoubles = doubles;
+    }
+    if (!recordDoubles || constantCount > (int)recordDoubles)
+    {
+        std::cerr << "ERROR::EPHEMERIS: unrecognized record layout in '" << path << "'" << std::endl;
+        return;
+    }
+    for (int i = 0; i < kEphemerisBodies - 1; ++i)
+    {
+        series[i].offset = pointers[i][0];
+        series[i].coefficients = pointers[i][1];
+        series[i].granules = pointers[i][2];
+        if (series[i].coefficients > kMaxCoefficients || (series[i].coefficients > 0 && series[i].coefficients < 2))
+        {
+            std::cerr << "ERROR::EPHEMERIS: unsupported series of " << series[i].coefficients << " coefficients in '" << path << "'" << std::endl;
+            recordDoubles = 0;
+            return;
+        }
+    }
+
+    // Constant names are in the header, their values in record 1.
+    for (int i = 0; i < constantCount; ++i)
+    {
+        std::size_t offset = i < 400 ? kNamesOffset + (std::size_t)i * 6 : kExtraNamesOffset + (std::size_t)(i - 400) * 6;
+        constantNames.push_back(readName(bytes, offset));
+        constantValues.push_back(readDouble(bytes, (recordDoubles + i) * 8, swap));
+    }
+
+    std::size_t totalRecords = file->size() / (recordDoubles * 8);
+    if (swap)
+    {
+        swapped.resize(totalRecords * recordDoubles);
+        for (std::size_t k = 0; k < swapped.size(); ++k)
+            swapped[k] = readDouble(bytes, k * 8, true);
+        data = swapped.data();
+        file.reset();
+    }
+    else
+        data = (const double *)bytes;
+    records = totalRecords - 2;
+}
+
+Ephemeris::~Ephemeris() = default;
+
+bool Ephemeris::has(EphemerisBody body) const
+{
+    if (body == EphemerisBody::Earth)
+        return has(EphemerisBody::EarthMoon) && has(EphemerisBody::Moon);
+    int index = (int)body;
+    return isOpen() && index >= 0 && index < kEphemerisBodies - 1 && series[index].coefficients > 0 && series[index].granules > 0;
+}
+
+double Ephemeris::constant(const char *name, double fallback) const
+{
+    for (std::size_t i = 0; i < constantNames.size(); ++i)
+        if (constantNames[i] == name)
+            return constantValues[i];
+    return fallback;
+}
+
+const double *Ephemeris::locate(int body, double jd, double &granuleStart, double &granuleDays) const
+{
+    if (!(jd >= start && jd <= end))
+        return nullptr;
+    std::size_t record = std::min((std::size_t)((jd - start) / span), records - 1);
+    const double *coefficients = data + (2 + record) * recordDoubles;
+    const Series &s = series[body];
+    granuleDays = span / s.granules;
+    // The record's own start, not start + record * span, so the granule
+    // boundaries are exactly the ones the coefficients were fitted on.
+    int granule = std::max(0, std::min((int)((jd - coefficients[0]) / granuleDays), s.granules - 1));
+    granuleStart = coefficients[0] + granule * granuleDays;
+    return coefficients + (s.offset - 1) + (std::size_t)granule * 3 * s.coefficients;
+}
+
+bool Ephemeris::state(EphemerisBody body, double jd, glm::dvec3 &position, glm::dvec3 *velocity) const
+{
+    if (!has(body))
+        return false;
+    if (body == EphemerisBody::Earth)
+    {
+        glm::dvec3 moon, moonVelocity;
+        if (!state(EphemerisBody::EarthMoon, jd, position, velocity) || !state(EphemerisBody::Moon, jd, moon, velocity ? &moonVelocity : nullptr))
+            return false;
+        position -= moon / (1.0 + emrat);
+        if (velocity)
+            *velocity -= moonVelocity / (1.0 + emrat);
+        return true;
+    }
+    double granuleStart, granuleDays;
+    const double *c = locate((int)body, jd, granuleStart, granuleDays);
+    if (!c)
+        return false;
+    int n = series[(int)body].coefficients;
+    double t[kMaxCoefficients], d[kMaxCoefficients];
+    double toUnit = 2.0 / granuleDays;
+    chebyshevBasis((jd - granuleStart) * toUnit - 1.0, n, t, velocity ? d : nullptr);
+    evaluateSeries(c, n, t, d, toUnit, position, velocity);
+    return true;
+}
+
+bool Ephemeris::evaluate(double jd, glm::dvec3 *positions, glm::dvec3 *velocities) const
+{
+    PROFILE_ZONE("Ephemeris::evaluate");
+    if (!isOpen() || !(jd >= start && jd <= end))
+        return false;
+    // Series with the same granule length share the Chebyshev argument, so the
+    // basis is rebuilt only when it changes (DE440: four lengths for eleven bodies).
+    double t[kMaxCoefficients], d[kMaxCoefficients];
+    double basisStart = std::numeric_limits<double>::quiet_NaN(), basisDays = 0.0;
+    int basisLength = 0;
+    for (int body = 0; body < kEphemerisBodies - 1; ++body)
+    {
+        positions[body] = glm::dvec3(0.0);
+        if (velocities)
+            velocities[body] = glm::dvec3(0.0);
+        if (!has((EphemerisBody)body))
+            continue;
+        double granuleStart, granuleDays;
+        const double *c = locate(body, jd, granuleStart, granuleDays);
+        int n = series[body].coefficients;
+        if (granuleStart != basisStart || granuleDays != basisDays || n > basisLength)
+        {
+            chebyshevBasis((jd - granuleStart) * (2.0 / granuleDays) - 1.0, n, t, velocities ? d : nullptr);
+            basisStart = granuleStart;
+            basisDays = granuleDays;
+            basisLength = n;
+        }
+        evaluateSeries(c, n, t, d, 2.0 / granuleDays, positions[body], velocities ? &velocities[body] : nullptr);
+    }
+    const int earth = (int)EphemerisBody::Earth, moon = (int)EphemerisBody::Moon, earthMoon = (int)EphemerisBody::EarthMoon;
+    positions[earth] = positions[earthMoon] - positions[moon] / (1.0 + emrat);
+    if (velocities)
+        velocities[earth] = velocities[earthMoon] - velocities[moon] / (1.0 + emrat);
+    return true;
+}
+
+std::size_t Ephemeris::sampleSeries(int body, const double *jd, std::size_t count, double *x, double *y, double *z,
+                                    double *vx, double *vy, double *vz) const
+{
+    RunKernel run = selectKernel(activeKernel);
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    int n = series[body].coefficients;
+    std::size_t inRange = 0;
+    std::size_t i = 0;
+    double granuleStart = 0.0, granuleDays = 0.0;
+    const double *c = count ? locate(body, jd[0], granuleStart, granuleDays) : nullptr;
+    while (i < count)
+    {
+        if (!c)
+        {
+            x[i] = y[i] = z[i] = nan;
+            if (vx)
+                vx[i] = vy[i] = vz[i] = nan;
+            ++i;
+            if (i < count)
+                c = locate(body, jd[i], granuleStart, granuleDays);
+            continue;
+        }
+        // The run of epochs in this granule.
+        std::size_t j = i + 1;
+        double nextStart = 0.0, nextDays = 0.0;
+        const double *next = nullptr;
+        for (; j < count; ++j)
+        {
+            next = locate(body, jd[j], nextStart, nextDays);
+            if (next != c)
+                break;
+        }
+        // Lone epochs (unsorted input) are cheaper without the vector setup.
+        Outputs out = {x + i, y + i, z + i, vx ? vx + i : nullptr, vy ? vy + i : nullptr, vz ? vz + i : nullptr};
+        (j - i < 4 ? scalarRun : run)(c, n, granuleStart, granuleDays, jd + i, j - i, out);
+        inRange += j - i;
+        i = j;
+        c = next;
+        granuleStart = nextStart;
+        granuleDays = nextDays;
+    }
+    return inRange;
+}
+
+std::size_t Ephemeris::sample(EphemerisBody body, const double *jd, std::size_t count, double *x, double *y, double *z,
+                              double *vx, double *vy, double *vz) const
+{
+    PROFILE_ZONE("Ephemeris::sample");
+    if (!(vx && vy && vz))
+        vx = vy = vz = nullptr;
+    if (!has(body))
+    {
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            x[i] = y[i] = z[i] = nan;
+            if (vx)
+                vx[i] = vy[i] = vz[i] = nan;
+        }
+        return 0;
+    }
+    if (body != EphemerisBody::Earth)
+        return sampleSeries((int)body, jd, count, x, y, z, vx, vy, vz);
+
+    // The Earth is the barycentre less the Moon's share, a block at a time.
+    const std::size_t kBlock = 256;
+    double moon[6][kBlock];
+    double scale = 1.0 / (1.0 + emrat);
+    std::size_t inRange = 0;
+    for (std::size_t first = 0; first < count; first += kBlock)
+    {
+        std::size_t block = std::min(kBlock, count - first);
+        inRange += sampleSeries((int)EphemerisBody::EarthMoon, jd + first, block, x + first, y + first, z + first,
+                                vx ? vx + first : nullptr, vy ? vy + first : nullptr, vz ? vz + first : nullptr);
+        sampleSeries((int)EphemerisBody::Moon, jd + first, block, moon[0], moon[1], moon[2],
+                     vx ? moon[3] : nullptr, vx ? moon[4] : nullptr, vx ? moon[5] : nullptr);
+        for (std::size_t i = 0; i < block; ++i)
+        {
+            x[first + i] -= moon[0][i] * scale;
+            y[first + i] -= moon[1][i] * scale;
+            z[first + i] -= moon[2][i] * scale;
+            if (vx)
+            {
+                vx[first + i] -= moon[3][i] * scale;
+                vy[first + i] -= moon[4][i] * scale;
+                vz[first + i] -= moon[5][i] * scale;
+            }
+        }
+    }
+    return inRange;
+}
+
+glm::dvec3 ephemerisToScene(const glm::dvec3 &icrf)
+{
+    double c = std::cos(kObliquity), s = std::sin(kObliquity);
+    glm::dvec3 ecliptic(icrf.x, c * icrf.y + s * icrf.z, -s * icrf.y + c * icrf.z);
+    return glm::dvec3(ecliptic.x, ecliptic.z, ecliptic.y);
+}
+
+EphemerisBodies::EphemerisBodies(const Ephemeris &ephemeris, const std::vector<std::string> &names, const BodyState &state,
+                                 const EphemerisSceneSettings &settings)
+    : ephemeris(ephemeris), settings(settings)
+{
+    bodies.assign(state.size(), -1);
+    reference.assign(state.size(), -1);
+    shift.assign(state.size(), glm::vec3(0.0f));
+    for (std::size_t i = 0; i < state.size() && i < names.size(); ++i)
+        for (int body = 0; body < kEphemerisBodies; ++body)
+            if (kBodyNames[body] && names[i] == kBodyNames[body] && ephemeris.has((EphemerisBody)body))
+            {
+                bodies[i] = body;
+                ++mappedCount;
+            }
+    const int sun = ephemeris.has(EphemerisBody::Sun) ? (int)EphemerisBody::Sun : -1;
+    for (std::size_t i = 0; i < state.size(); ++i)
+    {
+        int parent = state.parent[i];
+        reference[i] = parent >= 0 && bodies[parent] >= 0 ? bodies[parent] : sun;
+    }
+}
+
+bool EphemerisBodies::apply(BodyState &state, float t)
+{
+    PROFILE_ZONE("EphemerisBodies::apply");
+    glm::dvec3 positions[kEphemerisBodies];
+    double jd = settings.epochJd + (double)t / settings.secondsPerDay;
+    if (!mappedCount || !ephemeris.evaluate(jd, positions))
+        return false;
+    // Barycentric like the others, so any pair can be subtracted.
+    positions[(int)EphemerisBody::Moon] += positions[(int)EphemerisBody::Earth];
+
+    double toScene = settings.unitsPerAu / ephemeris.au();
+    const int sun = (int)EphemerisBody::Sun;
+    for (std::size_t i = 0; i < state.size(); ++i)
+    {
+        // Slots are in parent-first order, so the parent has already moved.
+        int parent = state.parent[i];
+        glm::vec3 old = state.position(i);
+        glm::vec3 moved;
+        if (bodies[i] >= 0)
+        {
+            glm::dvec3 offset = positions[bodies[i]] - (reference[i] >= 0 ? positions[reference[i]] : glm::dvec3(0.0));
+            double scale = reference[i] < 0 || reference[i] == sun ? toScene : toScene * settings.satelliteScale;
+            moved = (parent >= 0 ? state.position(parent) : glm::vec3(0.0f)) + glm::vec3(ephemerisToScene(offset) * scale);
+        }
+        else
+            moved = old + (parent >= 0 ? shift[parent] : glm::vec3(0.0f));
+        shift[i] = moved - old;
+        state.positionX[i] = moved.x;
+        state.positionY[i] = moved.y;
+        state.positionZ[i] = moved.z;
+    }
+    updateBodyModels(state, t);
+    return true;
+}
@@ -0,0 +1,78 @@
+#include "../include/frame_stats.h"
+
+#include <algorithm>
+#include <cmath>
+
+void FrameStats::record(const std::string &name, double value)
+{
+    for (auto &entry : series)
+    {
+        if (entry.first == name)
+        {
+            entry.second.push_back(value);
+            return;
+        }
+    }
+    series.emplace_back(name, std::vector<double>{value});
+}
+
+void FrameStats::clear()
+{
+    for (auto &entry : series)
+        entry.second.clear();
+}
+
+FrameStats::Summary FrameStats::summarize(const std::string &name) const
+{
+    Summary summary;
+    for (const auto &entry : series)
+    {
+        if (entry.first != name || entry.second.empty())
+            continue;
+
+        std::vector<double> sorted = entry.second;
+        std::sort(sorted.begin(), sorted.end());
+
+        // Nearest-rank percentile: the smallest sample with at least p% of samples <= it.
+        auto percentile = [&sorted](double p)
+        {
+            std::size_t rank = (std::size_t)std::ceil(p / 100.0 * sorted.size());
+            return sorted[std::min(std::max<std::size_t>(rank, 1), sorted.size()) - 1];
+        };
+
+        double sum = 0.0;
+        for (double v : sorted)
+            sum += v;
+
+        summary.count = sorted.size();
+        summary.mean = sum / sorted.size();
+        summary.p50 = percentile(50.0);
+        summary.p95 = percentile(95.0);
+        summary.p99 = percentile(99.0);
+        summary.max = sorted.back();
+        break;
+    }
+    return summary;
+}
+
+void FrameStats::writeJson(std::ostream &out) const
+{
+    out << "{";
+    bool first = true;
+    for (const auto &entry : series)
+    {
+        if (entry.second.empty())
+            continue;
+
+        Summary s = summarize(entry.first);
+        out << (first ? "" : ",") << "\n    \"" << entry.first << "\": {"
+            << "\"count\": " << s.count
+            << ", \"mean\": " << s.mean
+            << ", \"p50\": " << s.p50
+            << ", \"p95\": " << s.p95
+            << ", \"p99\": " << s.p99
+            << ", \"max\": " << s.max << "}";
+        first = false;
+    }
+    out << "\n  }";
+}
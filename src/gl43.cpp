@@ -0,0 +1,32 @@
+#include "../include/gl43.h"
+
+#ifndef GL_VERSION_4_3
+PFNGLDISPATCHCOMPUTEPROC glad_glDispatchCompute = nullptr;
+PFNGLMEMORYBARRIERPROC glad_glMemoryBarrier = nullptr;
+PFNGLMULTIDRAWELEMENTSINDIRECTPROC glad_glMultiDrawElementsIndirect = nullptr;
+#endif
+
+namespace
+{
+    bool available = false;
+}
+
+bool GL43::load(GLADloadproc load)
+{
+    available = false;
+    if (GLVersion.major < 4 || (GLVersion.major == 4 && GLVersion.minor < 3))
+        return false;
+
+#ifndef GL_VERSION_4_3
+    glad_glDispatchCompute = (PFNGLDISPATCHCOMPUTEPROC)load("glDispatchCompute");
+    glad_glMemoryBarrier = (PFNGLMEMORYBARRIERPROC)load("glMemoryBarrier");
+    glad_glMultiDrawElementsIndirect = (PFNGLMULTIDRAWELEMENTSINDIRECTPROC)load("glMultiDrawElementsIndirect");
+#endif
+    available = glad_glDispatchCompute && glad_glMemoryBarrier && glad_glMultiDrawElementsIndirect;
+    return available;
+}
+
+bool GL43::isAvailable()
+{
+    return available;
+}
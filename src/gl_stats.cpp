@@ -0,0 +1,735 @@
+#include "../include/gl_stats.h"
+#include "../include/gl43.h"
+
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    enum Category
+    {
+        DRAW,
+        STATE,
+        UNIFORM,
+        UPLOAD,
+        CREATE,
+        DESTROY,
+        QUERY,
+        LINK
+    };
+
+    // X(name, category) for every intercepted entry point.
+#define GL_STATS_FUNCTIONS(X)                 \
+    X(glDrawArrays, DRAW)                     \
+    X(glDrawElements, DRAW)                   \
+    X(glDrawRangeElements, DRAW)              \
+    X(glDrawArraysInstanced, DRAW)            \
+    X(glDrawElementsInstanced, DRAW)          \
+    X(glDrawElementsBaseVertex, DRAW)         \
+    X(glDrawElementsInstancedBaseVertex, DRAW)\
+    X(glMultiDrawArrays, DRAW)                \
+    X(glMultiDrawElements, DRAW)              \
+    X(glMultiDrawElementsIndirect, DRAW)      \
+    X(glUseProgram, STATE)                    \
+    X(glBindVertexArray, STATE)               \
+    X(glActiveTexture, STATE)                 \
+    X(glBindTexture, STATE)                   \
+    X(glBindBuffer, STATE)                    \
+    X(glBindBufferBase, STATE)                \
+    X(glBindFramebuffer, STATE)               \
+    X(glEnable, STATE)                        \
+    X(glDisable, STATE)                       \
+    X(glDepthFunc, STATE)                     \
+    X(glDepthMask, STATE)                     \
+    X(glBlendFunc, STATE)                     \
+    X(glClearColor, STATE)                    \
+    X(glViewport, STATE)                      \
+    X(glUniform1i, UNIFORM)                   \
+    X(glUniform1f, UNIFORM)                   \
+    X(glUniform2f, UNIFORM)                   \
+    X(glUniform3f, UNIFORM)                   \
+    X(glUniform4f, UNIFORM)                   \
+    X(glUniform1fv, UNIFORM)                  \
+    X(glUniform3fv, UNIFORM)                  \
+    X(glUniform4fv, UNIFORM)                  \
+    X(glUniformMatrix3fv, UNIFORM)            \
+    X(glUniformMatrix4fv, UNIFORM)            \
+    X(glGetUniformLocation, QUERY)            \
+    X(glBufferData, UPLOAD)                   \
+    X(glBufferSubData, UPLOAD)                \
+    X(glMapBufferRange, UPLOAD)               \
+    X(glTexImage2D, UPLOAD)                   \
+    X(glTexSubImage2D, UPLOAD)                \
+    X(glTexImage3D, UPLOAD)                   \
+    X(glTexSubImage3D, UPLOAD)                \
+    X(glGenBuffers, CREATE)                   \
+    X(glGenVertexArrays, CREATE)              \
+    X(glGenTextures, CREATE)                  \
+    X(glCreateProgram, CREATE)                \
+    X(glDeleteBuffers, DESTROY)               \
+    X(glDeleteVertexArrays, DESTROY)          \
+    X(glDeleteTextures, DESTROY)              \
+    X(glDeleteProgram, DESTROY)               \
+    X(glLinkProgram, LINK)
+
+    enum Function
+    {
+#define GL_STATS_ENUM(name, category) FN_##name,
+        GL_STATS_FUNCTIONS(GL_STATS_ENUM)
+#undef GL_STATS_ENUM
+        FN_COUNT
+    };
+
+    const char *const kFunctionNames[FN_COUNT] = {
+#define GL_STATS_NAME(name, category) #name,
+        GL_STATS_FUNCTIONS(GL_STATS_NAME)
+#undef GL_STATS_NAME
+    };
+
+    const Category kFunctionCategories[FN_COUNT] = {
+#define GL_STATS_CATEGORY(name, category) category,
+        GL_STATS_FUNCTIONS(GL_STATS_CATEGORY)
+#undef GL_STATS_CATEGORY
+    };
+
+    // Original driver entry points, saved by install().
+#define GL_STATS_REAL(name, category) decltype(glad_##name) real_##name = nullptr;
+    GL_STATS_FUNCTIONS(GL_STATS_REAL)
+#undef GL_STATS_REAL
+
+    struct Counters
+    {
+        std::uint64_t calls[FN_COUNT] = {};
+        std::uint64_t redundant[FN_COUNT] = {};
+        std::uint64_t inactiveUniforms = 0;
+        std::uint64_t bytesUploaded = 0;
+        std::uint64_t verticesSubmitted = 0;
+    };
+
+    bool installed = false;
+    Counters frame;
+    Counters total;
+
+    // --- Shadowed GL state used to detect redundant calls ---
+    const int kMaxTextureUnits = 32;
+    const int kTextureTargets = 4;   // 2D, cube map, 2D array, other
+
+    GLuint currentProgram = 0;
+    GLuint currentVAO = 0;
+    GLenum currentActiveTexture = GL_TEXTURE0;
+    GLuint boundTextures[kMaxTextureUnits][kTextureTargets] = {};
+    std::unordered_map<GLenum, GLuint> boundBuffers;
+    std::unordered_map<GLenum, bool> capabilities;
+    GLenum currentDepthFunc = GL_LESS;
+    GLboolean currentDepthMask = GL_TRUE;
+    GLenum currentBlendSrc = GL_ONE, currentBlendDst = GL_ZERO;
+    GLfloat currentClearColor[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    GLint currentViewport[4] = {-1, -1, -1, -1};
+    GLuint currentFramebuffer = 0;
+
+    // Last value uploaded to each (program, location).
+    std::unordered_map<std::uint64_t, std::vector<unsigned char>> uniformValues;
+
+    inline void count(Function fn)
+    {
+        ++frame.calls[fn];
+        ++total.calls[fn];
+    }
+
+    inline void countRedundant(Function fn)
+    {
+        ++frame.redundant[fn];
+        ++total.redundant[fn];
+    }
+
+    inline void countBytes(std::uint64_t bytes)
+    {
+        frame.bytesUploaded += bytes;
+        total.bytesUploaded += bytes;
+    }
+
+    inline void countVertices(std::uint64_t vertices)
+    {
+        frame.verticesSubmitted += vertices;
+        total.verticesSubmitted += vertices;
+    }
+
+    int textureTargetIndex(GLenum target)
+    {
+        switch (target)
+        {
+        case GL_TEXTURE_2D: return 0;
+        case GL_TEXTURE_CUBE_MAP: return 1;
+        case GL_TEXTURE_2D_ARRAY: return 2;
+        default: return 3;
+        }
+    }
+
+    std::uint64_t bytesPerPixel(GLenum format, GLenum type)
+    {
+        std::uint64_t components;
+        switch (format)
+        {
+        case GL_RED: case GL_RED_INTEGER: case GL_DEPTH_COMPONENT: components = 1; break;
+        case GL_RG: case GL_RG_INTEGER: case GL_DEPTH_STENCIL: components = 2; break;
+        case GL_RGB: case GL_BGR: case GL_RGB_INTEGER: components = 3; break;
+        default: components = 4; break;
+        }
+        switch (type)
+        {
+        case GL_UNSIGNED_BYTE: case GL_BYTE: return components;
+        case GL_UNSIGNED_SHORT: case GL_SHORT: case GL_HALF_FLOAT: return components * 2;
+        case GL_UNSIGNED_INT_24_8: return 4;
+        default: return components * 4;
+        }
+    }
+
+    // Records an upload of @p size bytes to the current program's @p location.
+    void trackUniform(Function fn, GLint location, const void *data, std::size_t size)
+    {
+        count(fn);
+        if (location < 0)
+        {
+            // Uniform optimized out or misspelled: the call does nothing at all.
+            ++frame.inactiveUniforms;
+            ++total.inactiveUniforms;
+            countRedundant(fn);
+            return;
+        }
+
+        std::uint64_t key = ((std::uint64_t)currentProgram << 32) | (std::uint32_t)location;
+        std::vector<unsigned char> &value = uniformValues[key];
+        if (value.size() == size && std::memcmp(value.data(), data, size) == 0)
+        {
+            countRedundant(fn);
+            return;
+        }
+        value.assign((const unsigned char *)data, (const unsigned char *)data + size);
+    }
+
+    void forgetProgramUniforms(GLuint program)
+    {
+        for (auto it = uniformValues.begin(); it != uniformValues.end();)
+        {
+            if ((GLuint)(it->first >> 32) == program)
+                it = uniformValues.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    // --- Draw calls ---
+    void APIENTRY hook_glDrawArrays(GLenum mode, GLint first, GLsizei n)
+    {
+        count(FN_glDrawArrays);
+        countVertices(n);
+        real_glDrawArrays(mode, first, n);
+    }
+
+    void APIENTRY hook_glDrawElements(GLenum mode, GLsizei n, GLenum type, const void *indices)
+    {
+        count(FN_glDrawElements);
+        countVertices(n);
+        real_glDrawElements(mode, n, type, indices);
+    }
+
+    void APIENTRY hook_glDrawRangeElements(GLenum mode, GLuint start, GLuint end, GLsizei n, GLenum type, const void *indices)
+    {
+        count(FN_glDrawRangeElements);
+        countVertices(n);
+        real_glDrawRangeElements(mode, start, end, n, type, indices);
+    }
+
+    void APIENTRY hook_glDrawArraysInstanced(GLenum mode, GLint first, GLsizei n, GLsizei instances)
+    {
+        count(FN_glDrawArraysInstanced);
+        countVertices((std::uint64_t)n * instances);
+        real_glDrawArraysInstanced(mode, first, n, instances);
+    }
+
+    void APIENTRY hook_glDrawElementsInstanced(GLenum mode, GLsizei n, GLenum type, const void *indices, GLsizei instances)
+    {
+        count(FN_glDrawElementsInstanced);
+        countVertices((std::uint64_t)n * instances);
+        real_glDrawElementsInstanced(mode, n, type, indices, instances);
+    }
+
+    void APIENTRY hook_glDrawElementsBaseVertex(GLenum mode, GLsizei n, GLenum type, const void *indices, GLint baseVertex)
+    {
+        count(FN_glDrawElementsBaseVertex);
+        countVertices(n);
+        real_glDrawElementsBaseVertex(mode, n, type, indices, baseVertex);
+    }
+
+    void APIENTRY hook_glDrawElementsInstancedBaseVertex(GLenum mode, GLsizei n, GLenum type, const void *indices, GLsizei instances, GLint baseVertex)
+    {
+        count(FN_glDrawElementsInstancedBaseVertex);
+        countVertices((std::uint64_t)n * instances);
+        real_glDrawElementsInstancedBaseVertex(mode, n, type, indices, instances, baseVertex);
+    }
+
+    void APIENTRY hook_glMultiDrawArrays(GLenum mode, const GLint *first, const GLsizei *n, GLsizei drawCount)
+    {
+        count(FN_glMultiDrawArrays);
+        for (GLsizei i = 0; i < drawCount; ++i)
+            countVertices(n[i]);
+        real_glMultiDrawArrays(mode, first, n, drawCount);
+    }
+
+    void APIENTRY hook_glMultiDrawElements(GLenum mode, const GLsizei *n, GLenum type, const void *const *indices, GLsizei drawCount)
+    {
+        count(FN_glMultiDrawElements);
+        for (GLsizei i = 0; i < drawCount; ++i)
+            countVertices(n[i]);
+        real_glMultiDrawElements(mode, n, type, indices, drawCount);
+    }
+
+    // The commands live in a GPU buffer, so neither their number nor their
+    // vertices are known here: this counts submissions only.
+    void APIENTRY hook_glMultiDrawElementsIndirect(GLenum mode, GLenum type, const void *indirect, GLsizei drawCount, GLsizei stride)
+    {
+        count(FN_glMultiDrawElementsIndirect);
+        real_glMultiDrawElementsIndirect(mode, type, indirect, drawCount, stride);
+    }
+
+    // --- State changes ---
+    void APIENTRY hook_glUseProgram(GLuint program)
+    {
+        count(FN_glUseProgram);
+        if (program == currentProgram)
+            countRedundant(FN_glUseProgram);
+        currentProgram = program;
+        real_glUseProgram(program);
+    }
+
+    void APIENTRY hook_glBindVertexArray(GLuint vao)
+    {
+        count(FN_glBindVertexArray);
+        if (vao == currentVAO)
+            countRedundant(FN_glBindVertexArray);
+        currentVAO = vao;
+        // The element buffer binding is part of the VAO.
+        boundBuffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+        real_glBindVertexArray(vao);
+    }
+
+    void APIENTRY hook_glActiveTexture(GLenum unit)
+    {
+        count(FN_glActiveTexture);
+        if (unit == currentActiveTexture)
+            countRedundant(FN_glActiveTexture);
+        currentActiveTexture = unit;
+        real_glActiveTexture(unit);
+    }
+
+    void APIENTRY hook_glBindTexture(GLenum target, GLuint texture)
+    {
+        count(FN_glBindTexture);
+        int unit = (int)(currentActiveTexture - GL_TEXTURE0);
+        if (unit >= 0 && unit < kMaxTextureUnits)
+        {
+            GLuint &bound = boundTextures[unit][textureTargetIndex(target)];
+            if (bound == texture)
+                countRedundant(FN_glBindTexture);
+            bound = texture;
+        }
+        real_glBindTexture(target, texture);
+    }
+
+    void APIENTRY hook_glBindBuffer(GLenum target, GLuint buffer)
+    {
+        count(FN_glBindBuffer);
+        auto it = boundBuffers.find(target);
+        if (it != boundBuffers.end() && it->second == buffer)
+            countRedundant(FN_glBindBuffer);
+        boundBuffers[target] = buffer;
+        real_glBindBuffer(target, buffer);
+    }
+
+    void APIENTRY hook_glBindBufferBase(GLenum target, GLuint index, GLuint buffer)
+    {
+        count(FN_glBindBufferBase);
+        // Also changes the generic binding point.
+        boundBuffers[target] = buffer;
+        real_glBindBufferBase(target, index, buffer);
+    }
+
+    void APIENTRY hook_glBindFramebuffer(GLenum target, GLuint framebuffer)
+    {
+        count(FN_glBindFramebuffer);
+        if (target == GL_FRAMEBUFFER && framebuffer == currentFramebuffer)
+            countRedundant(FN_glBindFramebuffer);
+        if (target == GL_FRAMEBUFFER)
+            currentFramebuffer = framebuffer;
+        real_glBindFramebuffer(target, framebuffer);
+    }
+
+    void APIENTRY hook_glEnable(GLenum cap)
+    {
+        count(FN_glEnable);
+        auto it = capabilities.find(cap);
+        if (it != capabilities.end() && it->second)
+            countRedundant(FN_glEnable);
+        capabilities[cap] = true;
+        real_glEnable(cap);
+    }
+
+    void APIENTRY hook_glDisable(GLenum cap)
+    {
+        count(FN_glDisable);
+        auto it = capabilities.find(cap);
+        if (it != capabilities.end() && !it->second)
+            countRedundant(FN_glDisable);
+        capabilities[cap] = false;
+        real_glDisable(cap);
+    }
+
+    void APIENTRY hook_glDepthFunc(GLenum func)
+    {
+        count(FN_glDepthFunc);
+        if (func == currentDepthFunc)
+            countRedundant(FN_glDepthFunc);
+        currentDepthFunc = func;
+        real_glDepthFunc(func);
+    }
+
+    void APIENTRY hook_glDepthMask(GLboolean flag)
+    {
+        count(FN_glDepthMask);
+        if (flag == currentDepthMask)
+            countRedundant(FN_glDepthMask);
+        currentDepthMask = flag;
+        real_glDepthMask(flag);
+    }
+
+    void APIENTRY hook_glBlendFunc(GLenum src, GLenum dst)
+    {
+        count(FN_glBlendFunc);
+        if (src == currentBlendSrc && dst == currentBlendDst)
+            countRedundant(FN_glBlendFunc);
+        currentBlendSrc = src;
+        currentBlendDst = dst;
+        real_glBlendFunc(src, dst);
+    }
+
+    void APIENTRY hook_glClearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a)
+    {
+        count(FN_glClearColor);
+        GLfloat color[4] = {r, g, b, a};
+        if (std::memcmp(color, currentClearColor, sizeof(color)) == 0)
+            countRedundant(FN_glClearColor);
+        std::memcpy(currentClearColor, color, sizeof(color));
+        real_glClearColor(r, g, b, a);
+    }
+
+    void APIENTRY hook_glViewport(GLint x, GLint y, GLsizei w, GLsizei h)
+    {
+        count(FN_glViewport);
+        GLint viewport[4] = {x, y, w, h};
+        if (std::memcmp(viewport, currentViewport, sizeof(viewport)) == 0)
+            countRedundant(FN_glViewport);
+        std::memcpy(currentViewport, viewport, sizeof(viewport));
+        real_glViewport(x, y, w, h);
+    }
+
+    void APIENTRY hook_glLinkProgram(GLuint program)
+    {
+        count(FN_glLinkProgram);
+        forgetProgramUniforms(program);
+        real_glLinkProgram(program);
+    }
+
+    // --- Uniforms ---
+    void APIENTRY hook_glUniform1i(GLint location, GLint v0)
+    {
+        trackUniform(FN_glUniform1i, location, &v0, sizeof(v0));
+        real_glUniform1i(location, v0);
+    }
+
+    void APIENTRY hook_glUniform1f(GLint location, GLfloat v0)
+    {
+        trackUniform(FN_glUniform1f, location, &v0, sizeof(v0));
+        real_glUniform1f(location, v0);
+    }
+
+    void APIENTRY hook_glUniform2f(GLint location, GLfloat v0, GLfloat v1)
+    {
+        GLfloat v[2] = {v0, v1};
+        trackUniform(FN_glUniform2f, location, v, sizeof(v));
+        real_glUniform2f(location, v0, v1);
+    }
+
+    void APIENTRY hook_glUniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2)
+    {
+        GLfloat v[3] = {v0, v1, v2};
+        trackUniform(FN_glUniform3f, location, v, sizeof(v));
+        real_glUniform3f(location, v0, v1, v2);
+    }
+
+    void APIENTRY hook_glUniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3)
+    {
+        GLfloat v[4] = {v0, v1, v2, v3};
+        trackUniform(FN_glUniform4f, location, v, sizeof(v));
+        real_glUniform4f(location, v0, v1, v2, v3);
+    }
+
+    void APIENTRY hook_glUniform1fv(GLint location, GLsizei n, const GLfloat *value)
+    {
+        trackUniform(FN_glUniform1fv, location, value, sizeof(GLfloat) * n);
+        real_glUniform1fv(location, n, value);
+    }
+
+    void APIENTRY hook_glUniform3fv(GLint location, GLsizei n, const GLfloat *value)
+    {
+        trackUniform(FN_glUniform3fv, location, value, sizeof(GLfloat) * 3 * n);
+        real_glUniform3fv(location, n, value);
+    }
+
+    void APIENTRY hook_glUniform4fv(GLint location, GLsizei n, const GLfloat *value)
+    {
+        trackUniform(FN_glUniform4fv, location, value, sizeof(GLfloat) * 4 * n);
+        real_glUniform4fv(location, n, value);
+    }
+
+    void APIENTRY hook_glUniformMatrix3fv(GLint location, GLsizei n, GLboolean transpose, const GLfloat *value)
+    {
+        trackUniform(FN_glUniformMatrix3fv, location, value, sizeof(GLfloat) * 9 * n);
+        real_glUniformMatrix3fv(location, n, transpose, value);
+    }
+
+    void APIENTRY hook_glUniformMatrix4fv(GLint location, GLsizei n, GLboolean transpose, const GLfloat *value)
+    {
+        trackUniform(FN_glUniformMatrix4fv, location, value, sizeof(GLfloat) * 16 * n);
+        real_glUniformMatrix4fv(location, n, transpose, value);
+    }
+
+    GLint APIENTRY hook_glGetUniformLocation(GLuint program, const GLchar *name)
+    {
+        count(FN_glGetUniformLocation);
+        return real_glGetUniformLocation(program, name);
+    }
+
+    // --- Uploads ---
+    void APIENTRY hook_glBufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage)
+    {
+        count(FN_glBufferData);
+        if (data)
+            countBytes(size);
+        real_glBufferData(target, size, data, usage);
+    }
+
+    void APIENTRY hook_glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data)
+    {
+        count(FN_glBufferSubData);
+        countBytes(size);
+        real_glBufferSubData(target, offset, size, data);
+    }
+
+    void *APIENTRY hook_glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access)
+    {
+        count(FN_glMapBufferRange);
+        if (access & GL_MAP_WRITE_BIT)
+            countBytes(length);
+        return real_glMapBufferRange(target, offset, length, access);
+    }
+
+    void APIENTRY hook_glTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei w, GLsizei h,
+                                    GLint border, GLenum format, GLenum type, const void *pixels)
+    {
+        count(FN_glTexImage2D);
+        if (pixels)
+            countBytes((std::uint64_t)w * h * bytesPerPixel(format, type));
+        real_glTexImage2D(target, level, internalFormat, w, h, border, format, type, pixels);
+    }
+
+    void APIENTRY hook_glTexSubImage2D(GLenum target, GLint level, GLint x, GLint y, GLsizei w, GLsizei h,
+                                       GLenum format, GLenum type, const void *pixels)
+    {
+        count(FN_glTexSubImage2D);
+        countBytes((std::uint64_t)w * h * bytesPerPixel(format, type));
+        real_glTexSubImage2D(target, level, x, y, w, h, format, type, pixels);
+    }
+
+    void APIENTRY hook_glTexImage3D(GLenum target, GLint level, GLint internalFormat, GLsizei w, GLsizei h, GLsizei d,
+                                    GLint border, GLenum format, GLenum type, const void *pixels)
+    {
+        count(FN_glTexImage3D);
+        if (pixels)
+            countBytes((std::uint64_t)w * h * d * bytesPerPixel(format, type));
+        real_glTexImage3D(target, level, internalFormat, w, h, d, border, format, type, pixels);
+    }
+
+    void APIENTRY hook_glTexSubImage3D(GLenum target, GLint level, GLint x, GLint y, GLint z, GLsizei w, GLsizei h,
+                                       GLsizei d, GLenum format, GLenum type, const void *pixels)
+    {
+        count(FN_glTexSubImage3D);
+        countBytes((std::uint64_t)w * h * d * bytesPerPixel(format, type));
+        real_glTexSubImage3D(target, level, x, y, z, w, h, d, format, type, pixels);
+    }
+
+    // --- Object lifetime ---
+    void APIENTRY hook_glGenBuffers(GLsizei n, GLuint *buffers)
+    {
+        count(FN_glGenBuffers);
+        real_glGenBuffers(n, buffers);
+    }
+
+    void APIENTRY hook_glGenVertexArrays(GLsizei n, GLuint *arrays)
+    {
+        count(FN_glGenVertexArrays);
+        real_glGenVertexArrays(n, arrays);
+    }
+
+    void APIENTRY hook_glGenTextures(GLsizei n, GLuint *textures)
+    {
+        count(FN_glGenTextures);
+        real_glGenTextures(n, textures);
+    }
+
+    GLuint APIENTRY hook_glCreateProgram()
+    {
+        count(FN_glCreateProgram);
+        return real_glCreateProgram();
+    }
+
+    void APIENTRY hook_glDeleteBuffers(GLsizei n, const GLuint *buffers)
+    {
+        count(FN_glDeleteBuffers);
+        for (GLsizei i = 0; i < n; ++i)
+        {
+            for (auto &binding : boundBuffers)
+            {
+                if (binding.second == buffers[i])
+                    binding.second = 0;
+            }
+        }
+        real_glDeleteBuffers(n, buffers);
+    }
+
+    void APIENTRY hook_glDeleteVertexArrays(GLsizei n, const GLuint *arrays)
+    {
+        count(FN_glDeleteVertexArrays);
+        for (GLsizei i = 0; i < n; ++i)
+        {
+            if (arrays[i] == currentVAO)
+                currentVAO = 0;
+        }
+        real_glDeleteVertexArrays(n, arrays);
+    }
+
+    void APIENTRY hook_glDeleteTextures(GLsizei n, const GLuint *textures)
+    {
+        count(FN_glDeleteTextures);
+        for (GLsizei i = 0; i < n; ++i)
+        {
+            for (auto &unit : boundTextures)
+            {
+                for (GLuint &bound : unit)
+                {
+                    if (bound == textures[i])
+                        bound = 0;
+                }
+            }
+        }
+        real_glDeleteTextures(n, textures);
+    }
+
+    void APIENTRY hook_glDeleteProgram(GLuint program)
+    {
+        count(FN_glDeleteProgram);
+        forgetProgramUniforms(program);
+        real_glDeleteProgram(program);
+    }
+
+    std::uint64_t sumCategory(const Counters &counters, Category category, bool redundantOnly)
+    {
+        std::uint64_t sum = 0;
+        for (int fn = 0; fn < FN_COUNT; ++fn)
+        {
+            if (kFunctionCategories[fn] == category)
+                sum += redundantOnly ? counters.redundant[fn] : counters.calls[fn];
+        }
+        return sum;
+    }
+}
+
+void GLStats::install()
+{
+    if (installed)
+        return;
+
+#define GL_STATS_HOOK(name, category) \
+    real_##name = glad_##name;        \
+    if (real_##name)                  \
+        glad_##name = hook_##name;
+    GL_STATS_FUNCTIONS(GL_STATS_HOOK)
+#undef GL_STATS_HOOK
+
+    // Seed the shadow state from the context so the first calls are judged correctly.
+    GLint value = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &value);
+    currentProgram = (GLuint)value;
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &value);
+    currentVAO = (GLuint)value;
+    glGetIntegerv(GL_ACTIVE_TEXTURE, &value);
+    currentActiveTexture = (GLenum)value;
+    glGetIntegerv(GL_DEPTH_FUNC, &value);
+    currentDepthFunc = (GLenum)value;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &value);
+    currentFramebuffer = (GLuint)value;
+    glGetIntegerv(GL_VIEWPORT, currentViewport);
+
+    installed = true;
+}
+
+void GLStats::resetTotals()
+{
+    total = Counters();
+}
+
+bool GLStats::isInstalled()
+{
+    return installed;
+}
+
+void GLStats::beginFrame()
+{
+    frame = Counters();
+}
+
+void GLStats::endFrame(FrameStats *stats)
+{
+    if (!installed || !stats)
+        return;
+
+    stats->record("gl_draw_calls", (double)sumCategory(frame, DRAW, false));
+    stats->record("gl_vertices_submitted", (double)frame.verticesSubmitted);
+    stats->record("gl_state_changes", (double)sumCategory(frame, STATE, false));
+    stats->record("gl_redundant_state_changes", (double)sumCategory(frame, STATE, true));
+    stats->record("gl_uniform_uploads", (double)sumCategory(frame, UNIFORM, false));
+    stats->record("gl_redundant_uniform_uploads", (double)sumCategory(frame, UNIFORM, true));
+    stats->record("gl_inactive_uniform_uploads", (double)frame.inactiveUniforms);
+    stats->record("gl_uniform_location_lookups", (double)frame.calls[FN_glGetUniformLocation]);
+    stats->record("gl_uploads", (double)sumCategory(frame, UPLOAD, false));
+    stats->record("gl_bytes_uploaded", (double)frame.bytesUploaded);
+    stats->record("gl_objects_created", (double)sumCategory(frame, CREATE, false));
+    stats->record("gl_objects_deleted", (double)sumCategory(frame, DESTROY, false));
+    stats->record("gl_program_links", (double)frame.calls[FN_glLinkProgram]);
+}
+
+void GLStats::writeJson(std::ostream &out)
+{
+    out << "{";
+    bool first = true;
+    for (int fn = 0; fn < FN_COUNT; ++fn)
+    {
+        if (total.calls[fn] == 0)
+            continue;
+        out << (first ? "" : ",") << "\n    \"" << kFunctionNames[fn] << "\": {\"calls\": " << total.calls[fn]
+            << ", \"redundant\": " << total.redundant[fn] << "}";
+        first = false;
+    }
+    out << "\n  }";
+}
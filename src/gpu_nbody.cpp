@@ -0,0 +1,166 @@
+#include "../include/gpu_nbody.h"
+#include "../include/profiler.h"
+#include "../include/glm/glm/gtc/constants.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+GpuNBody::GpuNBody(const GpuNBodySettings &nbodySettings)
+    : settings(nbodySettings),
+      stepShader("shaders/nbody.comp")
+{
+    PROFILE_ZONE("GpuNBody::GpuNBody");
+
+    settings.count = std::min(settings.count, 65535u * kTileSize);
+    std::vector<glm::vec4> positions, velocities;
+    generateCluster(positions, velocities);
+
+    glGenBuffers(3, buffers);
+    std::size_t bytes = std::max<std::size_t>(settings.count, 1) * sizeof(glm::vec4);
+    const glm::vec4 *initial[3] = {positions.data(), velocities.data(), nullptr};
+    for (int i = 0; i < 3; ++i)
+    {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[i]);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, bytes, settings.count ? initial[i] : nullptr, GL_DYNAMIC_DRAW);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    // The storage buffer the compute shader integrates in place is the instance attribute.
+    mesh.reset(new InstancedPointMesh(buffers[0]));
+
+    // Accelerations at t = 0 for the first half kick.
+    dispatch(1, 0.0f);
+}
+
+GpuNBody::~GpuNBody()
+{
+    mesh.reset();
+    glDeleteBuffers(3, buffers);
+    glDeleteProgram(stepShader.ID);
+}
+
+void GpuNBody::generateCluster(std::vector<glm::vec4> &positions, std::vector<glm::vec4> &velocities) const
+{
+    PROFILE_ZONE("GpuNBody::generateCluster");
+
+    // Plummer sphere in equilibrium (Aarseth, Henon & Wielen 1974): radius
+    // from the inverse cumulative mass, speed a fraction q of the local escape
+    // speed with q drawn from its distribution q^2 (1 - q^2)^(7/2) by rejection.
+    std::mt19937 random(settings.seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    auto direction = [&]()
+    {
+        float cosTheta = 2.0f * unit(random) - 1.0f;
+        float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+        float phi = 2.0f * glm::pi<float>() * unit(random);
+        return glm::vec3(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+    };
+
+    float a = settings.scaleRadius;
+    float gm = settings.count ? settings.totalGm / (float)settings.count : 0.0f;
+    positions.resize(settings.count);
+    velocities.resize(settings.count);
+    glm::vec3 centerPosition(0.0f), centerVelocity(0.0f);
+    for (unsigned int i = 0; i < settings.count; ++i)
+    {
+        float r;
+        do
+            r = a / std::sqrt(std::pow(std::max(unit(random), 1e-6f), -2.0f / 3.0f) - 1.0f);
+        while (r > 10.0f * a);
+
+        float q, g;
+        do
+        {
+            q = unit(random);
+            g = 0.1f * unit(random);
+        } while (g > q * q * std::pow(1.0f - q * q, 3.5f));
+        float escape = std::sqrt(2.0f * settings.totalGm) * std::pow(r * r + a * a, -0.25f);
+
+        glm::vec3 position = r * direction();
+        glm::vec3 velocity = q * escape * direction();
+        positions[i] = glm::vec4(position, gm);
+        velocities[i] = glm::vec4(velocity, 0.0f);
+        centerPosition += position;
+        centerVelocity += velocity;
+    }
+
+    // Centre of mass at settings.center, at rest.
+    if (settings.count)
+    {
+        centerPosition /= (float)settings.count;
+        centerVelocity /= (float)settings.count;
+    }
+    for (unsigned int i = 0; i < settings.count; ++i)
+    {
+        positions[i] += glm::vec4(settings.center - centerPosition, 0.0f);
+        velocities[i] -= glm::vec4(centerVelocity, 0.0f);
+    }
+}
+
+void GpuNBody::dispatch(int stage, float dt)
+{
+    stepShader.use();
+    glUniform1i(glGetUniformLocation(stepShader.ID, "stage"), stage);
+    glUniform1ui(glGetUniformLocation(stepShader.ID, "bodyCount"), (GLuint)settings.count);
+    stepShader.setFloat("dt", dt);
+    stepShader.setFloat("softening2", settings.softening * settings.softening);
+    for (GLuint i = 0; i < 3; ++i)
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i, buffers[i]);
+    glDispatchCompute((GLuint)((settings.count + kTileSize - 1) / kTileSize), 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void GpuNBody::step(int direction)
+{
+    PROFILE_ZONE("GpuNBody::step");
+    float dt = direction < 0 ? -settings.dt : settings.dt;
+    if (settings.count)
+    {
+        // Stage 0: half kick with the last accelerations, then drift; stage 1:
+        // accelerations at the new positions, then the second half kick.
+        dispatch(0, dt);
+        dispatch(1, dt);
+    }
+    currentTime += dt;
+}
+
+int GpuNBody::advanceTo(double t)
+{
+    int steps = 0;
+    while (steps < settings.maxSteps && std::abs(t - currentTime) >= 0.5 * settings.dt)
+    {
+        step(t > currentTime ? 1 : -1);
+        ++steps;
+    }
+    return steps;
+}
+
+void GpuNBody::draw(const glm::mat4 &view, const glm::mat4 &projection, const glm::vec3 &lightPos, float viewportHeight)
+{
+    PROFILE_ZONE("GpuNBody::draw");
+    if (settings.count == 0)
+        return;
+
+    glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+    mesh->draw(view, projection, lightPos, viewportHeight, settings.bodySize, settings.points, settings.count);
+}
+
+void GpuNBody::read(std::vector<glm::vec4> &positions, std::vector<glm::vec4> &velocities) const
+{
+    positions.resize(settings.count);
+    velocities.resize(settings.count);
+    if (settings.count == 0)
+        return;
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glBindBuffer(GL_COPY_READ_BUFFER, buffers[0]);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, settings.count * sizeof(glm::vec4), positions.data());
+    glBindBuffer(GL_COPY_READ_BUFFER, buffers[1]);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, settings.count * sizeof(glm::vec4), velocities.data());
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+}
+
+std::size_t GpuNBody::gpuBytes() const
+{
+    return 3 * std::max<std::size_t>(settings.count, 1) * sizeof(glm::vec4) + mesh->gpuBytes();
+}
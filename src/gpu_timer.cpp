@@ -0,0 +1,136 @@
+#include "../include/gpu_timer.h"
+#include "../include/profiler.h"
+
+GpuTimer::GpuTimer(FrameStats *sink, int latency)
+    : stats(sink), slots(latency > 1 ? latency : 2)
+{
+}
+
+GpuTimer::~GpuTimer()
+{
+    for (auto &slot : slots)
+    {
+        if (!slot.pool.empty())
+            glDeleteQueries((GLsizei)slot.pool.size(), slot.pool.data());
+    }
+}
+
+unsigned int GpuTimer::nextQuery(FrameSlot &slot)
+{
+    if (slot.used == (int)slot.pool.size())
+    {
+        unsigned int query;
+        glGenQueries(1, &query);
+        slot.pool.push_back(query);
+    }
+    return slot.pool[slot.used++];
+}
+
+void GpuTimer::beginFrame(bool record)
+{
+    PROFILE_ZONE("GpuTimer::beginFrame");
+
+    current = (current + 1) % (int)slots.size();
+    FrameSlot &slot = slots[current];
+    if (slot.pending)
+        readBack(slot, false);
+
+    slot.passes.clear();
+    slot.used = 0;
+    slot.record = record;
+    openPasses.clear();
+
+    slot.frameBegin = nextQuery(slot);
+    glQueryCounter(slot.frameBegin, GL_TIMESTAMP);
+}
+
+void GpuTimer::endFrame()
+{
+    FrameSlot &slot = slots[current];
+    slot.frameEnd = nextQuery(slot);
+    glQueryCounter(slot.frameEnd, GL_TIMESTAMP);
+    slot.pending = true;
+}
+
+void GpuTimer::beginPass(const char *name)
+{
+    FrameSlot &slot = slots[current];
+    PassQuery pass{name, nextQuery(slot), 0};
+    glQueryCounter(pass.begin, GL_TIMESTAMP);
+    openPasses.push_back((int)slot.passes.size());
+    slot.passes.push_back(pass);
+}
+
+void GpuTimer::endPass()
+{
+    if (openPasses.empty())
+        return;
+
+    FrameSlot &slot = slots[current];
+    PassQuery &pass = slot.passes[openPasses.back()];
+    openPasses.pop_back();
+    pass.end = nextQuery(slot);
+    glQueryCounter(pass.end, GL_TIMESTAMP);
+}
+
+void GpuTimer::flush()
+{
+    // Oldest first, so series stay in frame order.
+    for (int i = 1; i <= (int)slots.size(); ++i)
+    {
+        FrameSlot &slot = slots[(current + i) % slots.size()];
+        if (slot.pending)
+            readBack(slot, true);
+    }
+}
+
+void GpuTimer::readBack(FrameSlot &slot, bool wait)
+{
+    slot.pending = false;
+
+    // Timestamps complete in order, so the frame's last query decides for all of them.
+    if (!wait)
+    {
+        GLint available = 0;
+        glGetQueryObjectiv(slot.frameEnd, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+        {
+            ++dropped;
+            return;
+        }
+    }
+    if (!slot.record || !stats)
+        return;
+
+    GLuint64 frameBegin = 0, frameEnd = 0;
+    glGetQueryObjectui64v(slot.frameBegin, GL_QUERY_RESULT, &frameBegin);
+    glGetQueryObjectui64v(slot.frameEnd, GL_QUERY_RESULT, &frameEnd);
+    stats->record("gpu_frame_ms", (frameEnd - frameBegin) / 1.0e6);
+
+    passTotals.clear();
+    for (const auto &pass : slot.passes)
+    {
+        if (!pass.end)
+            continue;
+
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(pass.begin, GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(pass.end, GL_QUERY_RESULT, &end);
+        double ms = (end - begin) / 1.0e6;
+
+        bool merged = false;
+        for (auto &total : passTotals)
+        {
+            if (total.first == pass.name)
+            {
+                total.second += ms;
+                merged = true;
+                break;
+            }
+        }
+        if (!merged)
+            passTotals.emplace_back(pass.name, ms);
+    }
+    for (const auto &total : passTotals)
+        stats->record(std::string("gpu_") + total.first + "_ms", total.second);
+}
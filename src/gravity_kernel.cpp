@@ -0,0 +1,344 @@
+#include "../include/gravity_kernel.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define GRAVITY_X86_KERNELS 1
+#endif
+
+namespace
+{
+    // Sources per tile: four arrays of 512 doubles (16 KB) stay in L1 while
+    // every target of the range is accumulated against them.
+    const std::size_t kTile = 512;
+
+    using Kernel = void (*)(const GravityTargets &, std::size_t, std::size_t, const GravitySources &, double);
+
+    // Adds the pull of sources [first, last) to targets [begin, end).
+    void scalarRange(const GravityTargets &targets, std::size_t begin, std::size_t end,
+                     const GravitySources &sources, std::size_t first, std::size_t last, double softening2)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            double xi = targets.x[i], yi = targets.y[i], zi = targets.z[i];
+            double axi = 0.0, ayi = 0.0, azi = 0.0;
+            for (std::size_t j = first; j < last; ++j)
+            {
+                double dx = sources.x[j] - xi;
+                double dy = sources.y[j] - yi;
+                double dz = sources.z[j] - zi;
+                double r2 = dx * dx + dy * dy + dz * dz + softening2;
+                if (r2 > 0.0) // a body never pulls itself
+                {
+                    double inverse = 1.0 / std::sqrt(r2);
+                    double f = sources.gm[j] * inverse * inverse * inverse;
+                    axi += f * dx;
+                    ayi += f * dy;
+                    azi += f * dz;
+                }
+            }
+            targets.ax[i] += axi;
+            targets.ay[i] += ayi;
+            targets.az[i] += azi;
+        }
+    }
+
+    void scalarKernel(const GravityTargets &targets, std::size_t begin, std::size_t end, const GravitySources &sources, double softening2)
+    {
+        for (std::size_t tile = 0; tile < sources.count; tile += kTile)
+            scalarRange(targets, begin, end, sources, tile, std::min(tile + kTile, sources.count), softening2);
+    }
+
+#ifdef GRAVITY_X86_KERNELS
+    // Four targets per register against one broadcast source at a time, so the
+    // accumulators never need a horizontal sum.
+    __attribute__((target("avx2,fma")))
+    void avx2Kernel(const GravityTargets &targets, std::size_t begin, std::size_t end, const GravitySources &sources, double softening2)
+    {
+        const __m256d eps2 = _mm256_set1_pd(softening2);
+        const __m256d zero = _mm256_setzero_pd();
+        const __m256d one = _mm256_set1_pd(1.0);
+        std::size_t vectorEnd = begin + (end - begin) / 4 * 4;
+
+        for (std::size_t tile = 0; tile < sources.count; tile += kTile)
+        {
+            std::size_t tileEnd = std::min(tile + kTile, sources.count);
+            for (std::size_t i = begin; i < vectorEnd; i += 4)
+            {
+                __m256d xi = _mm256_loadu_pd(targets.x + i);
+                __m256d yi = _mm256_loadu_pd(targets.y + i);
+                __m256d zi = _mm256_loadu_pd(targets.z + i);
+                __m256d axi = zero, ayi = zero, azi = zero;
+                for (std::size_t j = tile; j < tileEnd; ++j)
+                {
+                    __m256d dx = _mm256_sub_pd(_mm256_broadcast_sd(sources.x + j), xi);
+                    __m256d dy = _mm256_sub_pd(_mm256_broadcast_sd(sources.y + j), yi);
+                    __m256d dz = _mm256_sub_pd(_mm256_broadcast_sd(sources.z + j), zi);
+                    __m256d r2 = _mm256_fmadd_pd(dx, dx, _mm256_fmadd_pd(dy, dy, _mm256_fmadd_pd(dz, dz, eps2)));
+                    __m256d inverse = _mm256_div_pd(one, _mm256_sqrt_pd(r2));
+                    __m256d f = _mm256_mul_pd(_mm256_mul_pd(_mm256_broadcast_sd(sources.gm + j), inverse), _mm256_mul_pd(inverse, inverse));
+                    f = _mm256_and_pd(f, _mm256_cmp_pd(r2, zero, _CMP_GT_OQ)); // a body never pulls itself
+                    axi = _mm256_fmadd_pd(f, dx, axi);
+                    ayi = _mm256_fmadd_pd(f, dy, ayi);
+                    azi = _mm256_fmadd_pd(f, dz, azi);
+                }
+                _mm256_storeu_pd(targets.ax + i, _mm256_add_pd(_mm256_loadu_pd(targets.ax + i), axi));
+                _mm256_storeu_pd(targets.ay + i, _mm256_add_pd(_mm256_loadu_pd(targets.ay + i), ayi));
+                _mm256_storeu_pd(targets.az + i, _mm256_add_pd(_mm256_loadu_pd(targets.az + i), azi));
+            }
+            scalarRange(targets, vectorEnd, end, sources, tile, tileEnd, softening2);
+        }
+    }
+
+    // Eight targets per register. 1/sqrt is rsqrt14 refined by two Newton
+    // steps (14 -> 28 -> 56 bits) instead of a square root and a division.
+    __attribute__((target("avx512f")))
+    void avx512Kernel(const GravityTargets &targets, std::size_t begin, std::size_t end, const GravitySources &sources, double softening2)
+    {
+        const __m512d eps2 = _mm512_set1_pd(softening2);
+        const __m512d zero = _mm512_setzero_pd();
+        const __m512d half = _mm512_set1_pd(0.5);
+        const __m512d threeHalves = _mm512_set1_pd(1.5);
+        std::size_t vectorEnd = begin + (end - begin) / 8 * 8;
+
+        for (std::size_t tile = 0; tile < sources.count; tile += kTile)
+        {
+            std::size_t tileEnd = std::min(tile + kTile, sources.count);
+            for (std::size_t i = begin; i < vectorEnd; i += 8)
+            {
+                __m512d xi = _mm512_loadu_pd(targets.x + i);
+                __m512d yi = _mm512_loadu_pd(targets.y + i);
+                __m512d zi = _mm512_loadu_pd(targets.z + i);
+                __m512d axi = zero, ayi = zero, azi = zero;
+                for (std::size_t j = tile; j < tileEnd; ++j)
+                {
+                    __m512d dx = _mm512_sub_pd(_mm512_set1_pd(sources.x[j]), xi);
+                    __m512d dy = _mm512_sub_pd(_mm512_set1_pd(sources.y[j]), yi);
+                    __m512d dz = _mm512_sub_pd(_mm512_set1_pd(sources.z[j]), zi);
+                    __m512d r2 = _mm512_fmadd_pd(dx, dx, _mm512_fmadd_pd(dy, dy, _mm512_fmadd_pd(dz, dz, eps2)));
+                    __mmask8 pulls = _mm512_cmp_pd_mask(r2, zero, _CMP_GT_OQ); // a body never pulls itself
+                    __m512d h = _mm512_mul_pd(half, r2);
+                    __m512d inverse = _mm512_maskz_rsqrt14_pd(pulls, r2);
+                    inverse = _mm512_mul_pd(inverse, _mm512_fnmadd_pd(_mm512_mul_pd(h, inverse), inverse, threeHalves));
+                    inverse = _mm512_mul_pd(inverse, _mm512_fnmadd_pd(_mm512_mul_pd(h, inverse), inverse, threeHalves));
+                    __m512d f = _mm512_maskz_mul_pd(pulls, _mm512_mul_pd(_mm512_set1_pd(sources.gm[j]), inverse), _mm512_mul_pd(inverse, inverse));
+                    axi = _mm512_fmadd_pd(f, dx, axi);
+                    ayi = _mm512_fmadd_pd(f, dy, ayi);
+                    azi = _mm512_fmadd_pd(f, dz, azi);
+                }
+                _mm512_storeu_pd(targets.ax + i, _mm512_add_pd(_mm512_loadu_pd(targets.ax + i), axi));
+                _mm512_storeu_pd(targets.ay + i, _mm512_add_pd(_mm512_loadu_pd(targets.ay + i), ayi));
+                _mm512_storeu_pd(targets.az + i, _mm512_add_pd(_mm512_loadu_pd(targets.az + i), azi));
+            }
+            scalarRange(targets, vectorEnd, end, sources, tile, tileEnd, softening2);
+        }
+    }
+#endif
+
+    // Monopole plus quadrupole of cell j at target i: with d from the target
+    // to the cell's centre of mass,
+    // a = gm d / r^3 - Q d / r^5 + 5/2 (d.Q d) d / r^7.
+    void scalarQuadrupoleRange(const GravityTargets &targets, std::size_t begin, std::size_t end,
+                               const GravityCells &cells, double softening2)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            double xi = targets.x[i], yi = targets.y[i], zi = targets.z[i];
+            double axi = 0.0, ayi = 0.0, azi = 0.0;
+            for (std::size_t j = 0; j < cells.count; ++j)
+            {
+                double dx = cells.x[j] - xi, dy = cells.y[j] - yi, dz = cells.z[j] - zi;
+                double inverse = 1.0 / std::sqrt(dx * dx + dy * dy + dz * dz + softening2);
+                double inverse2 = inverse * inverse;
+                double inverse5 = inverse2 * inverse2 * inverse;
+                double qx = cells.xx[j] * dx + cells.xy[j] * dy + cells.xz[j] * dz;
+                double qy = cells.xy[j] * dx + cells.yy[j] * dy + cells.yz[j] * dz;
+                double qz = cells.xz[j] * dx + cells.yz[j] * dy + cells.zz[j] * dz;
+                double g = cells.gm[j] * inverse2 * inverse + 2.5 * (dx * qx + dy * qy + dz * qz) * inverse5 * inverse2;
+                axi += g * dx - qx * inverse5;
+                ayi += g * dy - qy * inverse5;
+                azi += g * dz - qz * inverse5;
+            }
+            targets.ax[i] += axi;
+            targets.ay[i] += ayi;
+            targets.az[i] += azi;
+        }
+    }
+
+#ifdef GRAVITY_X86_KERNELS
+    __attribute__((target("avx2,fma")))
+    void avx2QuadrupoleKernel(const GravityTargets &targets, std::size_t begin, std::size_t end, const GravityCells &cells, double softening2)
+    {
+        const __m256d eps2 = _mm256_set1_pd(softening2);
+        const __m256d one = _mm256_set1_pd(1.0);
+        const __m256d fiveHalves = _mm256_set1_pd(2.5);
+        std::size_t vectorEnd = begin + (end - begin) / 4 * 4;
+        for (std::size_t i = begin; i < vectorEnd; i += 4)
+        {
+            __m256d xi = _mm256_loadu_pd(targets.x + i);
+            __m256d yi = _mm256_loadu_pd(targets.y + i);
+            __m256d zi = _mm256_loadu_pd(targets.z + i);
+            __m256d axi = _mm256_loadu_pd(targets.ax + i);
+            __m256d ayi = _mm256_loadu_pd(targets.ay + i);
+            __m256d azi = _mm256_loadu_pd(targets.az + i);
+            for (std::size_t j = 0; j < cells.count; ++j)
+            {
+                __m256d dx = _mm256_sub_pd(_mm256_broadcast_sd(cells.x + j), xi);
+                __m256d dy = _mm256_sub_pd(_mm256_broadcast_sd(cells.y + j), yi);
+                __m256d dz = _mm256_sub_pd(_mm256_broadcast_sd(cells.z + j), zi);
+                __m256d r2 = _mm256_fmadd_pd(dx, dx, _mm256_fmadd_pd(dy, dy, _mm256_fmadd_pd(dz, dz, eps2)));
+                __m256d inverse = _mm256_div_pd(one, _mm256_sqrt_pd(r2));
+                __m256d inverse2 = _mm256_mul_pd(inverse, inverse);
+                __m256d inverse5 = _mm256_mul_pd(_mm256_mul_pd(inverse2, inverse2), inverse);
+                __m256d xy = _mm256_broadcast_sd(cells.xy + j), xz = _mm256_broadcast_sd(cells.xz + j), yz = _mm256_broadcast_sd(cells.yz + j);
+                __m256d qx = _mm256_fmadd_pd(_mm256_broadcast_sd(cells.xx + j), dx, _mm256_fmadd_pd(xy, dy, _mm256_mul_pd(xz, dz)));
+                __m256d qy = _mm256_fmadd_pd(xy, dx, _mm256_fmadd_pd(_mm256_broadcast_sd(cells.yy + j), dy, _mm256_mul_pd(yz, dz)));
+                __m256d qz = _mm256_fmadd_pd(xz, dx, _mm256_fmadd_pd(yz, dy, _mm256_mul_pd(_mm256_broadcast_sd(cells.zz + j), dz)));
+                __m256d dqd = _mm256_fmadd_pd(dx, qx, _mm256_fmadd_pd(dy, qy, _mm256_mul_pd(dz, qz)));
+                __m256d g = _mm256_fmadd_pd(_mm256_mul_pd(fiveHalves, dqd), _mm256_mul_pd(inverse5, inverse2),
+                                            _mm256_mul_pd(_mm256_broadcast_sd(cells.gm + j), _mm256_mul_pd(inverse2, inverse)));
+                axi = _mm256_fnmadd_pd(qx, inverse5, _mm256_fmadd_pd(g, dx, axi));
+                ayi = _mm256_fnmadd_pd(qy, inverse5, _mm256_fmadd_pd(g, dy, ayi));
+                azi = _mm256_fnmadd_pd(qz, inverse5, _mm256_fmadd_pd(g, dz, azi));
+            }
+            _mm256_storeu_pd(targets.ax + i, axi);
+            _mm256_storeu_pd(targets.ay + i, ayi);
+            _mm256_storeu_pd(targets.az + i, azi);
+        }
+        scalarQuadrupoleRange(targets, vectorEnd, end, cells, softening2);
+    }
+
+    __attribute__((target("avx512f")))
+    void avx512QuadrupoleKernel(const GravityTargets &targets, std::size_t begin, std::size_t end, const GravityCells &cells, double softening2)
+    {
+        const __m512d eps2 = _mm512_set1_pd(softening2);
+        const __m512d half = _mm512_set1_pd(0.5);
+        const __m512d threeHalves = _mm512_set1_pd(1.5);
+        const __m512d fiveHalves = _mm512_set1_pd(2.5);
+        std::size_t vectorEnd = begin + (end - begin) / 8 * 8;
+        for (std::size_t i = begin; i < vectorEnd; i += 8)
+        {
+            __m512d xi = _mm512_loadu_pd(targets.x + i);
+            __m512d yi = _mm512_loadu_pd(targets.y + i);
+            __m512d zi = _mm512_loadu_pd(targets.z + i);
+            __m512d axi = _mm512_loadu_pd(targets.ax + i);
+            __m512d ayi = _mm512_loadu_pd(targets.ay + i);
+            __m512d azi = _mm512_loadu_pd(targets.az + i);
+            for (std::size_t j = 0; j < cells.count; ++j)
+            {
+                __m512d dx = _mm512_sub_pd(_mm512_set1_pd(cells.x[j]), xi);
+                __m512d dy = _mm512_sub_pd(_mm512_set1_pd(cells.y[j]), yi);
+                __m512d dz = _mm512_sub_pd(_mm512_set1_pd(cells.z[j]), zi);
+                __m512d r2 = _mm512_fmadd_pd(dx, dx, _mm512_fmadd_pd(dy, dy, _mm512_fmadd_pd(dz, dz, eps2)));
+                __m512d h = _mm512_mul_pd(half, r2);
+                __m512d inverse = _mm512_maskz_rsqrt14_pd(0xff, r2); // the unmasked form trips -Wmaybe-uninitialized in GCC 12's header
+                inverse = _mm512_mul_pd(inverse, _mm512_fnmadd_pd(_mm512_mul_pd(h, inverse), inverse, threeHalves));
+                inverse = _mm512_mul_pd(inverse, _mm512_fnmadd_pd(_mm512_mul_pd(h, inverse), inverse, threeHalves));
+                __m512d inverse2 = _mm512_mul_pd(inverse, inverse);
+                __m512d inverse5 = _mm512_mul_pd(_mm512_mul_pd(inverse2, inverse2), inverse);
+                __m512d xy = _mm512_set1_pd(cells.xy[j]), xz = _mm512_set1_pd(cells.xz[j]), yz = _mm512_set1_pd(cells.yz[j]);
+                __m512d qx = _mm512_fmadd_pd(_mm512_set1_pd(cells.xx[j]), dx, _mm512_fmadd_pd(xy, dy, _mm512_mul_pd(xz, dz)));
+                __m512d qy = _mm512_fmadd_pd(xy, dx, _mm512_fmadd_pd(_mm512_set1_pd(cells.yy[j]), dy, _mm512_mul_pd(yz, dz)));
+                __m512d qz = _mm512_fmadd_pd(xz, dx, _mm512_fmadd_pd(yz, dy, _mm512_mul_pd(_mm512_set1_pd(cells.zz[j]), dz)));
+                __m512d dqd = _mm512_fmadd_pd(dx, qx, _mm512_fmadd_pd(dy, qy, _mm512_mul_pd(dz, qz)));
+                __m512d g = _mm512_fmadd_pd(_mm512_mul_pd(fiveHalves, dqd), _mm512_mul_pd(inverse5, inverse2),
+                                            _mm512_mul_pd(_mm512_set1_pd(cells.gm[j]), _mm512_mul_pd(inverse2, inverse)));
+                axi = _mm512_fnmadd_pd(qx, inverse5, _mm512_fmadd_pd(g, dx, axi));
+                ayi = _mm512_fnmadd_pd(qy, inverse5, _mm512_fmadd_pd(g, dy, ayi));
+                azi = _mm512_fnmadd_pd(qz, inverse5, _mm512_fmadd_pd(g, dz, azi));
+            }
+            _mm512_storeu_pd(targets.ax + i, axi);
+            _mm512_storeu_pd(targets.ay + i, ayi);
+            _mm512_storeu_pd(targets.az + i, azi);
+        }
+        scalarQuadrupoleRange(targets, vectorEnd, end, cells, softening2);
+    }
+#endif
+
+    Kernel kernelFunction(NBodyKernel kernel)
+    {
+        switch (kernel)
+        {
+#ifdef GRAVITY_X86_KERNELS
+        case NBodyKernel::Avx2:
+            return avx2Kernel;
+        case NBodyKernel::Avx512:
+            return avx512Kernel;
+#endif
+        default:
+            return scalarKernel;
+        }
+    }
+}
+
+void accumulateCellGravity(NBodyKernel kernel, const GravityTargets &targets, std::size_t begin, std::size_t end,
+                           const GravityCells &cells, double softening2)
+{
+    if (begin >= end || cells.count == 0)
+        return;
+    switch (kernel)
+    {
+#ifdef GRAVITY_X86_KERNELS
+    case NBodyKernel::Avx2:
+        avx2QuadrupoleKernel(targets, begin, end, cells, softening2);
+        break;
+    case NBodyKernel::Avx512:
+        avx512QuadrupoleKernel(targets, begin, end, cells, softening2);
+        break;
+#endif
+    default:
+        scalarQuadrupoleRange(targets, begin, end, cells, softening2);
+        break;
+    }
+}
+
+bool isGravityKernelSupported(NBodyKernel kernel)
+{
+    switch (kernel)
+    {
+    case NBodyKernel::Auto:
+    case NBodyKernel::Scalar:
+        return true;
+#ifdef GRAVITY_X86_KERNELS
+    case NBodyKernel::Avx2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case NBodyKernel::Avx512:
+        return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+        return false;
+    }
+}
+
+NBodyKernel resolveGravityKernel(NBodyKernel kernel)
+{
+    if (kernel == NBodyKernel::Auto)
+        return isGravityKernelSupported(NBodyKernel::Avx512) ? NBodyKernel::Avx512
+               : isGravityKernelSupported(NBodyKernel::Avx2) ? NBodyKernel::Avx2
+                                                             : NBodyKernel::Scalar;
+    return isGravityKernelSupported(kernel) ? kernel : NBodyKernel::Scalar;
+}
+
+const char *gravityKernelName(NBodyKernel kernel)
+{
+    switch (kernel)
+    {
+    case NBodyKernel::Scalar:
+        return "scalar";
+    case NBodyKernel::Avx2:
+        return "avx2";
+    case NBodyKernel::Avx512:
+        return "avx512";
+    default:
+        return "auto";
+    }
+}
+
+void accumulateGravity(NBodyKernel kernel, const GravityTargets &targets, std::size_t begin, std::size_t end,
+                       const GravitySources &sources, double softening2)
+{
+    if (begin < end && sources.count > 0)
+        kernelFunction(kernel)(targets, begin, end, sources, softening2);
+}
@@ -0,0 +1,296 @@
+#include "../include/indirect_renderer.h"
+#include "../include/frustum.h"
+#include "../include/profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+IndirectRenderer::IndirectRenderer()
+    : cullShader("shaders/cull_bodies.comp")
+{
+    glGenVertexArrays(1, &vao);
+    GLuint *buffers[] = {&vertexBuffer, &indexBuffer, &bodyBuffer, &chainBuffer, &errorBuffer,
+                         &commandBuffer, &instanceBuffer, &bodyLevelBuffer, &readbackBuffers[0], &readbackBuffers[1]};
+    for (GLuint *buffer : buffers)
+        glGenBuffers(1, buffer);
+}
+
+IndirectRenderer::~IndirectRenderer()
+{
+    glDeleteVertexArrays(1, &vao);
+    GLuint buffers[] = {vertexBuffer, indexBuffer, bodyBuffer, chainBuffer, errorBuffer,
+                        commandBuffer, instanceBuffer, bodyLevelBuffer, readbackBuffers[0], readbackBuffers[1]};
+    glDeleteBuffers(10, buffers);
+    glDeleteProgram(cullShader.ID);
+}
+
+int IndirectRenderer::chainIndex(const LodChain *chain)
+{
+    auto found = std::find(chains.begin(), chains.end(), chain);
+    if (found != chains.end())
+        return (int)(found - chains.begin());
+    chains.push_back(chain);
+    poolDirty = true;
+    return (int)chains.size() - 1;
+}
+
+void IndirectRenderer::add(const LodMesh &mesh, const glm::mat4 &model, const glm::vec3 &center, float radius, int textureLayer, int pass)
+{
+    if (!mesh || pass < 0 || pass >= kPasses)
+        return;
+    GpuBody body;
+    body.model = model;
+    body.sphere = glm::vec4(center, radius);
+    body.chain = (GLuint)chainIndex(mesh.getChain());
+    body.pass = (GLuint)pass;
+    body.textureLayer = (float)textureLayer;
+    body.padding = 0;
+    bodies.push_back(body);
+}
+
+void IndirectRenderer::buildMeshPool(MeshCache &meshes)
+{
+    PROFILE_ZONE("IndirectRenderer::buildMeshPool");
+
+    levels.clear();
+    chainFirstLevel.clear();
+    poolFormat = meshes.vertexFormat();
+    GLsizei stride = vertexStride(poolFormat);
+
+    // Offsets of every level in the shared buffers.
+    std::size_t vertexTotal = 0, indexTotal = 0;
+    std::vector<MeshHandle> handles;
+    for (const LodChain *chain : chains)
+    {
+        chainFirstLevel.push_back((GLuint)levels.size());
+        for (const LodLevel &lodLevel : chain->levels)
+        {
+            Planet &mesh = meshes.get(lodLevel.mesh);
+            if (mesh.getVertexFormat() != poolFormat)
+                std::cerr << "ERROR::INDIRECT_RENDERER::MIXED_VERTEX_FORMATS" << std::endl;
+            primitiveMode = mesh.getPrimitiveMode();
+            Level level;
+            level.maxError = lodLevel.maxError;
+            level.firstIndex = (GLuint)indexTotal;
+            level.baseVertex = (GLint)vertexTotal;
+            level.indexCount = mesh.getIndexCount();
+            level.triangles = mesh.getTriangleCount();
+            levels.push_back(level);
+            handles.push_back(lodLevel.mesh);
+            vertexTotal += mesh.getVertexCount();
+            indexTotal += mesh.getIndexCount();
+        }
+    }
+
+    // Vertices are copied on the GPU; indices come back to the CPU once to be
+    // widened to 32 bits (one index type per multi-draw), with 16-bit restart
+    // indices becoming the 32-bit fixed restart index.
+    glBindBuffer(GL_COPY_WRITE_BUFFER, vertexBuffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)(vertexTotal * stride), nullptr, GL_STATIC_DRAW);
+    std::vector<GLuint> indices(indexTotal);
+    for (std::size_t i = 0; i < handles.size(); ++i)
+    {
+        Planet &mesh = meshes.get(handles[i]);
+        glBindBuffer(GL_COPY_READ_BUFFER, mesh.getVertexBuffer());
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, (GLintptr)levels[i].baseVertex * stride,
+                            (GLsizeiptr)mesh.getVertexCount() * stride);
+
+        GLuint *out = indices.data() + levels[i].firstIndex;
+        glBindBuffer(GL_COPY_READ_BUFFER, mesh.getIndexBuffer());
+        if (mesh.getIndexType() == GL_UNSIGNED_SHORT)
+        {
+            std::vector<unsigned short> shortIndices(mesh.getIndexCount());
+            glGetBufferSubData(GL_COPY_READ_BUFFER, 0, shortIndices.size() * sizeof(unsigned short), shortIndices.data());
+            for (std::size_t j = 0; j < shortIndices.size(); ++j)
+                out[j] = shortIndices[j] == mesh.getRestartIndex() && primitiveMode == GL_TRIANGLE_STRIP ? 0xFFFFFFFFu : shortIndices[j];
+        }
+        else
+        {
+            glGetBufferSubData(GL_COPY_READ_BUFFER, 0, (GLsizeiptr)mesh.getIndexCount() * sizeof(GLuint), out);
+        }
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    std::vector<GLuint> chainData;
+    for (std::size_t c = 0; c < chains.size(); ++c)
+    {
+        chainData.push_back(chainFirstLevel[c]);
+        chainData.push_back((GLuint)chains[c]->levels.size());
+    }
+    std::vector<float> errors;
+    for (const Level &level : levels)
+        errors.push_back(level.maxError);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, chainBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, chainData.size() * sizeof(GLuint), chainData.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, errorBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, errors.size() * sizeof(float), errors.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    setVertexAttributes(poolFormat);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+
+    // Instance attributes as in Planet::drawInstanced(); each command's
+    // baseInstance selects its slice of instanceBuffer.
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    GLsizei instanceStride = sizeof(PlanetInstance);
+    for (GLuint column = 0; column < 4; ++column)
+    {
+        glEnableVertexAttribArray(4 + column);
+        glVertexAttribPointer(4 + column, 4, GL_FLOAT, GL_FALSE, instanceStride, (void *)(offsetof(PlanetInstance, model) + column * sizeof(glm::vec4)));
+        glVertexAttribDivisor(4 + column, 1);
+    }
+    glEnableVertexAttribArray(8);
+    glVertexAttribPointer(8, 1, GL_FLOAT, GL_FALSE, instanceStride, (void *)offsetof(PlanetInstance, textureLayer));
+    glVertexAttribDivisor(8, 1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    readbackCommands[0].clear();
+    readbackCommands[1].clear();
+    commands.clear();
+    poolDirty = false;
+}
+
+void IndirectRenderer::cull(MeshCache &meshes, const glm::mat4 &viewProjection, const glm::vec3 &eye,
+                            float fovY, float viewportHeight, const LodSettings &lodSettings)
+{
+    PROFILE_ZONE("IndirectRenderer::cull");
+
+    if (poolDirty)
+        buildMeshPool(meshes);
+
+    // Last frame's instance counts, for takeTriangleCount() a frame from now.
+    std::vector<DrawElementsIndirectCommand> &readback = readbackCommands[frame % 2];
+    readback = commands;
+    GLuint readbackBuffer = readbackBuffers[frame % 2];
+    if (!commands.empty())
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, readbackBuffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand), nullptr, GL_STREAM_READ);
+        glBindBuffer(GL_COPY_READ_BUFFER, commandBuffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, commands.size() * sizeof(DrawElementsIndirectCommand));
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+    ++frame;
+
+    // Each (pass, level) command owns a slice of the instance buffer as large
+    // as the number of bodies of that pass using the level's chain.
+    std::vector<GLuint> bodiesPerChain(kPasses * chains.size(), 0);
+    for (const GpuBody &body : bodies)
+        ++bodiesPerChain[body.pass * chains.size() + body.chain];
+    commands.assign(kPasses * levels.size(), DrawElementsIndirectCommand());
+    GLuint instanceTotal = 0;
+    for (int pass = 0; pass < kPasses; ++pass)
+    {
+        passUsed[pass] = false;
+        for (std::size_t c = 0; c < chains.size(); ++c)
+        {
+            GLuint count = bodiesPerChain[pass * chains.size() + c];
+            passUsed[pass] = passUsed[pass] || count > 0;
+            for (std::size_t l = 0; l < chains[c]->levels.size(); ++l)
+            {
+                const Level &level = levels[chainFirstLevel[c] + l];
+                DrawElementsIndirectCommand &command = commands[pass * levels.size() + chainFirstLevel[c] + l];
+                command.count = level.indexCount;
+                command.instanceCount = 0;
+                command.firstIndex = level.firstIndex;
+                command.baseVertex = level.baseVertex;
+                command.baseInstance = instanceTotal;
+                instanceTotal += count;
+            }
+        }
+    }
+    if (bodies.empty())
+        return;
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, bodyBuffer);
+    if (bodies.size() > bodyCapacity)
+        bodyCapacity = std::max(bodies.size(), bodyCapacity * 2);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, bodyCapacity * sizeof(GpuBody), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, bodies.size() * sizeof(GpuBody), bodies.data());
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data(), GL_STREAM_DRAW);
+
+    if (instanceTotal > instanceCapacity)
+    {
+        instanceCapacity = std::max<std::size_t>(instanceTotal, instanceCapacity * 2);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, instanceBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, instanceCapacity * sizeof(PlanetInstance), nullptr, GL_STREAM_DRAW);
+    }
+
+    // A different body list starts every body at its finest level again, like a new LodMesh.
+    if (bodies.size() != bodyLevelCount)
+    {
+        std::vector<GLuint> zeros(bodies.size(), 0);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, bodyLevelBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, zeros.size() * sizeof(GLuint), zeros.data(), GL_DYNAMIC_DRAW);
+        bodyLevelCount = bodies.size();
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glm::vec4 frustumPlanes[6];
+    extractFrustumPlanes(viewProjection, frustumPlanes);
+
+    cullShader.use();
+    glUniform1ui(glGetUniformLocation(cullShader.ID, "bodyCount"), (GLuint)bodies.size());
+    glUniform1ui(glGetUniformLocation(cullShader.ID, "levelCount"), (GLuint)levels.size());
+    cullShader.setVec4Array("frustumPlanes", frustumPlanes, 6);
+    cullShader.setVec3("cameraPos", eye);
+    cullShader.setFloat("tanHalfFovY", std::tan(fovY * 0.5f));
+    cullShader.setFloat("viewportHeight", viewportHeight);
+    cullShader.setBool("lodEnabled", lodSettings.enabled);
+    cullShader.setFloat("maxErrorPx", lodSettings.maxErrorPx);
+    cullShader.setFloat("hysteresis", lodSettings.hysteresis);
+
+    GLuint bindings[] = {bodyBuffer, chainBuffer, errorBuffer, commandBuffer, instanceBuffer, bodyLevelBuffer};
+    for (GLuint i = 0; i < 6; ++i)
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i, bindings[i]);
+    glDispatchCompute((GLuint)((bodies.size() + 63) / 64), 1, 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+}
+
+void IndirectRenderer::draw(int pass, const Shader &shader)
+{
+    PROFILE_ZONE("IndirectRenderer::draw");
+    if (pass < 0 || pass >= kPasses || !passUsed[pass] || levels.empty())
+        return;
+
+    shader.setBool("instanced", true);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    // The pool's indices are 32-bit, so strips restart at the fixed index 0xFFFFFFFF.
+    if (primitiveMode == GL_TRIANGLE_STRIP)
+        glEnable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+    glMultiDrawElementsIndirect(primitiveMode, GL_UNSIGNED_INT,
+                                (const void *)(pass * levels.size() * sizeof(DrawElementsIndirectCommand)),
+                                (GLsizei)levels.size(), 0);
+    if (primitiveMode == GL_TRIANGLE_STRIP)
+        glDisable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+std::size_t IndirectRenderer::takeTriangleCount()
+{
+    // Copied by the cull() before last, so the GPU is normally done with it.
+    const std::vector<DrawElementsIndirectCommand> &layout = readbackCommands[frame % 2];
+    if (layout.empty() || layout.size() != kPasses * levels.size())
+        return 0;
+
+    std::vector<DrawElementsIndirectCommand> counts(layout.size());
+    glBindBuffer(GL_COPY_READ_BUFFER, readbackBuffers[frame % 2]);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, counts.size() * sizeof(DrawElementsIndirectCommand), counts.data());
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+    std::size_t triangles = 0;
+    for (std::size_t i = 0; i < counts.size(); ++i)
+        triangles += (std::size_t)counts[i].instanceCount * levels[i % levels.size()].triangles;
+    return triangles;
+}
@@ -0,0 +1,71 @@
+#include "../include/instance_batch.h"
+#include "../include/profiler.h"
+
+#include <algorithm>
+
+InstanceBatch::~InstanceBatch()
+{
+    if (buffer)
+        glDeleteBuffers(1, &buffer);
+}
+
+void InstanceBatch::add(MeshHandle mesh, const glm::mat4 &model, int textureLayer)
+{
+    if (!mesh)
+        return;
+    Entry entry;
+    entry.mesh = mesh;
+    entry.instance.model = model;
+    entry.instance.textureLayer = (float)textureLayer;
+    entry.instance.padding[0] = entry.instance.padding[1] = entry.instance.padding[2] = 0.0f;
+    entries.push_back(entry);
+}
+
+std::size_t InstanceBatch::draw(MeshCache &meshes, const Shader &shader, bool instanced)
+{
+    PROFILE_ZONE("InstanceBatch::draw");
+    if (entries.empty())
+        return 0;
+
+    if (!instanced)
+    {
+        shader.setBool("instanced", false);
+        for (const Entry &entry : entries)
+        {
+            shader.setMat4("model", entry.instance.model);
+            shader.setFloat("textureLayer", entry.instance.textureLayer);
+            meshes.draw(entry.mesh);
+        }
+        return entries.size();
+    }
+
+    // Group by mesh; stable so instances of a mesh keep their submission order.
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b)
+                     { return a.mesh.id < b.mesh.id; });
+    upload.resize(entries.size());
+    for (std::size_t i = 0; i < entries.size(); ++i)
+        upload[i] = entries[i].instance;
+
+    if (!buffer)
+        glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    if (upload.size() > capacity)
+        capacity = std::max(upload.size(), capacity * 2);
+    // Orphan last frame's storage rather than wait for draws still reading it.
+    glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(PlanetInstance), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, upload.size() * sizeof(PlanetInstance), upload.data());
+
+    shader.setBool("instanced", true);
+    std::size_t draws = 0;
+    for (std::size_t first = 0; first < entries.size();)
+    {
+        std::size_t end = first + 1;
+        while (end < entries.size() && entries[end].mesh == entries[first].mesh)
+            ++end;
+        meshes.drawInstanced(entries[first].mesh, buffer, (GLintptr)(first * sizeof(PlanetInstance)), (GLsizei)(end - first));
+        ++draws;
+        first = end;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return draws;
+}
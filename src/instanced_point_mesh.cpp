@@ -0,0 +1,78 @@
+#include "../include/instanced_point_mesh.h"
+#include "../include/planet.h"
+#include "../include/profiler.h"
+
+InstancedPointMesh::InstancedPointMesh(GLuint instanceBuffer)
+    : shader("shaders/nbody.vert", "shaders/asteroid.frag")
+{
+    MeshData sphere = generateIcosphere(1.0f, 1);
+    meshIndexCount = (GLsizei)sphere.indices.size();
+    glGenBuffers(1, &meshVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, meshVBO);
+    glBufferData(GL_ARRAY_BUFFER, sphere.positions.size() * sizeof(glm::vec3), sphere.positions.data(), GL_STATIC_DRAW);
+    glGenBuffers(1, &meshEBO);
+
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void *)0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshEBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sphere.indices.size() * sizeof(unsigned int), sphere.indices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glEnableVertexAttribArray(4);
+    glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void *)0);
+    glVertexAttribDivisor(4, 1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+InstancedPointMesh::~InstancedPointMesh()
+{
+    glDeleteVertexArrays(1, &vao);
+    GLuint mesh[] = {meshVBO, meshEBO};
+    glDeleteBuffers(2, mesh);
+    glDeleteProgram(shader.ID);
+}
+
+void InstancedPointMesh::draw(const glm::mat4 &view, const glm::mat4 &projection, const glm::vec3 &lightPos, float viewportHeight,
+                              float size, bool points, std::size_t count)
+{
+    PROFILE_ZONE("InstancedPointMesh::draw");
+    if (count == 0)
+        return;
+
+    shader.use();
+    shader.setMat4("view", view);
+    shader.setMat4("projection", projection);
+    shader.setVec3("lightPos", lightPos);
+    shader.setFloat("bodySize", size);
+    shader.setBool("points", points);
+    shader.setFloat("pointScale", viewportHeight * projection[1][1]); // diameter in pixels at w = 1
+
+    glBindVertexArray(vao);
+    if (points)
+    {
+        glEnable(GL_PROGRAM_POINT_SIZE);
+        glDrawArraysInstanced(GL_POINTS, 0, 1, (GLsizei)count);
+        glDisable(GL_PROGRAM_POINT_SIZE);
+    }
+    else
+    {
+        glDrawElementsInstanced(GL_TRIANGLES, meshIndexCount, GL_UNSIGNED_INT, nullptr, (GLsizei)count);
+    }
+    glBindVertexArray(0);
+}
+
+std::size_t InstancedPointMesh::gpuBytes() const
+{
+    std::size_t bytes = 0;
+    GLint size = 0;
+    for (GLuint buffer : {meshVBO, meshEBO})
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+        bytes += (std::size_t)size;
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    return bytes;
+}
@@ -0,0 +1,376 @@
+#include "../include/kepler.h"
+#include "../include/parallel.h"
+#include "../include/profiler.h"
+#include "../include/simd_math.h"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef SIMD_MATH_X86
+#define KEPLER_X86_KERNELS 1
+#endif
+
+namespace
+{
+    const double kTwoPi = 6.28318530717958647693;
+
+    // A Halley step under this leaves an error under ~1e-20 for the next,
+    // and updating sin E and cos E to first order in it is exact to 5e-17.
+    const double kConverged = 1e-8;
+
+    // Parallel::threadCount()'s minimum; starting a thread costs about 1000 orbits of scalar work.
+    const std::size_t kMinOrbitsPerThread = 16384;
+
+    struct Orbits
+    {
+        const double *meanAnomaly, *epoch, *meanMotion, *e, *a, *b;
+        const double *px, *py, *pz, *qx, *qy, *qz;
+    };
+
+    struct States
+    {
+        double *x, *y, *z, *vx, *vy, *vz; // velocities may be null
+    };
+
+    using Kernel = void (*)(const Orbits &, const States &, std::size_t, std::size_t, double, int);
+
+    double reduceAngle(double angle)
+    {
+        return angle - kTwoPi * std::nearbyint(angle / kTwoPi);
+    }
+
+    void writeState(const Orbits &orbits, const States &states, std::size_t i, double s, double c)
+    {
+        double e = orbits.e[i];
+        double u = orbits.a[i] * (c - e), v = orbits.b[i] * s;
+        states.x[i] = u * orbits.px[i] + v * orbits.qx[i];
+        states.y[i] = u * orbits.py[i] + v * orbits.qy[i];
+        states.z[i] = u * orbits.pz[i] + v * orbits.qz[i];
+        if (states.vx)
+        {
+            double rate = orbits.meanMotion[i] / (1.0 - e * c); // dE/dt
+            double du = -orbits.a[i] * s * rate, dv = orbits.b[i] * c * rate;
+            states.vx[i] = du * orbits.px[i] + dv * orbits.qx[i];
+            states.vy[i] = du * orbits.py[i] + dv * orbits.qy[i];
+            states.vz[i] = du * orbits.pz[i] + dv * orbits.qz[i];
+        }
+    }
+
+    void scalarRange(const Orbits &orbits, const States &states, std::size_t begin, std::size_t end, double t, int maxIterations)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            double s, c;
+            solveKepler(orbits.meanAnomaly[i] + orbits.meanMotion[i] * (t - orbits.epoch[i]), orbits.e[i], maxIterations, &s, &c);
+            writeState(orbits, states, i, s, c);
+        }
+    }
+
+#ifdef KEPLER_X86_KERNELS
+    using simd::sinCos4;
+    using simd::sinCos8;
+
+    __attribute__((target("avx2,fma")))
+    void avx2Range(const Orbits &orbits, const States &states, std::size_t begin, std::size_t end, double t, int maxIterations)
+    {
+        const __m256d signBit = _mm256_set1_pd(-0.0);
+        const __m256d time = _mm256_set1_pd(t);
+        std::size_t i = begin;
+        for (; i + 4 <= end; i += 4)
+        {
+            __m256d m = _mm256_fmadd_pd(_mm256_loadu_pd(orbits.meanMotion + i), _mm256_sub_pd(time, _mm256_loadu_pd(orbits.epoch + i)),
+                                        _mm256_loadu_pd(orbits.meanAnomaly + i));
+            m = _mm256_fnmadd_pd(_mm256_set1_pd(kTwoPi), _mm256_round_pd(_mm256_mul_pd(m, _mm256_set1_pd(1.0 / kTwoPi)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC), m);
+            __m256d e = _mm256_loadu_pd(orbits.e + i);
+
+            // Danby's starter, then Halley's method on f(E) = E - e sin E - M.
+            __m256d ecc = _mm256_or_pd(_mm256_mul_pd(_mm256_set1_pd(0.85), e), _mm256_and_pd(m, signBit));
+            __m256d E = _mm256_add_pd(m, ecc);
+            __m256d s, c;
+            bool converged = false;
+            for (int k = 0; k < maxIterations && !converged; ++k)
+            {
+                sinCos4(E, s, c);
+                __m256d es = _mm256_mul_pd(e, s);
+                __m256d f = _mm256_sub_pd(_mm256_sub_pd(E, es), m);
+                __m256d df = _mm256_fnmadd_pd(e, c, _mm256_set1_pd(1.0));
+                __m256d denominator = _mm256_fnmadd_pd(_mm256_mul_pd(_mm256_set1_pd(0.5), f), es, _mm256_mul_pd(df, df));
+                __m256d step = _mm256_div_pd(_mm256_mul_pd(f, df), denominator);
+                E = _mm256_sub_pd(E, step);
+                __m256d sinE = _mm256_fnmadd_pd(c, step, s); // sin(E - step), to first order
+                c = _mm256_fmadd_pd(s, step, c);
+                s = sinE;
+                converged = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_andnot_pd(signBit, step), _mm256_set1_pd(kConverged), _CMP_GE_OQ)) == 0;
+            }
+            if (!converged)
+                sinCos4(E, s, c);
+
+            __m256d a = _mm256_loadu_pd(orbits.a + i);
+            __m256d u = _mm256_mul_pd(a, _mm256_sub_pd(c, e));
+            __m256d v = _mm256_mul_pd(_mm256_loadu_pd(orbits.b + i), s);
+            _mm256_storeu_pd(states.x + i, _mm256_fmadd_pd(u, _mm256_loadu_pd(orbits.px + i), _mm256_mul_pd(v, _mm256_loadu_pd(orbits.qx + i))));
+            _mm256_storeu_pd(states.y + i, _mm256_fmadd_pd(u, _mm256_loadu_pd(orbits.py + i), _mm256_mul_pd(v, _mm256_loadu_pd(orbits.qy + i))));
+            _mm256_storeu_pd(states.z + i, _mm256_fmadd_pd(u, _mm256_loadu_pd(orbits.pz + i), _mm256_mul_pd(v, _mm256_loadu_pd(orbits.qz + i))));
+            if (states.vx)
+            {
+                __m256d rate = _mm256_div_pd(_mm256_loadu_pd(orbits.meanMotion + i), _mm256_fnmadd_pd(e, c, _mm256_set1_pd(1.0)));
+                __m256d du = _mm256_xor_pd(_mm256_mul_pd(_mm256_mul_pd(a, s), rate), signBit);
+                __m256d dv = _mm256_mul_pd(_mm256_mul_pd(_mm256_loadu_pd(orbits.b + i), c), rate);
+                _mm256_storeu_pd(states.vx + i, _mm256_fmadd_pd(du, _mm256_loadu_pd(orbits.px + i), _mm256_mul_pd(dv, _mm256_loadu_pd(orbits.qx + i))));
+                _mm256_storeu_pd(states.vy + i, _mm256_fmadd_pd(du, _mm256_loadu_pd(orbits.py + i), _mm256_mul_pd(dv, _mm256_loadu_pd(orbits.qy + i))));
+                _mm256_storeu_pd(states.vz + i, _mm256_fmadd_pd(du, _mm256_loadu_pd(orbits.pz + i), _mm256_mul_pd(dv, _mm256_loadu_pd(orbits.qz + i))));
+            }
+        }
+        scalarRange(orbits, states, i, end, t, maxIterations);
+    }
+
+    __attribute__((target("avx512f")))
+    void avx512Range(const Orbits &orbits, const States &states, std::size_t begin, std::size_t end, double t, int maxIterations)
+    {
+        const __m512d zero = _mm512_setzero_pd();
+        const __m512d time = _mm512_set1_pd(t);
+        std::size_t i = begin;
+        for (; i + 8 <= end; i += 8)
+        {
+            __m512d m = _mm512_fmadd_pd(_mm512_loadu_pd(orbits.meanMotion + i), _mm512_sub_pd(time, _mm512_loadu_pd(orbits.epoch + i)),
+                                        _mm512_loadu_pd(orbits.meanAnomaly + i));
+            m = _mm512_fnmadd_pd(_mm512_set1_pd(kTwoPi), _mm512_maskz_roundscale_pd(0xff, _mm512_mul_pd(m, _mm512_set1_pd(1.0 / kTwoPi)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC), m);
+            __m512d e = _mm512_loadu_pd(orbits.e + i);
+
+            // As avx2Range().
+            __m512d ecc = _mm512_mul_pd(_mm512_set1_pd(0.85), e);
+            ecc = _mm512_mask_sub_pd(ecc, _mm512_cmp_pd_mask(m, zero, _CMP_LT_OQ), zero, ecc);
+            __m512d E = _mm512_add_pd(m, ecc);
+            __m512d s, c;
+            bool converged = false;
+            for (int k = 0; k < maxIterations && !converged; ++k)
+            {
+                sinCos8(E, s, c);
+                __m512d es = _mm512_mul_pd(e, s);
+                __m512d f = _mm512_sub_pd(_mm512_sub_pd(E, es), m);
+                __m512d df = _mm512_fnmadd_pd(e, c, _mm512_set1_pd(1.0));
+                __m512d denominator = _mm512_fnmadd_pd(_mm512_mul_pd(_mm512_set1_pd(0.5), f), es, _mm512_mul_pd(df, df));
+                __m512d step = _mm512_div_pd(_mm512_mul_pd(f, df), denominator);
+                E = _mm512_sub_pd(E, step);
+                __m512d sinE = _mm512_fnmadd_pd(c, step, s);
+                c = _mm512_fmadd_pd(s, step, c);
+                s = sinE;
+                converged = _mm512_cmp_pd_mask(_mm512_abs_pd(step), _mm512_set1_pd(kConverged), _CMP_GE_OQ) == 0;
+            }
+            if (!converged)
+                sinCos8(E, s, c);
+
+            __m512d a = _mm512_loadu_pd(orbits.a + i);
+            __m512d u = _mm512_mul_pd(a, _mm512_sub_pd(c, e));
+            __m512d v = _mm512_mul_pd(_mm512_loadu_pd(orbits.b + i), s);
+            _mm512_storeu_pd(states.x + i, _mm512_fmadd_pd(u, _mm512_loadu_pd(orbits.px + i), _mm512_mul_pd(v, _mm512_loadu_pd(orbits.qx + i))));
+            _mm512_storeu_pd(states.y + i, _mm512_fmadd_pd(u, _mm512_loadu_pd(orbits.py + i), _mm512_mul_pd(v, _mm512_loadu_pd(orbits.qy + i))));
+            _mm512_storeu_pd(states.z + i, _mm512_fmadd_pd(u, _mm512_loadu_pd(orbits.pz + i), _mm512_mul_pd(v, _mm512_loadu_pd(orbits.qz + i))));
+            if (states.vx)
+            {
+                __m512d rate = _mm512_div_pd(_mm512_loadu_pd(orbits.meanMotion + i), _mm512_fnmadd_pd(e, c, _mm512_set1_pd(1.0)));
+                __m512d du = _mm512_sub_pd(zero, _mm512_mul_pd(_mm512_mul_pd(a, s), rate));
+                __m512d dv = _mm512_mul_pd(_mm512_mul_pd(_mm512_loadu_pd(orbits.b + i), c), rate);
+                _mm512_storeu_pd(states.vx + i, _mm512_fmadd_pd(du, _mm512_loadu_pd(orbits.px + i), _mm512_mul_pd(dv, _mm512_loadu_pd(orbits.qx + i))));
+                _mm512_storeu_pd(states.vy + i, _mm512_fmadd_pd(du, _mm512_loadu_pd(orbits.py + i), _mm512_mul_pd(dv, _mm512_loadu_pd(orbits.qy + i))));
+                _mm512_storeu_pd(states.vz + i, _mm512_fmadd_pd(du, _mm512_loadu_pd(orbits.pz + i), _mm512_mul_pd(dv, _mm512_loadu_pd(orbits.qz + i))));
+            }
+        }
+        scalarRange(orbits, states, i, end, t, maxIterations);
+    }
+#endif
+
+    Kernel selectKernel(NBodyKernel kernel)
+    {
+#ifdef KEPLER_X86_KERNELS
+        if (kernel == NBodyKernel::Avx512)
+            return avx512Range;
+        if (kernel == NBodyKernel::Avx2)
+            return avx2Range;
+#endif
+        return scalarRange;
+    }
+}
+
+double solveKepler(double meanAnomaly, double eccentricity, int maxIterations, double *sinE, double *cosE)
+{
+    double m = reduceAngle(meanAnomaly);
+    double E = m + (m < 0.0 ? -0.85 : 0.85) * eccentricity;
+    double s = 0.0, c = 1.0;
+    bool converged = false;
+    for (int k = 0; k < maxIterations && !converged; ++k)
+    {
+        s = std::sin(E);
+        c = std::cos(E);
+        double f = E - eccentricity * s - m;
+        double df = 1.0 - eccentricity * c;
+        double step = f * df / (df * df - 0.5 * f * eccentricity * s);
+        E -= step;
+        double sinStep = s - c * step; // to first order, as in the SIMD kernels
+        c += s * step;
+        s = sinStep;
+        converged = std::abs(step) < kConverged;
+    }
+    if (!converged)
+    {
+        s = std::sin(E);
+        c = std::cos(E);
+    }
+    if (sinE)
+        *sinE = s;
+    if (cosE)
+        *cosE = c;
+    return E;
+}
+
+void perifocalBasis(double inclination, double ascendingNode, double periapsis, glm::dvec3 &p, glm::dvec3 &q)
+{
+    double cosNode = std::cos(ascendingNode), sinNode = std::sin(ascendingNode);
+    double cosPeri = std::cos(periapsis), sinPeri = std::sin(periapsis);
+    double cosInc = std::cos(inclination), sinInc = std::sin(inclination);
+    // Ecliptic (z up) components, written as scene (x, y, z) = ecliptic (x, z, y).
+    p = glm::dvec3(cosNode * cosPeri - sinNode * sinPeri * cosInc, sinPeri * sinInc, sinNode * cosPeri + cosNode * sinPeri * cosInc);
+    q = glm::dvec3(-cosNode * sinPeri - sinNode * cosPeri * cosInc, cosPeri * sinInc, -sinNode * sinPeri + cosNode * cosPeri * cosInc);
+}
+
+void keplerState(const OrbitalElements &elements, double t, glm::dvec3 &position, glm::dvec3 *velocity)
+{
+    glm::dvec3 p, q;
+    perifocalBasis(elements.inclination, elements.ascendingNode, elements.periapsis, p, q);
+    double e = elements.eccentricity;
+    double a = elements.semiMajorAxis, b = a * std::sqrt(1.0 - e * e);
+    double s, c;
+    solveKepler(elements.meanAnomaly + elements.meanMotion * (t - elements.epoch), e, 8, &s, &c);
+    position = a * (c - e) * p + b * s * q;
+    if (velocity)
+    {
+        double rate = elements.meanMotion / (1.0 - e * c);
+        *velocity = (-a * s * rate) * p + (b * c * rate) * q;
+    }
+}
+
+bool osculatingElements(const glm::dvec3 &position, const glm::dvec3 &velocity, double gm, double t, OrbitalElements &elements)
+{
+    // In ecliptic (z up) axes, the reverse of perifocalBasis().
+    glm::dvec3 r(position.x, position.z, position.y), v(velocity.x, velocity.z, velocity.y);
+    double distance = glm::length(r);
+    double energy = 0.5 * glm::dot(v, v) - gm / distance;
+    glm::dvec3 h = glm::cross(r, v);
+    double hLength = glm::length(h);
+    if (!(energy < 0.0) || hLength <= 0.0)
+        return false;
+
+    glm::dvec3 normal = h / hLength;
+    glm::dvec3 node(-h.y, h.x, 0.0); // z x h
+    double nodeLength = glm::length(node);
+    node = nodeLength > 1e-12 * hLength ? node / nodeLength : glm::dvec3(1.0, 0.0, 0.0);
+    glm::dvec3 eccentricity = glm::cross(v, h) / gm - r / distance;
+    double e = glm::length(eccentricity);
+    glm::dvec3 periapsis = e > 1e-12 ? eccentricity / e : node;
+
+    double a = -gm / (2.0 * energy);
+    double trueAnomaly = std::atan2(glm::dot(r, glm::cross(normal, periapsis)), glm::dot(r, periapsis));
+    double E = std::atan2(std::sqrt(std::max(1.0 - e * e, 0.0)) * std::sin(trueAnomaly), e + std::cos(trueAnomaly));
+
+    elements.semiMajorAxis = a;
+    elements.eccentricity = e;
+    elements.inclination = std::acos(std::min(std::max(normal.z, -1.0), 1.0));
+    elements.ascendingNode = std::atan2(node.y, node.x);
+    elements.periapsis = std::atan2(glm::dot(periapsis, glm::cross(normal, node)), glm::dot(periapsis, node));
+    elements.meanAnomaly = E - e * std::sin(E);
+    elements.epoch = t;
+    elements.meanMotion = std::sqrt(gm / (a * a * a));
+    return true;
+}
+
+KeplerPropagator::KeplerPropagator(const KeplerSettings &keplerSettings)
+    : settings(keplerSettings)
+{
+    activeKernel = resolveGravityKernel(settings.kernel);
+}
+
+std::size_t KeplerPropagator::add(const OrbitalElements &elements)
+{
+    resize(size() + 1);
+    set(size() - 1, elements);
+    return size() - 1;
+}
+
+void KeplerPropagator::set(std::size_t i, const OrbitalElements &elements)
+{
+    double e = std::min(std::max(elements.eccentricity, 0.0), 0.999999);
+    glm::dvec3 p, q;
+    perifocalBasis(elements.inclination, elements.ascendingNode, elements.periapsis, p, q);
+    meanAnomaly[i] = elements.meanAnomaly;
+    epoch[i] = elements.epoch;
+    meanMotion[i] = elements.meanMotion;
+    eccentricity[i] = e;
+    semiMajorAxis[i] = elements.semiMajorAxis;
+    semiMinorAxis[i] = elements.semiMajorAxis * std::sqrt(1.0 - e * e);
+    px[i] = p.x;
+    py[i] = p.y;
+    pz[i] = p.z;
+    qx[i] = q.x;
+    qy[i] = q.y;
+    qz[i] = q.z;
+    inclination[i] = elements.inclination;
+    ascendingNode[i] = elements.ascendingNode;
+    periapsis[i] = elements.periapsis;
+}
+
+void KeplerPropagator::reserve(std::size_t count)
+{
+    for (std::vector<double> *values : columns())
+        values->reserve(count);
+}
+
+void KeplerPropagator::clear()
+{
+    for (std::vector<double> *values : columns())
+        values->clear();
+}
+
+void KeplerPropagator::resize(std::size_t count)
+{
+    // The default OrbitalElements: a unit circle in the reference plane.
+    const double defaults[kColumns] = {0.0, 0.0, 1.0, 0.0, 1.0, 1.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0};
+    std::array<std::vector<double> *, kColumns> values = columns();
+    for (int c = 0; c < kColumns; ++c)
+        values[c]->resize(count, defaults[c]);
+}
+
+std::array<std::vector<double> *, KeplerPropagator::kColumns> KeplerPropagator::columns()
+{
+    return {&meanAnomaly, &epoch, &meanMotion, &eccentricity, &semiMajorAxis, &semiMinorAxis,
+            &px, &py, &pz, &qx, &qy, &qz, &inclination, &ascendingNode, &periapsis};
+}
+
+OrbitalElements KeplerPropagator::elements(std::size_t i) const
+{
+    OrbitalElements result;
+    result.semiMajorAxis = semiMajorAxis[i];
+    result.eccentricity = eccentricity[i];
+    result.inclination = inclination[i];
+    result.ascendingNode = ascendingNode[i];
+    result.periapsis = periapsis[i];
+    result.meanAnomaly = meanAnomaly[i];
+    result.epoch = epoch[i];
+    result.meanMotion = meanMotion[i];
+    return result;
+}
+
+void KeplerPropagator::propagate(double t, double *x, double *y, double *z, double *vx, double *vy, double *vz) const
+{
+    PROFILE_ZONE("KeplerPropagator::propagate");
+    const std::size_t count = size();
+    Orbits orbits = {meanAnomaly.data(), epoch.data(), meanMotion.data(), eccentricity.data(), semiMajorAxis.data(), semiMinorAxis.data(),
+                     px.data(), py.data(), pz.data(), qx.data(), qy.data(), qz.data()};
+    bool velocities = vx && vy && vz;
+    States states = {x, y, z, velocities ? vx : nullptr, velocities ? vy : nullptr, velocities ? vz : nullptr};
+    Kernel kernel = selectKernel(activeKernel);
+    int maxIterations = std::max(settings.maxIterations, 1);
+
+    unsigned int threads = Parallel::threadCount(settings.threads, count, kMinOrbitsPerThread);
+    Parallel::parallelSlices(threads, count, [&](unsigned int, std::size_t begin, std::size_t end)
+                             { kernel(orbits, states, begin, end, t, maxIterations); });
+}
@@ -0,0 +1,43 @@
+#include "../include/lod.h"
+
+#include <cmath>
+
+float projectedRadiusPx(const glm::vec3 &center, float radius, const glm::vec3 &eye, float fovY, float viewportHeight)
+{
+    float distance = glm::length(center - eye);
+    if (distance <= radius)
+        return viewportHeight; // camera inside the sphere
+
+    // Tangent of the angular radius (asin(r / d)) relative to the half field of view.
+    float tanAngle = radius / std::sqrt(distance * distance - radius * radius);
+    return tanAngle / std::tan(fovY * 0.5f) * viewportHeight * 0.5f;
+}
+
+MeshHandle LodMesh::select(float radiusPx, const LodSettings &settings)
+{
+    if (!*this)
+        return MeshHandle();
+
+    const std::vector<LodLevel> &levels = chain->levels;
+    int last = (int)levels.size() - 1;
+    if (level > last)
+        level = last;
+
+    if (!settings.enabled)
+    {
+        level = 0;
+        return levels[0].mesh;
+    }
+
+    float refineAbove = settings.maxErrorPx * (1.0f + settings.hysteresis);
+    float coarsenBelow = settings.maxErrorPx * (1.0f - settings.hysteresis);
+
+    // A level refined away from is over the upper bound, so it can't pass the
+    // lower one in the same call: the two loops never undo each other.
+    while (level > 0 && levels[level].maxError * radiusPx > refineAbove)
+        level--;
+    while (level < last && levels[level + 1].maxError * radiusPx < coarsenBelow)
+        level++;
+
+    return levels[level].mesh;
+}
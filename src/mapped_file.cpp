@@ -0,0 +1,61 @@
+#include "../include/mapped_file.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string &path)
+{
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+        return;
+    file = handle;
+    LARGE_INTEGER fileSize;
+    opened = GetFileSizeEx(handle, &fileSize) != 0;
+    bytes = opened ? (std::size_t)fileSize.QuadPart : 0;
+    if (bytes == 0)
+        return;
+    mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping)
+        view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+    struct stat info;
+    opened = ::fstat(fd, &info) == 0;
+    bytes = opened ? (std::size_t)info.st_size : 0;
+    if (bytes > 0)
+    {
+        view = ::mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view == MAP_FAILED)
+            view = nullptr;
+        else
+            ::madvise(view, bytes, MADV_WILLNEED); // readers touch most pages, often from several threads
+    }
+    ::close(fd);
+#endif
+    if (bytes > 0 && !view)
+        opened = false;
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+    if (view)
+        UnmapViewOfFile(view);
+    if (mapping)
+        CloseHandle((HANDLE)mapping);
+    if (file)
+        CloseHandle((HANDLE)file);
+#else
+    if (view)
+        ::munmap(view, bytes);
+#endif
+}
@@ -0,0 +1,99 @@
+#include "../include/mesh_cache.h"
+
+#include <algorithm>
+
+MeshHandle MeshCache::acquireSphere(unsigned int rings, unsigned int sectors)
+{
+    return acquire(SphereType::UV, rings, sectors);
+}
+
+MeshHandle MeshCache::acquireIcosphere(unsigned int subdivisions)
+{
+    return acquire(SphereType::Icosphere, subdivisions, 0);
+}
+
+MeshHandle MeshCache::acquireCubeSphere(unsigned int segments)
+{
+    return acquire(SphereType::CubeSphere, segments, 0);
+}
+
+MeshHandle MeshCache::acquire(SphereType type, unsigned int a, unsigned int b)
+{
+    // A handful of tessellations at most: a linear scan beats hashing here.
+    for (std::size_t i = 0; i < entries.size(); ++i)
+    {
+        if (entries[i].type == type && entries[i].a == a && entries[i].b == b)
+            return MeshHandle{(int)i};
+    }
+
+    MeshData mesh;
+    switch (type)
+    {
+    case SphereType::UV:
+        mesh = generateUVSphere(1.0f, a, b);
+        break;
+    case SphereType::Icosphere:
+        mesh = generateIcosphere(1.0f, a);
+        break;
+    case SphereType::CubeSphere:
+        mesh = generateCubeSphere(1.0f, a);
+        break;
+    }
+    // Measured on the plain triangle list, before strips may replace it.
+    float error = sphereMaxRadialError(mesh);
+    prepareMesh(mesh, options);
+
+    entries.push_back(Entry{type, a, b, std::make_unique<Planet>(mesh, options.format), error});
+    return MeshHandle{(int)entries.size() - 1};
+}
+
+const LodChain *MeshCache::acquireSphereLod(unsigned int finestRings)
+{
+    for (const auto &chain : lodChains)
+    {
+        if (chain.first == finestRings)
+            return chain.second.get();
+    }
+
+    auto chain = std::make_unique<LodChain>();
+    for (unsigned int rings = finestRings;; rings = std::max(8u, rings * 3 / 4))
+    {
+        MeshHandle mesh = acquireSphere(rings, rings);
+        chain->levels.push_back(LodLevel{mesh, maxError(mesh)});
+        if (rings <= 8)
+            break;
+    }
+
+    lodChains.emplace_back(finestRings, std::move(chain));
+    return lodChains.back().second.get();
+}
+
+Planet &MeshCache::get(MeshHandle handle)
+{
+    return *entries[handle.id].mesh;
+}
+
+void MeshCache::draw(MeshHandle handle)
+{
+    if (handle)
+    {
+        entries[handle.id].mesh->draw();
+        trianglesDrawn += entries[handle.id].mesh->getTriangleCount();
+    }
+}
+
+void MeshCache::drawInstanced(MeshHandle handle, GLuint instanceBuffer, GLintptr offset, GLsizei instanceCount)
+{
+    if (handle && instanceCount > 0)
+    {
+        entries[handle.id].mesh->drawInstanced(instanceBuffer, offset, instanceCount);
+        trianglesDrawn += (std::size_t)entries[handle.id].mesh->getTriangleCount() * instanceCount;
+    }
+}
+
+std::size_t MeshCache::takeTriangleCount()
+{
+    std::size_t count = trianglesDrawn;
+    trianglesDrawn = 0;
+    return count;
+}
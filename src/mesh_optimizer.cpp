@@ -0,0 +1,340 @@
+#include "../include/mesh_optimizer.h"
+#include "../include/profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+
+namespace
+{
+    // Forsyth's published tuning constants.
+    const float kCacheDecayPower = 1.5f;
+    const float kLastTriangleScore = 0.75f;
+    const float kValenceBoostScale = 2.0f;
+    const float kValenceBoostPower = 0.5f;
+
+    float vertexScore(int cachePosition, unsigned int remainingTriangles, unsigned int cacheSize)
+    {
+        if (remainingTriangles == 0)
+            return -1.0f; // nothing left to draw with this vertex
+
+        float score = 0.0f;
+        if (cachePosition >= 0)
+        {
+            // The three vertices of the last triangle get a fixed score so the
+            // next triangle doesn't simply reuse the same edge every time.
+            if (cachePosition < 3)
+                score = kLastTriangleScore;
+            else
+                score = std::pow(1.0f - (float)(cachePosition - 3) / (float)(cacheSize - 3), kCacheDecayPower);
+        }
+
+        // Favour vertices with few triangles left so they can leave the cache for good.
+        score += kValenceBoostScale * std::pow((float)remainingTriangles, -kValenceBoostPower);
+        return score;
+    }
+
+    std::uint64_t edgeKey(unsigned int from, unsigned int to)
+    {
+        return ((std::uint64_t)from << 32) | to;
+    }
+}
+
+std::size_t MeshOptimizer::removeDegenerateTriangles(std::vector<unsigned int> &indices, const std::vector<glm::vec3> &positions)
+{
+    std::size_t write = 0;
+    for (std::size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        unsigned int a = indices[i], b = indices[i + 1], c = indices[i + 2];
+        if (a == b || b == c || a == c)
+            continue;
+
+        glm::vec3 ab = positions[b] - positions[a];
+        glm::vec3 bc = positions[c] - positions[b];
+        glm::vec3 ca = positions[a] - positions[c];
+        float ab2 = glm::dot(ab, ab), bc2 = glm::dot(bc, bc), ca2 = glm::dot(ca, ca);
+        float longest = std::max(ab2, std::max(bc2, ca2));
+        float shortest = std::min(ab2, std::min(bc2, ca2));
+        if (shortest <= longest * 1e-10f) // squared lengths, i.e. a 1e-5 edge ratio
+            continue;
+
+        indices[write++] = a;
+        indices[write++] = b;
+        indices[write++] = c;
+    }
+
+    std::size_t removed = (indices.size() - write) / 3;
+    indices.resize(write);
+    return removed;
+}
+
+void MeshOptimizer::optimizeVertexCache(std::vector<unsigned int> &indices, std::size_t vertexCount, unsigned int cacheSize)
+{
+    PROFILE_ZONE("MeshOptimizer::optimizeVertexCache");
+
+    std::size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || cacheSize < 4)
+        return;
+
+    // Vertex -> triangle adjacency in CSR form; each vertex's live triangles
+    // are kept at the front of its range so removal is a swap.
+    std::vector<unsigned int> remaining(vertexCount, 0);
+    for (unsigned int index : indices)
+        remaining[index]++;
+
+    std::vector<unsigned int> adjacencyOffset(vertexCount + 1, 0);
+    for (std::size_t v = 0; v < vertexCount; ++v)
+        adjacencyOffset[v + 1] = adjacencyOffset[v] + remaining[v];
+
+    std::vector<unsigned int> adjacency(indices.size());
+    std::vector<unsigned int> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+    for (std::size_t t = 0; t < triangleCount; ++t)
+    {
+        for (int k = 0; k < 3; ++k)
+            adjacency[fill[indices[t * 3 + k]]++] = (unsigned int)t;
+    }
+
+    std::vector<float> score(vertexCount);
+    for (std::size_t v = 0; v < vertexCount; ++v)
+        score[v] = vertexScore(-1, remaining[v], cacheSize);
+
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<char> emitted(triangleCount, 0);
+    for (std::size_t t = 0; t < triangleCount; ++t)
+        triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+
+    std::vector<unsigned int> cache, nextCache;
+    cache.reserve(cacheSize + 3);
+    nextCache.reserve(cacheSize + 3);
+
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+
+    std::size_t cursor = 0;
+    long long best = -1;
+    for (std::size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+    {
+        if (best < 0)
+        {
+            // Dead end: nothing in the cache has triangles left, so restart
+            // from the next unemitted triangle in input order.
+            while (emitted[cursor])
+                ++cursor;
+            best = (long long)cursor;
+        }
+
+        unsigned int triangle = (unsigned int)best;
+        const unsigned int *corners = &indices[triangle * 3];
+        output.insert(output.end(), corners, corners + 3);
+        emitted[triangle] = 1;
+
+        for (int k = 0; k < 3; ++k)
+        {
+            unsigned int v = corners[k];
+            unsigned int *begin = &adjacency[adjacencyOffset[v]];
+            unsigned int *end = begin + remaining[v];
+            unsigned int *slot = std::find(begin, end, triangle);
+            std::swap(*slot, *(end - 1));
+            remaining[v]--;
+        }
+
+        // LRU update: the emitted triangle's corners move to the front.
+        nextCache.assign(corners, corners + 3);
+        for (unsigned int v : cache)
+        {
+            if (v != corners[0] && v != corners[1] && v != corners[2])
+                nextCache.push_back(v);
+        }
+
+        // Rescore everything whose cache position changed (including evictions)...
+        for (std::size_t i = 0; i < nextCache.size(); ++i)
+        {
+            unsigned int v = nextCache[i];
+            int position = i < cacheSize ? (int)i : -1;
+            float newScore = vertexScore(position, remaining[v], cacheSize);
+            float delta = newScore - score[v];
+            score[v] = newScore;
+
+            unsigned int *begin = &adjacency[adjacencyOffset[v]];
+            for (unsigned int *it = begin; it != begin + remaining[v]; ++it)
+                triangleScore[*it] += delta;
+        }
+
+        if (nextCache.size() > cacheSize)
+            nextCache.resize(cacheSize);
+        cache.swap(nextCache);
+
+        // ...then pick the best triangle touching the cache.
+        best = -1;
+        float bestScore = -1.0f;
+        for (unsigned int v : cache)
+        {
+            unsigned int *begin = &adjacency[adjacencyOffset[v]];
+            for (unsigned int *it = begin; it != begin + remaining[v]; ++it)
+            {
+                if (triangleScore[*it] > bestScore)
+                {
+                    bestScore = triangleScore[*it];
+                    best = *it;
+                }
+            }
+        }
+    }
+
+    indices.swap(output);
+}
+
+std::vector<unsigned int> MeshOptimizer::optimizeVertexFetch(std::vector<unsigned int> &indices, std::size_t vertexCount)
+{
+    std::vector<unsigned int> remap(vertexCount, ~0u);
+    unsigned int next = 0;
+    for (unsigned int &index : indices)
+    {
+        if (remap[index] == ~0u)
+            remap[index] = next++;
+        index = remap[index];
+    }
+    return remap;
+}
+
+std::vector<unsigned int> MeshOptimizer::buildTriangleStrips(const std::vector<unsigned int> &indices, unsigned int restartIndex)
+{
+    PROFILE_ZONE("MeshOptimizer::buildTriangleStrips");
+
+    std::size_t triangleCount = indices.size() / 3;
+
+    // Each directed edge belongs to at most one triangle of a consistently wound mesh.
+    std::unordered_map<std::uint64_t, unsigned int> edgeOwner;
+    edgeOwner.reserve(indices.size());
+    for (std::size_t t = 0; t < triangleCount; ++t)
+    {
+        const unsigned int *c = &indices[t * 3];
+        edgeOwner[edgeKey(c[0], c[1])] = (unsigned int)t;
+        edgeOwner[edgeKey(c[1], c[2])] = (unsigned int)t;
+        edgeOwner[edgeKey(c[2], c[0])] = (unsigned int)t;
+    }
+
+    std::vector<char> used(triangleCount, 0);
+
+    // Unused triangle containing the directed edge from -> to, or -1.
+    auto neighbour = [&](unsigned int from, unsigned int to) -> long long
+    {
+        auto it = edgeOwner.find(edgeKey(from, to));
+        return (it != edgeOwner.end() && !used[it->second]) ? (long long)it->second : -1;
+    };
+    // Corner of triangle t that follows `to` in its winding.
+    auto thirdCorner = [&](unsigned int t, unsigned int to) -> unsigned int
+    {
+        const unsigned int *c = &indices[t * 3];
+        return c[0] == to ? c[1] : (c[1] == to ? c[2] : c[0]);
+    };
+
+    std::vector<unsigned int> strips;
+    strips.reserve(indices.size());
+    std::vector<unsigned int> strip;
+
+    for (std::size_t start = 0; start < triangleCount; ++start)
+    {
+        if (used[start])
+            continue;
+        used[start] = 1;
+
+        // Start on whichever rotation lets the strip continue.
+        const unsigned int *c = &indices[start * 3];
+        int rotation = 0;
+        for (int r = 0; r < 3; ++r)
+        {
+            if (neighbour(c[(r + 2) % 3], c[(r + 1) % 3]) >= 0)
+            {
+                rotation = r;
+                break;
+            }
+        }
+        strip.assign({c[rotation], c[(rotation + 1) % 3], c[(rotation + 2) % 3]});
+
+        // Triangle i of a strip is (s[i], s[i+1], s[i+2]) for even i and
+        // (s[i+1], s[i], s[i+2]) for odd i; the next triangle must own that edge.
+        for (;;)
+        {
+            std::size_t n = strip.size();
+            bool even = ((n - 2) % 2) == 0;
+            unsigned int from = even ? strip[n - 2] : strip[n - 1];
+            unsigned int to = even ? strip[n - 1] : strip[n - 2];
+            long long next = neighbour(from, to);
+            if (next < 0)
+                break;
+            used[next] = 1;
+            strip.push_back(thirdCorner((unsigned int)next, to));
+        }
+
+        if (!strips.empty())
+            strips.push_back(restartIndex);
+        strips.insert(strips.end(), strip.begin(), strip.end());
+    }
+
+    return strips;
+}
+
+MeshOptimizer::CacheStats MeshOptimizer::analyzeVertexCache(const std::vector<unsigned int> &indices, std::size_t vertexCount, unsigned int cacheSize)
+{
+    std::vector<unsigned int> timestamp(vertexCount, 0);
+    std::vector<char> referenced(vertexCount, 0);
+    unsigned int time = cacheSize + 1;
+    std::size_t misses = 0, unique = 0;
+    for (unsigned int index : indices)
+    {
+        // FIFO: an entry is still cached if fewer than cacheSize misses happened since it was loaded.
+        if (time - timestamp[index] > cacheSize)
+        {
+            timestamp[index] = time++;
+            misses++;
+        }
+        if (!referenced[index])
+        {
+            referenced[index] = 1;
+            unique++;
+        }
+    }
+
+    std::size_t triangles = indices.size() / 3;
+    CacheStats stats;
+    stats.acmr = triangles ? (float)misses / (float)triangles : 0.0f;
+    stats.atvr = unique ? (float)misses / (float)unique : 0.0f;
+    return stats;
+}
+
+MeshOptimizer::CacheStats MeshOptimizer::analyzeStripVertexCache(const std::vector<unsigned int> &strips, std::size_t vertexCount,
+                                                                 unsigned int restartIndex, unsigned int cacheSize)
+{
+    std::vector<unsigned int> timestamp(vertexCount, 0);
+    std::vector<char> referenced(vertexCount, 0);
+    unsigned int time = cacheSize + 1;
+    std::size_t misses = 0, unique = 0, triangles = 0, stripLength = 0;
+    for (unsigned int index : strips)
+    {
+        if (index == restartIndex)
+        {
+            stripLength = 0;
+            continue;
+        }
+        if (++stripLength >= 3)
+            triangles++;
+
+        if (time - timestamp[index] > cacheSize)
+        {
+            timestamp[index] = time++;
+            misses++;
+        }
+        if (!referenced[index])
+        {
+            referenced[index] = 1;
+            unique++;
+        }
+    }
+
+    CacheStats stats;
+    stats.acmr = triangles ? (float)misses / (float)triangles : 0.0f;
+    stats.atvr = unique ? (float)misses / (float)unique : 0.0f;
+    return stats;
+}
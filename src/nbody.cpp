@@ -0,0 +1,263 @@
+#include "../include/nbody.h"
+#include "../include/parallel.h"
+#include "../include/profiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // Parallel::threadCount()'s minimum: about a millisecond of scalar work.
+    const std::size_t kMinInteractionsPerThread = 2 * 1024 * 1024;
+}
+
+bool NBodySystem::isSupported(NBodyKernel kernel)
+{
+    return isGravityKernelSupported(kernel);
+}
+
+const char *NBodySystem::kernelName(NBodyKernel kernel)
+{
+    return gravityKernelName(kernel);
+}
+
+NBodySystem::NBodySystem(const NBodySettings &nbodySettings)
+    : settings(nbodySettings)
+{
+    activeKernel = resolveGravityKernel(settings.kernel);
+}
+
+std::size_t NBodySystem::add(const glm::dvec3 &position, const glm::dvec3 &velocity, double bodyGm)
+{
+    x.push_back(position.x);
+    y.push_back(position.y);
+    z.push_back(position.z);
+    vx.push_back(velocity.x);
+    vy.push_back(velocity.y);
+    vz.push_back(velocity.z);
+    ax.push_back(0.0);
+    ay.push_back(0.0);
+    az.push_back(0.0);
+    gm.push_back(bodyGm);
+    accelerationsValid = false;
+    initialEnergyValid = false;
+    return x.size() - 1;
+}
+
+void NBodySystem::clear()
+{
+    for (std::vector<double> *values : {&x, &y, &z, &vx, &vy, &vz, &ax, &ay, &az, &gm})
+        values->clear();
+    currentTime = 0.0;
+    accelerationsValid = false;
+    initialEnergyValid = false;
+}
+
+std::size_t NBodySystem::massiveCount() const
+{
+    return (std::size_t)std::count_if(gm.begin(), gm.end(), [](double value) { return value > 0.0; });
+}
+
+void NBodySystem::gatherSources()
+{
+    sourceCount = 0;
+    for (std::size_t i = 0; i < gm.size(); ++i)
+        sourceCount += gm[i] > 0.0;
+    for (std::vector<double> *values : {&sourceX, &sourceY, &sourceZ, &sourceGm})
+        values->resize(sourceCount);
+
+    std::size_t source = 0;
+    for (std::size_t i = 0; i < gm.size(); ++i)
+    {
+        if (gm[i] <= 0.0)
+            continue;
+        sourceX[source] = x[i];
+        sourceY[source] = y[i];
+        sourceZ[source] = z[i];
+        sourceGm[source] = gm[i];
+        ++source;
+    }
+}
+
+double NBodySystem::interactionsPerEvaluation() const
+{
+    if (settings.solver == NBodySolver::BarnesHut)
+        return tree.lastInteractions();
+    return (double)size() * (double)massiveCount();
+}
+
+void NBodySystem::computeAccelerations()
+{
+    PROFILE_ZONE("NBodySystem::computeAccelerations");
+    gatherSources();
+
+    if (settings.solver == NBodySolver::BarnesHut)
+    {
+        OctreeSettings treeSettings;
+        treeSettings.openingAngle = settings.openingAngle;
+        treeSettings.quadrupole = settings.quadrupole;
+        treeSettings.softening = settings.softening;
+        treeSettings.threads = settings.threads;
+        tree.build(sourceX.data(), sourceY.data(), sourceZ.data(), sourceGm.data(), sourceCount, treeSettings);
+        tree.accelerations(x.data(), y.data(), z.data(), ax.data(), ay.data(), az.data(), size());
+        accelerationsValid = true;
+        return;
+    }
+
+    const std::size_t count = size();
+    GravityTargets targets = {x.data(), y.data(), z.data(), ax.data(), ay.data(), az.data()};
+    GravitySources sources = {sourceX.data(), sourceY.data(), sourceZ.data(), sourceGm.data(), sourceCount};
+    double softening2 = settings.softening * settings.softening;
+
+    unsigned int threads = Parallel::threadCount(settings.threads, (std::size_t)interactionsPerEvaluation(), kMinInteractionsPerThread);
+    threads = (unsigned int)std::min<std::size_t>(threads, std::max<std::size_t>(count, 1));
+    Parallel::parallelSlices(threads, count, [&](unsigned int, std::size_t begin, std::size_t end)
+    {
+        std::fill(ax.begin() + begin, ax.begin() + end, 0.0);
+        std::fill(ay.begin() + begin, ay.begin() + end, 0.0);
+        std::fill(az.begin() + begin, az.begin() + end, 0.0);
+        accumulateGravity(activeKernel, targets, begin, end, sources, softening2);
+    });
+    accelerationsValid = true;
+}
+
+void NBodySystem::kickDriftKick(double dt)
+{
+    if (!accelerationsValid)
+        computeAccelerations();
+
+    const std::size_t count = size();
+    double halfStep = 0.5 * dt;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        vx[i] += ax[i] * halfStep;
+        vy[i] += ay[i] * halfStep;
+        vz[i] += az[i] * halfStep;
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+        z[i] += vz[i] * dt;
+    }
+    computeAccelerations();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        vx[i] += ax[i] * halfStep;
+        vy[i] += ay[i] * halfStep;
+        vz[i] += az[i] * halfStep;
+    }
+}
+
+void NBodySystem::step(int direction)
+{
+    PROFILE_ZONE("NBodySystem::step");
+    if (!initialEnergyValid)
+    {
+        initialEnergy = energy();
+        initialEnergyValid = true;
+    }
+
+    double dt = direction < 0 ? -settings.dt : settings.dt;
+    if (settings.integrator == NBodyIntegrator::Leapfrog)
+    {
+        kickDriftKick(dt);
+    }
+    else
+    {
+        // Yoshida's 4th-order composition: w1, w0, w1 with 2 w1 + w0 = 1.
+        const double cubeRootTwo = std::cbrt(2.0);
+        const double w1 = 1.0 / (2.0 - cubeRootTwo);
+        const double w0 = -cubeRootTwo * w1;
+        kickDriftKick(w1 * dt);
+        kickDriftKick(w0 * dt);
+        kickDriftKick(w1 * dt);
+    }
+    currentTime += dt;
+}
+
+int NBodySystem::advanceTo(double t)
+{
+    int steps = 0;
+    while (steps < settings.maxSteps && std::abs(t - currentTime) >= 0.5 * settings.dt)
+    {
+        step(t > currentTime ? 1 : -1);
+        ++steps;
+    }
+    return steps;
+}
+
+double NBodySystem::energy() const
+{
+    PROFILE_ZONE("NBodySystem::energy");
+    double softening2 = settings.softening * settings.softening;
+    double kinetic = 0.0, potential = 0.0;
+    for (std::size_t i = 0; i < size(); ++i)
+    {
+        if (gm[i] <= 0.0)
+            continue;
+        kinetic += 0.5 * gm[i] * (vx[i] * vx[i] + vy[i] * vy[i] + vz[i] * vz[i]);
+        for (std::size_t j = i + 1; j < size(); ++j)
+        {
+            if (gm[j] <= 0.0)
+                continue;
+            double dx = x[j] - x[i], dy = y[j] - y[i], dz = z[j] - z[i];
+            double r2 = dx * dx + dy * dy + dz * dz + softening2;
+            if (r2 > 0.0)
+                potential -= gm[i] * gm[j] / std::sqrt(r2);
+        }
+    }
+    return kinetic + potential;
+}
+
+double NBodySystem::energyDrift() const
+{
+    if (!initialEnergyValid || initialEnergy == 0.0)
+        return 0.0;
+    return std::abs(energy() - initialEnergy) / std::abs(initialEnergy);
+}
+
+void initializeFromBodies(NBodySystem &system, BodyState &state)
+{
+    PROFILE_ZONE("initializeFromBodies");
+    const std::size_t count = state.size();
+    std::vector<glm::dvec3> positions(count), velocities(count);
+    glm::dvec3 momentum(0.0);
+    double totalGm = 0.0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        OrbitalElements orbit = bodyOrbit(state, i);
+        int parent = state.parent[i];
+        if (parent >= 0)
+        {
+            double parentGm = state.gm[parent];
+            double a = orbit.semiMajorAxis;
+            if (parentGm > 0.0 && a > 0.0)
+                orbit.meanMotion = std::sqrt((parentGm + state.gm[i]) / (a * a * a)) * (state.orbitSpeed[i] < 0.0f ? -1.0 : 1.0);
+        }
+        keplerState(orbit, 0.0, positions[i], &velocities[i]);
+        if (parent >= 0)
+        {
+            positions[i] += positions[parent];
+            velocities[i] += velocities[parent];
+        }
+        momentum += (double)state.gm[i] * velocities[i];
+        totalGm += state.gm[i];
+    }
+
+    // Zero net momentum, so the system as a whole does not drift off.
+    glm::dvec3 centerVelocity = totalGm > 0.0 ? momentum / totalGm : glm::dvec3(0.0);
+    system.clear();
+    for (std::size_t i = 0; i < count; ++i)
+        system.add(positions[i], velocities[i] - centerVelocity, state.gm[i]);
+}
+
+void writeToBodies(const NBodySystem &system, BodyState &state, float t)
+{
+    std::size_t count = std::min(system.size(), state.size());
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        glm::dvec3 position = system.position(i);
+        state.positionX[i] = (float)position.x;
+        state.positionY[i] = (float)position.y;
+        state.positionZ[i] = (float)position.z;
+    }
+    updateBodyModels(state, t);
+}
@@ -0,0 +1,494 @@
+#include "../include/octree.h"
+#include "../include/parallel.h"
+#include "../include/profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    const int kMortonBits = 21; // per axis: 63-bit codes, cells down to 2^-21 of the root
+
+    // Subtrees below this level are built as separate tasks (up to 64 of them).
+    const int kParallelLevels = 2;
+
+    // Parallel::threadCount()'s minimums for the build and the force walk.
+    const std::size_t kMinBodiesPerThread = 16384;
+    const std::size_t kMinTargetsPerThread = 2048;
+
+    // Targets walked together: their interaction list is built once and
+    // summed with the SIMD kernel. Groups cost very different amounts (dense
+    // regions open more cells), so threads take them as they go rather than
+    // fixed slices.
+    const std::size_t kGroupSize = 32;
+
+    /** @brief What one group of targets sums: point masses (bodies, and cells without quadrupoles) and cells. */
+    struct InteractionList
+    {
+        std::vector<double> x, y, z, gm;
+        std::vector<double> cellX, cellY, cellZ, cellGm, xx, yy, zz, xy, xz, yz;
+
+        void clear()
+        {
+            for (std::vector<double> *values : {&x, &y, &z, &gm, &cellX, &cellY, &cellZ, &cellGm, &xx, &yy, &zz, &xy, &xz, &yz})
+                values->clear();
+        }
+
+        GravitySources sources() const { return {x.data(), y.data(), z.data(), gm.data(), x.size()}; }
+        GravityCells cells() const
+        {
+            return {cellX.data(), cellY.data(), cellZ.data(), cellGm.data(), xx.data(), yy.data(), zz.data(), xy.data(), xz.data(), yz.data(), cellX.size()};
+        }
+    };
+
+    /** @brief Spreads the low 21 bits of @p v to every third bit. */
+    std::uint64_t spreadBits(std::uint64_t v)
+    {
+        v &= 0x1fffff;
+        v = (v | v << 32) & 0x1f00000000ffffull;
+        v = (v | v << 16) & 0x1f0000ff0000ffull;
+        v = (v | v << 8) & 0x100f00f00f00f00full;
+        v = (v | v << 4) & 0x10c30c30c30c30c3ull;
+        v = (v | v << 2) & 0x1249249249249249ull;
+        return v;
+    }
+
+    /**
+     * @brief Sorts @p keys, and @p values along with them: LSD radix sort, 8
+     * bits a pass. Each thread counts its slice, then scatters it to offsets
+     * after the slices before it, so every pass is stable. Passes where every
+     * key has the same byte (the top ones, for codes of a small cluster) are skipped.
+     */
+    void radixSort(std::vector<std::uint64_t> &keys, std::vector<std::uint32_t> &values, unsigned int threads)
+    {
+        const std::size_t count = keys.size();
+        std::vector<std::uint64_t> keyScratch(count);
+        std::vector<std::uint32_t> valueScratch(count);
+        std::vector<std::size_t> offsets(threads * 256);
+        for (int shift = 0; shift < 64; shift += 8)
+        {
+            std::fill(offsets.begin(), offsets.end(), 0);
+            Parallel::parallelSlices(threads, count, [&](unsigned int t, std::size_t begin, std::size_t end)
+            {
+                std::size_t *histogram = &offsets[t * 256];
+                for (std::size_t i = begin; i < end; ++i)
+                    ++histogram[(keys[i] >> shift) & 0xff];
+            });
+
+            bool trivial = false;
+            std::size_t running = 0;
+            for (int digit = 0; digit < 256; ++digit)
+            {
+                std::size_t digitStart = running;
+                for (unsigned int t = 0; t < threads; ++t)
+                {
+                    std::size_t n = offsets[t * 256 + digit];
+                    offsets[t * 256 + digit] = running;
+                    running += n;
+                }
+                trivial = trivial || running - digitStart == count;
+            }
+            if (trivial)
+                continue;
+
+            Parallel::parallelSlices(threads, count, [&](unsigned int t, std::size_t begin, std::size_t end)
+            {
+                std::size_t *offset = &offsets[t * 256];
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    std::size_t to = offset[(keys[i] >> shift) & 0xff]++;
+                    keyScratch[to] = keys[i];
+                    valueScratch[to] = values[i];
+                }
+            });
+            keys.swap(keyScratch);
+            values.swap(valueScratch);
+        }
+    }
+}
+
+std::uint64_t GravityOctree::mortonCode(double x, double y, double z) const
+{
+    const double scale = (double)(1u << kMortonBits) / rootSize;
+    const double last = (double)((1u << kMortonBits) - 1);
+    auto cell = [&](double v, double origin) { return (std::uint64_t)std::min(std::max((v - origin) * scale, 0.0), last); };
+    return spreadBits(cell(x, rootCorner.x)) << 2 | spreadBits(cell(y, rootCorner.y)) << 1 | spreadBits(cell(z, rootCorner.z));
+}
+
+void GravityOctree::build(const double *x, const double *y, const double *z, const double *gm, std::size_t count,
+                          const OctreeSettings &octreeSettings)
+{
+    PROFILE_ZONE("GravityOctree::build");
+    settings = octreeSettings;
+    nodes.clear();
+    quadrupoles.clear();
+    codes.resize(count);
+    for (std::vector<double> *values : {&bodyX, &bodyY, &bodyZ, &bodyGm})
+        values->resize(count);
+    if (count == 0)
+        return;
+
+    // Bounding cube, a little larger so the far faces still get codes below 2^21.
+    glm::dvec3 low(std::numeric_limits<double>::max()), high(-std::numeric_limits<double>::max());
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        low = glm::min(low, glm::dvec3(x[i], y[i], z[i]));
+        high = glm::max(high, glm::dvec3(x[i], y[i], z[i]));
+    }
+    double extent = std::max(high.x - low.x, std::max(high.y - low.y, high.z - low.z));
+    rootSize = extent > 0.0 ? extent * (1.0 + 1e-9) : 1.0;
+    rootCorner = low;
+
+    unsigned int threads = Parallel::threadCount(settings.threads, count, kMinBodiesPerThread);
+    std::vector<std::uint32_t> order(count);
+    {
+        PROFILE_ZONE("Morton sort");
+        Parallel::parallelSlices(threads, count, [&](unsigned int, std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                codes[i] = mortonCode(x[i], y[i], z[i]);
+                order[i] = (std::uint32_t)i;
+            }
+        });
+        radixSort(codes, order, threads);
+        Parallel::parallelSlices(threads, count, [&](unsigned int, std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                bodyX[i] = x[order[i]];
+                bodyY[i] = y[order[i]];
+                bodyZ[i] = z[order[i]];
+                bodyGm[i] = gm[order[i]];
+            }
+        });
+    }
+
+    PROFILE_ZONE("Octree cells");
+    BuildRange root = {0, (std::uint32_t)count, 0, rootCorner};
+    if (threads <= 1)
+    {
+        nodes.reserve(count / std::max(settings.leafSize, 1) * 2 + 1);
+        quadrupoles.reserve(nodes.capacity());
+        buildSubtree(nodes, quadrupoles, root);
+        return;
+    }
+
+    std::vector<BuildRange> tasks;
+    collectTasks(root, tasks);
+    std::vector<std::vector<OctreeNode>> taskNodes(tasks.size());
+    std::vector<std::vector<OctreeQuadrupole>> taskQuadrupoles(tasks.size());
+    std::atomic<std::size_t> nextTask(0);
+    Parallel::parallelFor(threads, [&](unsigned int)
+    {
+        for (std::size_t task = nextTask++; task < tasks.size(); task = nextTask++)
+            buildSubtree(taskNodes[task], taskQuadrupoles[task], tasks[task]);
+    });
+    std::size_t task = 0;
+    assemble(root, taskNodes, taskQuadrupoles, task);
+}
+
+int GravityOctree::childRanges(const BuildRange &range, BuildRange children[8]) const
+{
+    // Every code in the range shares its top 3 * level bits, so the next
+    // three, the octant, are sorted too: each child is one partition point on.
+    const int shift = 3 * (kMortonBits - 1 - range.level);
+    const double half = cellSize(range.level + 1);
+    const std::uint64_t *begin = codes.data() + range.begin;
+    const std::uint64_t *end = codes.data() + range.end;
+    int count = 0;
+    for (int octant = 0; octant < 8 && begin < end; ++octant)
+    {
+        const std::uint64_t *childEnd = std::partition_point(begin, end, [&](std::uint64_t code) { return (int)((code >> shift) & 7) <= octant; });
+        if (childEnd > begin)
+        {
+            glm::dvec3 offset((octant >> 2) & 1, (octant >> 1) & 1, octant & 1);
+            children[count++] = {(std::uint32_t)(begin - codes.data()), (std::uint32_t)(childEnd - codes.data()), range.level + 1, range.corner + half * offset};
+        }
+        begin = childEnd;
+    }
+    return count;
+}
+
+namespace
+{
+    bool isLeafRange(std::uint32_t begin, std::uint32_t end, int level, int leafSize)
+    {
+        return (int)(end - begin) <= leafSize || level == kMortonBits;
+    }
+
+    void addQuadrupole(OctreeQuadrupole &q, double gm, const glm::dvec3 &d)
+    {
+        double r2 = glm::dot(d, d);
+        q.xx += gm * (3.0 * d.x * d.x - r2);
+        q.yy += gm * (3.0 * d.y * d.y - r2);
+        q.zz += gm * (3.0 * d.z * d.z - r2);
+        q.xy += gm * 3.0 * d.x * d.y;
+        q.xz += gm * 3.0 * d.x * d.z;
+        q.yz += gm * 3.0 * d.y * d.z;
+    }
+
+    void setOpenRadius(OctreeNode &node, const glm::dvec3 &corner, double size, double openingAngle)
+    {
+        glm::dvec3 center = corner + 0.5 * size;
+        double offset = glm::length(glm::dvec3(node.x, node.y, node.z) - center);
+        double radius = openingAngle > 0.0 ? size / openingAngle + offset : std::numeric_limits<double>::infinity();
+        node.openRadius2 = radius * radius;
+    }
+}
+
+void GravityOctree::finishLeaf(OctreeNode &node, OctreeQuadrupole &quadrupole, const BuildRange &range) const
+{
+    double gm = 0.0;
+    glm::dvec3 weighted(0.0);
+    for (std::uint32_t i = range.begin; i < range.end; ++i)
+    {
+        gm += bodyGm[i];
+        weighted += bodyGm[i] * glm::dvec3(bodyX[i], bodyY[i], bodyZ[i]);
+    }
+    double size = cellSize(range.level);
+    glm::dvec3 com = gm > 0.0 ? weighted / gm : range.corner + 0.5 * size;
+
+    quadrupole = OctreeQuadrupole();
+    for (std::uint32_t i = range.begin; i < range.end; ++i)
+        addQuadrupole(quadrupole, bodyGm[i], glm::dvec3(bodyX[i], bodyY[i], bodyZ[i]) - com);
+
+    node.x = com.x;
+    node.y = com.y;
+    node.z = com.z;
+    node.gm = gm;
+    node.skip = 1;
+    node.first = range.begin;
+    node.count = range.end - range.begin;
+    node.isLeaf = 1;
+    setOpenRadius(node, range.corner, size, settings.openingAngle);
+}
+
+void GravityOctree::finishInternal(std::vector<OctreeNode> &out, std::vector<OctreeQuadrupole> &outQuadrupoles, std::size_t index,
+                                   const std::size_t *children, int childCount, const BuildRange &range) const
+{
+    double gm = 0.0;
+    glm::dvec3 weighted(0.0);
+    for (int c = 0; c < childCount; ++c)
+    {
+        const OctreeNode &child = out[children[c]];
+        gm += child.gm;
+        weighted += child.gm * glm::dvec3(child.x, child.y, child.z);
+    }
+    double size = cellSize(range.level);
+    glm::dvec3 com = gm > 0.0 ? weighted / gm : range.corner + 0.5 * size;
+
+    // Parallel axis theorem: each child's own quadrupole plus its mass at its offset.
+    OctreeQuadrupole quadrupole = OctreeQuadrupole();
+    for (int c = 0; c < childCount; ++c)
+    {
+        const OctreeNode &child = out[children[c]];
+        const OctreeQuadrupole &q = outQuadrupoles[children[c]];
+        quadrupole.xx += q.xx;
+        quadrupole.yy += q.yy;
+        quadrupole.zz += q.zz;
+        quadrupole.xy += q.xy;
+        quadrupole.xz += q.xz;
+        quadrupole.yz += q.yz;
+        addQuadrupole(quadrupole, child.gm, glm::dvec3(child.x, child.y, child.z) - com);
+    }
+    outQuadrupoles[index] = quadrupole;
+
+    OctreeNode &node = out[index];
+    node.x = com.x;
+    node.y = com.y;
+    node.z = com.z;
+    node.gm = gm;
+    node.skip = (std::uint32_t)(out.size() - index);
+    node.first = range.begin;
+    node.count = range.end - range.begin;
+    node.isLeaf = 0;
+    setOpenRadius(node, range.corner, size, settings.openingAngle);
+}
+
+void GravityOctree::buildSubtree(std::vector<OctreeNode> &out, std::vector<OctreeQuadrupole> &outQuadrupoles, const BuildRange &range) const
+{
+    std::size_t index = out.size();
+    out.emplace_back();
+    outQuadrupoles.emplace_back();
+    if (isLeafRange(range.begin, range.end, range.level, settings.leafSize))
+    {
+        finishLeaf(out[index], outQuadrupoles[index], range);
+        return;
+    }
+
+    BuildRange children[8];
+    std::size_t childIndices[8];
+    int childCount = childRanges(range, children);
+    for (int c = 0; c < childCount; ++c)
+    {
+        childIndices[c] = out.size();
+        buildSubtree(out, outQuadrupoles, children[c]);
+    }
+    finishInternal(out, outQuadrupoles, index, childIndices, childCount, range);
+}
+
+void GravityOctree::collectTasks(const BuildRange &range, std::vector<BuildRange> &tasks) const
+{
+    if (range.level == kParallelLevels || isLeafRange(range.begin, range.end, range.level, settings.leafSize))
+    {
+        tasks.push_back(range);
+        return;
+    }
+    BuildRange children[8];
+    int childCount = childRanges(range, children);
+    for (int c = 0; c < childCount; ++c)
+        collectTasks(children[c], tasks);
+}
+
+std::size_t GravityOctree::assemble(const BuildRange &range, std::vector<std::vector<OctreeNode>> &taskNodes,
+                                    std::vector<std::vector<OctreeQuadrupole>> &taskQuadrupoles, std::size_t &nextTask)
+{
+    // Walks the same cells as collectTasks(), so the tasks come back in order.
+    std::size_t index = nodes.size();
+    if (range.level == kParallelLevels || isLeafRange(range.begin, range.end, range.level, settings.leafSize))
+    {
+        nodes.insert(nodes.end(), taskNodes[nextTask].begin(), taskNodes[nextTask].end());
+        quadrupoles.insert(quadrupoles.end(), taskQuadrupoles[nextTask].begin(), taskQuadrupoles[nextTask].end());
+        std::vector<OctreeNode>().swap(taskNodes[nextTask]);
+        std::vector<OctreeQuadrupole>().swap(taskQuadrupoles[nextTask]);
+        ++nextTask;
+        return index;
+    }
+
+    nodes.emplace_back();
+    quadrupoles.emplace_back();
+    BuildRange children[8];
+    std::size_t childIndices[8];
+    int childCount = childRanges(range, children);
+    for (int c = 0; c < childCount; ++c)
+        childIndices[c] = assemble(children[c], taskNodes, taskQuadrupoles, nextTask);
+    finishInternal(nodes, quadrupoles, index, childIndices, childCount, range);
+    return index;
+}
+
+void GravityOctree::accelerations(const double *x, const double *y, const double *z, double *ax, double *ay, double *az,
+                                  std::size_t count) const
+{
+    PROFILE_ZONE("GravityOctree::accelerations");
+    interactions = 0.0;
+    if (nodes.empty())
+    {
+        std::fill(ax, ax + count, 0.0);
+        std::fill(ay, ay + count, 0.0);
+        std::fill(az, az + count, 0.0);
+        return;
+    }
+
+    // Targets in Morton order, so each group of consecutive ones is compact.
+    unsigned int threads = Parallel::threadCount(settings.threads, count, kMinTargetsPerThread);
+    std::vector<std::uint64_t> keys(count);
+    std::vector<std::uint32_t> order(count);
+    Parallel::parallelSlices(threads, count, [&](unsigned int, std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            keys[i] = mortonCode(x[i], y[i], z[i]);
+            order[i] = (std::uint32_t)i;
+        }
+    });
+    radixSort(keys, order, threads);
+
+    const OctreeNode *cells = nodes.data();
+    const std::size_t cellCount = nodes.size();
+    const double softening2 = settings.softening * settings.softening;
+    const NBodyKernel kernel = resolveGravityKernel(settings.kernel);
+
+    std::vector<double> threadInteractions(threads, 0.0);
+    std::atomic<std::size_t> nextGroup(0);
+    Parallel::parallelFor(threads, [&](unsigned int thread)
+    {
+        InteractionList list;
+        double groupX[kGroupSize], groupY[kGroupSize], groupZ[kGroupSize];
+        double groupAx[kGroupSize], groupAy[kGroupSize], groupAz[kGroupSize];
+        double summed = 0.0;
+
+        for (std::size_t group = nextGroup.fetch_add(kGroupSize); group < count; group = nextGroup.fetch_add(kGroupSize))
+        {
+            std::size_t groupCount = std::min(kGroupSize, count - group);
+            glm::dvec3 low(std::numeric_limits<double>::max()), high(-std::numeric_limits<double>::max());
+            for (std::size_t k = 0; k < groupCount; ++k)
+            {
+                std::uint32_t target = order[group + k];
+                groupX[k] = x[target];
+                groupY[k] = y[target];
+                groupZ[k] = z[target];
+                groupAx[k] = groupAy[k] = groupAz[k] = 0.0;
+                low = glm::min(low, glm::dvec3(groupX[k], groupY[k], groupZ[k]));
+                high = glm::max(high, glm::dvec3(groupX[k], groupY[k], groupZ[k]));
+            }
+
+            // One walk for the whole group, accepting a cell only if it is far
+            // enough from every point of the group's bounding box.
+            list.clear();
+            std::size_t cell = 0;
+            while (cell < cellCount)
+            {
+                const OctreeNode &node = cells[cell];
+                double dx = std::max(std::max(low.x - node.x, node.x - high.x), 0.0);
+                double dy = std::max(std::max(low.y - node.y, node.y - high.y), 0.0);
+                double dz = std::max(std::max(low.z - node.z, node.z - high.z), 0.0);
+                if (dx * dx + dy * dy + dz * dz > node.openRadius2)
+                {
+                    if (settings.quadrupole)
+                    {
+                        const OctreeQuadrupole &q = quadrupoles[cell];
+                        list.cellX.push_back(node.x);
+                        list.cellY.push_back(node.y);
+                        list.cellZ.push_back(node.z);
+                        list.cellGm.push_back(node.gm);
+                        list.xx.push_back(q.xx);
+                        list.yy.push_back(q.yy);
+                        list.zz.push_back(q.zz);
+                        list.xy.push_back(q.xy);
+                        list.xz.push_back(q.xz);
+                        list.yz.push_back(q.yz);
+                    }
+                    else
+                    {
+                        list.x.push_back(node.x);
+                        list.y.push_back(node.y);
+                        list.z.push_back(node.z);
+                        list.gm.push_back(node.gm);
+                    }
+                    cell += node.skip;
+                }
+                else if (node.isLeaf)
+                {
+                    list.x.insert(list.x.end(), bodyX.begin() + node.first, bodyX.begin() + node.first + node.count);
+                    list.y.insert(list.y.end(), bodyY.begin() + node.first, bodyY.begin() + node.first + node.count);
+                    list.z.insert(list.z.end(), bodyZ.begin() + node.first, bodyZ.begin() + node.first + node.count);
+                    list.gm.insert(list.gm.end(), bodyGm.begin() + node.first, bodyGm.begin() + node.first + node.count);
+                    ++cell;
+                }
+                else
+                {
+                    ++cell;
+                }
+            }
+
+            GravityTargets targets = {groupX, groupY, groupZ, groupAx, groupAy, groupAz};
+            accumulateGravity(kernel, targets, 0, groupCount, list.sources(), softening2);
+            accumulateCellGravity(kernel, targets, 0, groupCount, list.cells(), softening2);
+            summed += (double)groupCount * (double)(list.x.size() + list.cellX.size());
+
+            for (std::size_t k = 0; k < groupCount; ++k)
+            {
+                std::uint32_t target = order[group + k];
+                ax[target] = groupAx[k];
+                ay[target] = groupAy[k];
+                az[target] = groupAz[k];
+            }
+        }
+        threadInteractions[thread] = summed;
+    });
+    for (double summed : threadInteractions)
+        interactions += summed;
+}
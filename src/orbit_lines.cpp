@@ -0,0 +1,186 @@
+#include "../include/orbit_lines.h"
+#include "../include/frustum.h"
+#include "../include/profiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    const float kTwoPi = 6.28318531f;
+
+    int nextPowerOfTwo(int value)
+    {
+        int power = 1;
+        while (power < value)
+            power *= 2;
+        return power;
+    }
+
+    bool outsideFrustum(const glm::vec4 planes[6], const glm::vec3 &center, float radius)
+    {
+        for (int i = 0; i < 6; ++i)
+        {
+            if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius)
+                return true;
+        }
+        return false;
+    }
+}
+
+OrbitLines::OrbitLines()
+{
+    for (glm::vec3 &position : parentPositions)
+        position = glm::vec3(0.0f);
+
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &orbitBuffer);
+    glGenTextures(1, &orbitTexture);
+}
+
+OrbitLines::~OrbitLines()
+{
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &orbitBuffer);
+    glDeleteTextures(1, &orbitTexture);
+}
+
+std::size_t OrbitLines::add(const OrbitPath &orbit)
+{
+    orbits.push_back(orbit);
+    dirty = true;
+    return orbits.size() - 1;
+}
+
+void OrbitLines::set(std::size_t index, const OrbitPath &orbit)
+{
+    orbits[index] = orbit;
+    dirty = true;
+}
+
+void OrbitLines::clear()
+{
+    orbits.clear();
+    dirty = true;
+}
+
+void OrbitLines::setParentPosition(int parent, const glm::vec3 &position)
+{
+    if (parent >= 0 && parent < kMaxParents)
+        parentPositions[parent] = position;
+}
+
+void OrbitLines::upload()
+{
+    records.resize(orbits.size());
+    for (std::size_t i = 0; i < orbits.size(); ++i)
+    {
+        const OrbitPath &orbit = orbits[i];
+        float e = glm::clamp(orbit.eccentricity, 0.0f, 0.999f);
+        glm::vec3 periapsis = glm::normalize(orbit.periapsis);
+        glm::vec3 minorAxis = glm::normalize(glm::cross(orbit.normal, periapsis));
+        records[i].periapsis = periapsis * orbit.semiMajorAxis;
+        records[i].eccentricity = e;
+        records[i].minorAxis = minorAxis * orbit.semiMajorAxis * std::sqrt(1.0f - e * e);
+        records[i].parent = (float)glm::clamp(orbit.parent, 0, kMaxParents - 1);
+        records[i].color = orbit.color;
+        records[i].padding = 0.0f;
+    }
+
+    glBindBuffer(GL_TEXTURE_BUFFER, orbitBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, records.size() * sizeof(OrbitRecord), records.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_BUFFER, orbitTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, orbitBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    dirty = false;
+}
+
+void OrbitLines::draw(const Shader &shader, const glm::mat4 &viewProjection, const glm::vec3 &eye, float fovY, float viewportHeight)
+{
+    PROFILE_ZONE("OrbitLines::draw");
+    firsts.clear();
+    counts.clear();
+    vertexCount = 0;
+    if (orbits.empty())
+        return;
+    if (dirty)
+        upload();
+
+    glm::vec4 frustumPlanes[6];
+    extractFrustumPlanes(viewProjection, frustumPlanes);
+    for (glm::vec4 &plane : frustumPlanes)
+        plane /= glm::length(glm::vec3(plane));
+
+    // Arc k spans eccentric anomalies [k, k + 1] * arcAngle; its vertex IDs
+    // start at arcSlot * arcStride, and n segments start 2n further on: as n
+    // is a power of two, orbit.vert recovers it from where the ID falls.
+    const float arcAngle = kTwoPi / kArcs;
+    const int maxSegments = nextPowerOfTwo(std::max(1, settings.maxSegmentsPerArc));
+    const int arcStride = 4 * maxSegments;
+    const float pixelsPerUnit = viewportHeight * 0.5f / std::tan(fovY * 0.5f);
+    const float maxErrorPx = std::max(settings.maxErrorPx, 1e-3f);
+
+    float cosE[kArcs + 1], sinE[kArcs + 1];
+    for (int k = 0; k <= kArcs; ++k)
+    {
+        cosE[k] = std::cos(k * arcAngle);
+        sinE[k] = std::sin(k * arcAngle);
+    }
+
+    for (std::size_t i = 0; i < records.size(); ++i)
+    {
+        const OrbitRecord &record = records[i];
+        float a = glm::length(record.periapsis);
+        float b = glm::length(record.minorAxis);
+        glm::vec3 center = parentPositions[(int)record.parent] - record.eccentricity * record.periapsis;
+        if (outsideFrustum(frustumPlanes, center, a))
+            continue;
+        float orbitDistance = glm::length(center - eye);
+        if (orbitDistance > a && a * pixelsPerUnit < maxErrorPx * orbitDistance)
+            continue; // the whole ellipse is within the error budget of a point
+
+        for (int k = 0; k < kArcs; ++k)
+        {
+            glm::vec3 p0 = center + cosE[k] * record.periapsis + sinE[k] * record.minorAxis;
+            glm::vec3 p1 = center + cosE[k + 1] * record.periapsis + sinE[k + 1] * record.minorAxis;
+
+            // A chord spanning dE strays at most |r''| dE^2 / 8 from the ellipse,
+            // with |r''(E)| = sqrt(a^2 cos^2 E + b^2 sin^2 E). That peaks at E = 0
+            // and pi, which are arc ends, so over an arc it peaks at one end.
+            float curvature = std::sqrt(std::max(a * a * cosE[k] * cosE[k] + b * b * sinE[k] * sinE[k],
+                                                 a * a * cosE[k + 1] * cosE[k + 1] + b * b * sinE[k + 1] * sinE[k + 1]));
+            glm::vec3 arcCenter = 0.5f * (p0 + p1);
+            float arcRadius = 0.5f * glm::length(p1 - p0) + curvature * arcAngle * arcAngle / 8.0f;
+            if (outsideFrustum(frustumPlanes, arcCenter, arcRadius))
+                continue;
+
+            int segments = maxSegments;
+            float distance = glm::length(arcCenter - eye) - arcRadius;
+            if (distance > 0.0f)
+            {
+                float needed = arcAngle * std::sqrt(curvature * pixelsPerUnit / (8.0f * maxErrorPx * distance));
+                if (needed < (float)maxSegments)
+                    segments = nextPowerOfTwo((int)std::ceil(needed));
+            }
+
+            int arcSlot = (int)i * kArcs + k;
+            firsts.push_back(arcSlot * arcStride + 2 * segments);
+            counts.push_back(segments + 1);
+            vertexCount += segments + 1;
+        }
+    }
+    if (firsts.empty())
+        return;
+
+    glUniform3fv(glGetUniformLocation(shader.ID, "parentPositions"), kMaxParents, &parentPositions[0][0]);
+    shader.setInt("orbits", 0);
+    shader.setInt("arcsPerOrbit", kArcs);
+    shader.setInt("arcStride", arcStride);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, orbitTexture);
+    glBindVertexArray(vao);
+    glMultiDrawArrays(GL_LINE_STRIP, firsts.data(), counts.data(), (GLsizei)firsts.size());
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
@@ -1,117 +1,464 @@
 #include "../include/planet.h"
+#include "../include/mesh_optimizer.h"
+#include "../include/profiler.h"
+#include "../include/sphere_generator.h"
 #include <vector>
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <unordered_map>
 
-Planet::Planet(float radius, unsigned int rings, unsigned int sectors)
+/**
+ * @brief 16-bit indices are used whenever every vertex index, plus 0xFFFF kept
+ * free as the primitive restart index, fits.
+ */
+static bool fitsShortIndices(size_t vertexCount)
 {
-    std::vector<glm::vec3> vertices;
-    std::vector<glm::vec2> texCoords;
-    std::vector<glm::vec3> normals;
-    std::vector<unsigned int> indices;
+    return vertexCount < 0xFFFF;
+}
 
-    // Constants for calculating vertex positions based on spherical coordinates
-    float const R = 1.0f / (float)(rings - 1);
-    float const S = 1.0f / (float)(sectors - 1);
+MeshData generateUVSphere(float radius, unsigned int rings, unsigned int sectors)
+{
+    PROFILE_ZONE("generateUVSphere");
+
+    MeshData mesh;
+    std::vector<glm::vec3> &vertices = mesh.positions;
+    std::vector<glm::vec2> &texCoords = mesh.texCoords;
+    std::vector<glm::vec3> &normals = mesh.normals;
+    std::vector<unsigned int> &indices = mesh.indices;
+
+    // Spherical coordinates (phi per ring, theta per sector) come from tables,
+    // so there is one sin/cos per ring and per sector rather than per vertex.
+    UVSphereTables tables = buildUVSphereTables(rings, sectors);
 
     // Generate vertices, normals, and texture coordinates
-    vertices.reserve(rings * sectors);
-    texCoords.reserve(rings * sectors);
-    normals.reserve(rings * sectors);
+    vertices.resize(uvSphereVertexCount(rings, sectors));
+    texCoords.resize(vertices.size());
+    normals.resize(vertices.size());
     for (unsigned int r = 0; r < rings; ++r)
     {
         for (unsigned int s = 0; s < sectors; ++s)
         {
-            // Calculate spherical coordinates (phi, theta)
-            float phi = glm::pi<float>() * r * R;
-            float theta = 2 * glm::pi<float>() * s * S;
-
             // Convert spherical to Cartesian coordinates (y-up)
-            float y = sin(-glm::pi<float>() / 2 + phi);
-            float x = cos(theta) * sin(phi);
-            float z = sin(theta) * sin(phi);
+            float y = tables.ringY[r];
+            float x = (float)(tables.sectorCos[s] * tables.ringRadius[r]);
+            float z = (float)(tables.sectorSin[s] * tables.ringRadius[r]);
 
+            size_t i = (size_t)r * sectors + s;
             // Texture coordinates (u, v) - flipped 'u' to correct mirroring
-            // texCoords.push_back(glm::vec2(1.0f - (s * S), r * R));
-            // Texture coordinates (u, v) - flipped 'u' to correct mirroring
-            glm::vec2 texCoord = glm::vec2(1.0f - (s * S), r * R);
-            texCoords.push_back(texCoord);
+            texCoords[i] = glm::vec2(tables.sectorU[s], tables.ringV[r]);
+            // Vertex position (scaled by radius)
+            vertices[i] = glm::vec3(x, y, z) * radius;
+            // Normal vector (for a sphere, it's just the normalized position vector before scaling)
+            normals[i] = glm::vec3(x, y, z);
+        }
+    }
 
-            // Print first few texCoords for debugging
-            if (r < 2 && s < 5) // Print first 10 texCoords
-            {
-                std::cout << "TexCoord [" << r << "," << s << "]: (" 
-                        << texCoord.x << ", " << texCoord.y << ")" << std::endl;
-            }
+    // Two triangles per quad: (r,s), (r,s+1), (r+1,s+1) and (r,s), (r+1,s+1), (r+1,s)
+    indices.resize(uvSphereIndexCount(rings, sectors));
+    writeUVSphere(radius, rings, sectors, nullptr, indices.data(), 1);
+    return mesh;
+}
 
+/**
+ * @brief Equirectangular texture coordinates matching generateUVSphere():
+ * u = 1 - longitude / 2pi (longitude measured from +X towards +Z), v = 0 at the -Y pole.
+ */
+static glm::vec2 equirectangularUV(const glm::vec3 &n)
+{
+    float theta = std::atan2(n.z, n.x);
+    if (theta < 0.0f)
+        theta += 2.0f * glm::pi<float>();
+    float phi = std::acos(glm::clamp(-n.y, -1.0f, 1.0f));
+    return glm::vec2(1.0f - theta / (2.0f * glm::pi<float>()), phi / glm::pi<float>());
+}
 
-            // Vertex position (scaled by radius)
-            vertices.push_back(glm::vec3(x, y, z) * radius);
+MeshData generateIcosphere(float radius, unsigned int subdivisions)
+{
+    PROFILE_ZONE("generateIcosphere");
 
-            // Normal vector (for a sphere, it's just the normalized position vector before scaling)
-            normals.push_back(glm::vec3(x, y, z));
+    // Icosahedron with counter-clockwise (outward-facing) triangles.
+    const float t = (1.0f + std::sqrt(5.0f)) / 2.0f;
+    std::vector<glm::vec3> points = {
+        {-1, t, 0}, {1, t, 0}, {-1, -t, 0}, {1, -t, 0},
+        {0, -1, t}, {0, 1, t}, {0, -1, -t}, {0, 1, -t},
+        {t, 0, -1}, {t, 0, 1}, {-t, 0, -1}, {-t, 0, 1}};
+    for (glm::vec3 &p : points)
+        p = glm::normalize(p);
+
+    std::vector<unsigned int> triangles = {
+        0, 11, 5, 0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11,
+        1, 5, 9, 5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
+        3, 9, 4, 3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9,
+        4, 9, 5, 2, 4, 11, 6, 2, 10, 8, 6, 7, 9, 8, 1};
+
+    // Each level splits every triangle into four; edge midpoints are shared
+    // between the two triangles of an edge through the map.
+    for (unsigned int level = 0; level < subdivisions; ++level)
+    {
+        std::unordered_map<std::uint64_t, unsigned int> midpoints;
+        midpoints.reserve(triangles.size());
+        auto midpoint = [&](unsigned int a, unsigned int b) -> unsigned int
+        {
+            std::uint64_t key = ((std::uint64_t)std::min(a, b) << 32) | std::max(a, b);
+            auto it = midpoints.find(key);
+            if (it != midpoints.end())
+                return it->second;
+            points.push_back(glm::normalize(points[a] + points[b]));
+            unsigned int index = (unsigned int)points.size() - 1;
+            midpoints.emplace(key, index);
+            return index;
+        };
+
+        std::vector<unsigned int> next;
+        next.reserve(triangles.size() * 4);
+        for (size_t i = 0; i < triangles.size(); i += 3)
+        {
+            unsigned int a = triangles[i], b = triangles[i + 1], c = triangles[i + 2];
+            unsigned int ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+            next.insert(next.end(), {a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca});
         }
+        triangles.swap(next);
+    }
+
+    MeshData mesh;
+    mesh.positions.reserve(points.size() + points.size() / 8);
+    mesh.normals.reserve(mesh.positions.capacity());
+    mesh.texCoords.reserve(mesh.positions.capacity());
+    for (const glm::vec3 &p : points)
+    {
+        mesh.positions.push_back(p * radius);
+        mesh.normals.push_back(p);
+        mesh.texCoords.push_back(equirectangularUV(p));
     }
 
-    // Generate indices for triangle strips (forming quadrilaterals)
-    indices.reserve((rings - 1) * (sectors - 1) * 6);
-    for (unsigned int r = 0; r < rings - 1; ++r)
+    // Triangles crossing the u = 0/1 seam would interpolate across the whole
+    // texture: their low-u corners get a duplicate vertex with u + 1 (textures
+    // repeat). Pole vertices have no longitude, so each triangle touching one
+    // gets its own copy at the mean u of the other two corners.
+    std::vector<unsigned int> seamCopy(points.size(), ~0u);
+    auto addCopy = [&](unsigned int source, glm::vec2 uv) -> unsigned int
     {
-        for (unsigned int s = 0; s < sectors - 1; ++s)
+        mesh.positions.push_back(mesh.positions[source]);
+        mesh.normals.push_back(mesh.normals[source]);
+        mesh.texCoords.push_back(uv);
+        return (unsigned int)mesh.positions.size() - 1;
+    };
+
+    mesh.indices.reserve(triangles.size());
+    for (size_t i = 0; i < triangles.size(); i += 3)
+    {
+        unsigned int corner[3] = {triangles[i], triangles[i + 1], triangles[i + 2]};
+        bool pole[3];
+        float u[3];
+        float minU = 2.0f, maxU = -1.0f;
+        for (int k = 0; k < 3; ++k)
+        {
+            const glm::vec3 &p = points[corner[k]];
+            pole[k] = std::fabs(p.x) < 1e-6f && std::fabs(p.z) < 1e-6f;
+            u[k] = mesh.texCoords[corner[k]].x;
+            if (!pole[k])
+            {
+                minU = std::min(minU, u[k]);
+                maxU = std::max(maxU, u[k]);
+            }
+        }
+
+        bool wraps = maxU - minU > 0.5f;
+        float sumU = 0.0f;
+        int counted = 0;
+        for (int k = 0; k < 3; ++k)
+        {
+            if (pole[k])
+                continue;
+            if (wraps && u[k] < 0.5f)
+            {
+                u[k] += 1.0f;
+                if (seamCopy[corner[k]] == ~0u)
+                    seamCopy[corner[k]] = addCopy(corner[k], glm::vec2(u[k], mesh.texCoords[corner[k]].y));
+                corner[k] = seamCopy[corner[k]];
+            }
+            sumU += u[k];
+            counted++;
+        }
+        for (int k = 0; k < 3; ++k)
         {
-            // Indices for the two triangles forming a quad
-            // Triangle 1: (r,s), (r, s+1), (r+1, s+1)
-            indices.push_back(r * sectors + s);
-            indices.push_back(r * sectors + (s + 1));
-            indices.push_back((r + 1) * sectors + (s + 1));
-
-            // Triangle 2: (r,s), (r+1, s+1), (r+1, s)
-            indices.push_back(r * sectors + s);
-            indices.push_back((r + 1) * sectors + (s + 1));
-            indices.push_back((r + 1) * sectors + s);
+            if (pole[k] && counted > 0)
+                corner[k] = addCopy(corner[k], glm::vec2(sumU / counted, mesh.texCoords[corner[k]].y));
         }
+
+        mesh.indices.insert(mesh.indices.end(), corner, corner + 3);
     }
-    indexCount = static_cast<unsigned int>(indices.size());
+    return mesh;
+}
+
+void cubeFaceBasis(int face, glm::vec3 &origin, glm::vec3 &u, glm::vec3 &v)
+{
+    // Cube point for face coordinates (sc, tc) = (2s - 1, 2t - 1), per the GL
+    // cube map face orientation:
+    // +X (1, -tc, -sc), -X (-1, -tc, sc), +Y (sc, 1, tc), -Y (sc, -1, -tc), +Z (sc, -tc, 1), -Z (-sc, -tc, -1)
+    static const glm::vec3 origins[6] = {{1, 1, 1}, {-1, 1, -1}, {-1, 1, -1}, {-1, -1, 1}, {-1, 1, 1}, {1, 1, -1}};
+    static const glm::vec3 us[6] = {{0, 0, -2}, {0, 0, 2}, {2, 0, 0}, {2, 0, 0}, {2, 0, 0}, {-2, 0, 0}};
+    static const glm::vec3 vs[6] = {{0, -2, 0}, {0, -2, 0}, {0, 0, 2}, {0, 0, -2}, {0, -2, 0}, {0, -2, 0}};
+    origin = origins[face];
+    u = us[face];
+    v = vs[face];
+}
+
+glm::vec3 cubeSphereDirection(int face, float s, float t)
+{
+    glm::vec3 origin, u, v;
+    cubeFaceBasis(face, origin, u, v);
+    glm::vec3 p = origin + s * u + t * v;
+
+    // Cube-to-sphere mapping that spreads vertices more evenly than normalize():
+    // cell areas vary by ~1.5x across a face instead of ~5x.
+    glm::vec3 p2 = p * p;
+    return glm::normalize(glm::vec3(
+        p.x * std::sqrt(std::max(0.0f, 1.0f - p2.y / 2.0f - p2.z / 2.0f + p2.y * p2.z / 3.0f)),
+        p.y * std::sqrt(std::max(0.0f, 1.0f - p2.z / 2.0f - p2.x / 2.0f + p2.z * p2.x / 3.0f)),
+        p.z * std::sqrt(std::max(0.0f, 1.0f - p2.x / 2.0f - p2.y / 2.0f + p2.x * p2.y / 3.0f))));
+}
+
+MeshData generateCubeSphere(float radius, unsigned int segments)
+{
+    PROFILE_ZONE("generateCubeSphere");
+
+    if (segments == 0)
+        segments = 1;
 
-    // Interleave vertex data (Position, Normal, TexCoord) into a single array
-    std::vector<float> data;
-    data.reserve(vertices.size() * 8); // 3 pos + 3 normal + 2 texCoord = 8 floats per vertex
-    for (size_t i = 0; i < vertices.size(); ++i)
+    MeshData mesh;
+    unsigned int side = segments + 1;
+    mesh.positions.reserve(6 * side * side);
+    mesh.normals.reserve(6 * side * side);
+    mesh.texCoords.reserve(6 * side * side);
+    mesh.indices.reserve(6 * segments * segments * 6);
+
+    for (int face = 0; face < 6; ++face)
     {
-        data.push_back(vertices[i].x);
-        data.push_back(vertices[i].y);
-        data.push_back(vertices[i].z);
+        // 3x2 atlas: +X -X +Y on the top row of the image, -Y +Z -Z below.
+        // v is flipped because loadTexture() flips images on load.
+        float column = (float)(face % 3);
+        float row = (float)(face / 3);
+        unsigned int base = (unsigned int)mesh.positions.size();
 
-        if (normals.size() > i)
+        for (unsigned int j = 0; j < side; ++j)
         {
-            data.push_back(normals[i].x);
-            data.push_back(normals[i].y);
-            data.push_back(normals[i].z);
+            for (unsigned int i = 0; i < side; ++i)
+            {
+                float s = (float)i / segments;
+                float t = (float)j / segments;
+                glm::vec3 n = cubeSphereDirection(face, s, t);
+                mesh.positions.push_back(n * radius);
+                mesh.normals.push_back(n);
+                mesh.texCoords.push_back(glm::vec2((column + s) / 3.0f, 1.0f - (row + t) / 2.0f));
+            }
         }
 
-        if (texCoords.size() > i)
+        // Face orientations differ in handedness; wind every face outward.
+        glm::vec3 a = mesh.normals[base], b = mesh.normals[base + 1], c = mesh.normals[base + side + 1];
+        bool flip = glm::dot(glm::cross(b - a, c - a), a + b + c) < 0.0f;
+
+        for (unsigned int j = 0; j < segments; ++j)
         {
-            data.push_back(texCoords[i].x);
-            data.push_back(texCoords[i].y);
+            for (unsigned int i = 0; i < segments; ++i)
+            {
+                unsigned int v00 = base + j * side + i, v10 = v00 + 1;
+                unsigned int v01 = v00 + side, v11 = v01 + 1;
+                if (flip)
+                    mesh.indices.insert(mesh.indices.end(), {v00, v11, v10, v00, v01, v11});
+                else
+                    mesh.indices.insert(mesh.indices.end(), {v00, v10, v11, v00, v11, v01});
+            }
         }
     }
+    return mesh;
+}
 
-    // --- OpenGL Buffer Setup ---
-    glGenVertexArrays(1, &VAO); // Generate VAO to store attribute configurations
-    glGenBuffers(1, &VBO);      // Generate VBO for vertex data
-    glGenBuffers(1, &EBO);      // Generate EBO for index data
+/** @brief Distance from the origin to the closest point of segment ab. */
+static double segmentDistance(const glm::dvec3 &a, const glm::dvec3 &b)
+{
+    glm::dvec3 ab = b - a;
+    double t = glm::clamp(-glm::dot(a, ab) / glm::dot(ab, ab), 0.0, 1.0);
+    return glm::length(a + ab * t);
+}
 
-    glBindVertexArray(VAO); // Bind the VAO to start configuring it
+/**
+ * The closest point of a triangle to the origin is the foot of the plane
+ * normal when it falls inside the triangle, else on an edge.
+ */
+float sphereMaxRadialError(const MeshData &mesh)
+{
+    double worst = 0.0;
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+    {
+        glm::dvec3 a(mesh.positions[mesh.indices[i]]);
+        glm::dvec3 b(mesh.positions[mesh.indices[i + 1]]);
+        glm::dvec3 c(mesh.positions[mesh.indices[i + 2]]);
+        glm::dvec3 normal = glm::cross(b - a, c - a);
+        double area2 = glm::length(normal);
+        if (area2 == 0.0)
+            continue;
+        normal /= area2;
 
-    // Upload interleaved vertex data to VBO
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), &data[0], GL_STATIC_DRAW);
+        double closest;
+        glm::dvec3 foot = normal * glm::dot(normal, a);
+        bool inside = glm::dot(glm::cross(b - a, foot - a), normal) >= 0.0 &&
+                      glm::dot(glm::cross(c - b, foot - b), normal) >= 0.0 &&
+                      glm::dot(glm::cross(a - c, foot - c), normal) >= 0.0;
+        if (inside)
+            closest = std::fabs(glm::dot(normal, a));
+        else
+            closest = std::min(segmentDistance(a, b), std::min(segmentDistance(b, c), segmentDistance(c, a)));
 
-    // Upload index data to EBO
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        worst = std::max(worst, 1.0 - closest);
+    }
+    return (float)worst;
+}
+
+void prepareMesh(MeshData &mesh, const MeshOptions &options)
+{
+    PROFILE_ZONE("prepareMesh");
+
+    if (options.optimize)
+    {
+        // The first and last rows each contain a fan of zero-area triangles
+        // (two corners on the pole), and the ring-by-ring order reloads every
+        // vertex of the previous ring once the cache has wrapped.
+        MeshOptimizer::removeDegenerateTriangles(mesh.indices, mesh.positions);
+        MeshOptimizer::optimizeVertexCache(mesh.indices, mesh.positions.size());
+
+        std::vector<unsigned int> remap = MeshOptimizer::optimizeVertexFetch(mesh.indices, mesh.positions.size());
+        MeshOptimizer::remapVertices(mesh.positions, remap);
+        MeshOptimizer::remapVertices(mesh.normals, remap);
+        MeshOptimizer::remapVertices(mesh.texCoords, remap);
+    }
+
+    if (options.triangleStrips && mesh.primitiveMode == GL_TRIANGLES)
+    {
+        mesh.restartIndex = fitsShortIndices(mesh.positions.size()) ? 0xFFFFu : 0xFFFFFFFFu;
+        mesh.indices = MeshOptimizer::buildTriangleStrips(mesh.indices, mesh.restartIndex);
+        mesh.primitiveMode = GL_TRIANGLE_STRIP;
+    }
+}
+
+Planet::Planet(float radius, unsigned int rings, unsigned int sectors, const MeshOptions &options)
+    : format(radius == 1.0f ? options.format : VertexFormat::Standard)
+{
+    PROFILE_ZONE("Planet::Planet");
+
+    // Nothing to do on the CPU between generation and upload: write the
+    // interleaved vertices and indices straight into the mapped buffers.
+    if (!options.optimize && !options.triangleStrips && format == VertexFormat::Standard && rings >= 2 && sectors >= 2)
+    {
+        uploadUVSphere(radius, rings, sectors);
+        return;
+    }
+
+    MeshData mesh = generateUVSphere(radius, rings, sectors);
+    prepareMesh(mesh, options);
+    upload(mesh);
+}
+
+Planet::Planet(const MeshData &mesh, VertexFormat vertexFormat)
+    : format(vertexFormat)
+{
+    if (format == VertexFormat::Compact)
+    {
+        for (size_t i = 0; i < mesh.positions.size(); ++i)
+        {
+            const glm::vec2 &uv = mesh.texCoords[i];
+            if (glm::length(mesh.positions[i] - mesh.normals[i]) > 1e-5f || // position can't be rebuilt from the normal
+                uv.x < 0.0f || uv.x > 1.0f || uv.y < 0.0f || uv.y > 1.0f) // unorm16 can't hold wrapped seam UVs
+            {
+                format = VertexFormat::Standard;
+                break;
+            }
+        }
+    }
+    upload(mesh);
+}
+
+/**
+ * @brief Octahedral normal encoding: folds the unit sphere onto the [-1,1]^2 square.
+ */
+static glm::vec2 octEncode(glm::vec3 n)
+{
+    n /= (std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z));
+    glm::vec2 e(n.x, n.y);
+    if (n.z < 0.0f)
+    {
+        e = glm::vec2((1.0f - std::fabs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f),
+                      (1.0f - std::fabs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f));
+    }
+    return e;
+}
+
+static glm::vec3 octDecode(glm::vec2 e)
+{
+    glm::vec3 n(e.x, e.y, 1.0f - std::fabs(e.x) - std::fabs(e.y));
+    if (n.z < 0.0f)
+    {
+        n.x = (1.0f - std::fabs(e.y)) * (e.x >= 0.0f ? 1.0f : -1.0f);
+        n.y = (1.0f - std::fabs(e.x)) * (e.y >= 0.0f ? 1.0f : -1.0f);
+    }
+    return glm::normalize(n);
+}
+
+/**
+ * @brief Quantizes @p n to snorm16 octahedral, keeping whichever of the four
+ * neighbouring grid points decodes closest to the original normal.
+ */
+static void octEncodeSnorm16(const glm::vec3 &n, short out[2])
+{
+    glm::vec2 e = octEncode(n);
+    float bestError = 2.0f;
+    for (int i = 0; i < 4; ++i)
+    {
+        float x = (i & 1) ? std::ceil(e.x * 32767.0f) : std::floor(e.x * 32767.0f);
+        float y = (i & 2) ? std::ceil(e.y * 32767.0f) : std::floor(e.y * 32767.0f);
+        glm::vec2 candidate(glm::clamp(x, -32767.0f, 32767.0f), glm::clamp(y, -32767.0f, 32767.0f));
+        float error = 1.0f - glm::dot(octDecode(candidate / 32767.0f), n);
+        if (error < bestError)
+        {
+            bestError = error;
+            out[0] = (short)candidate.x;
+            out[1] = (short)candidate.y;
+        }
+    }
+}
+
+/** @brief One vertex of VertexFormat::Compact (8 bytes). */
+struct CompactVertex
+{
+    short octNormal[2];
+    unsigned short texCoord[2];
+};
+
+GLsizei vertexStride(VertexFormat format)
+{
+    return format == VertexFormat::Compact ? (GLsizei)sizeof(CompactVertex) : (GLsizei)sizeof(StandardVertex);
+}
+
+void setVertexAttributes(VertexFormat format)
+{
+    if (format == VertexFormat::Compact)
+    {
+        // Attribute 0 (position) stays disabled: the shaders decode it from the normal.
+        GLsizei stride = sizeof(CompactVertex);
+
+        // Attribute 2: Texture Coordinates (unorm16, normalized to [0,1] by GL)
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void *)offsetof(CompactVertex, texCoord));
+
+        // Attribute 3: Octahedral Normal (snorm16, normalized to [-1,1] by GL)
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 2, GL_SHORT, GL_TRUE, stride, (void *)offsetof(CompactVertex, octNormal));
+        return;
+    }
 
-    // --- Configure Vertex Attributes ---
     // Calculate the stride between consecutive vertices in the interleaved array
     GLsizei stride = (3 + 3 + 2) * sizeof(float); // Pos(3) + Normal(3) + TexCoord(2)
 
@@ -126,6 +473,136 @@ Planet::Planet(float radius, unsigned int rings, unsigned int sectors)
     // Attribute 2: Vertex Texture Coordinates
     glEnableVertexAttribArray(2);
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void *)(6 * sizeof(float))); // 2 floats, starting after normal data
+}
+
+void Planet::uploadUVSphere(float radius, unsigned int rings, unsigned int sectors)
+{
+    PROFILE_ZONE("Planet::uploadUVSphere");
+
+    vertexCount = (unsigned int)uvSphereVertexCount(rings, sectors);
+    indexCount = (unsigned int)uvSphereIndexCount(rings, sectors);
+    triangleCount = indexCount / 3;
+    primitiveMode = GL_TRIANGLES;
+    restartIndex = 0xFFFFFFFFu;
+    indexType = fitsShortIndices(vertexCount) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    GLsizeiptr indexBytes = (GLsizeiptr)indexCount * (indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int));
+
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
+    glBindVertexArray(VAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)vertexCount * sizeof(StandardVertex), nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, nullptr, GL_STATIC_DRAW);
+
+    // Write-only, whole-buffer invalidating maps: the driver can hand out
+    // fresh memory without copying or synchronizing.
+    const GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT;
+    void *vertices = glMapBufferRange(GL_ARRAY_BUFFER, 0, (GLsizeiptr)vertexCount * sizeof(StandardVertex), access);
+    void *indices = glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, 0, indexBytes, access);
+    if (vertices && indices)
+    {
+        if (indexType == GL_UNSIGNED_SHORT)
+            writeUVSphere(radius, rings, sectors, (StandardVertex *)vertices, (unsigned short *)indices);
+        else
+            writeUVSphere(radius, rings, sectors, (StandardVertex *)vertices, (unsigned int *)indices);
+    }
+    else
+    {
+        std::cerr << "ERROR::PLANET::MAP_BUFFER_FAILED" << std::endl;
+    }
+    if ((vertices && glUnmapBuffer(GL_ARRAY_BUFFER) == GL_FALSE) || (indices && glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER) == GL_FALSE))
+        std::cerr << "ERROR::PLANET::BUFFER_CONTENTS_LOST" << std::endl;
+
+    setVertexAttributes(VertexFormat::Standard);
+    glBindVertexArray(0);
+}
+
+void Planet::upload(const MeshData &mesh)
+{
+    const std::vector<glm::vec3> &vertices = mesh.positions;
+    const std::vector<glm::vec3> &normals = mesh.normals;
+    const std::vector<glm::vec2> &texCoords = mesh.texCoords;
+    const std::vector<unsigned int> &indices = mesh.indices;
+
+    vertexCount = static_cast<unsigned int>(vertices.size());
+    indexCount = static_cast<unsigned int>(indices.size());
+    primitiveMode = mesh.primitiveMode;
+    restartIndex = mesh.restartIndex;
+    if (primitiveMode == GL_TRIANGLE_STRIP)
+    {
+        triangleCount = 0;
+        unsigned int stripLength = 0;
+        for (unsigned int index : indices)
+        {
+            stripLength = (index == restartIndex) ? 0 : stripLength + 1;
+            if (stripLength >= 3)
+                triangleCount++;
+        }
+    }
+    else
+    {
+        triangleCount = indexCount / 3;
+    }
+
+    // --- OpenGL Buffer Setup ---
+    glGenVertexArrays(1, &VAO); // Generate VAO to store attribute configurations
+    glGenBuffers(1, &VBO);      // Generate VBO for vertex data
+    glGenBuffers(1, &EBO);      // Generate EBO for index data
+
+    glBindVertexArray(VAO); // Bind the VAO to start configuring it
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+
+    if (format == VertexFormat::Compact)
+    {
+        std::vector<CompactVertex> data(vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i)
+        {
+            octEncodeSnorm16(normals[i], data[i].octNormal);
+            data[i].texCoord[0] = (unsigned short)std::lround(glm::clamp(texCoords[i].x, 0.0f, 1.0f) * 65535.0f);
+            data[i].texCoord[1] = (unsigned short)std::lround(glm::clamp(texCoords[i].y, 0.0f, 1.0f) * 65535.0f);
+        }
+        glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(CompactVertex), data.data(), GL_STATIC_DRAW);
+        setVertexAttributes(VertexFormat::Compact);
+    }
+    else
+    {
+        // Interleave vertex data (Position, Normal, TexCoord) into a single array
+        std::vector<float> data;
+        data.reserve(vertices.size() * 8); // 3 pos + 3 normal + 2 texCoord = 8 floats per vertex
+        for (size_t i = 0; i < vertices.size(); ++i)
+        {
+            data.push_back(vertices[i].x);
+            data.push_back(vertices[i].y);
+            data.push_back(vertices[i].z);
+
+            data.push_back(normals[i].x);
+            data.push_back(normals[i].y);
+            data.push_back(normals[i].z);
+
+            data.push_back(texCoords[i].x);
+            data.push_back(texCoords[i].y);
+        }
+        glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), &data[0], GL_STATIC_DRAW);
+        setVertexAttributes(VertexFormat::Standard);
+    }
+
+    // Upload index data to EBO, 16-bit whenever the vertex count allows it
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    if (fitsShortIndices(vertices.size()))
+    {
+        std::vector<unsigned short> shortIndices(indices.begin(), indices.end());
+        indexType = GL_UNSIGNED_SHORT;
+        restartIndex = 0xFFFFu; // where a 32-bit restart index ends up after narrowing
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * sizeof(unsigned short), shortIndices.data(), GL_STATIC_DRAW);
+    }
+    else
+    {
+        indexType = GL_UNSIGNED_INT;
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    }
 
     glBindVertexArray(0); // Unbind VAO to prevent accidental changes
     // Buffers (VBO, EBO) remain associated with the VAO even after unbinding the VAO itself
@@ -146,8 +623,56 @@ Planet::~Planet()
  */
 void Planet::draw()
 {
+    PROFILE_ZONE("Planet::draw");
     glBindVertexArray(VAO); // Bind the VAO containing the mesh data and attribute configuration
-    // Draw the triangles using the indices stored in the EBO
-    glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+    if (primitiveMode == GL_TRIANGLE_STRIP)
+    {
+        // Restart state is global, so it is only switched on around strip draws.
+        glEnable(GL_PRIMITIVE_RESTART);
+        glPrimitiveRestartIndex(restartIndex);
+        glDrawElements(GL_TRIANGLE_STRIP, indexCount, indexType, 0);
+        glDisable(GL_PRIMITIVE_RESTART);
+    }
+    else
+    {
+        // Draw the triangles using the indices stored in the EBO
+        glDrawElements(GL_TRIANGLES, indexCount, indexType, 0);
+    }
     glBindVertexArray(0); // Unbind the VAO
 }
+
+void Planet::drawInstanced(GLuint instanceBuffer, GLintptr offset, GLsizei instanceCount)
+{
+    PROFILE_ZONE("Planet::drawInstanced");
+    glBindVertexArray(VAO);
+
+    // The instance attributes point into the caller's buffer only for this
+    // draw, so plain draw() calls never read a stale or deleted buffer.
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    GLsizei stride = sizeof(PlanetInstance);
+    for (GLuint column = 0; column < 4; ++column)
+    {
+        glEnableVertexAttribArray(4 + column);
+        glVertexAttribPointer(4 + column, 4, GL_FLOAT, GL_FALSE, stride, (void *)(offset + offsetof(PlanetInstance, model) + column * sizeof(glm::vec4)));
+        glVertexAttribDivisor(4 + column, 1);
+    }
+    glEnableVertexAttribArray(8);
+    glVertexAttribPointer(8, 1, GL_FLOAT, GL_FALSE, stride, (void *)(offset + offsetof(PlanetInstance, textureLayer)));
+    glVertexAttribDivisor(8, 1);
+
+    if (primitiveMode == GL_TRIANGLE_STRIP)
+    {
+        glEnable(GL_PRIMITIVE_RESTART);
+        glPrimitiveRestartIndex(restartIndex);
+        glDrawElementsInstanced(GL_TRIANGLE_STRIP, indexCount, indexType, 0, instanceCount);
+        glDisable(GL_PRIMITIVE_RESTART);
+    }
+    else
+    {
+        glDrawElementsInstanced(GL_TRIANGLES, indexCount, indexType, 0, instanceCount);
+    }
+
+    for (GLuint location = 4; location <= 8; ++location)
+        glDisableVertexAttribArray(location);
+    glBindVertexArray(0);
+}
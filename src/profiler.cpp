@@ -0,0 +1,166 @@
+#include "../include/profiler.h"
+
+#ifdef ENABLE_PROFILER
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    // Relaxed atomics (plain moves on x86), so the exporter can read a slot
+    // the owner is overwriting without a data race.
+    struct ZoneEvent
+    {
+        std::atomic<const char *> name;
+        std::atomic<std::uint64_t> startNs;
+        std::atomic<std::uint64_t> endNs;
+    };
+
+    struct ZoneSnapshot
+    {
+        const char *name;
+        std::uint64_t startNs;
+        std::uint64_t endNs;
+    };
+
+    // One per thread. Only the owning thread writes, and keeps writing while
+    // the exporter reads: `written` is published with release ordering after
+    // each event, and a release fence orders it before the next slot is
+    // overwritten. The exporter copies the last kEventsPerThread events out,
+    // then reloads `written` after an acquire fence and drops the copies whose
+    // slots the owner may have reused meanwhile (seqlock style), so every
+    // exported zone is one whole event; the trace just loses the oldest ones.
+    struct ThreadBuffer
+    {
+        std::uint32_t threadId = 0;
+        std::string threadName;
+        std::atomic<std::uint64_t> written{0};
+        std::unique_ptr<ZoneEvent[]> events{new ZoneEvent[Profiler::kEventsPerThread]};
+    };
+
+    // Buffers are never freed: a thread that exits keeps its zones available for export.
+    std::mutex registryMutex;
+    std::vector<ThreadBuffer *> registry;
+
+    const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+    ThreadBuffer &localBuffer()
+    {
+        thread_local ThreadBuffer *buffer = nullptr;
+        if (!buffer)
+        {
+            buffer = new ThreadBuffer();
+            std::lock_guard<std::mutex> lock(registryMutex);
+            buffer->threadId = (std::uint32_t)registry.size();
+            registry.push_back(buffer);
+        }
+        return *buffer;
+    }
+
+    void writeEscaped(std::ostream &out, const std::string &text)
+    {
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+                out << '\\';
+            out << c;
+        }
+    }
+}
+
+std::uint64_t Profiler::nowNs()
+{
+    return (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - epoch).count();
+}
+
+void Profiler::recordZone(const char *name, std::uint64_t startNs, std::uint64_t endNs)
+{
+    ThreadBuffer &buffer = localBuffer();
+    std::uint64_t index = buffer.written.load(std::memory_order_relaxed);
+    ZoneEvent &event = buffer.events[index % kEventsPerThread];
+    // The exporter must see `written` move past this slot's old event before it sees any of the new one.
+    std::atomic_thread_fence(std::memory_order_release);
+    event.name.store(name, std::memory_order_relaxed);
+    event.startNs.store(startNs, std::memory_order_relaxed);
+    event.endNs.store(endNs, std::memory_order_relaxed);
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::setThreadName(const char *name)
+{
+    ThreadBuffer &buffer = localBuffer();
+    std::lock_guard<std::mutex> lock(registryMutex);
+    buffer.threadName = name;
+}
+
+bool Profiler::writeChromeTrace(const std::string &path)
+{
+    std::ofstream out(path);
+    if (!out)
+        return false;
+
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    bool first = true;
+
+    std::vector<ZoneSnapshot> snapshot;
+    snapshot.reserve(kEventsPerThread);
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (ThreadBuffer *buffer : registry)
+    {
+        if (!buffer->threadName.empty())
+        {
+            out << (first ? "" : ",\n")
+                << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": " << buffer->threadId
+                << ", \"args\": {\"name\": \"";
+            writeEscaped(out, buffer->threadName);
+            out << "\"}}";
+            first = false;
+        }
+
+        // Copy first: the owner may be recording into the ring right now.
+        std::uint64_t written = buffer->written.load(std::memory_order_acquire);
+        std::uint64_t begin = written > kEventsPerThread ? written - kEventsPerThread : 0;
+        snapshot.clear();
+        for (std::uint64_t i = begin; i < written; ++i)
+        {
+            const ZoneEvent &event = buffer->events[i % kEventsPerThread];
+            snapshot.push_back(ZoneSnapshot{event.name.load(std::memory_order_relaxed),
+                                            event.startNs.load(std::memory_order_relaxed),
+                                            event.endNs.load(std::memory_order_relaxed)});
+        }
+        // Event `index` is overwritten while the owner records event index + kEventsPerThread,
+        // which it starts once `written` reaches that; drop everything up to there.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        std::uint64_t rewritten = buffer->written.load(std::memory_order_relaxed);
+        std::uint64_t valid = rewritten >= kEventsPerThread ? rewritten - kEventsPerThread + 1 : 0;
+        for (std::uint64_t i = std::max(begin, valid); i < written; ++i)
+        {
+            const ZoneSnapshot &event = snapshot[i - begin];
+            // Complete ("X") events, timestamps in microseconds.
+            out << (first ? "" : ",\n")
+                << "{\"name\": \"";
+            writeEscaped(out, event.name);
+            out << "\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << buffer->threadId
+                << ", \"ts\": " << event.startNs / 1000.0
+                << ", \"dur\": " << (event.endNs - event.startNs) / 1000.0 << "}";
+            first = false;
+        }
+    }
+    out << "\n]}\n";
+    return (bool)out;
+}
+
+#else
+
+std::uint64_t Profiler::nowNs() { return 0; }
+void Profiler::recordZone(const char *, std::uint64_t, std::uint64_t) {}
+void Profiler::setThreadName(const char *) {}
+bool Profiler::writeChromeTrace(const std::string &) { return false; }
+
+#endif
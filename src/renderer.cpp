@@ -0,0 +1,668 @@
+#include "../include/renderer.h"
+#include "../include/texture.h"
+#include "../include/profiler.h"
+#include "../include/gpu_timer.h"
+#include "../include/frame_stats.h"
+#include "../include/glm/glm/gtc/matrix_transform.hpp"
+#include "../include/glm/glm/gtc/type_ptr.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// ===================== Eclipse Check =====================
+bool isEclipse(const glm::vec3& sunPos, const glm::vec3& earthPos, const glm::vec3& moonPos)
+{
+    glm::vec3 SE = earthPos - sunPos;
+    glm::vec3 SM = moonPos - sunPos;
+
+    float distance = glm::length(glm::cross(SE, SM)) / glm::length(SE);
+
+    bool inBetween =
+        glm::dot(SE, SM) > 0 &&
+        glm::length(SM) < glm::length(SE);
+
+    return (distance < 0.5f && inBetween);
+}
+
+Renderer::Renderer(const MeshOptions &meshOptions)
+    : sunShader("shaders/emissive.vert","shaders/emissive.frag"),
+      planetShader("shaders/lighting.vert","shaders/lighting.frag"),
+      skyboxShader("shaders/skybox.vert","shaders/skybox.frag"),
+      orbitShader("shaders/orbit.vert", "shaders/orbit.frag"),
+      terrainShader("shaders/terrain.vert", "shaders/terrain.frag"),
+      meshes(meshOptions)
+{
+    PROFILE_ZONE("Renderer::Renderer");
+
+    // --- Textures ---
+    sunTex   = loadTexture("textures/sun.jpg");
+    earthTex = loadTexture("textures/earth.jpg");
+    moonTex  = loadTexture("textures/moon.jpg");
+
+    std::vector<std::string> faces
+    {
+        "textures/skybox/right.jpg",
+        "textures/skybox/left.jpg",
+        "textures/skybox/top.jpg",
+        "textures/skybox/bottom.jpg",
+        "textures/skybox/front.jpg",
+        "textures/skybox/back.jpg"
+    };
+    cubemapTexture = loadCubemap(faces);
+
+    // --- Skybox VAO/VBO ---
+    float skyboxVertices[] = {
+    // ----------- Back face -----------
+        -1.0f,  1.0f, -1.0f,
+        -1.0f, -1.0f, -1.0f,
+        1.0f, -1.0f, -1.0f,
+        1.0f, -1.0f, -1.0f,
+        1.0f,  1.0f, -1.0f,
+        -1.0f,  1.0f, -1.0f,
+
+        // ----------- Left face -----------
+        -1.0f, -1.0f,  1.0f,
+        -1.0f, -1.0f, -1.0f,
+        -1.0f,  1.0f, -1.0f,
+        -1.0f,  1.0f, -1.0f,
+        -1.0f,  1.0f,  1.0f,
+        -1.0f, -1.0f,  1.0f,
+
+        // ----------- Right face -----------
+        1.0f, -1.0f, -1.0f,
+        1.0f, -1.0f,  1.0f,
+        1.0f,  1.0f,  1.0f,
+        1.0f,  1.0f,  1.0f,
+        1.0f,  1.0f, -1.0f,
+        1.0f, -1.0f, -1.0f,
+
+        // ----------- Front face -----------
+        -1.0f, -1.0f,  1.0f,
+        -1.0f,  1.0f,  1.0f,
+        1.0f,  1.0f,  1.0f,
+        1.0f,  1.0f,  1.0f,
+        1.0f, -1.0f,  1.0f,
+        -1.0f, -1.0f,  1.0f,
+
+        // ----------- Top face -----------
+        -1.0f,  1.0f, -1.0f,
+        1.0f,  1.0f, -1.0f,
+        1.0f,  1.0f,  1.0f,
+        1.0f,  1.0f,  1.0f,
+        -1.0f,  1.0f,  1.0f,
+        -1.0f,  1.0f, -1.0f,
+
+        // ----------- Bottom face -----------
+        -1.0f, -1.0f, -1.0f,
+        -1.0f, -1.0f,  1.0f,
+        1.0f, -1.0f,  1.0f,
+        1.0f, -1.0f,  1.0f,
+        1.0f, -1.0f, -1.0f,
+        -1.0f, -1.0f, -1.0f
+    };
+
+    glGenVertexArrays(1, &skyboxVAO);
+    glGenBuffers(1, &skyboxVBO);
+    glBindVertexArray(skyboxVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), &skyboxVertices, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glBindVertexArray(0);
+
+    // --- Planets: unit spheres shared through the cache, sized by the model matrix ---
+    scenario = loadScenario_SolarSystemBasic(meshes);
+    buildBodyTextures();
+    findBodies();
+    if (IndirectRenderer::isSupported())
+        indirect.reset(new IndirectRenderer());
+
+    // --- Terrain: procedural unless height tiles exist under terrain/earth and terrain/moon ---
+    terrainSettings.source.directory = "terrain";
+}
+
+Renderer::~Renderer()
+{
+    glDeleteVertexArrays(1, &skyboxVAO);
+    glDeleteBuffers(1, &skyboxVBO);
+
+    unsigned int textures[] = { sunTex, earthTex, moonTex, cubemapTexture, bodyTextures };
+    glDeleteTextures(5, textures);
+}
+
+void Renderer::buildBodyTextures()
+{
+    std::vector<std::string> paths;
+    for (auto& body : scenario.bodies)
+    {
+        auto found = std::find(paths.begin(), paths.end(), body.texturePath);
+        body.textureLayer = (int)(found - paths.begin());
+        if (found == paths.end())
+            paths.push_back(body.texturePath);
+    }
+    if (bodyTextures)
+        glDeleteTextures(1, &bodyTextures);
+    bodyTextures = loadTextureArray(paths);
+}
+
+void Renderer::findBodies()
+{
+    sunBody = findBody(scenario, "Sun");
+    earthBody = findBody(scenario, "Earth");
+    moonBody = findBody(scenario, "Moon");
+
+    // One orbit line per body that shows one, around its parent's slot.
+    orbitLines.clear();
+    orbitParents.clear();
+    const BodyState &state = scenario.state;
+    std::vector<int> slots(scenario.bodies.size(), -1);
+    for (std::size_t i = 0; i < scenario.bodies.size(); ++i)
+    {
+        int parent = state.parent[i];
+        if (!scenario.bodies[i].showOrbit || parent < 0)
+            continue;
+        int &slot = slots[parent];
+        if (slot < 0)
+        {
+            if ((int)orbitParents.size() == OrbitLines::kMaxParents)
+                continue;
+            slot = (int)orbitParents.size();
+            orbitParents.push_back(parent);
+        }
+        OrbitPath orbit;
+        orbit.parent = slot;
+        orbit.semiMajorAxis = state.orbitRadius[i];
+        orbit.eccentricity = state.orbitEccentricity[i];
+        glm::dvec3 periapsis, ahead;
+        perifocalBasis(state.orbitInclination[i], state.orbitAscendingNode[i], state.orbitPeriapsis[i], periapsis, ahead);
+        orbit.periapsis = glm::vec3(periapsis);
+        orbit.normal = glm::vec3(glm::cross(periapsis, ahead));
+        orbit.color = scenario.bodies[i].orbitColor;
+        orbitLines.add(orbit);
+    }
+
+    ephemerisBodies.reset();
+    if (ephemeris)
+    {
+        std::vector<std::string> names;
+        for (const CelestialBody &body : scenario.bodies)
+            names.push_back(body.name);
+        ephemerisBodies.reset(new EphemerisBodies(*ephemeris, names, state, ephemerisSettings));
+    }
+}
+
+void Renderer::addEarthSatellites(unsigned int count)
+{
+    addSatellites(scenario, meshes, "Earth", count);
+    buildBodyTextures();
+    findBodies();
+    if (nbody)
+        startNBody();
+}
+
+void Renderer::setNBody(const NBodySettings &settings)
+{
+    nbodySettings = settings;
+    startNBody();
+}
+
+void Renderer::startNBody()
+{
+    nbody.reset();
+    if (!nbodySettings.enabled)
+        return;
+    nbody.reset(new NBodySystem(nbodySettings));
+    initializeFromBodies(*nbody, scenario.state);
+}
+
+void Renderer::setAsteroidBelt(const AsteroidBeltSettings &settings)
+{
+    asteroids.reset();
+    if (settings.count > 0)
+        asteroids.reset(new AsteroidBelt(settings));
+}
+
+void Renderer::setGpuNBody(const GpuNBodySettings &settings)
+{
+    gpuNBody.reset();
+    if (settings.count > 0 && GpuNBody::isSupported())
+        gpuNBody.reset(new GpuNBody(settings));
+}
+
+bool Renderer::setEphemeris(const std::string &path, const EphemerisSceneSettings &settings)
+{
+    ephemerisBodies.reset();
+    ephemeris.reset();
+    ephemerisSettings = settings;
+    if (!path.empty())
+    {
+        ephemeris.reset(new Ephemeris(path));
+        if (!ephemeris->isOpen())
+            ephemeris.reset();
+    }
+    findBodies();
+    return path.empty() || ephemeris;
+}
+
+bool Renderer::setSatelliteSwarm(const std::string &path, const SatelliteSwarmSettings &settings)
+{
+    satellites.reset();
+    if (path.empty())
+        return true;
+    std::vector<TwoLineElements> elements;
+    if (!loadTwoLineElements(path, elements))
+        return false;
+    satellites.reset(new SatelliteSwarm(elements, settings));
+    if (satellites->size() == 0)
+    {
+        std::cerr << "ERROR::TLE: no element set in '" << path << "' could be propagated" << std::endl;
+        satellites.reset();
+        return false;
+    }
+    return true;
+}
+
+void Renderer::renderFrame(Camera &camera, SimulationState &sim, float currentFrame, float aspect)
+{
+    PROFILE_ZONE("Renderer::renderFrame");
+
+    glClearColor(0.01f,0.01f,0.01f,1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    glm::mat4 view = camera.GetViewMatrix();
+
+    // Discrete LOD: every body draws the coarsest level of its chain whose
+    // silhouette error, at its current projected size, is within lodSettings.
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    float fovY = glm::radians(camera.Zoom);
+    auto selectLod = [&](LodMesh &mesh, const glm::vec3 &center, float radius)
+    {
+        return mesh.select(projectedRadiusPx(center, radius, camera.Position, fovY, (float)viewport[3]), lodSettings);
+    };
+
+    BodyState &state = scenario.state;
+    int sun = bodySlot(scenario, sunBody);
+    int earth = bodySlot(scenario, earthBody);
+    int moon = bodySlot(scenario, moonBody);
+
+// ======================= Planet Movement  =======================
+    float t;
+    int nbodySteps = 0;
+    glm::vec3 sunPos(0.0f), earthPos(0.0f), moonPos(0.0f);
+    {
+        PROFILE_ZONE("Planet movement");
+
+        if(sim.isFrozen)
+            t = sim.frozenTime;
+        else
+            t = currentFrame * sim.speedFactor;
+
+        if (nbody)
+        {
+            nbodySteps = nbody->advanceTo(t);
+            writeToBodies(*nbody, state, t);
+        }
+        else
+        {
+            // Every body, parents before children (resolveHierarchy()).
+            updateTransforms(scenario, t);
+            if (ephemerisBodies)
+                ephemerisBodies->apply(state, t);
+        }
+
+        if (sun >= 0)
+            sunPos = state.position(sun);
+        if (earth >= 0)
+            earthPos = state.position(earth);
+        if (moon >= 0)
+            moonPos = state.position(moon);
+    }
+
+    // =======================  moon size after eclipse  =======================
+    float moonRadius = moon >= 0 ? state.radius[moon] : 0.135f;
+    bool drawEclipseMoon = false;
+    glm::mat4 eclipseMoonModel(1.0f);
+    if (sim.eclipseMode)
+    {
+        PROFILE_ZONE("Eclipse: moon apparent size");
+        static float originalMoonRadius = 0.1f;
+
+        glm::vec3 camPos = camera.Position;
+        glm::vec3 toMoon = glm::normalize(moonPos - camPos);
+        glm::vec3 toSun = glm::normalize(sunPos - camPos);
+
+        float dotCameraMoon = glm::dot(camera.Front, toMoon);
+
+
+        glm::vec3 earthToMoon = moonPos - earthPos;
+        glm::vec3 earthToCam = camPos - earthPos;
+
+        float projectionLength = glm::dot(earthToCam, glm::normalize(earthToMoon));
+
+        float dotSunMoon = glm::dot(toSun, toMoon);
+
+        float distCamToEarth = glm::length(earthPos - camPos);
+        float distEarthToMoon = glm::length(earthToMoon);
+
+        bool isCameraBetween = (distCamToEarth < distEarthToMoon) && (projectionLength > 0);
+
+        bool isMoonInFrontOfSun = (dotSunMoon > 0.95f);
+
+        bool isLookingAtMoon = (dotCameraMoon > 0.7f);
+
+        glm::vec3 camToEarthDir = glm::normalize(earthPos - camPos);
+        float dotCamFrontToEarth = glm::dot(camera.Front, camToEarthDir);
+        bool isEarthBehindCamera = (dotCamFrontToEarth < 0);
+
+        if (isCameraBetween && isMoonInFrontOfSun && isLookingAtMoon && isEarthBehindCamera)
+        {
+            moonRadius = 0.6f;
+
+            float distCamToMoon = glm::length(moonPos - camPos);
+            float desiredDistance = distCamToMoon + 1000.0f;
+
+            glm::vec3 camToMoonDir = glm::normalize(moonPos - camPos);
+            moonPos = camPos + camToMoonDir * desiredDistance;
+
+            // Drawn with the other planets, in addition to the moon at its orbit position.
+            eclipseMoonModel = glm::translate(glm::mat4(1.0f), moonPos);
+            eclipseMoonModel = glm::scale(eclipseMoonModel, glm::vec3(moonRadius));
+            drawEclipseMoon = true;
+
+        }
+        else
+        {
+            moonRadius = originalMoonRadius;
+        }
+    }
+    // The moon's apparent size changes with the eclipse state: rescale its model matrix.
+    if (moon >= 0)
+        state.model[moon] = glm::scale(state.model[moon], glm::vec3(moonRadius / state.radius[moon]));
+
+    // ======================= Terrain =======================
+    // Close up, the Earth and the Moon switch from their Planet mesh to the
+    // streamed quadtree terrain; the near plane then follows the altitude so
+    // the surface isn't clipped.
+    float nearPlane = 0.1f;
+    auto useTerrain = [&](std::unique_ptr<PlanetTerrain> &terrain, const char *name, unsigned int seed, const glm::vec3 &center, float radius)
+    {
+        if (!terrainEnabled || projectedRadiusPx(center, radius, camera.Position, fovY, (float)viewport[3]) < terrainSettings.minRadiusPx)
+            return false;
+        if (!terrain)
+        {
+            TerrainSettings settings = terrainSettings;
+            if (!settings.source.directory.empty())
+                settings.source.directory += std::string("/") + name;
+            settings.source.seed += seed;
+            terrain.reset(new PlanetTerrain(settings));
+        }
+        float altitude = glm::length(camera.Position - center) - radius * (1.0f + std::abs(terrainSettings.source.heightScale));
+        nearPlane = std::min(nearPlane, glm::clamp(0.5f * altitude, 0.0005f, 0.1f));
+        return true;
+    };
+    bool earthTerrainActive = earth >= 0 && useTerrain(earthTerrain, "earth", 0, earthPos, state.radius[earth]);
+    bool moonTerrainActive = moon >= 0 && useTerrain(moonTerrain, "moon", 1, moonPos, moonRadius);
+    glm::mat4 projection = glm::perspective(fovY, aspect, nearPlane, 100.0f);
+
+    std::size_t terrainTriangles = 0;
+    auto drawTerrain = [&](PlanetTerrain &terrain, const glm::mat4 &model, unsigned int texture, bool shadowed)
+    {
+        terrain.update(glm::vec3(glm::inverse(model) * glm::vec4(camera.Position, 1.0f)), projection * view * model);
+
+        terrainShader.use();
+        terrainShader.setInt("ourTexture", 0);
+        terrainShader.setBool("isShadowed", shadowed);
+        terrainShader.setVec3("lightPos", sunPos);
+        terrainShader.setMat4("model", model);
+        terrainShader.setMat4("view", view);
+        terrainShader.setMat4("projection", projection);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        terrain.draw(terrainShader);
+        terrainTriangles += terrain.getStats().triangles;
+    };
+
+    bool earthInShadow = false;
+    if(sim.eclipseMode)
+    {
+        PROFILE_ZONE("Eclipse: earth shadow test");
+        // Sun → Earth
+        glm::vec3 SE = earthPos - sunPos;
+        // Sun → Moon
+        glm::vec3 SM = moonPos - sunPos;
+
+        float distance = glm::length(glm::cross(SE, SM)) / glm::length(SE);
+
+        bool earthBetween = glm::dot(SE, SM) > 0 && glm::length(SM) < glm::length(SE);
+
+        if(distance < 0.5f && earthBetween)
+        {
+            earthInShadow = true;
+            std::cout << "EARTH IN SHADOW (SOLAR ECLIPSE)\n";
+        }
+    }
+
+    // ==================================================
+    //                  الكسوف Solar Eclipse
+    // ==================================================
+    if (sim.eclipseMode && !sim.isFrozen)
+    {
+        PROFILE_ZONE("Eclipse: solar eclipse test");
+        glm::vec3 sunPos(0.0f, 0.0f, 0.0f);
+
+        glm::vec3 ES = sunPos - earthPos;
+        glm::vec3 EM = moonPos - earthPos;
+
+        float distance = glm::length(glm::cross(ES, EM)) / glm::length(ES);
+
+        bool moonBetween =
+            glm::dot(ES, EM) > 0 &&
+            glm::length(EM) < glm::length(ES);
+
+        if (distance < 0.3f && moonBetween)
+        {
+            sim.isFrozen = true;
+            sim.frozenTime = t;
+            std::cout << "SOLAR ECLIPSE OCCURRED\n";
+        }
+    }
+
+    // ==================================================
+    //                  الخسوف Lunar Eclipse
+    // ==================================================
+    if (sim.lunarEclipseMode && !sim.isFrozen)
+    {
+        PROFILE_ZONE("Eclipse: lunar eclipse test");
+        glm::vec3 sunPos(0.0f, 0.0f, 0.0f);
+
+        // Sun → Earth
+        glm::vec3 SE = earthPos - sunPos;
+        // Sun → Moon
+        glm::vec3 SM = moonPos - sunPos;
+
+        float distance = glm::length(glm::cross(SE, SM)) / glm::length(SE);
+
+        bool earthBetween =
+            glm::dot(SE, SM) > 0 &&
+            glm::length(SE) < glm::length(SM);
+
+        if (distance < 0.3f && earthBetween)
+        {
+            sim.isFrozen = true;
+            sim.frozenTime = t;
+            std::cout << "LUNAR ECLIPSE OCCURRED\n";
+        }
+    }
+
+    // ======================= draw planet =======================
+    // Every body is queued as an instance (model matrix + texture array layer)
+    // of its current LOD mesh; each pass then draws one instanced call per mesh.
+    // With the GPU-driven path, the same bodies go to the IndirectRenderer,
+    // which culls them and picks their LOD level in a compute shader instead.
+    bool gpuBodies = isGpuDriven();
+    sunInstances.clear();
+    planetInstances.clear();
+    if (indirect)
+        indirect->clear();
+    {
+        PROFILE_ZONE("Queue bodies");
+        for (int i = 0; i < (int)scenario.bodies.size(); ++i)
+        {
+            CelestialBody &body = scenario.bodies[i];
+            if (!body.mesh || (i == earth && earthTerrainActive) || (i == moon && moonTerrainActive))
+                continue;
+            // The moon's LOD follows its (possibly eclipse-displaced) apparent position.
+            glm::vec3 center = i == moon ? moonPos : state.position(i);
+            float radius = i == moon ? moonRadius : state.radius[i];
+            if (gpuBodies)
+            {
+                indirect->add(body.mesh, state.model[i], center, radius, body.textureLayer, body.isEmissive ? 0 : 1);
+                continue;
+            }
+            selectLod(body.mesh, center, radius);
+            (body.isEmissive ? sunInstances : planetInstances).add(body.mesh.current(), state.model[i], body.textureLayer);
+        }
+        CelestialBody *moonBody = moon >= 0 ? &scenario.bodies[moon] : nullptr;
+        if (drawEclipseMoon && moonBody && moonBody->mesh)
+        {
+            if (gpuBodies)
+                indirect->add(moonBody->mesh, eclipseMoonModel, moonPos, moonRadius, moonBody->textureLayer, 1);
+            else
+                planetInstances.add(moonBody->mesh.current(), eclipseMoonModel, moonBody->textureLayer);
+        }
+    }
+    if (gpuBodies)
+    {
+        GpuPass gpuPass(gpuTimer, "cull");
+        indirect->cull(meshes, projection * view, camera.Position, fovY, (float)viewport[3], lodSettings);
+    }
+
+    {
+        PROFILE_ZONE("Draw sun");
+        GpuPass gpuPass(gpuTimer, "sun");
+        sunShader.use();
+        sunShader.setBool("compactVertices", meshes.vertexFormat() == VertexFormat::Compact);
+        sunShader.setInt("bodyTextures", 0);
+        sunShader.setMat4("view", view);
+        sunShader.setMat4("projection", projection);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, bodyTextures);
+        if (gpuBodies)
+            indirect->draw(0, sunShader);
+        else
+            sunInstances.draw(meshes, sunShader, instancing);
+    }
+
+    {
+        PROFILE_ZONE("Draw planets");
+        GpuPass gpuPass(gpuTimer, "planets");
+
+        if (earthTerrainActive)
+        {
+            PROFILE_ZONE("Earth terrain");
+            drawTerrain(*earthTerrain, state.model[earth], earthTex, earthInShadow);
+        }
+        if (moonTerrainActive) {
+            PROFILE_ZONE("Moon terrain");
+            drawTerrain(*moonTerrain, state.model[moon], moonTex, earthInShadow);
+        }
+
+        planetShader.use();
+        planetShader.setBool("compactVertices", meshes.vertexFormat() == VertexFormat::Compact);
+        planetShader.setInt("bodyTextures", 0);
+        planetShader.setBool("isShadowed", earthInShadow);
+        planetShader.setVec3("lightPos", sunPos);
+        planetShader.setVec3("viewPos", camera.Position);
+        planetShader.setMat4("view", view);
+        planetShader.setMat4("projection", projection);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, bodyTextures);
+        if (gpuBodies)
+            indirect->draw(1, planetShader);
+        else
+            planetInstances.draw(meshes, planetShader, instancing);
+    }
+
+    AsteroidStats asteroidStats;
+    if (asteroids)
+    {
+        PROFILE_ZONE("Draw asteroids");
+        GpuPass gpuPass(gpuTimer, "asteroids");
+        asteroids->draw(t, view, projection, camera.Position, fovY, (float)viewport[3], sunPos, gpuDriven);
+        asteroidStats = asteroids->takeStats();
+    }
+
+    int gpuNBodySteps = 0;
+    if (gpuNBody)
+    {
+        PROFILE_ZONE("Draw GPU N-body");
+        GpuPass gpuPass(gpuTimer, "gpu_nbody");
+        gpuNBodySteps = gpuNBody->advanceTo(t);
+        gpuNBody->draw(view, projection, sunPos, (float)viewport[3]);
+    }
+
+    std::size_t satellitesSolved = 0;
+    if (satellites && earth >= 0)
+    {
+        PROFILE_ZONE("Draw satellites");
+        GpuPass gpuPass(gpuTimer, "satellites");
+        glm::vec3 earthAxis(state.axisX[earth], state.axisY[earth], state.axisZ[earth]);
+        satellites->update(t, earthPos, earthAxis, state.radius[earth]);
+        satellitesSolved = satellites->lastSolved();
+        satellites->draw(view, projection, sunPos, (float)viewport[3]);
+    }
+
+    {
+        PROFILE_ZONE("Draw orbits");
+        GpuPass gpuPass(gpuTimer, "orbits");
+
+        orbitShader.use();
+        orbitShader.setMat4("view", view);
+        orbitShader.setMat4("projection", projection);
+        for (int slot = 0; slot < (int)orbitParents.size(); ++slot)
+            orbitLines.setParentPosition(slot, state.position(orbitParents[slot]));
+        orbitLines.draw(orbitShader, projection * view, camera.Position, fovY, (float)viewport[3]);
+    }
+
+    // ======================= Skybox =======================
+    {
+        PROFILE_ZONE("Draw skybox");
+        GpuPass gpuPass(gpuTimer, "skybox");
+        glDepthFunc(GL_LEQUAL);
+        skyboxShader.use();
+        glm::mat4 skyboxView = glm::mat4(glm::mat3(camera.GetViewMatrix()));
+        skyboxShader.setMat4("view", skyboxView);
+        skyboxShader.setMat4("projection", projection);
+        glBindVertexArray(skyboxVAO);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
+        glDrawArrays(GL_TRIANGLES,0,36);
+        glBindVertexArray(0);
+        glDepthFunc(GL_LESS);
+    }
+
+    std::size_t triangles = meshes.takeTriangleCount() + terrainTriangles;
+    if (gpuBodies)
+        triangles += indirect->takeTriangleCount();
+    triangles += asteroidStats.triangles;
+    if (frameStats)
+    {
+        frameStats->record("triangles", (double)triangles);
+        frameStats->record("orbit_vertices", (double)orbitLines.getVertexCount());
+        if (asteroids && isGpuDriven()) // the 3.3 path does not know what it culled
+            frameStats->record("asteroids_drawn", (double)asteroidStats.rocks);
+        if (nbody)
+        {
+            frameStats->record("nbody_steps", (double)nbodySteps);
+            frameStats->record("nbody_energy_drift", nbody->energyDrift());
+        }
+        if (gpuNBody)
+            frameStats->record("gpu_nbody_steps", (double)gpuNBodySteps);
+        if (satellites)
+            frameStats->record("satellites_solved", (double)satellitesSolved);
+    }
+}
@@ -0,0 +1,64 @@
+#include "../include/satellite_swarm.h"
+#include "../include/profiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+SatelliteSwarm::SatelliteSwarm(const std::vector<TwoLineElements> &elements, const SatelliteSwarmSettings &swarmSettings)
+    : settings(swarmSettings),
+      sgp4(swarmSettings.sgp4)
+{
+    PROFILE_ZONE("SatelliteSwarm::SatelliteSwarm");
+    sgp4.add(elements);
+    if (settings.epochJd <= 0.0)
+        settings.epochJd = sgp4.latestEpochJd();
+    x.resize(sgp4.size());
+    y.resize(sgp4.size());
+    z.resize(sgp4.size());
+
+    glGenBuffers(1, &instanceBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, std::max<std::size_t>(sgp4.size(), 1) * sizeof(glm::vec4), nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    mesh.reset(new InstancedPointMesh(instanceBuffer));
+}
+
+SatelliteSwarm::~SatelliteSwarm()
+{
+    mesh.reset();
+    glDeleteBuffers(1, &instanceBuffer);
+}
+
+void SatelliteSwarm::update(float t, const glm::vec3 &earthPosition, const glm::vec3 &earthAxis, float earthRadius)
+{
+    PROFILE_ZONE("SatelliteSwarm::update");
+    const std::size_t count = sgp4.size();
+    if (count == 0)
+        return;
+    currentJd = settings.epochJd + (double)t / settings.secondsPerDay;
+    solvedCount = sgp4.update(currentJd);
+    sgp4.positions(currentJd, x.data(), y.data(), z.data());
+
+    // TEME axes in the scene: z along the pole, x the scene's +x made perpendicular to it.
+    glm::vec3 pole = glm::normalize(earthAxis);
+    glm::vec3 reference = std::abs(pole.x) < 0.99f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 0.0f, 1.0f);
+    glm::vec3 equinox = glm::normalize(reference - pole * glm::dot(reference, pole));
+    float scale = (float)(earthRadius / kSgp4EarthRadiusKm);
+    glm::vec3 axisX = equinox * scale, axisY = glm::cross(equinox, pole) * scale, axisZ = pole * scale;
+
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glm::vec4 *instances = (glm::vec4 *)glMapBufferRange(GL_ARRAY_BUFFER, 0, count * sizeof(glm::vec4), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (instances)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            instances[i] = glm::vec4(earthPosition + axisX * (float)x[i] + axisY * (float)y[i] + axisZ * (float)z[i], 0.0f);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void SatelliteSwarm::draw(const glm::mat4 &view, const glm::mat4 &projection, const glm::vec3 &lightPos, float viewportHeight)
+{
+    PROFILE_ZONE("SatelliteSwarm::draw");
+    mesh->draw(view, projection, lightPos, viewportHeight, settings.size, settings.points, sgp4.size());
+}
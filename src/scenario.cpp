@@ -1,12 +1,14 @@
 #include "../include/glm/glm/glm.hpp"
 #include "../include/glm/glm/gtc/constants.hpp"
 #include "../include/scenario.h"
-#include "../include/planet.h"
+#include "../include/mesh_cache.h"
 #include <vector>
 #include <string>
 #include <optional>
 #include <memory>
 #include <cmath>
+#include <random>
+#include <algorithm>
 
 // Destructor implementation
 CelestialBody::~CelestialBody() = default;
@@ -14,7 +16,7 @@ CelestialBody::~CelestialBody() = default;
 /**
  * @brief Creates and returns a Scenario object containing only Sun, Earth, and Moon.
  */
-Scenario loadScenario_SolarSystemBasic()
+Scenario loadScenario_SolarSystemBasic(MeshCache &meshes)
 {
     Scenario scenario;
     scenario.initialCameraPos = glm::vec3(0.0f, 5.0f, 20.0f);
@@ -24,34 +26,156 @@ Scenario loadScenario_SolarSystemBasic()
     // Define baseline parameters relative to Earth for easier scaling
     float earthRadius = 0.5f;
     float earthOrbitRadius = 10.0f;
-    float earthOrbitSpeed = 0.5f;
-    float earthRotationSpeed = 1.0f;
+    float earthOrbitSpeed = 1.0f;
+    float earthRotationSpeed = glm::radians(50.0f);
+
+    // Gravitational parameters, only used when NBodySystem (nbody.h) moves the
+    // bodies: the Sun's makes Earth's circular orbit take earthOrbitSpeed. The
+    // Moon orbits at a fifth of Earth's distance from the Sun, so Earth needs
+    // 40% of the Sun's mass to hold it (a Hill radius of 2.5 Moon orbits);
+    // the Moon then circles at ~7 rad/s instead of the analytic 3.
+    float sunGm = earthOrbitSpeed * earthOrbitSpeed * earthOrbitRadius * earthOrbitRadius * earthOrbitRadius;
+    float earthGm = 0.4f * sunGm;
 
     // Sun
-    CelestialBody sun(
-        "Sun", 2.0f, "textures/sun.jpg", true,
-        0.0f, 0.0f, 0.1f, glm::vec3(0.0f, 1.0f, 0.0f),
-        std::nullopt
-    );
-    sun.mesh = std::make_unique<Planet>(1.0f, 64, 64);
-    scenario.bodies.push_back(std::move(sun));
+    CelestialBody sun("Sun", "textures/sun.jpg", true, std::nullopt);
+    sun.mesh = LodMesh(meshes.acquireSphereLod(64));
+    addBody(scenario, std::move(sun), BodyMotion{2.0f, 0.0f, 0.0f, 0.0f, 0.1f, glm::vec3(0.0f, 1.0f, 0.0f), sunGm});
 
     // Earth
-    CelestialBody earth(
-        "Earth", earthRadius, "textures/earth.jpg", false,
-        earthOrbitRadius, earthOrbitSpeed, earthRotationSpeed, glm::vec3(0.0f, 1.0f, 0.0f),
-        "Sun");
-    earth.mesh = std::make_unique<Planet>(1.0f, 64, 64);
-    scenario.bodies.push_back(std::move(earth));
+    CelestialBody earth("Earth", "textures/earth.jpg", false, "Sun");
+    earth.mesh = LodMesh(meshes.acquireSphereLod(64));
+    addBody(scenario, std::move(earth),
+            BodyMotion{earthRadius, earthOrbitRadius, earthOrbitSpeed, 0.0f, earthRotationSpeed, glm::vec3(0.0f, 1.0f, 0.0f), earthGm});
 
     // Moon
-    CelestialBody moon(
-        "Moon", earthRadius * 0.27f, "textures/moon.jpg", false,
-        earthRadius * 2.0f + 0.5f, earthOrbitSpeed * 2.0f, earthRotationSpeed * 0.1f, glm::vec3(0.0f, 1.0f, 0.0f),
-        "Earth"
-    );
-    moon.mesh = std::make_unique<Planet>(1.0f, 32, 32);
-    scenario.bodies.push_back(std::move(moon));
+    CelestialBody moon("Moon", "textures/moon.jpg", false, "Earth");
+    moon.orbitColor = glm::vec3(0.5f, 0.5f, 1.0f);
+    moon.mesh = LodMesh(meshes.acquireSphereLod(32));
+    addBody(scenario, std::move(moon),
+            BodyMotion{earthRadius * 0.27f, earthRadius * 4.0f, earthOrbitSpeed * 3.0f, 0.0f, earthRotationSpeed * 0.1f, glm::vec3(0.0f, 1.0f, 0.0f), earthGm * 0.0123f});
 
+    resolveHierarchy(scenario);
     return scenario;
-}
\ No newline at end of file
+}
+
+void addSatellites(Scenario &scenario, MeshCache &meshes, const std::string &parentName, unsigned int count, unsigned int seed)
+{
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> radius(0.01f, 0.04f);
+    std::uniform_real_distribution<float> orbitRadius(0.8f, 3.5f);
+    std::uniform_real_distribution<float> orbitSpeed(0.5f, 4.0f);
+    std::uniform_real_distribution<float> phase(0.0f, 2.0f * glm::pi<float>());
+
+    // One LOD chain for the whole swarm; at their size the coarse levels are what gets drawn.
+    const LodChain *lod = meshes.acquireSphereLod(32);
+    scenario.bodies.reserve(scenario.bodies.size() + count);
+    scenario.state.reserve(scenario.state.size() + count);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        CelestialBody satellite(parentName + " satellite " + std::to_string(i + 1), "textures/moon.jpg", false, parentName);
+        satellite.showOrbit = false;
+        satellite.mesh = LodMesh(lod);
+        BodyMotion motion;
+        motion.radius = radius(random);
+        motion.orbitRadius = orbitRadius(random);
+        motion.orbitSpeed = orbitSpeed(random);
+        motion.orbitPhase = phase(random);
+        motion.rotationSpeed = 0.1f;
+        addBody(scenario, std::move(satellite), motion);
+    }
+    resolveHierarchy(scenario);
+}
+
+BodyHandle addBody(Scenario &scenario, CelestialBody body, const BodyMotion &motion)
+{
+    BodyHandle handle = (BodyHandle)scenario.slots.size();
+    scenario.slots.push_back((std::uint32_t)scenario.bodies.size());
+    scenario.handles.push_back(handle);
+    scenario.names.emplace(body.name, handle);
+    scenario.bodies.push_back(std::move(body));
+    scenario.state.add(motion);
+    return handle;
+}
+
+BodyHandle findBody(const Scenario &scenario, const std::string &name)
+{
+    auto found = scenario.names.find(name);
+    return found == scenario.names.end() ? kNoBody : found->second;
+}
+
+void resolveHierarchy(Scenario &scenario)
+{
+    std::vector<CelestialBody> &bodies = scenario.bodies;
+    const int count = (int)bodies.size();
+
+    std::vector<int> parents(count, -1);
+    for (int i = 0; i < count; ++i)
+    {
+        if (!bodies[i].parentName)
+            continue;
+        int parent = bodySlot(scenario, findBody(scenario, *bodies[i].parentName));
+        if (parent != i)
+            parents[i] = parent;
+    }
+
+    // Depth in the tree: walk up to the first ancestor of known depth, then
+    // fill the path back down. Reaching a body already on the path is a
+    // cycle, which is cut there.
+    std::vector<int> depths(count, -1);
+    std::vector<char> onPath(count, 0);
+    std::vector<int> path;
+    for (int i = 0; i < count; ++i)
+    {
+        int j = i;
+        while (j >= 0 && depths[j] < 0 && !onPath[j])
+        {
+            onPath[j] = 1;
+            path.push_back(j);
+            j = parents[j];
+        }
+        if (j >= 0 && depths[j] < 0)
+        {
+            parents[j] = -1;
+            depths[j] = 0;
+        }
+        for (auto it = path.rbegin(); it != path.rend(); ++it)
+        {
+            if (depths[*it] < 0)
+                depths[*it] = parents[*it] >= 0 ? depths[parents[*it]] + 1 : 0;
+            onPath[*it] = 0;
+        }
+        path.clear();
+    }
+
+    // Stable, so siblings keep the order they were added in.
+    std::vector<std::size_t> order(count);
+    for (int i = 0; i < count; ++i)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return depths[a] < depths[b]; });
+
+    std::vector<int> newSlot(count);
+    for (int i = 0; i < count; ++i)
+        newSlot[order[i]] = i;
+
+    std::vector<CelestialBody> sorted;
+    sorted.reserve(bodies.size());
+    std::vector<BodyHandle> handles(count);
+    for (int i = 0; i < count; ++i)
+    {
+        sorted.push_back(std::move(bodies[order[i]]));
+        handles[i] = scenario.handles[order[i]];
+        scenario.slots[handles[i]] = (std::uint32_t)i;
+    }
+    bodies = std::move(sorted);
+    scenario.handles = std::move(handles);
+
+    scenario.state.permute(order);
+    for (int i = 0; i < count; ++i)
+        scenario.state.parent[i] = parents[order[i]] >= 0 ? newSlot[parents[order[i]]] : -1;
+}
+
+void updateTransforms(Scenario &scenario, float t)
+{
+    updateBodyTransforms(scenario.state, t);
+}
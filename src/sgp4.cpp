@@ -0,0 +1,1566 @@
+#include "../include/sgp4.h"
+#include "../include/mapped_file.h"
+#include "../include/parallel.h"
+#include "../include/profiler.h"
+#include "../include/simd_math.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+#ifdef SIMD_MATH_X86
+#define SGP4_X86_KERNELS 1
+#endif
+
+namespace
+{
+    const double kPi = 3.14159265358979323846;
+    const double kTwoPi = 6.28318530717958647693;
+    const double kJ2000 = 2451545.0;
+
+    // WGS-72, which the element sets are fitted with.
+    const double kMu = 398600.8; // km^3 / s^2
+    const double kEarthRadius = kSgp4EarthRadiusKm;
+    const double kXke = 0.07436691613317342; // 60 / sqrt(kEarthRadius^3 / kMu): sqrt(mu) in earth radii^1.5 per minute
+    const double kJ2 = 0.001082616;
+    const double kJ3 = -0.00000253881;
+    const double kJ4 = -0.00000165597;
+    const double kJ3OverJ2 = kJ3 / kJ2;
+    const double kVelocity = kEarthRadius * kXke / 60.0; // earth radii per minute to km/s
+    const double kTwoThirds = 2.0 / 3.0;
+
+    // Parallel::threadCount()'s minimum; starting a thread costs about 100 satellites of SGP4.
+    const std::size_t kMinSatellitesPerThread = 2048;
+    // update() hands out work in chunks this size and checks the clock between them.
+    const std::size_t kChunk = 256;
+
+    enum NearEarthColumn
+    {
+        kEpoch,
+        kNo,      // un-Kozai'd mean motion
+        kEcco,
+        kInclo,
+        kArgpo,
+        kNodeo,
+        kMo,
+        kBstar,
+        kMdot,
+        kArgpdot,
+        kNodedot,
+        kNodecf,
+        kCc1,
+        kCc4,
+        kCc5,
+        kT2cof,
+        kOmgcof,
+        kXmcof,
+        kEta,
+        kDelmo,
+        kSinmao,
+        kD2,
+        kD3,
+        kD4,
+        kT3cof,
+        kT4cof,
+        kT5cof,
+        kFull,    // 1 for the full drag model, 0 for the simplified one (perigee under 220 km)
+        kAycof,
+        kXlcof,
+        kCon41,
+        kX1mth2,
+        kX7thm1,
+        kCosio,
+        kSinio,
+        kABase,   // (xke / no)^(2/3)
+        kNearEarthColumnCount
+    };
+    static_assert(kNearEarthColumnCount == Sgp4Propagator::kNearEarthColumns, "Sgp4Propagator::kNearEarthColumns");
+
+    using Columns = const double *const *;
+
+    struct States
+    {
+        double *x, *y, *z, *vx, *vy, *vz; // velocities may be null
+    };
+
+    using Kernel = void (*)(Columns, const States &, std::size_t, std::size_t, double);
+
+    /** @brief Greenwich mean sidereal time of a UT1 Julian date (IAU 1982), radians. */
+    double greenwichSiderealTime(double jd)
+    {
+        double tut1 = (jd - kJ2000) / 36525.0;
+        double seconds = -6.2e-6 * tut1 * tut1 * tut1 + 0.093104 * tut1 * tut1 + (876600.0 * 3600.0 + 8640184.812866) * tut1 + 67310.54841;
+        double angle = std::fmod(seconds * (kPi / 180.0) / 240.0, kTwoPi);
+        return angle < 0.0 ? angle + kTwoPi : angle;
+    }
+
+    void writeState(const States &states, std::size_t i, const double state[6])
+    {
+        states.x[i] = state[0];
+        states.y[i] = state[1];
+        states.z[i] = state[2];
+        if (states.vx)
+        {
+            states.vx[i] = state[3];
+            states.vy[i] = state[4];
+            states.vz[i] = state[5];
+        }
+    }
+
+    void writeNaN(const States &states, std::size_t i)
+    {
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        states.x[i] = states.y[i] = states.z[i] = nan;
+        if (states.vx)
+            states.vx[i] = states.vy[i] = states.vz[i] = nan;
+    }
+
+    /**
+     * @brief From the secular and long-period elements on: Kepler's equation
+     * for the eccentric longitude, the short-period periodics and the TEME
+     * state (the end of Vallado's sgp4()). @return false if the orbit failed
+     */
+    bool shortPeriodic(double am, double nm, double ep, double xincp, double argpp, double nodep, double mp,
+                       double aycof, double xlcof, double con41, double x1mth2, double x7thm1, double state[6])
+    {
+        double sinip = std::sin(xincp), cosip = std::cos(xincp);
+        double axnl = ep * std::cos(argpp);
+        double temp = 1.0 / (am * (1.0 - ep * ep));
+        double aynl = ep * std::sin(argpp) + temp * aycof;
+        double xl = mp + argpp + nodep + temp * xlcof * axnl;
+
+        double u = std::fmod(xl - nodep, kTwoPi);
+        double eo1 = u, tem5 = 9999.9, sineo1 = 0.0, coseo1 = 1.0;
+        for (int ktr = 1; std::abs(tem5) >= 1e-12 && ktr <= 10; ++ktr)
+        {
+            sineo1 = std::sin(eo1);
+            coseo1 = std::cos(eo1);
+            tem5 = 1.0 - coseo1 * axnl - sineo1 * aynl;
+            tem5 = (u - aynl * coseo1 + axnl * sineo1 - eo1) / tem5;
+            tem5 = std::min(std::max(tem5, -0.95), 0.95);
+            eo1 += tem5;
+        }
+
+        double ecose = axnl * coseo1 + aynl * sineo1;
+        double esine = axnl * sineo1 - aynl * coseo1;
+        double el2 = axnl * axnl + aynl * aynl;
+        double pl = am * (1.0 - el2);
+        if (pl < 0.0)
+            return false;
+        double rl = am * (1.0 - ecose);
+        double rdotl = std::sqrt(am) * esine / rl;
+        double rvdotl = std::sqrt(pl) / rl;
+        double betal = std::sqrt(1.0 - el2);
+        temp = esine / (1.0 + betal);
+        double sinu = am / rl * (sineo1 - aynl - axnl * temp);
+        double cosu = am / rl * (coseo1 - axnl + aynl * temp);
+        double su = std::atan2(sinu, cosu);
+        double sin2u = (cosu + cosu) * sinu;
+        double cos2u = 1.0 - 2.0 * sinu * sinu;
+        temp = 1.0 / pl;
+        double temp1 = 0.5 * kJ2 * temp;
+        double temp2 = temp1 * temp;
+
+        double mrt = rl * (1.0 - 1.5 * temp2 * betal * con41) + 0.5 * temp1 * x1mth2 * cos2u;
+        su -= 0.25 * temp2 * x7thm1 * sin2u;
+        double xnode = nodep + 1.5 * temp2 * cosip * sin2u;
+        double xinc = xincp + 1.5 * temp2 * cosip * sinip * cos2u;
+        double mvt = rdotl - nm * temp1 * x1mth2 * sin2u / kXke;
+        double rvdot = rvdotl + nm * temp1 * (x1mth2 * cos2u + 1.5 * con41) / kXke;
+        if (mrt < 1.0)
+            return false;
+
+        double sinsu = std::sin(su), cossu = std::cos(su);
+        double snod = std::sin(xnode), cnod = std::cos(xnode);
+        double sini = std::sin(xinc), cosi = std::cos(xinc);
+        double xmx = -snod * cosi, xmy = cnod * cosi;
+        double ux = xmx * sinsu + cnod * cossu, uy = xmy * sinsu + snod * cossu, uz = sini * sinsu;
+        double vx = xmx * cossu - cnod * sinsu, vy = xmy * cossu - snod * sinsu, vz = sini * cossu;
+        state[0] = mrt * ux * kEarthRadius;
+        state[1] = mrt * uy * kEarthRadius;
+        state[2] = mrt * uz * kEarthRadius;
+        state[3] = (mvt * ux + rvdot * vx) * kVelocity;
+        state[4] = (mvt * uy + rvdot * vy) * kVelocity;
+        state[5] = (mvt * uz + rvdot * vz) * kVelocity;
+        return true;
+    }
+
+    /** @brief SGP4 for near-Earth satellite @p i, @p t minutes from its epoch. */
+    bool nearEarthState(Columns c, std::size_t i, double t, double state[6])
+    {
+        double xmdf = c[kMo][i] + c[kMdot][i] * t;
+        double argpdf = c[kArgpo][i] + c[kArgpdot][i] * t;
+        double nodedf = c[kNodeo][i] + c[kNodedot][i] * t;
+        double argpm = argpdf, mm = xmdf, t2 = t * t;
+        double nodem = nodedf + c[kNodecf][i] * t2;
+        double tempa = 1.0 - c[kCc1][i] * t;
+        double tempe = c[kBstar][i] * c[kCc4][i] * t;
+        double templ = c[kT2cof][i] * t2;
+        if (c[kFull][i] != 0.0)
+        {
+            double delomg = c[kOmgcof][i] * t;
+            double delmtemp = 1.0 + c[kEta][i] * std::cos(xmdf);
+            double delm = c[kXmcof][i] * (delmtemp * delmtemp * delmtemp - c[kDelmo][i]);
+            double temp = delomg + delm;
+            mm = xmdf + temp;
+            argpm = argpdf - temp;
+            double t3 = t2 * t, t4 = t3 * t;
+            tempa = tempa - c[kD2][i] * t2 - c[kD3][i] * t3 - c[kD4][i] * t4;
+            tempe += c[kBstar][i] * c[kCc5][i] * (std::sin(mm) - c[kSinmao][i]);
+            templ = templ + c[kT3cof][i] * t3 + t4 * (c[kT4cof][i] + t * c[kT5cof][i]);
+        }
+
+        double am = c[kABase][i] * tempa * tempa;
+        double nm = kXke / (am * std::sqrt(am));
+        double em = c[kEcco][i] - tempe;
+        if (em >= 1.0 || em < -0.001)
+            return false;
+        em = std::max(em, 1e-6);
+        mm += c[kNo][i] * templ;
+        double xlm = mm + argpm + nodem;
+        nodem = std::fmod(nodem, kTwoPi);
+        argpm = std::fmod(argpm, kTwoPi);
+        xlm = std::fmod(xlm, kTwoPi);
+        mm = std::fmod(xlm - argpm - nodem, kTwoPi);
+        return shortPeriodic(am, nm, em, c[kInclo][i], argpm, nodem, mm, c[kAycof][i], c[kXlcof][i],
+                             c[kCon41][i], c[kX1mth2][i], c[kX7thm1][i], state);
+    }
+
+    void scalarRange(Columns c, const States &states, std::size_t begin, std::size_t end, double jd)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            double state[6];
+            if (nearEarthState(c, i, (jd - c[kEpoch][i]) * 1440.0, state))
+                writeState(states, i, state);
+            else
+                writeNaN(states, i);
+        }
+    }
+
+#ifdef SGP4_X86_KERNELS
+    // The kernels follow nearEarthState() lane by lane. Angles that grow
+    // with time are reduced to [-pi, pi] before their sine is taken instead
+    // of fmod; the argument of latitude is rotated by its short-period
+    // correction rather than rebuilt with atan2; a lane whose orbit fails
+    // any of the scalar checks is written as NaN.
+    __attribute__((target("avx2,fma")))
+    inline void sinCosAny4(__m256d x, __m256d &s, __m256d &c)
+    {
+        x = _mm256_fnmadd_pd(_mm256_set1_pd(kTwoPi), _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(1.0 / kTwoPi)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC), x);
+        simd::sinCos4(x, s, c);
+    }
+
+    __attribute__((target("avx2,fma")))
+    void avx2Range(Columns c, const States &states, std::size_t begin, std::size_t end, double jd)
+    {
+        const __m256d one = _mm256_set1_pd(1.0);
+        const __m256d signBit = _mm256_set1_pd(-0.0);
+        std::size_t i = begin;
+        for (; i + 4 <= end; i += 4)
+        {
+            __m256d t = _mm256_mul_pd(_mm256_sub_pd(_mm256_set1_pd(jd), _mm256_loadu_pd(c[kEpoch] + i)), _mm256_set1_pd(1440.0));
+            __m256d t2 = _mm256_mul_pd(t, t), t3 = _mm256_mul_pd(t2, t), t4 = _mm256_mul_pd(t3, t);
+            __m256d xmdf = _mm256_fmadd_pd(_mm256_loadu_pd(c[kMdot] + i), t, _mm256_loadu_pd(c[kMo] + i));
+            __m256d argpdf = _mm256_fmadd_pd(_mm256_loadu_pd(c[kArgpdot] + i), t, _mm256_loadu_pd(c[kArgpo] + i));
+            __m256d nodem = _mm256_fmadd_pd(_mm256_loadu_pd(c[kNodedot] + i), t, _mm256_loadu_pd(c[kNodeo] + i));
+            nodem = _mm256_fmadd_pd(_mm256_loadu_pd(c[kNodecf] + i), t2, nodem);
+            __m256d bstar = _mm256_loadu_pd(c[kBstar] + i);
+            __m256d full = _mm256_loadu_pd(c[kFull] + i);
+
+            // Drag: the full model's terms are zero or masked out for the simplified one.
+            __m256d sinXmdf, cosXmdf;
+            sinCosAny4(xmdf, sinXmdf, cosXmdf);
+            __m256d delmtemp = _mm256_fmadd_pd(_mm256_loadu_pd(c[kEta] + i), cosXmdf, one);
+            __m256d delm = _mm256_mul_pd(_mm256_loadu_pd(c[kXmcof] + i), _mm256_fmsub_pd(_mm256_mul_pd(delmtemp, delmtemp), delmtemp, _mm256_loadu_pd(c[kDelmo] + i)));
+            __m256d temp = _mm256_mul_pd(_mm256_fmadd_pd(_mm256_loadu_pd(c[kOmgcof] + i), t, delm), full);
+            __m256d mm = _mm256_add_pd(xmdf, temp);
+            __m256d argpm = _mm256_sub_pd(argpdf, temp);
+            __m256d tempa = _mm256_fnmadd_pd(_mm256_loadu_pd(c[kCc1] + i), t, one);
+            tempa = _mm256_fnmadd_pd(_mm256_loadu_pd(c[kD2] + i), t2, tempa);
+            tempa = _mm256_fnmadd_pd(_mm256_loadu_pd(c[kD3] + i), t3, tempa);
+            tempa = _mm256_fnmadd_pd(_mm256_loadu_pd(c[kD4] + i), t4, tempa);
+            __m256d sinMm, cosMm;
+            sinCosAny4(mm, sinMm, cosMm);
+            __m256d tempe = _mm256_mul_pd(_mm256_mul_pd(bstar, _mm256_loadu_pd(c[kCc4] + i)), t);
+            tempe = _mm256_fmadd_pd(_mm256_mul_pd(_mm256_mul_pd(full, bstar), _mm256_loadu_pd(c[kCc5] + i)), _mm256_sub_pd(sinMm, _mm256_loadu_pd(c[kSinmao] + i)), tempe);
+            __m256d templ = _mm256_mul_pd(_mm256_loadu_pd(c[kT2cof] + i), t2);
+            templ = _mm256_fmadd_pd(_mm256_loadu_pd(c[kT3cof] + i), t3, templ);
+            templ = _mm256_fmadd_pd(t4, _mm256_fmadd_pd(t, _mm256_loadu_pd(c[kT5cof] + i), _mm256_loadu_pd(c[kT4cof] + i)), templ);
+
+            __m256d am = _mm256_mul_pd(_mm256_loadu_pd(c[kABase] + i), _mm256_mul_pd(tempa, tempa));
+            __m256d sqrtAm = _mm256_sqrt_pd(am);
+            __m256d nm = _mm256_div_pd(_mm256_set1_pd(kXke), _mm256_mul_pd(am, sqrtAm));
+            __m256d em = _mm256_sub_pd(_mm256_loadu_pd(c[kEcco] + i), tempe);
+            __m256d bad = _mm256_or_pd(_mm256_cmp_pd(em, one, _CMP_GE_OQ), _mm256_cmp_pd(em, _mm256_set1_pd(-0.001), _CMP_LT_OQ));
+            em = _mm256_max_pd(_mm256_andnot_pd(bad, em), _mm256_set1_pd(1e-6)); // failed lanes go on as circular orbits
+            mm = _mm256_fmadd_pd(_mm256_loadu_pd(c[kNo] + i), templ, mm);
+
+            // Long-period periodics.
+            __m256d sinArgp, cosArgp;
+            sinCosAny4(argpm, sinArgp, cosArgp);
+            __m256d axnl = _mm256_mul_pd(em, cosArgp);
+            temp = _mm256_div_pd(one, _mm256_mul_pd(am, _mm256_fnmadd_pd(em, em, one)));
+            __m256d aynl = _mm256_fmadd_pd(em, sinArgp, _mm256_mul_pd(temp, _mm256_loadu_pd(c[kAycof] + i)));
+            __m256d u = _mm256_add_pd(_mm256_add_pd(mm, argpm), _mm256_mul_pd(_mm256_mul_pd(temp, _mm256_loadu_pd(c[kXlcof] + i)), axnl));
+            u = _mm256_fnmadd_pd(_mm256_set1_pd(kTwoPi), _mm256_round_pd(_mm256_mul_pd(u, _mm256_set1_pd(1.0 / kTwoPi)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC), u);
+
+            // Kepler's equation for the eccentric longitude; converged lanes keep their values.
+            __m256d eo1 = u, sineo1 = _mm256_setzero_pd(), coseo1 = one;
+            __m256d active = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+            for (int k = 0; k < 10 && _mm256_movemask_pd(active); ++k)
+            {
+                __m256d s, co;
+                simd::sinCos4(eo1, s, co);
+                __m256d denominator = _mm256_fnmadd_pd(s, aynl, _mm256_fnmadd_pd(co, axnl, one));
+                __m256d tem5 = _mm256_div_pd(_mm256_sub_pd(_mm256_fmadd_pd(axnl, s, _mm256_fnmadd_pd(aynl, co, u)), eo1), denominator);
+                tem5 = _mm256_min_pd(_mm256_max_pd(tem5, _mm256_set1_pd(-0.95)), _mm256_set1_pd(0.95));
+                sineo1 = _mm256_blendv_pd(sineo1, s, active);
+                coseo1 = _mm256_blendv_pd(coseo1, co, active);
+                eo1 = _mm256_add_pd(eo1, _mm256_and_pd(tem5, active));
+                active = _mm256_and_pd(active, _mm256_cmp_pd(_mm256_andnot_pd(signBit, tem5), _mm256_set1_pd(1e-12), _CMP_GE_OQ));
+            }
+
+            // Short-period periodics.
+            __m256d ecose = _mm256_fmadd_pd(axnl, coseo1, _mm256_mul_pd(aynl, sineo1));
+            __m256d esine = _mm256_fmsub_pd(axnl, sineo1, _mm256_mul_pd(aynl, coseo1));
+            __m256d el2 = _mm256_fmadd_pd(axnl, axnl, _mm256_mul_pd(aynl, aynl));
+            __m256d pl = _mm256_mul_pd(am, _mm256_sub_pd(one, el2));
+            bad = _mm256_or_pd(bad, _mm256_cmp_pd(pl, _mm256_setzero_pd(), _CMP_LT_OQ));
+            __m256d rl = _mm256_mul_pd(am, _mm256_sub_pd(one, ecose));
+            __m256d invRl = _mm256_div_pd(one, rl);
+            __m256d rdotl = _mm256_mul_pd(_mm256_mul_pd(sqrtAm, esine), invRl);
+            __m256d rvdotl = _mm256_mul_pd(_mm256_sqrt_pd(pl), invRl);
+            __m256d betal = _mm256_sqrt_pd(_mm256_sub_pd(one, el2));
+            temp = _mm256_div_pd(esine, _mm256_add_pd(one, betal));
+            __m256d amOverRl = _mm256_mul_pd(am, invRl);
+            __m256d sinu = _mm256_mul_pd(amOverRl, _mm256_fnmadd_pd(axnl, temp, _mm256_sub_pd(sineo1, aynl)));
+            __m256d cosu = _mm256_mul_pd(amOverRl, _mm256_fmadd_pd(aynl, temp, _mm256_sub_pd(coseo1, axnl)));
+            __m256d sin2u = _mm256_mul_pd(_mm256_add_pd(cosu, cosu), sinu);
+            __m256d cos2u = _mm256_fnmadd_pd(_mm256_add_pd(sinu, sinu), sinu, one);
+            temp = _mm256_div_pd(one, pl);
+            __m256d temp1 = _mm256_mul_pd(_mm256_set1_pd(0.5 * kJ2), temp);
+            __m256d temp2 = _mm256_mul_pd(temp1, temp);
+
+            __m256d con41 = _mm256_loadu_pd(c[kCon41] + i);
+            __m256d x1mth2 = _mm256_loadu_pd(c[kX1mth2] + i);
+            __m256d cosio = _mm256_loadu_pd(c[kCosio] + i);
+            __m256d mrt = _mm256_mul_pd(rl, _mm256_fnmadd_pd(_mm256_mul_pd(_mm256_set1_pd(1.5), temp2), _mm256_mul_pd(betal, con41), one));
+            mrt = _mm256_fmadd_pd(_mm256_mul_pd(_mm256_set1_pd(0.5), temp1), _mm256_mul_pd(x1mth2, cos2u), mrt);
+            bad = _mm256_or_pd(bad, _mm256_cmp_pd(mrt, one, _CMP_LT_OQ));
+            __m256d delta = _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(0.25), temp2), _mm256_mul_pd(_mm256_loadu_pd(c[kX7thm1] + i), sin2u));
+            __m256d sinDelta, cosDelta;
+            simd::sinCos4(delta, sinDelta, cosDelta);
+            __m256d sinsu = _mm256_fmsub_pd(sinu, cosDelta, _mm256_mul_pd(cosu, sinDelta)); // sin(su - delta)
+            __m256d cossu = _mm256_fmadd_pd(cosu, cosDelta, _mm256_mul_pd(sinu, sinDelta));
+            __m256d xnode = _mm256_fmadd_pd(_mm256_mul_pd(_mm256_set1_pd(1.5), temp2), _mm256_mul_pd(cosio, sin2u), nodem);
+            __m256d xinc = _mm256_fmadd_pd(_mm256_mul_pd(_mm256_set1_pd(1.5), temp2), _mm256_mul_pd(_mm256_mul_pd(cosio, _mm256_loadu_pd(c[kSinio] + i)), cos2u),
+                                           _mm256_loadu_pd(c[kInclo] + i));
+            __m256d nmTemp1 = _mm256_mul_pd(_mm256_mul_pd(nm, temp1), _mm256_set1_pd(1.0 / kXke));
+            __m256d mvt = _mm256_fnmadd_pd(nmTemp1, _mm256_mul_pd(x1mth2, sin2u), rdotl);
+            __m256d rvdot = _mm256_fmadd_pd(nmTemp1, _mm256_fmadd_pd(x1mth2, cos2u, _mm256_mul_pd(_mm256_set1_pd(1.5), con41)), rvdotl);
+
+            __m256d snod, cnod, sini, cosi;
+            sinCosAny4(xnode, snod, cnod);
+            simd::sinCos4(xinc, sini, cosi);
+            __m256d xmx = _mm256_xor_pd(_mm256_mul_pd(snod, cosi), signBit), xmy = _mm256_mul_pd(cnod, cosi);
+            __m256d ux = _mm256_fmadd_pd(xmx, sinsu, _mm256_mul_pd(cnod, cossu));
+            __m256d uy = _mm256_fmadd_pd(xmy, sinsu, _mm256_mul_pd(snod, cossu));
+            __m256d uz = _mm256_mul_pd(sini, sinsu);
+            __m256d nan = _mm256_set1_pd(std::numeric_limits<double>::quiet_NaN());
+            __m256d radius = _mm256_blendv_pd(_mm256_mul_pd(mrt, _mm256_set1_pd(kEarthRadius)), nan, bad);
+            _mm256_storeu_pd(states.x + i, _mm256_mul_pd(radius, ux));
+            _mm256_storeu_pd(states.y + i, _mm256_mul_pd(radius, uy));
+            _mm256_storeu_pd(states.z + i, _mm256_mul_pd(radius, uz));
+            if (states.vx)
+            {
+                __m256d vx = _mm256_fmsub_pd(xmx, cossu, _mm256_mul_pd(cnod, sinsu));
+                __m256d vy = _mm256_fmsub_pd(xmy, cossu, _mm256_mul_pd(snod, sinsu));
+                __m256d vz = _mm256_mul_pd(sini, cossu);
+                __m256d radial = _mm256_blendv_pd(_mm256_mul_pd(mvt, _mm256_set1_pd(kVelocity)), nan, bad);
+                __m256d along = _mm256_mul_pd(rvdot, _mm256_set1_pd(kVelocity));
+                _mm256_storeu_pd(states.vx + i, _mm256_fmadd_pd(radial, ux, _mm256_mul_pd(along, vx)));
+                _mm256_storeu_pd(states.vy + i, _mm256_fmadd_pd(radial, uy, _mm256_mul_pd(along, vy)));
+                _mm256_storeu_pd(states.vz + i, _mm256_fmadd_pd(radial, uz, _mm256_mul_pd(along, vz)));
+            }
+        }
+        scalarRange(c, states, i, end, jd);
+    }
+
+    __attribute__((target("avx512f")))
+    inline void sinCosAny8(__m512d x, __m512d &s, __m512d &c)
+    {
+        x = _mm512_fnmadd_pd(_mm512_set1_pd(kTwoPi), _mm512_maskz_roundscale_pd(0xff, _mm512_mul_pd(x, _mm512_set1_pd(1.0 / kTwoPi)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC), x);
+        simd::sinCos8(x, s, c);
+    }
+
+    __attribute__((target("avx512f")))
+    void avx512Range(Columns c, const States &states, std::size_t begin, std::size_t end, double jd)
+    {
+        const __m512d one = _mm512_set1_pd(1.0);
+        const __m512d zero = _mm512_setzero_pd();
+        std::size_t i = begin;
+        for (; i + 8 <= end; i += 8)
+        {
+            // As avx2Range().
+            __m512d t = _mm512_mul_pd(_mm512_sub_pd(_mm512_set1_pd(jd), _mm512_loadu_pd(c[kEpoch] + i)), _mm512_set1_pd(1440.0));
+            __m512d t2 = _mm512_mul_pd(t, t), t3 = _mm512_mul_pd(t2, t), t4 = _mm512_mul_pd(t3, t);
+            __m512d xmdf = _mm512_fmadd_pd(_mm512_loadu_pd(c[kMdot] + i), t, _mm512_loadu_pd(c[kMo] + i));
+            __m512d argpdf = _mm512_fmadd_pd(_mm512_loadu_pd(c[kArgpdot] + i), t, _mm512_loadu_pd(c[kArgpo] + i));
+            __m512d nodem = _mm512_fmadd_pd(_mm512_loadu_pd(c[kNodedot] + i), t, _mm512_loadu_pd(c[kNodeo] + i));
+            nodem = _mm512_fmadd_pd(_mm512_loadu_pd(c[kNodecf] + i), t2, nodem);
+            __m512d bstar = _mm512_loadu_pd(c[kBstar] + i);
+            __m512d full = _mm512_loadu_pd(c[kFull] + i);
+
+            __m512d sinXmdf, cosXmdf;
+            sinCosAny8(xmdf, sinXmdf, cosXmdf);
+            __m512d delmtemp = _mm512_fmadd_pd(_mm512_loadu_pd(c[kEta] + i), cosXmdf, one);
+            __m512d delm = _mm512_mul_pd(_mm512_loadu_pd(c[kXmcof] + i), _mm512_fmsub_pd(_mm512_mul_pd(delmtemp, delmtemp), delmtemp, _mm512_loadu_pd(c[kDelmo] + i)));
+            __m512d temp = _mm512_mul_pd(_mm512_fmadd_pd(_mm512_loadu_pd(c[kOmgcof] + i), t, delm), full);
+            __m512d mm = _mm512_add_pd(xmdf, temp);
+            __m512d argpm = _mm512_sub_pd(argpdf, temp);
+            __m512d tempa = _mm512_fnmadd_pd(_mm512_loadu_pd(c[kCc1] + i), t, one);
+            tempa = _mm512_fnmadd_pd(_mm512_loadu_pd(c[kD2] + i), t2, tempa);
+            tempa = _mm512_fnmadd_pd(_mm512_loadu_pd(c[kD3] + i), t3, tempa);
+            tempa = _mm512_fnmadd_pd(_mm512_loadu_pd(c[kD4] + i), t4, tempa);
+            __m512d sinMm, cosMm;
+            sinCosAny8(mm, sinMm, cosMm);
+            __m512d tempe = _mm512_mul_pd(_mm512_mul_pd(bstar, _mm512_loadu_pd(c[kCc4] + i)), t);
+            tempe = _mm512_fmadd_pd(_mm512_mul_pd(_mm512_mul_pd(full, bstar), _mm512_loadu_pd(c[kCc5] + i)), _mm512_sub_pd(sinMm, _mm512_loadu_pd(c[kSinmao] + i)), tempe);
+            __m512d templ = _mm512_mul_pd(_mm512_loadu_pd(c[kT2cof] + i), t2);
+            templ = _mm512_fmadd_pd(_mm512_loadu_pd(c[kT3cof] + i), t3, templ);
+            templ = _mm512_fmadd_pd(t4, _mm512_fmadd_pd(t, _mm512_loadu_pd(c[kT5cof] + i), _mm512_loadu_pd(c[kT4cof] + i)), templ);
+
+            __m512d am = _mm512_mul_pd(_mm512_loadu_pd(c[kABase] + i), _mm512_mul_pd(tempa, tempa));
+            __m512d sqrtAm = _mm512_maskz_sqrt_pd(0xff, am);
+            __m512d nm = _mm512_div_pd(_mm512_set1_pd(kXke), _mm512_mul_pd(am, sqrtAm));
+            __m512d em = _mm512_sub_pd(_mm512_loadu_pd(c[kEcco] + i), tempe);
+            __mmask8 bad = _mm512_cmp_pd_mask(em, one, _CMP_GE_OQ) | _mm512_cmp_pd_mask(em, _mm512_set1_pd(-0.001), _CMP_LT_OQ);
+            em = _mm512_maskz_max_pd(0xff, _mm512_maskz_mov_pd(~bad, em), _mm512_set1_pd(1e-6));
+            mm = _mm512_fmadd_pd(_mm512_loadu_pd(c[kNo] + i), templ, mm);
+
+            __m512d sinArgp, cosArgp;
+            sinCosAny8(argpm, sinArgp, cosArgp);
+            __m512d axnl = _mm512_mul_pd(em, cosArgp);
+            temp = _mm512_div_pd(one, _mm512_mul_pd(am, _mm512_fnmadd_pd(em, em, one)));
+            __m512d aynl = _mm512_fmadd_pd(em, sinArgp, _mm512_mul_pd(temp, _mm512_loadu_pd(c[kAycof] + i)));
+            __m512d u = _mm512_add_pd(_mm512_add_pd(mm, argpm), _mm512_mul_pd(_mm512_mul_pd(temp, _mm512_loadu_pd(c[kXlcof] + i)), axnl));
+            u = _mm512_fnmadd_pd(_mm512_set1_pd(kTwoPi), _mm512_maskz_roundscale_pd(0xff, _mm512_mul_pd(u, _mm512_set1_pd(1.0 / kTwoPi)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC), u);
+
+            __m512d eo1 = u, sineo1 = zero, coseo1 = one;
+            __mmask8 active = 0xff;
+            for (int k = 0; k < 10 && active; ++k)
+            {
+                __m512d s, co;
+                simd::sinCos8(eo1, s, co);
+                __m512d denominator = _mm512_fnmadd_pd(s, aynl, _mm512_fnmadd_pd(co, axnl, one));
+                __m512d tem5 = _mm512_div_pd(_mm512_sub_pd(_mm512_fmadd_pd(axnl, s, _mm512_fnmadd_pd(aynl, co, u)), eo1), denominator);
+                tem5 = _mm512_maskz_min_pd(0xff, _mm512_maskz_max_pd(0xff, tem5, _mm512_set1_pd(-0.95)), _mm512_set1_pd(0.95));
+                sineo1 = _mm512_mask_blend_pd(active, sineo1, s);
+                coseo1 = _mm512_mask_blend_pd(active, coseo1, co);
+                eo1 = _mm512_mask_add_pd(eo1, active, eo1, tem5);
+                active &= _mm512_cmp_pd_mask(_mm512_abs_pd(tem5), _mm512_set1_pd(1e-12), _CMP_GE_OQ);
+            }
+
+            __m512d ecose = _mm512_fmadd_pd(axnl, coseo1, _mm512_mul_pd(aynl, sineo1));
+            __m512d esine = _mm512_fmsub_pd(axnl, sineo1, _mm512_mul_pd(aynl, coseo1));
+            __m512d el2 = _mm512_fmadd_pd(axnl, axnl, _mm512_mul_pd(aynl, aynl));
+            __m512d pl = _mm512_mul_pd(am, _mm512_sub_pd(one, el2));
+            bad |= _mm512_cmp_pd_mask(pl, zero, _CMP_LT_OQ);
+            __m512d rl = _mm512_mul_pd(am, _mm512_sub_pd(one, ecose));
+            __m512d invRl = _mm512_div_pd(one, rl);
+            __m512d rdotl = _mm512_mul_pd(_mm512_mul_pd(sqrtAm, esine), invRl);
+            __m512d rvdotl = _mm512_mul_pd(_mm512_maskz_sqrt_pd(0xff, pl), invRl);
+            __m512d betal = _mm512_maskz_sqrt_pd(0xff, _mm512_sub_pd(one, el2));
+            temp = _mm512_div_pd(esine, _mm512_add_pd(one, betal));
+            __m512d amOverRl = _mm512_mul_pd(am, invRl);
+            __m512d sinu = _mm512_mul_pd(amOverRl, _mm512_fnmadd_pd(axnl, temp, _mm512_sub_pd(sineo1, aynl)));
+            __m512d cosu = _mm512_mul_pd(amOverRl, _mm512_fmadd_pd(aynl, temp, _mm512_sub_pd(coseo1, axnl)));
+            __m512d sin2u = _mm512_mul_pd(_mm512_add_pd(cosu, cosu), sinu);
+            __m512d cos2u = _mm512_fnmadd_pd(_mm512_add_pd(sinu, sinu), sinu, one);
+            temp = _mm512_div_pd(one, pl);
+            __m512d temp1 = _mm512_mul_pd(_mm512_set1_pd(0.5 * kJ2), temp);
+            __m512d temp2 = _mm512_mul_pd(temp1, temp);
+
+            __m512d con41 = _mm512_loadu_pd(c[kCon41] + i);
+            __m512d x1mth2 = _mm512_loadu_pd(c[kX1mth2] + i);
+            __m512d cosio = _mm512_loadu_pd(c[kCosio] + i);
+            __m512d mrt = _mm512_mul_pd(rl, _mm512_fnmadd_pd(_mm512_mul_pd(_mm512_set1_pd(1.5), temp2), _mm512_mul_pd(betal, con41), one));
+            mrt = _mm512_fmadd_pd(_mm512_mul_pd(_mm512_set1_pd(0.5), temp1), _mm512_mul_pd(x1mth2, cos2u), mrt);
+            bad |= _mm512_cmp_pd_mask(mrt, one, _CMP_LT_OQ);
+            __m512d delta = _mm512_mul_pd(_mm512_mul_pd(_mm512_set1_pd(0.25), temp2), _mm512_mul_pd(_mm512_loadu_pd(c[kX7thm1] + i), sin2u));
+            __m512d sinDelta, cosDelta;
+            simd::sinCos8(delta, sinDelta, cosDelta);
+            __m512d sinsu = _mm512_fmsub_pd(sinu, cosDelta, _mm512_mul_pd(cosu, sinDelta));
+            __m512d cossu = _mm512_fmadd_pd(cosu, cosDelta, _mm512_mul_pd(sinu, sinDelta));
+            __m512d xnode = _mm512_fmadd_pd(_mm512_mul_pd(_mm512_set1_pd(1.5), temp2), _mm512_mul_pd(cosio, sin2u), nodem);
+            __m512d xinc = _mm512_fmadd_pd(_mm512_mul_pd(_mm512_set1_pd(1.5), temp2), _mm512_mul_pd(_mm512_mul_pd(cosio, _mm512_loadu_pd(c[kSinio] + i)), cos2u),
+                                           _mm512_loadu_pd(c[kInclo] + i));
+            __m512d nmTemp1 = _mm512_mul_pd(_mm512_mul_pd(nm, temp1), _mm512_set1_pd(1.0 / kXke));
+            __m512d mvt = _mm512_fnmadd_pd(nmTemp1, _mm512_mul_pd(x1mth2, sin2u), rdotl);
+            __m512d rvdot = _mm512_fmadd_pd(nmTemp1, _mm512_fmadd_pd(x1mth2, cos2u, _mm512_mul_pd(_mm512_set1_pd(1.5), con41)), rvdotl);
+
+            __m512d snod, cnod, sini, cosi;
+            sinCosAny8(xnode, snod, cnod);
+            simd::sinCos8(xinc, sini, cosi);
+            __m512d xmx = _mm512_sub_pd(zero, _mm512_mul_pd(snod, cosi)), xmy = _mm512_mul_pd(cnod, cosi);
+            __m512d ux = _mm512_fmadd_pd(xmx, sinsu, _mm512_mul_pd(cnod, cossu));
+            __m512d uy = _mm512_fmadd_pd(xmy, sinsu, _mm512_mul_pd(snod, cossu));
+            __m512d uz = _mm512_mul_pd(sini, sinsu);
+            __m512d nan = _mm512_set1_pd(std::numeric_limits<double>::quiet_NaN());
+            __m512d radius = _mm512_mask_blend_pd(bad, _mm512_mul_pd(mrt, _mm512_set1_pd(kEarthRadius)), nan);
+            _mm512_storeu_pd(states.x + i, _mm512_mul_pd(radius, ux));
+            _mm512_storeu_pd(states.y + i, _mm512_mul_pd(radius, uy));
+            _mm512_storeu_pd(states.z + i, _mm512_mul_pd(radius, uz));
+            if (states.vx)
+            {
+                __m512d vx = _mm512_fmsub_pd(xmx, cossu, _mm512_mul_pd(cnod, sinsu));
+                __m512d vy = _mm512_fmsub_pd(xmy, cossu, _mm512_mul_pd(snod, sinsu));
+                __m512d vz = _mm512_mul_pd(sini, cossu);
+                __m512d radial = _mm512_mask_blend_pd(bad, _mm512_mul_pd(mvt, _mm512_set1_pd(kVelocity)), nan);
+                __m512d along = _mm512_mul_pd(rvdot, _mm512_set1_pd(kVelocity));
+                _mm512_storeu_pd(states.vx + i, _mm512_fmadd_pd(radial, ux, _mm512_mul_pd(along, vx)));
+                _mm512_storeu_pd(states.vy + i, _mm512_fmadd_pd(radial, uy, _mm512_mul_pd(along, vy)));
+                _mm512_storeu_pd(states.vz + i, _mm512_fmadd_pd(radial, uz, _mm512_mul_pd(along, vz)));
+            }
+        }
+        scalarRange(c, states, i, end, jd);
+    }
+#endif
+
+    Kernel selectKernel(NBodyKernel kernel)
+    {
+#ifdef SGP4_X86_KERNELS
+        if (kernel == NBodyKernel::Avx512)
+            return avx512Range;
+        if (kernel == NBodyKernel::Avx2)
+            return avx2Range;
+#endif
+        return scalarRange;
+    }
+
+    using Clock = std::chrono::steady_clock;
+
+    KeplerSettings osculatingSettings(const Sgp4Settings &settings)
+    {
+        KeplerSettings kepler;
+        kepler.kernel = settings.kernel;
+        kepler.threads = settings.threads;
+        return kepler;
+    }
+}
+
+/**
+ * @brief What SDP4 keeps for a deep-space satellite: the near-Earth terms it
+ * shares with SGP4, the lunar and solar periodics (Vallado's dscom) and the
+ * secular rates and geopotential resonance (dsinit).
+ */
+struct Sgp4DeepSpace
+{
+    TwoLineElements source;
+    double no = 0.0, ecco = 0.0, inclo = 0.0, argpo = 0.0, nodeo = 0.0, mo = 0.0, bstar = 0.0;
+    double mdot = 0.0, argpdot = 0.0, nodedot = 0.0, nodecf = 0.0, cc1 = 0.0, cc4 = 0.0, t2cof = 0.0, gsto = 0.0;
+
+    // Lunar-solar periodics; the epoch values dscom subtracts are always zero.
+    double e3 = 0.0, ee2 = 0.0, se2 = 0.0, se3 = 0.0, sgh2 = 0.0, sgh3 = 0.0, sgh4 = 0.0, sh2 = 0.0, sh3 = 0.0;
+    double si2 = 0.0, si3 = 0.0, sl2 = 0.0, sl3 = 0.0, sl4 = 0.0, xgh2 = 0.0, xgh3 = 0.0, xgh4 = 0.0, xh2 = 0.0, xh3 = 0.0;
+    double xi2 = 0.0, xi3 = 0.0, xl2 = 0.0, xl3 = 0.0, xl4 = 0.0, zmol = 0.0, zmos = 0.0;
+
+    // Secular rates and resonance: 0 none, 1 one-day, 2 half-day.
+    int irez = 0;
+    double d2201 = 0.0, d2211 = 0.0, d3210 = 0.0, d3222 = 0.0, d4410 = 0.0, d4422 = 0.0;
+    double d5220 = 0.0, d5232 = 0.0, d5421 = 0.0, d5433 = 0.0;
+    double dedt = 0.0, didt = 0.0, dmdt = 0.0, dnodt = 0.0, domdt = 0.0;
+    double del1 = 0.0, del2 = 0.0, del3 = 0.0, xfact = 0.0, xlamo = 0.0;
+
+    // The resonance integrator steps 720 minutes from the epoch and resumes
+    // from its last step; the steps do not depend on the path, only one
+    // thread solves a satellite at a time.
+    mutable double atime = 0.0, xli = 0.0, xni = 0.0;
+};
+
+namespace
+{
+    /** @brief The lunar and solar terms of Vallado's dscom() that dsinit() reads once. */
+    struct LunarSolar
+    {
+        double sinim, cosim, emsq, s1, s2, s3, s4, s5, ss1, ss2, ss3, ss4, ss5;
+        double sz1, sz3, sz11, sz13, sz21, sz23, sz31, sz33, z1, z3, z11, z13, z21, z23, z31, z33;
+    };
+
+    void deepSpaceCommon(double epoch, double ep, double argpp, double inclp, double nodep, double np, Sgp4DeepSpace &d, LunarSolar &out)
+    {
+        const double zes = 0.01675, zel = 0.05490, c1ss = 2.9864797e-6, c1l = 4.7968065e-7;
+        const double zsinis = 0.39785416, zcosis = 0.91744867, zcosgs = 0.1945905, zsings = -0.98088458;
+
+        double nm = np, em = ep;
+        double snodm = std::sin(nodep), cnodm = std::cos(nodep);
+        double sinomm = std::sin(argpp), cosomm = std::cos(argpp);
+        double sinim = std::sin(inclp), cosim = std::cos(inclp);
+        double emsq = em * em;
+        double betasq = 1.0 - emsq;
+        double rtemsq = std::sqrt(betasq);
+
+        double day = epoch + 18261.5;
+        double xnodce = std::fmod(4.5236020 - 9.2422029e-4 * day, kTwoPi);
+        double stem = std::sin(xnodce), ctem = std::cos(xnodce);
+        double zcosil = 0.91375164 - 0.03568096 * ctem;
+        double zsinil = std::sqrt(1.0 - zcosil * zcosil);
+        double zsinhl = 0.089683511 * stem / zsinil;
+        double zcoshl = std::sqrt(1.0 - zsinhl * zsinhl);
+        double gam = 5.8351514 + 0.0019443680 * day;
+        double zx = 0.39785416 * stem / zsinil;
+        double zy = zcoshl * ctem + 0.91744867 * zsinhl * stem;
+        zx = gam + std::atan2(zx, zy) - xnodce;
+        double zcosgl = std::cos(zx), zsingl = std::sin(zx);
+
+        // The sun's terms, then the moon's.
+        double zcosg = zcosgs, zsing = zsings, zcosi = zcosis, zsini = zsinis, zcosh = cnodm, zsinh = snodm;
+        double cc = c1ss, xnoi = 1.0 / nm;
+        double s1 = 0, s2 = 0, s3 = 0, s4 = 0, s5 = 0, s6 = 0, s7 = 0;
+        double z1 = 0, z2 = 0, z3 = 0, z11 = 0, z12 = 0, z13 = 0, z21 = 0, z22 = 0, z23 = 0, z31 = 0, z32 = 0, z33 = 0;
+        double ss1 = 0, ss2 = 0, ss3 = 0, ss4 = 0, ss5 = 0, ss6 = 0, ss7 = 0;
+        double sz1 = 0, sz2 = 0, sz3 = 0, sz11 = 0, sz12 = 0, sz13 = 0, sz21 = 0, sz22 = 0, sz23 = 0, sz31 = 0, sz32 = 0, sz33 = 0;
+        for (int body = 0; body < 2; ++body)
+        {
+            double a1 = zcosg * zcosh + zsing * zcosi * zsinh;
+            double a3 = -zsing * zcosh + zcosg * zcosi * zsinh;
+            double a7 = -zcosg * zsinh + zsing * zcosi * zcosh;
+            double a8 = zsing * zsini;
+            double a9 = zsing * zsinh + zcosg * zcosi * zcosh;
+            double a10 = zcosg * zsini;
+            double a2 = cosim * a7 + sinim * a8;
+            double a4 = cosim * a9 + sinim * a10;
+            double a5 = -sinim * a7 + cosim * a8;
+            double a6 = -sinim * a9 + cosim * a10;
+
+            double x1 = a1 * cosomm + a2 * sinomm;
+            double x2 = a3 * cosomm + a4 * sinomm;
+            double x3 = -a1 * sinomm + a2 * cosomm;
+            double x4 = -a3 * sinomm + a4 * cosomm;
+            double x5 = a5 * sinomm;
+            double x6 = a6 * sinomm;
+            double x7 = a5 * cosomm;
+            double x8 = a6 * cosomm;
+
+            z31 = 12.0 * x1 * x1 - 3.0 * x3 * x3;
+            z32 = 24.0 * x1 * x2 - 6.0 * x3 * x4;
+            z33 = 12.0 * x2 * x2 - 3.0 * x4 * x4;
+            z1 = 3.0 * (a1 * a1 + a2 * a2) + z31 * emsq;
+            z2 = 6.0 * (a1 * a3 + a2 * a4) + z32 * emsq;
+            z3 = 3.0 * (a3 * a3 + a4 * a4) + z33 * emsq;
+            z11 = -6.0 * a1 * a5 + emsq * (-24.0 * x1 * x7 - 6.0 * x3 * x5);
+            z12 = -6.0 * (a1 * a6 + a3 * a5) + emsq * (-24.0 * (x2 * x7 + x1 * x8) - 6.0 * (x3 * x6 + x4 * x5));
+            z13 = -6.0 * a3 * a6 + emsq * (-24.0 * x2 * x8 - 6.0 * x4 * x6);
+            z21 = 6.0 * a2 * a5 + emsq * (24.0 * x1 * x5 - 6.0 * x3 * x7);
+            z22 = 6.0 * (a4 * a5 + a2 * a6) + emsq * (24.0 * (x2 * x5 + x1 * x6) - 6.0 * (x4 * x7 + x3 * x8));
+            z23 = 6.0 * a4 * a6 + emsq * (24.0 * x2 * x6 - 6.0 * x4 * x8);
+            z1 = z1 + z1 + betasq * z31;
+            z2 = z2 + z2 + betasq * z32;
+            z3 = z3 + z3 + betasq * z33;
+            s3 = cc * xnoi;
+            s2 = -0.5 * s3 / rtemsq;
+            s4 = s3 * rtemsq;
+            s1 = -15.0 * em * s4;
+            s5 = x1 * x3 + x2 * x4;
+            s6 = x2 * x3 + x1 * x4;
+            s7 = x2 * x4 - x1 * x3;
+
+            if (body == 0)
+            {
+                ss1 = s1; ss2 = s2; ss3 = s3; ss4 = s4; ss5 = s5; ss6 = s6; ss7 = s7;
+                sz1 = z1; sz2 = z2; sz3 = z3;
+                sz11 = z11; sz12 = z12; sz13 = z13;
+                sz21 = z21; sz22 = z22; sz23 = z23;
+                sz31 = z31; sz32 = z32; sz33 = z33;
+                zcosg = zcosgl;
+                zsing = zsingl;
+                zcosi = zcosil;
+                zsini = zsinil;
+                zcosh = zcoshl * cnodm + zsinhl * snodm;
+                zsinh = snodm * zcoshl - cnodm * zsinhl;
+                cc = c1l;
+            }
+        }
+
+        d.zmol = std::fmod(4.7199672 + 0.22997150 * day - gam, kTwoPi);
+        d.zmos = std::fmod(6.2565837 + 0.017201977 * day, kTwoPi);
+        d.se2 = 2.0 * ss1 * ss6;
+        d.se3 = 2.0 * ss1 * ss7;
+        d.si2 = 2.0 * ss2 * sz12;
+        d.si3 = 2.0 * ss2 * (sz13 - sz11);
+        d.sl2 = -2.0 * ss3 * sz2;
+        d.sl3 = -2.0 * ss3 * (sz3 - sz1);
+        d.sl4 = -2.0 * ss3 * (-21.0 - 9.0 * emsq) * zes;
+        d.sgh2 = 2.0 * ss4 * sz32;
+        d.sgh3 = 2.0 * ss4 * (sz33 - sz31);
+        d.sgh4 = -18.0 * ss4 * zes;
+        d.sh2 = -2.0 * ss2 * sz22;
+        d.sh3 = -2.0 * ss2 * (sz23 - sz21);
+        d.ee2 = 2.0 * s1 * s6;
+        d.e3 = 2.0 * s1 * s7;
+        d.xi2 = 2.0 * s2 * z12;
+        d.xi3 = 2.0 * s2 * (z13 - z11);
+        d.xl2 = -2.0 * s3 * z2;
+        d.xl3 = -2.0 * s3 * (z3 - z1);
+        d.xl4 = -2.0 * s3 * (-21.0 - 9.0 * emsq) * zel;
+        d.xgh2 = 2.0 * s4 * z32;
+        d.xgh3 = 2.0 * s4 * (z33 - z31);
+        d.xgh4 = -18.0 * s4 * zel;
+        d.xh2 = -2.0 * s2 * z22;
+        d.xh3 = -2.0 * s2 * (z23 - z21);
+
+        out = {sinim, cosim, emsq, s1, s2, s3, s4, s5, ss1, ss2, ss3, ss4, ss5,
+               sz1, sz3, sz11, sz13, sz21, sz23, sz31, sz33, z1, z3, z11, z13, z21, z23, z31, z33};
+    }
+
+    /** @brief Vallado's dsinit() at the epoch: secular rates and the resonance coefficients. */
+    void deepSpaceInit(const LunarSolar &ls, double xpidot, double eccsq, Sgp4DeepSpace &d)
+    {
+        const double q22 = 1.7891679e-6, q31 = 2.1460748e-6, q33 = 2.2123015e-7;
+        const double root22 = 1.7891679e-6, root44 = 7.3636953e-9, root54 = 2.1765803e-9;
+        const double root32 = 3.7393792e-7, root52 = 1.1428639e-7;
+        const double rptim = 4.37526908801129966e-3; // the earth's rotation, radians per minute
+        const double znl = 1.5835218e-4, zns = 1.19459e-5;
+
+        double nm = d.no, em = d.ecco, emsq = ls.emsq, inclm = d.inclo;
+        double sinim = ls.sinim, cosim = ls.cosim;
+
+        d.irez = 0;
+        if (nm < 0.0052359877 && nm > 0.0034906585)
+            d.irez = 1;
+        if (nm >= 8.26e-3 && nm <= 9.24e-3 && em >= 0.5)
+            d.irez = 2;
+
+        double ses = ls.ss1 * zns * ls.ss5;
+        double sis = ls.ss2 * zns * (ls.sz11 + ls.sz13);
+        double sls = -zns * ls.ss3 * (ls.sz1 + ls.sz3 - 14.0 - 6.0 * emsq);
+        double sghs = ls.ss4 * zns * (ls.sz31 + ls.sz33 - 6.0);
+        double shs = -zns * ls.ss2 * (ls.sz21 + ls.sz23);
+        if (inclm < 5.2359877e-2 || inclm > kPi - 5.2359877e-2)
+            shs = 0.0;
+        if (sinim != 0.0)
+            shs /= sinim;
+        double sgs = sghs - cosim * shs;
+
+        d.dedt = ses + ls.s1 * znl * ls.s5;
+        d.didt = sis + ls.s2 * znl * (ls.z11 + ls.z13);
+        d.dmdt = sls - znl * ls.s3 * (ls.z1 + ls.z3 - 14.0 - 6.0 * emsq);
+        double sghl = ls.s4 * znl * (ls.z31 + ls.z33 - 6.0);
+        double shll = -znl * ls.s2 * (ls.z21 + ls.z23);
+        if (inclm < 5.2359877e-2 || inclm > kPi - 5.2359877e-2)
+            shll = 0.0;
+        d.domdt = sgs + sghl;
+        d.dnodt = shs;
+        if (sinim != 0.0)
+        {
+            d.domdt -= cosim / sinim * shll;
+            d.dnodt += shll / sinim;
+        }
+
+        double theta = std::fmod(d.gsto, kTwoPi);
+        if (d.irez == 0)
+            return;
+        double aonv = std::pow(nm / kXke, kTwoThirds);
+
+        if (d.irez == 2)
+        {
+            // Half-day (Molniya) resonance.
+            double cosisq = cosim * cosim;
+            em = d.ecco;
+            emsq = eccsq;
+            double eoc = em * emsq;
+            double g201 = -0.306 - (em - 0.64) * 0.440;
+            double g211, g310, g322, g410, g422, g520, g521, g532, g533;
+            if (em <= 0.65)
+            {
+                g211 = 3.616 - 13.2470 * em + 16.2900 * emsq;
+                g310 = -19.302 + 117.3900 * em - 228.4190 * emsq + 156.5910 * eoc;
+                g322 = -18.9068 + 109.7927 * em - 214.6334 * emsq + 146.5816 * eoc;
+                g410 = -41.122 + 242.6940 * em - 471.0940 * emsq + 313.9530 * eoc;
+                g422 = -146.407 + 841.8800 * em - 1629.014 * emsq + 1083.4350 * eoc;
+                g520 = -532.114 + 3017.977 * em - 5740.032 * emsq + 3708.2760 * eoc;
+            }
+            else
+            {
+                g211 = -72.099 + 331.819 * em - 508.738 * emsq + 266.724 * eoc;
+                g310 = -346.844 + 1582.851 * em - 2415.925 * emsq + 1246.113 * eoc;
+                g322 = -342.585 + 1554.908 * em - 2366.899 * emsq + 1215.972 * eoc;
+                g410 = -1052.797 + 4758.686 * em - 7193.992 * emsq + 3651.957 * eoc;
+                g422 = -3581.690 + 16178.110 * em - 24462.770 * emsq + 12422.520 * eoc;
+                if (em > 0.715)
+                    g520 = -5149.66 + 29936.92 * em - 54087.36 * emsq + 31324.56 * eoc;
+                else
+                    g520 = 1464.74 - 4664.75 * em + 3763.64 * emsq;
+            }
+            if (em < 0.7)
+            {
+                g533 = -919.22770 + 4988.6100 * em - 9064.7700 * emsq + 5542.21 * eoc;
+                g521 = -822.71072 + 4568.6173 * em - 8491.4146 * emsq + 5337.524 * eoc;
+                g532 = -853.66600 + 4690.2500 * em - 8624.7700 * emsq + 5341.4 * eoc;
+            }
+            else
+            {
+                g533 = -37995.780 + 161616.52 * em - 229838.20 * emsq + 109377.94 * eoc;
+                g521 = -51752.104 + 218913.95 * em - 309468.16 * emsq + 146349.42 * eoc;
+                g532 = -40023.880 + 170470.89 * em - 242699.48 * emsq + 115605.82 * eoc;
+            }
+
+            double sini2 = sinim * sinim;
+            double f220 = 0.75 * (1.0 + 2.0 * cosim + cosisq);
+            double f221 = 1.5 * sini2;
+            double f321 = 1.875 * sinim * (1.0 - 2.0 * cosim - 3.0 * cosisq);
+            double f322 = -1.875 * sinim * (1.0 + 2.0 * cosim - 3.0 * cosisq);
+            double f441 = 35.0 * sini2 * f220;
+            double f442 = 39.3750 * sini2 * sini2;
+            double f522 = 9.84375 * sinim * (sini2 * (1.0 - 2.0 * cosim - 5.0 * cosisq) + 0.33333333 * (-2.0 + 4.0 * cosim + 6.0 * cosisq));
+            double f523 = sinim * (4.92187512 * sini2 * (-2.0 - 4.0 * cosim + 10.0 * cosisq) + 6.56250012 * (1.0 + 2.0 * cosim - 3.0 * cosisq));
+            double f542 = 29.53125 * sinim * (2.0 - 8.0 * cosim + cosisq * (-12.0 + 8.0 * cosim + 10.0 * cosisq));
+            double f543 = 29.53125 * sinim * (-2.0 - 8.0 * cosim + cosisq * (12.0 + 8.0 * cosim - 10.0 * cosisq));
+
+            double xno2 = nm * nm;
+            double ainv2 = aonv * aonv;
+            double temp1 = 3.0 * xno2 * ainv2;
+            double temp = temp1 * root22;
+            d.d2201 = temp * f220 * g201;
+            d.d2211 = temp * f221 * g211;
+            temp1 *= aonv;
+            temp = temp1 * root32;
+            d.d3210 = temp * f321 * g310;
+            d.d3222 = temp * f322 * g322;
+            temp1 *= aonv;
+            temp = 2.0 * temp1 * root44;
+            d.d4410 = temp * f441 * g410;
+            d.d4422 = temp * f442 * g422;
+            temp1 *= aonv;
+            temp = temp1 * root52;
+            d.d5220 = temp * f522 * g520;
+            d.d5232 = temp * f523 * g532;
+            temp = 2.0 * temp1 * root54;
+            d.d5421 = temp * f542 * g521;
+            d.d5433 = temp * f543 * g533;
+            d.xlamo = std::fmod(d.mo + d.nodeo + d.nodeo - theta - theta, kTwoPi);
+            d.xfact = d.mdot + d.dmdt + 2.0 * (d.nodedot + d.dnodt - rptim) - d.no;
+        }
+        else
+        {
+            // One-day (geosynchronous) resonance.
+            double g200 = 1.0 + emsq * (-2.5 + 0.8125 * emsq);
+            double g310 = 1.0 + 2.0 * emsq;
+            double g300 = 1.0 + emsq * (-6.0 + 6.60937 * emsq);
+            double f220 = 0.75 * (1.0 + cosim) * (1.0 + cosim);
+            double f311 = 0.9375 * sinim * sinim * (1.0 + 3.0 * cosim) - 0.75 * (1.0 + cosim);
+            double f330 = 1.0 + cosim;
+            f330 = 1.875 * f330 * f330 * f330;
+            d.del1 = 3.0 * nm * nm * aonv * aonv;
+            d.del2 = 2.0 * d.del1 * f220 * g200 * q22;
+            d.del3 = 3.0 * d.del1 * f330 * g300 * q33 * aonv;
+            d.del1 = d.del1 * f311 * g310 * q31 * aonv;
+            d.xlamo = std::fmod(d.mo + d.nodeo + d.argpo - theta, kTwoPi);
+            d.xfact = d.mdot + xpidot - rptim + d.dmdt + d.domdt + d.dnodt - d.no;
+        }
+        d.xli = d.xlamo;
+        d.xni = d.no;
+        d.atime = 0.0;
+    }
+
+    /** @brief Vallado's dspace(): secular lunar-solar rates and the resonance integration to @p t minutes. */
+    void deepSpaceSecular(const Sgp4DeepSpace &d, double t, double &em, double &argpm, double &inclm, double &mm, double &nodem, double &nm)
+    {
+        const double fasx2 = 0.13130908, fasx4 = 2.8843198, fasx6 = 0.37448087;
+        const double g22 = 5.7686396, g32 = 0.95240898, g44 = 1.8014998, g52 = 1.0508330, g54 = 4.4108898;
+        const double rptim = 4.37526908801129966e-3;
+        const double stepp = 720.0, stepn = -720.0, step2 = 259200.0;
+
+        double theta = std::fmod(d.gsto + t * rptim, kTwoPi);
+        em += d.dedt * t;
+        inclm += d.didt * t;
+        argpm += d.domdt * t;
+        nodem += d.dnodt * t;
+        mm += d.dmdt * t;
+        if (d.irez == 0)
+            return;
+
+        // Euler-Maclaurin steps from the epoch, or from the last call's step.
+        if (d.atime == 0.0 || t * d.atime <= 0.0 || std::abs(t) < std::abs(d.atime))
+        {
+            d.atime = 0.0;
+            d.xni = d.no;
+            d.xli = d.xlamo;
+        }
+        double delt = t > 0.0 ? stepp : stepn;
+        double xndt, xldot, xnddt, ft;
+        for (;;)
+        {
+            if (d.irez != 2)
+            {
+                xndt = d.del1 * std::sin(d.xli - fasx2) + d.del2 * std::sin(2.0 * (d.xli - fasx4)) + d.del3 * std::sin(3.0 * (d.xli - fasx6));
+                xldot = d.xni + d.xfact;
+                xnddt = d.del1 * std::cos(d.xli - fasx2) + 2.0 * d.del2 * std::cos(2.0 * (d.xli - fasx4)) + 3.0 * d.del3 * std::cos(3.0 * (d.xli - fasx6));
+                xnddt *= xldot;
+            }
+            else
+            {
+                double xomi = d.argpo + d.argpdot * d.atime;
+                double x2omi = xomi + xomi;
+                double x2li = d.xli + d.xli;
+                xndt = d.d2201 * std::sin(x2omi + d.xli - g22) + d.d2211 * std::sin(d.xli - g22) + d.d3210 * std::sin(xomi + d.xli - g32) +
+                       d.d3222 * std::sin(-xomi + d.xli - g32) + d.d4410 * std::sin(x2omi + x2li - g44) + d.d4422 * std::sin(x2li - g44) +
+                       d.d5220 * std::sin(xomi + d.xli - g52) + d.d5232 * std::sin(-xomi + d.xli - g52) + d.d5421 * std::sin(xomi + x2li - g54) +
+                       d.d5433 * std::sin(-xomi + x2li - g54);
+                xldot = d.xni + d.xfact;
+                xnddt = d.d2201 * std::cos(x2omi + d.xli - g22) + d.d2211 * std::cos(d.xli - g22) + d.d3210 * std::cos(xomi + d.xli - g32) +
+                        d.d3222 * std::cos(-xomi + d.xli - g32) + d.d5220 * std::cos(xomi + d.xli - g52) + d.d5232 * std::cos(-xomi + d.xli - g52) +
+                        2.0 * (d.d4410 * std::cos(x2omi + x2li - g44) + d.d4422 * std::cos(x2li - g44) + d.d5421 * std::cos(xomi + x2li - g54) +
+                               d.d5433 * std::cos(-xomi + x2li - g54));
+                xnddt *= xldot;
+            }
+            if (std::abs(t - d.atime) < stepp)
+            {
+                ft = t - d.atime;
+                break;
+            }
+            d.xli += xldot * delt + xndt * step2;
+            d.xni += xndt * delt + xnddt * step2;
+            d.atime += delt;
+        }
+
+        nm = d.xni + xndt * ft + xnddt * ft * ft * 0.5;
+        double xl = d.xli + xldot * ft + xndt * ft * ft * 0.5;
+        if (d.irez != 1)
+            mm = xl - 2.0 * nodem + 2.0 * theta;
+        else
+            mm = xl - nodem - argpm + theta;
+    }
+
+    /** @brief Vallado's dpper(): adds the lunar-solar periodics at @p t minutes. */
+    void deepSpacePeriodics(const Sgp4DeepSpace &d, double t, double &ep, double &inclp, double &nodep, double &argpp, double &mp)
+    {
+        const double zns = 1.19459e-5, zes = 0.01675, znl = 1.5835218e-4, zel = 0.05490;
+
+        double zm = d.zmos + zns * t;
+        double zf = zm + 2.0 * zes * std::sin(zm);
+        double sinzf = std::sin(zf);
+        double f2 = 0.5 * sinzf * sinzf - 0.25;
+        double f3 = -0.5 * sinzf * std::cos(zf);
+        double ses = d.se2 * f2 + d.se3 * f3;
+        double sis = d.si2 * f2 + d.si3 * f3;
+        double sls = d.sl2 * f2 + d.sl3 * f3 + d.sl4 * sinzf;
+        double sghs = d.sgh2 * f2 + d.sgh3 * f3 + d.sgh4 * sinzf;
+        double shs = d.sh2 * f2 + d.sh3 * f3;
+
+        zm = d.zmol + znl * t;
+        zf = zm + 2.0 * zel * std::sin(zm);
+        sinzf = std::sin(zf);
+        f2 = 0.5 * sinzf * sinzf - 0.25;
+        f3 = -0.5 * sinzf * std::cos(zf);
+        double sel = d.ee2 * f2 + d.e3 * f3;
+        double sil = d.xi2 * f2 + d.xi3 * f3;
+        double sll = d.xl2 * f2 + d.xl3 * f3 + d.xl4 * sinzf;
+        double sghl = d.xgh2 * f2 + d.xgh3 * f3 + d.xgh4 * sinzf;
+        double shll = d.xh2 * f2 + d.xh3 * f3;
+
+        double pe = ses + sel, pinc = sis + sil, pl = sls + sll, pgh = sghs + sghl, ph = shs + shll;
+        inclp += pinc;
+        ep += pe;
+        double sinip = std::sin(inclp), cosip = std::cos(inclp);
+        if (inclp >= 0.2)
+        {
+            ph /= sinip;
+            pgh -= cosip * ph;
+            argpp += pgh;
+            nodep += ph;
+            mp += pl;
+        }
+        else
+        {
+            // Lyddane's modification for low inclinations.
+            double sinop = std::sin(nodep), cosop = std::cos(nodep);
+            double alfdp = sinip * sinop + (ph * cosop + pinc * cosip * sinop);
+            double betdp = sinip * cosop + (-ph * sinop + pinc * cosip * cosop);
+            nodep = std::fmod(nodep, kTwoPi);
+            double xls = mp + argpp + cosip * nodep;
+            double dls = pl + pgh - pinc * nodep * sinip;
+            xls += dls;
+            double xnoh = nodep;
+            nodep = std::atan2(alfdp, betdp);
+            if (std::abs(xnoh - nodep) > kPi)
+                nodep += nodep < xnoh ? kTwoPi : -kTwoPi;
+            mp += pl;
+            argpp = xls - mp - cosip * nodep;
+        }
+    }
+
+    /** @brief SDP4 @p t minutes from the epoch. */
+    bool deepSpaceState(const Sgp4DeepSpace &d, double t, double state[6])
+    {
+        double xmdf = d.mo + d.mdot * t;
+        double argpm = d.argpo + d.argpdot * t;
+        double nodem = d.nodeo + d.nodedot * t + d.nodecf * t * t;
+        double mm = xmdf;
+        double tempa = 1.0 - d.cc1 * t;
+        double tempe = d.bstar * d.cc4 * t;
+        double templ = d.t2cof * t * t;
+
+        double nm = d.no, em = d.ecco, inclm = d.inclo;
+        deepSpaceSecular(d, t, em, argpm, inclm, mm, nodem, nm);
+        if (nm <= 0.0)
+            return false;
+        double am = std::pow(kXke / nm, kTwoThirds) * tempa * tempa;
+        nm = kXke / std::pow(am, 1.5);
+        em -= tempe;
+        if (em >= 1.0 || em < -0.001)
+            return false;
+        em = std::max(em, 1e-6);
+        mm += d.no * templ;
+        double xlm = mm + argpm + nodem;
+        nodem = std::fmod(nodem, kTwoPi);
+        argpm = std::fmod(argpm, kTwoPi);
+        xlm = std::fmod(xlm, kTwoPi);
+        mm = std::fmod(xlm - argpm - nodem, kTwoPi);
+
+        double ep = em, xincp = inclm, argpp = argpm, nodep = nodem, mp = mm;
+        deepSpacePeriodics(d, t, ep, xincp, nodep, argpp, mp);
+        if (xincp < 0.0)
+        {
+            xincp = -xincp;
+            nodep += kPi;
+            argpp -= kPi;
+        }
+        if (ep < 0.0 || ep > 1.0)
+            return false;
+
+        // The inclination moves, so the terms near-Earth orbits precompute are redone.
+        double sinip = std::sin(xincp), cosip = std::cos(xincp);
+        double aycof = -0.5 * kJ3OverJ2 * sinip;
+        double xlcof = -0.25 * kJ3OverJ2 * sinip * (3.0 + 5.0 * cosip) / (std::abs(cosip + 1.0) > 1.5e-12 ? 1.0 + cosip : 1.5e-12);
+        double cosisq = cosip * cosip;
+        return shortPeriodic(am, nm, ep, xincp, argpp, nodep, mp, aycof, xlcof, 3.0 * cosisq - 1.0, 1.0 - cosisq, 7.0 * cosisq - 1.0, state);
+    }
+
+    /**
+     * @brief Vallado's sgp4init(): un-Kozai the mean motion and precompute the
+     * near-Earth terms into @p column (kNearEarthColumns values), or, for
+     * periods of 225 minutes or more, fill @p deepSpace instead.
+     */
+    void initialize(const TwoLineElements &tle, double *column, Sgp4DeepSpace &deepSpace, bool &isDeepSpace)
+    {
+        const double ss = 78.0 / kEarthRadius + 1.0;
+        const double qzms2t = std::pow((120.0 - 78.0) / kEarthRadius, 4.0);
+
+        double ecco = tle.eccentricity, inclo = tle.inclination, argpo = tle.periapsis, mo = tle.meanAnomaly;
+        double bstar = tle.bstar;
+
+        // initl()
+        double eccsq = ecco * ecco;
+        double omeosq = 1.0 - eccsq;
+        double rteosq = std::sqrt(omeosq);
+        double cosio = std::cos(inclo), cosio2 = cosio * cosio;
+        double ak = std::pow(kXke / tle.meanMotion, kTwoThirds);
+        double d1 = 0.75 * kJ2 * (3.0 * cosio2 - 1.0) / (rteosq * omeosq);
+        double del = d1 / (ak * ak);
+        double adel = ak * (1.0 - del * del - del * (1.0 / 3.0 + 134.0 * del * del / 81.0));
+        del = d1 / (adel * adel);
+        double no = tle.meanMotion / (1.0 + del);
+        double ao = std::pow(kXke / no, kTwoThirds);
+        double sinio = std::sin(inclo);
+        double po = ao * omeosq;
+        double con42 = 1.0 - 5.0 * cosio2;
+        double con41 = -con42 - cosio2 - cosio2;
+        double posq = po * po;
+        double rp = ao * (1.0 - ecco);
+
+        bool simple = rp < 220.0 / kEarthRadius + 1.0;
+        double sfour = ss, qzms24 = qzms2t;
+        double perige = (rp - 1.0) * kEarthRadius;
+        if (perige < 156.0)
+        {
+            sfour = perige < 98.0 ? 20.0 : perige - 78.0;
+            qzms24 = std::pow((120.0 - sfour) / kEarthRadius, 4.0);
+            sfour = sfour / kEarthRadius + 1.0;
+        }
+        double pinvsq = 1.0 / posq;
+        double tsi = 1.0 / (ao - sfour);
+        double eta = ao * ecco * tsi;
+        double etasq = eta * eta;
+        double eeta = ecco * eta;
+        double psisq = std::abs(1.0 - etasq);
+        double coef = qzms24 * std::pow(tsi, 4.0);
+        double coef1 = coef / std::pow(psisq, 3.5);
+        double cc2 = coef1 * no * (ao * (1.0 + 1.5 * etasq + eeta * (4.0 + etasq)) + 0.375 * kJ2 * tsi / psisq * con41 * (8.0 + 3.0 * etasq * (8.0 + etasq)));
+        double cc1 = bstar * cc2;
+        double cc3 = ecco > 1.0e-4 ? -2.0 * coef * tsi * kJ3OverJ2 * no * sinio / ecco : 0.0;
+        double x1mth2 = 1.0 - cosio2;
+        double cc4 = 2.0 * no * coef1 * ao * omeosq *
+                     (eta * (2.0 + 0.5 * etasq) + ecco * (0.5 + 2.0 * etasq) -
+                      kJ2 * tsi / (ao * psisq) * (-3.0 * con41 * (1.0 - 2.0 * eeta + etasq * (1.5 - 0.5 * eeta)) + 0.75 * x1mth2 * (2.0 * etasq - eeta * (1.0 + etasq)) * std::cos(2.0 * argpo)));
+        double cc5 = 2.0 * coef1 * ao * omeosq * (1.0 + 2.75 * (etasq + eeta) + eeta * etasq);
+        double cosio4 = cosio2 * cosio2;
+        double temp1 = 1.5 * kJ2 * pinvsq * no;
+        double temp2 = 0.5 * temp1 * kJ2 * pinvsq;
+        double temp3 = -0.46875 * kJ4 * pinvsq * pinvsq * no;
+        double mdot = no + 0.5 * temp1 * rteosq * con41 + 0.0625 * temp2 * rteosq * (13.0 - 78.0 * cosio2 + 137.0 * cosio4);
+        double argpdot = -0.5 * temp1 * con42 + 0.0625 * temp2 * (7.0 - 114.0 * cosio2 + 395.0 * cosio4) + temp3 * (3.0 - 36.0 * cosio2 + 49.0 * cosio4);
+        double xhdot1 = -temp1 * cosio;
+        double nodedot = xhdot1 + (0.5 * temp2 * (4.0 - 19.0 * cosio2) + 2.0 * temp3 * (3.0 - 7.0 * cosio2)) * cosio;
+        double xpidot = argpdot + nodedot;
+        double omgcof = bstar * cc3 * std::cos(argpo);
+        double xmcof = ecco > 1.0e-4 ? -kTwoThirds * coef * bstar / eeta : 0.0;
+        double nodecf = 3.5 * omeosq * xhdot1 * cc1;
+        double t2cof = 1.5 * cc1;
+        double xlcof = -0.25 * kJ3OverJ2 * sinio * (3.0 + 5.0 * cosio) / (std::abs(cosio + 1.0) > 1.5e-12 ? 1.0 + cosio : 1.5e-12);
+        double aycof = -0.5 * kJ3OverJ2 * sinio;
+        double delmotemp = 1.0 + eta * std::cos(mo);
+
+        isDeepSpace = kTwoPi / no >= 225.0;
+        if (isDeepSpace)
+        {
+            Sgp4DeepSpace &d = deepSpace;
+            d = Sgp4DeepSpace();
+            d.source = tle;
+            d.no = no;
+            d.ecco = ecco;
+            d.inclo = inclo;
+            d.argpo = argpo;
+            d.nodeo = tle.ascendingNode;
+            d.mo = mo;
+            d.bstar = bstar;
+            d.mdot = mdot;
+            d.argpdot = argpdot;
+            d.nodedot = nodedot;
+            d.nodecf = nodecf;
+            d.cc1 = cc1;
+            d.cc4 = cc4;
+            d.t2cof = t2cof;
+            d.gsto = greenwichSiderealTime(tle.epochJd);
+            LunarSolar lunarSolar;
+            deepSpaceCommon(tle.epochJd - 2433281.5, ecco, argpo, inclo, tle.ascendingNode, no, d, lunarSolar);
+            deepSpaceInit(lunarSolar, xpidot, eccsq, d);
+            return;
+        }
+
+        double d2 = 0.0, d3 = 0.0, d4 = 0.0, t3cof = 0.0, t4cof = 0.0, t5cof = 0.0;
+        if (!simple)
+        {
+            double cc1sq = cc1 * cc1;
+            d2 = 4.0 * ao * tsi * cc1sq;
+            double temp = d2 * tsi * cc1 / 3.0;
+            d3 = (17.0 * ao + sfour) * temp;
+            d4 = 0.5 * temp * ao * tsi * (221.0 * ao + 31.0 * sfour) * cc1;
+            t3cof = d2 + 2.0 * cc1sq;
+            t4cof = 0.25 * (3.0 * d3 + cc1 * (12.0 * d2 + 10.0 * cc1sq));
+            t5cof = 0.2 * (3.0 * d4 + 12.0 * cc1 * d3 + 6.0 * d2 * d2 + 15.0 * cc1sq * (2.0 * d2 + cc1sq));
+        }
+
+        column[kEpoch] = tle.epochJd;
+        column[kNo] = no;
+        column[kEcco] = ecco;
+        column[kInclo] = inclo;
+        column[kArgpo] = argpo;
+        column[kNodeo] = tle.ascendingNode;
+        column[kMo] = mo;
+        column[kBstar] = bstar;
+        column[kMdot] = mdot;
+        column[kArgpdot] = argpdot;
+        column[kNodedot] = nodedot;
+        column[kNodecf] = nodecf;
+        column[kCc1] = cc1;
+        column[kCc4] = cc4;
+        column[kCc5] = cc5;
+        column[kT2cof] = t2cof;
+        column[kOmgcof] = simple ? 0.0 : omgcof;
+        column[kXmcof] = simple ? 0.0 : xmcof;
+        column[kEta] = eta;
+        column[kDelmo] = delmotemp * delmotemp * delmotemp;
+        column[kSinmao] = std::sin(mo);
+        column[kD2] = d2;
+        column[kD3] = d3;
+        column[kD4] = d4;
+        column[kT3cof] = t3cof;
+        column[kT4cof] = t4cof;
+        column[kT5cof] = t5cof;
+        column[kFull] = simple ? 0.0 : 1.0;
+        column[kAycof] = aycof;
+        column[kXlcof] = xlcof;
+        column[kCon41] = con41;
+        column[kX1mth2] = x1mth2;
+        column[kX7thm1] = 7.0 * cosio2 - 1.0;
+        column[kCosio] = cosio;
+        column[kSinio] = sinio;
+        column[kABase] = ao;
+    }
+}
+
+namespace
+{
+    // Columns [first, last] of a line, 1-based as the format documents
+    // them, without their spaces.
+    bool readField(const char *line, std::size_t length, int first, int last, char (&text)[24])
+    {
+        if ((std::size_t)last > length)
+            return false;
+        int count = 0;
+        for (int k = first - 1; k < last; ++k)
+            if (line[k] != ' ')
+                text[count++] = line[k];
+        text[count] = '\0';
+        return count > 0;
+    }
+
+    bool readNumber(const char *line, std::size_t length, int first, int last, double &value)
+    {
+        char text[24];
+        if (!readField(line, length, first, last, text))
+            return false;
+        char *end;
+        value = std::strtod(text, &end);
+        return *end == '\0';
+    }
+
+    // A field with an implied leading decimal point and an optional
+    // exponent: "0086731" is 0.0086731, "-11606-4" is -0.11606e-4.
+    bool readImpliedDecimal(const char *line, std::size_t length, int first, int last, double &value)
+    {
+        char text[24];
+        if (!readField(line, length, first, last, text))
+            return false;
+        const char *p = text;
+        double sign = *p == '-' ? -1.0 : 1.0;
+        if (*p == '-' || *p == '+')
+            ++p;
+        double mantissa = 0.0, scale = 1.0;
+        const char *digits = p;
+        for (; *p >= '0' && *p <= '9'; ++p)
+        {
+            mantissa = mantissa * 10.0 + (*p - '0');
+            scale *= 10.0;
+        }
+        if (p == digits)
+            return false;
+        long exponent = 0;
+        if (*p == '-' || *p == '+')
+        {
+            char *end;
+            exponent = std::strtol(p, &end, 10);
+            if (*end != '\0')
+                return false;
+        }
+        else if (*p != '\0')
+            return false;
+        value = sign * mantissa / scale * std::pow(10.0, (double)exponent);
+        return true;
+    }
+
+    // Five digits, or Alpha-5: a letter for the ten-thousands (A = 10, I and O skipped).
+    bool readCatalogNumber(const char *line, std::size_t length, int &number)
+    {
+        char text[24];
+        if (!readField(line, length, 3, 7, text))
+            return false;
+        int tens = 0;
+        const char *digits = text;
+        char letter = text[0];
+        if (letter >= 'A' && letter <= 'Z' && letter != 'I' && letter != 'O')
+        {
+            tens = 10 + (letter - 'A') - (letter > 'I') - (letter > 'O');
+            ++digits;
+        }
+        char *end;
+        long value = std::strtol(digits, &end, 10);
+        if (*end != '\0' || end == digits)
+            return false;
+        number = tens * 10000 + (int)value;
+        return true;
+    }
+}
+
+bool parseTwoLineElements(const char *line1, const char *line2, TwoLineElements &elements)
+{
+    const double degrees = kPi / 180.0;
+    std::size_t length1 = std::strlen(line1), length2 = std::strlen(line2);
+    if (line1[0] != '1' || line2[0] != '2')
+        return false;
+
+    TwoLineElements result;
+    double year, day, inclination, node, periapsis, meanAnomaly, revolutionsPerDay;
+    if (!readCatalogNumber(line1, length1, result.catalogNumber) ||
+        !readNumber(line1, length1, 19, 20, year) || !readNumber(line1, length1, 21, 32, day) ||
+        !readImpliedDecimal(line1, length1, 54, 61, result.bstar) ||
+        !readNumber(line2, length2, 9, 16, inclination) || !readNumber(line2, length2, 18, 25, node) ||
+        !readImpliedDecimal(line2, length2, 27, 33, result.eccentricity) ||
+        !readNumber(line2, length2, 35, 42, periapsis) || !readNumber(line2, length2, 44, 51, meanAnomaly) ||
+        !readNumber(line2, length2, 53, 63, revolutionsPerDay))
+        return false;
+    if (!(revolutionsPerDay > 0.0) || result.eccentricity >= 1.0)
+        return false;
+
+    // Two-digit years from 1957, Sputnik's.
+    int fullYear = (int)year + (year < 57.0 ? 2000 : 1900);
+    double januaryFirst = 367.0 * fullYear - std::floor(7.0 * fullYear * 0.25) + 30.0 + 1.0 + 1721013.5;
+    result.epochJd = januaryFirst + day - 1.0;
+    result.inclination = inclination * degrees;
+    result.ascendingNode = node * degrees;
+    result.periapsis = periapsis * degrees;
+    result.meanAnomaly = meanAnomaly * degrees;
+    result.meanMotion = revolutionsPerDay * kTwoPi / 1440.0;
+    elements = result;
+    return true;
+}
+
+bool loadTwoLineElements(const std::string &path, std::vector<TwoLineElements> &elements, TleLoadStats *stats)
+{
+    PROFILE_ZONE("loadTwoLineElements");
+    MappedFile file(path);
+    if (!file.isOpen())
+    {
+        std::cerr << "ERROR::TLE: could not read '" << path << "'" << std::endl;
+        return false;
+    }
+
+    const char *data = file.data();
+    const std::size_t size = file.size();
+    std::size_t position = 0;
+    // The next line, without its end of line, cut at 80 characters.
+    auto nextLine = [&](char (&line)[81])
+    {
+        if (position >= size)
+            return false;
+        std::size_t length = 0;
+        for (; position < size && data[position] != '\n'; ++position)
+            if (length < 80)
+                line[length++] = data[position];
+        ++position;
+        if (length > 0 && line[length - 1] == '\r')
+            --length;
+        line[length] = '\0';
+        return true;
+    };
+
+    TleLoadStats counts;
+    char title[81] = "", line[81], second[81];
+    while (nextLine(line))
+    {
+        if (line[0] != '1' || line[1] != ' ')
+        {
+            std::memcpy(title, line, sizeof(title));
+            continue;
+        }
+        if (!nextLine(second))
+        {
+            ++counts.skipped;
+            break;
+        }
+        TwoLineElements set;
+        if (second[0] != '2' || !parseTwoLineElements(line, second, set))
+        {
+            ++counts.skipped;
+            title[0] = '\0';
+            continue;
+        }
+
+        // Space-Track's three-line sets number the title line "0".
+        const char *name = title[0] == '0' && title[1] == ' ' ? title + 2 : title;
+        std::size_t length = std::min(std::strlen(name), set.name.size() - 1);
+        while (length > 0 && name[length - 1] == ' ')
+            --length;
+        std::memcpy(set.name.data(), name, length);
+        elements.push_back(set);
+        ++counts.sets;
+        title[0] = '\0';
+    }
+    if (stats)
+        *stats = counts;
+    return true;
+}
+
+Sgp4Propagator::Sgp4Propagator(const Sgp4Settings &sgp4Settings)
+    : settings(sgp4Settings), osculating(osculatingSettings(sgp4Settings))
+{
+    activeKernel = resolveGravityKernel(settings.kernel);
+}
+
+Sgp4Propagator::~Sgp4Propagator() = default;
+
+std::size_t Sgp4Propagator::deepSpaceCount() const
+{
+    return deep.size();
+}
+
+const TwoLineElements &Sgp4Propagator::elements(std::size_t i) const
+{
+    return i < nearEarthCount() ? nearEarthSources[i] : deep[i - nearEarthCount()].source;
+}
+
+double Sgp4Propagator::latestEpochJd() const
+{
+    double latest = 0.0;
+    for (std::size_t i = 0; i < size(); ++i)
+        latest = std::max(latest, elements(i).epochJd);
+    return latest;
+}
+
+bool Sgp4Propagator::add(const TwoLineElements &tle)
+{
+    if (!(tle.meanMotion > 0.0) || !(tle.eccentricity >= 0.0 && tle.eccentricity < 1.0))
+        return false;
+    double column[kNearEarthColumns];
+    Sgp4DeepSpace deepSpace;
+    bool isDeepSpace = false;
+    initialize(tle, column, deepSpace, isDeepSpace);
+
+    // Vallado's sgp4init() ends with a solve at the epoch, which rejects decayed orbits.
+    double state[6];
+    if (isDeepSpace)
+    {
+        if (!deepSpaceState(deepSpace, 0.0, state))
+            return false;
+        deep.push_back(deepSpace);
+    }
+    else
+    {
+        const double *columns[kNearEarthColumns];
+        for (int k = 0; k < kNearEarthColumns; ++k)
+            columns[k] = column + k;
+        if (!nearEarthState(columns, 0, 0.0, state))
+            return false;
+        for (int k = 0; k < kNearEarthColumns; ++k)
+            nearEarth[k].push_back(column[k]);
+        nearEarthSources.push_back(tle);
+    }
+    fitted = false;
+    return true;
+}
+
+std::size_t Sgp4Propagator::add(const std::vector<TwoLineElements> &elements)
+{
+    PROFILE_ZONE("Sgp4Propagator::add");
+    for (std::vector<double> &values : nearEarth)
+        values.reserve(values.size() + elements.size());
+    nearEarthSources.reserve(nearEarthSources.size() + elements.size());
+    std::size_t added = 0;
+    for (const TwoLineElements &tle : elements)
+        added += add(tle) ? 1 : 0;
+    return added;
+}
+
+void Sgp4Propagator::clear()
+{
+    for (std::vector<double> &values : nearEarth)
+        values.clear();
+    nearEarthSources.clear();
+    deep.clear();
+    osculating.clear();
+    solved.clear();
+    fitJd.clear();
+    cursor = 0;
+    fitted = false;
+}
+
+void Sgp4Propagator::solveRange(std::size_t begin, std::size_t end, double jd, double *x, double *y, double *z,
+                                double *vx, double *vy, double *vz) const
+{
+    const std::size_t nearCount = nearEarthCount();
+    States states = {x, y, z, vx, vy, vz};
+    if (begin < nearCount)
+    {
+        const double *columns[kNearEarthColumns];
+        for (int k = 0; k < kNearEarthColumns; ++k)
+            columns[k] = nearEarth[k].data();
+        selectKernel(activeKernel)(columns, states, begin, std::min(end, nearCount), jd);
+    }
+    for (std::size_t i = std::max(begin, nearCount); i < end; ++i)
+    {
+        const Sgp4DeepSpace &d = deep[i - nearCount];
+        double state[6];
+        if (deepSpaceState(d, (jd - d.source.epochJd) * 1440.0, state))
+            writeState(states, i, state);
+        else
+            writeNaN(states, i);
+    }
+}
+
+void Sgp4Propagator::propagate(double jd, double *x, double *y, double *z, double *vx, double *vy, double *vz) const
+{
+    PROFILE_ZONE("Sgp4Propagator::propagate");
+    const std::size_t count = size();
+    bool velocities = vx && vy && vz;
+    if (!velocities)
+        vx = vy = vz = nullptr;
+    unsigned int threads = Parallel::threadCount(settings.threads, count, kMinSatellitesPerThread);
+    if (threads <= 1)
+    {
+        solveRange(0, count, jd, x, y, z, vx, vy, vz);
+        return;
+    }
+    // Chunks rather than one range per thread: the deep-space satellites at the end cost several times more.
+    Parallel::runChunks((count + kChunk - 1) / kChunk, threads, [&](std::size_t n)
+                        { solveRange(n * kChunk, std::min(count, (n + 1) * kChunk), jd, x, y, z, vx, vy, vz); });
+}
+
+std::size_t Sgp4Propagator::update(double jd)
+{
+    PROFILE_ZONE("Sgp4Propagator::update");
+    const std::size_t count = size();
+    if (count == 0)
+        return 0;
+    if (osculating.size() != count || !fitted)
+    {
+        osculating.resize(count);
+        solved.assign(count * 6, 0.0);
+        fitJd.assign((count + kChunk - 1) / kChunk, jd);
+        cursor = 0;
+        fitted = false;
+    }
+
+    const std::size_t chunks = (count + kChunk - 1) / kChunk;
+    Clock::time_point deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(settings.budgetMs));
+    bool limited = fitted && settings.budgetMs > 0.0;
+    double *x = solved.data(), *y = x + count, *z = y + count;
+    double *vx = z + count, *vy = vx + count, *vz = vy + count;
+    const double minutes = (jd - kJ2000) * 1440.0;
+    const double gm = kMu * 3600.0; // km^3 / min^2
+    std::atomic<std::size_t> satellites(0);
+
+    auto solveChunk = [&](std::size_t n)
+    {
+        std::size_t chunk = (cursor + n) % chunks;
+        std::size_t begin = chunk * kChunk, end = std::min(count, begin + kChunk);
+        solveRange(begin, end, jd, x, y, z, vx, vy, vz);
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            // Scene order, as OrbitalElements; a failed solve leaves the satellite at the focus.
+            OrbitalElements orbit;
+            glm::dvec3 position(x[i], z[i], y[i]), velocity(vx[i] * 60.0, vz[i] * 60.0, vy[i] * 60.0);
+            if (!osculatingElements(position, velocity, gm, minutes, orbit))
+                orbit.semiMajorAxis = 0.0;
+            osculating.set(i, orbit);
+        }
+        fitJd[chunk] = jd;
+        satellites += end - begin;
+    };
+
+    // The chunks from the cursor on are the oldest; those past maxAgeMinutes go first, whatever the budget.
+    std::size_t stale = 0;
+    if (limited && settings.maxAgeMinutes > 0.0)
+        while (stale < chunks && std::abs(jd - fitJd[(cursor + stale) % chunks]) * 1440.0 > settings.maxAgeMinutes)
+            ++stale;
+    unsigned int threads = Parallel::threadCount(settings.threads, count, kMinSatellitesPerThread);
+    std::size_t ran = stale > 0 ? Parallel::runChunks(stale, threads, solveChunk) : 0;
+    ran += Parallel::runChunks(chunks - stale, threads, [&](std::size_t n) { solveChunk(stale + n); },
+                               limited ? &deadline : nullptr);
+
+    cursor = (cursor + ran) % chunks;
+    fitted = true;
+    return satellites.load();
+}
+
+void Sgp4Propagator::positions(double jd, double *x, double *y, double *z) const
+{
+    PROFILE_ZONE("Sgp4Propagator::positions");
+    osculating.propagate((jd - kJ2000) * 1440.0, x, z, y);
+}
@@ -1,7 +1,11 @@
 #include "../include/shader.h"
+#include "../include/profiler.h"
+#include "../include/gl43.h"
 
 Shader::Shader(const char *vertexPath, const char *fragmentPath)
 {
+    PROFILE_ZONE("Shader::Shader");
+
     // 1. Retrieve the vertex/fragment source code from filePath
     std::string vertexCode;
     std::string fragmentCode;
@@ -57,6 +61,39 @@ Shader::Shader(const char *vertexPath, const char *fragmentPath)
     glDeleteShader(fragment);
 }
 
+Shader::Shader(const char *computePath)
+{
+    PROFILE_ZONE("Shader::Shader");
+
+    std::string computeCode;
+    std::ifstream cShaderFile;
+    cShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    try
+    {
+        cShaderFile.open(computePath);
+        std::stringstream cShaderStream;
+        cShaderStream << cShaderFile.rdbuf();
+        cShaderFile.close();
+        computeCode = cShaderStream.str();
+    }
+    catch (std::ifstream::failure &e)
+    {
+        std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << " (" << computePath << ")" << std::endl;
+    }
+    const char *cShaderCode = computeCode.c_str();
+
+    unsigned int compute = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(compute, 1, &cShaderCode, NULL);
+    glCompileShader(compute);
+    checkCompileErrors(compute, "COMPUTE");
+
+    ID = glCreateProgram();
+    glAttachShader(ID, compute);
+    glLinkProgram(ID);
+    checkCompileErrors(ID, "PROGRAM");
+    glDeleteShader(compute);
+}
+
 void Shader::use()
 {
     glUseProgram(ID);
@@ -97,6 +134,11 @@ void Shader::setMat4(const std::string &name, const glm::mat4 &mat) const
     glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
 }
 
+void Shader::setVec4Array(const std::string &name, const glm::vec4 *values, int count) const
+{
+    glUniform4fv(glGetUniformLocation(ID, name.c_str()), count, &values[0][0]);
+}
+
 void Shader::checkCompileErrors(unsigned int shader, std::string type)
 {
     int success;
@@ -0,0 +1,162 @@
+#include "../include/sphere_generator.h"
+#include "../include/parallel.h"
+#include "../include/profiler.h"
+#include "../include/glm/glm/gtc/constants.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SPHERE_GENERATOR_SSE2 1
+#endif
+
+UVSphereTables buildUVSphereTables(unsigned int rings, unsigned int sectors)
+{
+    // Same expressions, in the same precision, as the per-vertex loop this
+    // replaces: angles in float, sin/cos and their products in double.
+    float const R = 1.0f / (float)(rings - 1);
+    float const S = 1.0f / (float)(sectors - 1);
+
+    UVSphereTables tables;
+    tables.ringY.resize(rings);
+    tables.ringRadius.resize(rings);
+    tables.ringV.resize(rings);
+    for (unsigned int r = 0; r < rings; ++r)
+    {
+        float phi = glm::pi<float>() * r * R;
+        tables.ringY[r] = (float)std::sin((double)(-glm::pi<float>() / 2 + phi));
+        tables.ringRadius[r] = std::sin((double)phi);
+        tables.ringV[r] = r * R;
+    }
+
+    tables.sectorCos.resize(sectors);
+    tables.sectorSin.resize(sectors);
+    tables.sectorU.resize(sectors);
+    for (unsigned int s = 0; s < sectors; ++s)
+    {
+        float theta = 2 * glm::pi<float>() * s * S;
+        tables.sectorCos[s] = std::cos((double)theta);
+        tables.sectorSin[s] = std::sin((double)theta);
+        tables.sectorU[s] = 1.0f - (s * S);
+    }
+    return tables;
+}
+
+/** @brief Vertices of rings [firstRing, endRing). */
+static void writeRingVertices(const UVSphereTables &tables, float radius, unsigned int sectors,
+                              unsigned int firstRing, unsigned int endRing, StandardVertex *vertices)
+{
+    for (unsigned int r = firstRing; r < endRing; ++r)
+    {
+        StandardVertex *out = vertices + (std::size_t)r * sectors;
+        double ringRadius = tables.ringRadius[r];
+        float y = tables.ringY[r];
+        float v = tables.ringV[r];
+        unsigned int s = 0;
+
+#ifdef SPHERE_GENERATOR_SSE2
+        // Four sectors per step: x and z as two double pairs each (rounded to
+        // float like the scalar path), then a 4x4 transpose turns the
+        // per-component registers into two 16-byte halves per vertex.
+        __m128d ringRadius2 = _mm_set1_pd(ringRadius);
+        __m128 radius4 = _mm_set1_ps(radius);
+        __m128 ny = _mm_set1_ps(y);
+        __m128 texV = _mm_set1_ps(v);
+        for (; s + 4 <= sectors; s += 4)
+        {
+            __m128 nx = _mm_movelh_ps(_mm_cvtpd_ps(_mm_mul_pd(_mm_loadu_pd(&tables.sectorCos[s]), ringRadius2)),
+                                      _mm_cvtpd_ps(_mm_mul_pd(_mm_loadu_pd(&tables.sectorCos[s + 2]), ringRadius2)));
+            __m128 nz = _mm_movelh_ps(_mm_cvtpd_ps(_mm_mul_pd(_mm_loadu_pd(&tables.sectorSin[s]), ringRadius2)),
+                                      _mm_cvtpd_ps(_mm_mul_pd(_mm_loadu_pd(&tables.sectorSin[s + 2]), ringRadius2)));
+
+            __m128 a0 = _mm_mul_ps(nx, radius4), a1 = _mm_mul_ps(ny, radius4), a2 = _mm_mul_ps(nz, radius4), a3 = nx;
+            __m128 b0 = ny, b1 = nz, b2 = _mm_loadu_ps(&tables.sectorU[s]), b3 = texV;
+            _MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+            _MM_TRANSPOSE4_PS(b0, b1, b2, b3);
+
+            float *dst = out[s].position;
+            _mm_storeu_ps(dst, a0);
+            _mm_storeu_ps(dst + 4, b0);
+            _mm_storeu_ps(dst + 8, a1);
+            _mm_storeu_ps(dst + 12, b1);
+            _mm_storeu_ps(dst + 16, a2);
+            _mm_storeu_ps(dst + 20, b2);
+            _mm_storeu_ps(dst + 24, a3);
+            _mm_storeu_ps(dst + 28, b3);
+        }
+#endif
+        for (; s < sectors; ++s)
+        {
+            float x = (float)(tables.sectorCos[s] * ringRadius);
+            float z = (float)(tables.sectorSin[s] * ringRadius);
+            StandardVertex &vertex = out[s];
+            vertex.position[0] = x * radius;
+            vertex.position[1] = y * radius;
+            vertex.position[2] = z * radius;
+            vertex.normal[0] = x;
+            vertex.normal[1] = y;
+            vertex.normal[2] = z;
+            vertex.texCoord[0] = tables.sectorU[s];
+            vertex.texCoord[1] = v;
+        }
+    }
+}
+
+/** @brief Indices of the quads between ring r and r + 1, for r in [firstRing, endRing). */
+template <typename Index>
+static void writeRingIndices(unsigned int sectors, unsigned int firstRing, unsigned int endRing, Index *indices)
+{
+    Index *out = indices + (std::size_t)firstRing * (sectors - 1) * 6;
+    for (unsigned int r = firstRing; r < endRing; ++r)
+    {
+        Index row = (Index)(r * sectors);
+        Index next = (Index)(row + sectors);
+        for (unsigned int s = 0; s < sectors - 1; ++s)
+        {
+            out[0] = (Index)(row + s);
+            out[1] = (Index)(row + s + 1);
+            out[2] = (Index)(next + s + 1);
+            out[3] = (Index)(row + s);
+            out[4] = (Index)(next + s + 1);
+            out[5] = (Index)(next + s);
+            out += 6;
+        }
+    }
+}
+
+template <typename Index>
+static void writeUVSphereImpl(float radius, unsigned int rings, unsigned int sectors,
+                              StandardVertex *vertices, Index *indices, unsigned int threads)
+{
+    PROFILE_ZONE("writeUVSphere");
+
+    if (rings < 2 || sectors < 2)
+        return;
+
+    UVSphereTables tables = buildUVSphereTables(rings, sectors);
+
+    // Split by whole rings, with at least 64k vertices a thread.
+    const std::size_t minVerticesPerThread = 64 * 1024;
+    unsigned int threadCount = std::min(Parallel::threadCount(threads, uvSphereVertexCount(rings, sectors), minVerticesPerThread), rings);
+    Parallel::parallelSlices(threadCount, rings, [&](unsigned int, std::size_t begin, std::size_t end)
+    {
+        unsigned int firstRing = (unsigned int)begin, endRing = (unsigned int)end;
+        if (vertices)
+            writeRingVertices(tables, radius, sectors, firstRing, endRing, vertices);
+        if (indices)
+            writeRingIndices(sectors, firstRing, std::min(endRing, rings - 1), indices);
+    });
+}
+
+void writeUVSphere(float radius, unsigned int rings, unsigned int sectors,
+                   StandardVertex *vertices, unsigned int *indices, unsigned int threads)
+{
+    writeUVSphereImpl(radius, rings, sectors, vertices, indices, threads);
+}
+
+void writeUVSphere(float radius, unsigned int rings, unsigned int sectors,
+                   StandardVertex *vertices, unsigned short *indices, unsigned int threads)
+{
+    writeUVSphereImpl(radius, rings, sectors, vertices, indices, threads);
+}
@@ -0,0 +1,350 @@
+#include "../include/terrain.h"
+#include "../include/frustum.h"
+#include "../include/planet.h"
+#include "../include/profiler.h"
+#include "../include/glm/glm/gtc/constants.hpp"
+#include "../include/glm/glm/gtc/type_ptr.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+    // Fraction of a level's distance band after which its vertices start
+    // morphing towards the next coarser grid.
+    const float kMorphStart = 0.7f;
+
+    /** @brief Distance from @p p to the box, 0 inside. */
+    float distanceToBox(const glm::vec3 &p, const glm::vec3 &boxMin, const glm::vec3 &boxMax)
+    {
+        glm::vec3 d = glm::max(glm::max(boxMin - p, p - boxMax), glm::vec3(0.0f));
+        return glm::length(d);
+    }
+}
+
+PlanetTerrain::PlanetTerrain(const TerrainSettings &terrainSettings)
+    : settings(terrainSettings), streamer(terrainSettings.source)
+{
+    PROFILE_ZONE("PlanetTerrain::PlanetTerrain");
+
+    settings.maxLevel = glm::clamp(settings.maxLevel, 0, 20);
+
+    GLint maxLayers = 256;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+    // The six roots are always resident; leave room for at least one level below them.
+    settings.tileBudget = glm::clamp<std::size_t>(settings.tileBudget, 6 + 24, (std::size_t)maxLayers);
+
+    // Level L chunks are (pi/2) / 2^L wide on the unit sphere; the deepest level has no finer band.
+    ranges.resize(settings.maxLevel + 2, 0.0f);
+    for (int level = 0; level <= settings.maxLevel; ++level)
+        ranges[level] = settings.lodDistanceRatio * glm::half_pi<float>() / (float)(1 << level);
+
+    // --- Height tile array: the fixed GPU budget ---
+    glGenTextures(1, &tileArray);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, tileArray);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA32F, kTileSamples, kTileSamples, (GLsizei)settings.tileBudget, 0, GL_RGBA, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    slots.resize(settings.tileBudget);
+
+    // --- Chunk grid: positions come from gl_VertexID, so only indices are stored ---
+    // Indices are grouped by quadrant so a quarter of a chunk can be drawn on its own.
+    std::vector<unsigned short> indices;
+    const int half = kTileQuads / 2;
+    for (int quadrant = 0; quadrant < 4; ++quadrant)
+    {
+        int x0 = (quadrant & 1) * half;
+        int y0 = (quadrant >> 1) * half;
+        for (int y = y0; y < y0 + half; ++y)
+        {
+            for (int x = x0; x < x0 + half; ++x)
+            {
+                unsigned short a = (unsigned short)(y * kTileSamples + x);
+                unsigned short b = (unsigned short)(a + 1);
+                unsigned short c = (unsigned short)(a + kTileSamples);
+                unsigned short d = (unsigned short)(c + 1);
+                // Same diagonal everywhere: a fully morphed grid then
+                // coincides with the next coarser one.
+                indices.insert(indices.end(), {a, b, d, a, d, c});
+            }
+        }
+    }
+    quadrantIndexCount = (GLsizei)(indices.size() / 4);
+
+    glGenVertexArrays(1, &gridVAO);
+    glGenBuffers(1, &gridEBO);
+    glBindVertexArray(gridVAO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gridEBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned short), indices.data(), GL_STATIC_DRAW);
+    glBindVertexArray(0);
+
+    // The face roots are loaded synchronously and never evicted, so every
+    // chunk always has some ancestor to draw with.
+    for (int face = 0; face < 6; ++face)
+    {
+        int slot = uploadTile(streamer.load(TileKey{face, 0, 0, 0}));
+        slots[slot].pinned = true;
+    }
+}
+
+PlanetTerrain::~PlanetTerrain()
+{
+    glDeleteTextures(1, &tileArray);
+    glDeleteVertexArrays(1, &gridVAO);
+    glDeleteBuffers(1, &gridEBO);
+}
+
+int PlanetTerrain::uploadTile(const HeightTile &tile)
+{
+    if (slotOfTile.count(tile.key.packed()))
+        return slotOfTile[tile.key.packed()];
+
+    // A free slot, else the least recently used tile that was not drawn in
+    // the previous frame either; when every tile is in use the new one is
+    // dropped and its chunks keep drawing with an ancestor.
+    int slot = -1;
+    for (int i = 0; i < (int)slots.size(); ++i)
+    {
+        const TileSlot &candidate = slots[i];
+        if (!candidate.used)
+        {
+            slot = i;
+            break;
+        }
+        if (!candidate.pinned && candidate.lastUsed + 1 < frame && (slot < 0 || candidate.lastUsed < slots[slot].lastUsed))
+            slot = i;
+    }
+    if (slot < 0)
+        return -1;
+
+    if (slots[slot].used)
+        slotOfTile.erase(slots[slot].key.packed());
+    slots[slot].key = tile.key;
+    slots[slot].used = true;
+    slots[slot].lastUsed = frame;
+    slots[slot].minHeight = tile.minHeight;
+    slots[slot].maxHeight = tile.maxHeight;
+    slotOfTile[tile.key.packed()] = slot;
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, tileArray);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, slot, kTileSamples, kTileSamples, 1, GL_RGBA, GL_FLOAT, tile.texels.data());
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    return slot;
+}
+
+int PlanetTerrain::residentLayer(const TileKey &key)
+{
+    auto it = slotOfTile.find(key.packed());
+    if (it == slotOfTile.end())
+        return -1;
+    slots[it->second].lastUsed = frame;
+    return it->second;
+}
+
+PlanetTerrain::NodeBounds PlanetTerrain::nodeBounds(const TileKey &key) const
+{
+    // Box and cone around a 3x3 sampling of the node at its lowest and highest
+    // elevation, padded for the bulge of the sphere between samples. The
+    // elevation range is the node's own tile's, or that of its closest
+    // resident ancestor, which contains it.
+    float size = 1.0f / (float)(1 << key.level);
+    TileKey ancestor = key;
+    auto it = slotOfTile.find(ancestor.packed());
+    while (it == slotOfTile.end())
+    {
+        ancestor = ancestor.parent();
+        it = slotOfTile.find(ancestor.packed());
+    }
+    float minHeight = slots[it->second].minHeight;
+    float maxHeight = slots[it->second].maxHeight;
+    glm::vec3 directions[9];
+    for (int j = 0; j <= 2; ++j)
+        for (int i = 0; i <= 2; ++i)
+            directions[j * 3 + i] = cubeSphereDirection(key.face, (key.x + i * 0.5f) * size, (key.y + j * 0.5f) * size);
+
+    NodeBounds bounds;
+    bounds.boxMin = glm::vec3(1e9f);
+    bounds.boxMax = glm::vec3(-1e9f);
+    bounds.axis = directions[4];
+    bounds.angle = 0.0f;
+    for (const glm::vec3 &direction : directions)
+    {
+        bounds.boxMin = glm::min(bounds.boxMin, glm::min(direction * (1.0f + minHeight), direction * (1.0f + maxHeight)));
+        bounds.boxMax = glm::max(bounds.boxMax, glm::max(direction * (1.0f + minHeight), direction * (1.0f + maxHeight)));
+        bounds.angle = std::max(bounds.angle, std::acos(glm::clamp(glm::dot(direction, bounds.axis), -1.0f, 1.0f)));
+    }
+    // Samples are at most ~(pi/2) * size / 2 * 1.3 radians apart; sagitta = 1 - cos(angle / 2).
+    float spacing = glm::half_pi<float>() * size * 0.5f * 1.3f;
+    float pad = (1.0f - std::cos(spacing * 0.5f)) * (1.0f + maxHeight);
+    bounds.boxMin -= glm::vec3(pad);
+    bounds.boxMax += glm::vec3(pad);
+    bounds.angle += spacing * 0.5f;
+    return bounds;
+}
+
+bool PlanetTerrain::nodeVisible(const NodeBounds &bounds) const
+{
+    // Horizon: a point at the highest elevation is hidden behind the lowest
+    // possible sphere once its angle from the camera direction exceeds
+    // acos(r / cameraDistance) + acos(r / (1 + heightScale)).
+    if (horizonAngle < glm::pi<float>())
+    {
+        float angle = std::acos(glm::clamp(glm::dot(glm::normalize(cameraPosition), bounds.axis), -1.0f, 1.0f));
+        if (angle - bounds.angle > horizonAngle)
+            return false;
+    }
+
+    for (int i = 0; i < 6; ++i)
+    {
+        const glm::vec4 &plane = frustumPlanes[i];
+        glm::vec3 farthest(plane.x >= 0.0f ? bounds.boxMax.x : bounds.boxMin.x,
+                           plane.y >= 0.0f ? bounds.boxMax.y : bounds.boxMin.y,
+                           plane.z >= 0.0f ? bounds.boxMax.z : bounds.boxMin.z);
+        if (glm::dot(glm::vec3(plane), farthest) + plane.w < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+void PlanetTerrain::update(const glm::vec3 &cameraLocal, const glm::mat4 &localToClip)
+{
+    PROFILE_ZONE("PlanetTerrain::update");
+
+    ++frame;
+    stats.uploads = 0;
+    {
+        PROFILE_ZONE("Upload height tiles");
+        for (const HeightTile &tile : streamer.takeCompleted(settings.uploadsPerFrame))
+        {
+            if (uploadTile(tile) >= 0)
+                ++stats.uploads;
+        }
+    }
+
+    // Clip planes in local space.
+    extractFrustumPlanes(localToClip, frustumPlanes);
+
+    cameraPosition = cameraLocal;
+    float heightScale = std::abs(settings.source.heightScale);
+    float occluder = 1.0f - heightScale;
+    float cameraDistance = glm::length(cameraLocal);
+    horizonAngle = cameraDistance > occluder
+        ? std::acos(occluder / cameraDistance) + std::acos(occluder / (1.0f + heightScale))
+        : glm::pi<float>();
+
+    chunks.clear();
+    stats.triangles = 0;
+    stats.deepestLevel = 0;
+    {
+        PROFILE_ZONE("Select chunks");
+        for (int face = 0; face < 6; ++face)
+            selectNode(TileKey{face, 0, 0, 0});
+    }
+
+    stats.chunks = chunks.size();
+    stats.residentTiles = slotOfTile.size();
+    stats.pendingTiles = streamer.pendingCount();
+    stats.gpuBytes = settings.tileBudget * kTileSamples * kTileSamples * 4 * sizeof(float) + quadrantIndexCount * 4 * sizeof(unsigned short);
+}
+
+void PlanetTerrain::selectNode(const TileKey &key)
+{
+    NodeBounds bounds = nodeBounds(key);
+    if (!nodeVisible(bounds))
+        return;
+
+    if (key.level < settings.maxLevel && distanceToBox(cameraPosition, bounds.boxMin, bounds.boxMax) < ranges[key.level + 1])
+    {
+        // Children within their own range are refined further; the others are
+        // covered by the matching quarter of this node's grid.
+        for (int i = 0; i < 4; ++i)
+        {
+            TileKey child = key.child(i);
+            NodeBounds childBounds = nodeBounds(child);
+            if (!nodeVisible(childBounds))
+                continue;
+            if (distanceToBox(cameraPosition, childBounds.boxMin, childBounds.boxMax) < ranges[child.level])
+                selectNode(child);
+            else
+                addChunk(key, i);
+        }
+        return;
+    }
+    addChunk(key, -1);
+}
+
+void PlanetTerrain::addChunk(const TileKey &key, int quadrant)
+{
+    Chunk chunk;
+    chunk.key = key;
+    chunk.quadrant = quadrant;
+    chunk.tileTransform = glm::vec3(1.0f, 0.0f, 0.0f);
+    chunk.layer = residentLayer(key);
+
+    if (chunk.layer < 0)
+    {
+        // Stream the tile and any missing ancestors (queued last, so they are
+        // served first), and stand in with the closest resident ancestor.
+        streamer.request(key);
+        TileKey ancestor = key.parent();
+        while ((chunk.layer = residentLayer(ancestor)) < 0)
+        {
+            streamer.request(ancestor);
+            ancestor = ancestor.parent();
+        }
+
+        int levels = key.level - ancestor.level;
+        float scale = 1.0f / (float)(1 << levels);
+        chunk.tileTransform = glm::vec3(scale, (key.x - (ancestor.x << levels)) * scale, (key.y - (ancestor.y << levels)) * scale);
+    }
+
+    chunks.push_back(chunk);
+    stats.triangles += (quadrant < 0 ? 4 : 1) * quadrantIndexCount / 3;
+    stats.deepestLevel = std::max(stats.deepestLevel, key.level);
+}
+
+void PlanetTerrain::draw(Shader &shader, int tileUnit)
+{
+    PROFILE_ZONE("PlanetTerrain::draw");
+
+    GLint faceLoc = glGetUniformLocation(shader.ID, "face");
+    GLint nodeOriginLoc = glGetUniformLocation(shader.ID, "nodeOrigin");
+    GLint nodeSizeLoc = glGetUniformLocation(shader.ID, "nodeSize");
+    GLint morphRangeLoc = glGetUniformLocation(shader.ID, "morphRange");
+    GLint tileLayerLoc = glGetUniformLocation(shader.ID, "tileLayer");
+    GLint tileTransformLoc = glGetUniformLocation(shader.ID, "tileTransform");
+
+    shader.setInt("heightTiles", tileUnit);
+    shader.setVec3("cameraLocal", cameraPosition);
+    glActiveTexture(GL_TEXTURE0 + tileUnit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, tileArray);
+    glBindVertexArray(gridVAO);
+
+    for (const Chunk &chunk : chunks)
+    {
+        int level = chunk.key.level;
+        float size = 1.0f / (float)(1 << level);
+        float morphEnd = ranges[level];
+        float morphStart = ranges[level + 1] + (morphEnd - ranges[level + 1]) * kMorphStart;
+
+        glUniform1i(faceLoc, chunk.key.face);
+        glUniform2f(nodeOriginLoc, chunk.key.x * size, chunk.key.y * size);
+        glUniform1f(nodeSizeLoc, size);
+        glUniform2f(morphRangeLoc, morphStart, morphEnd);
+        glUniform1f(tileLayerLoc, (float)chunk.layer);
+        glUniform3fv(tileTransformLoc, 1, glm::value_ptr(chunk.tileTransform));
+
+        if (chunk.quadrant < 0)
+            glDrawElements(GL_TRIANGLES, quadrantIndexCount * 4, GL_UNSIGNED_SHORT, (void *)0);
+        else
+            glDrawElements(GL_TRIANGLES, quadrantIndexCount, GL_UNSIGNED_SHORT, (void *)(chunk.quadrant * quadrantIndexCount * sizeof(unsigned short)));
+    }
+
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glActiveTexture(GL_TEXTURE0);
+}
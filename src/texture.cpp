@@ -0,0 +1,148 @@
+#include "../include/texture.h"
+#include "../include/stb_image.h"
+#include "../include/profiler.h"
+
+#include <algorithm>
+#include <iostream>
+
+// ===================== Load Texture =====================
+unsigned int loadTexture(const char* path)
+{
+    PROFILE_ZONE("loadTexture");
+    unsigned int textureID;
+    glGenTextures(1,&textureID);
+
+    int width,height,nrChannels;
+    stbi_set_flip_vertically_on_load(true);
+    unsigned char* data = stbi_load(path,&width,&height,&nrChannels,0);
+    if(data)
+    {
+        GLenum format = (nrChannels == 3) ? GL_RGB : GL_RGBA;
+        glBindTexture(GL_TEXTURE_2D,textureID);
+        glTexImage2D(GL_TEXTURE_2D,0,format,width,height,0,format,GL_UNSIGNED_BYTE,data);
+        glGenerateMipmap(GL_TEXTURE_2D);
+
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+
+        stbi_image_free(data);
+    }
+    else
+    {
+        std::cerr << "Failed to load texture: " << path << std::endl;
+        stbi_image_free(data);
+    }
+
+    return textureID;
+}
+
+// ===================== Load Texture Array =====================
+unsigned int loadTextureArray(const std::vector<std::string> &paths)
+{
+    PROFILE_ZONE("loadTextureArray");
+
+    // Every image becomes a temporary 2D texture first; the array then gets
+    // the largest size and each layer is filled by a linear-filtered blit.
+    std::vector<unsigned int> images(paths.size(), 0);
+    std::vector<int> widths(paths.size(), 0), heights(paths.size(), 0);
+    int width = 1, height = 1;
+    stbi_set_flip_vertically_on_load(true);
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        unsigned char* data = stbi_load(paths[i].c_str(), &widths[i], &heights[i], nullptr, 4);
+        if (!data)
+        {
+            std::cerr << "Failed to load texture: " << paths[i] << std::endl;
+            continue;
+        }
+        glGenTextures(1, &images[i]);
+        glBindTexture(GL_TEXTURE_2D, images[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, widths[i], heights[i], 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        stbi_image_free(data);
+        width = std::max(width, widths[i]);
+        height = std::max(height, heights[i]);
+    }
+
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, (GLsizei)std::max<size_t>(paths.size(), 1), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    GLint previousRead, previousDraw;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousRead);
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousDraw);
+    unsigned int framebuffers[2];
+    glGenFramebuffers(2, framebuffers);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffers[0]);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffers[1]);
+    GLboolean scissor = glIsEnabled(GL_SCISSOR_TEST);
+    glDisable(GL_SCISSOR_TEST);
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, textureID, 0, (GLint)i);
+        if (!images[i])
+        {
+            GLfloat black[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+            glClearBufferfv(GL_COLOR, 0, black);
+            continue;
+        }
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, images[i], 0);
+        glBlitFramebuffer(0, 0, widths[i], heights[i], 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    }
+    if (scissor)
+        glEnable(GL_SCISSOR_TEST);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, previousRead);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previousDraw);
+    glDeleteFramebuffers(2, framebuffers);
+    for (unsigned int image : images)
+        if (image)
+            glDeleteTextures(1, &image);
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    return textureID;
+}
+
+// ===================== Load Cubemap =====================
+unsigned int loadCubemap(std::vector<std::string> faces)
+{
+    PROFILE_ZONE("loadCubemap");
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+
+    int width, height, nrChannels;
+    stbi_set_flip_vertically_on_load(false);
+
+    for(unsigned int i = 0; i < faces.size(); i++)
+    {
+        unsigned char* data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
+        if(data)
+        {
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
+                         0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
+            stbi_image_free(data);
+        }
+        else
+        {
+            std::cout << "Cubemap texture failed to load: " << faces[i] << std::endl;
+            stbi_image_free(data);
+        }
+    }
+
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+    return textureID;
+}
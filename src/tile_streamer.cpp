@@ -0,0 +1,229 @@
+#include "../include/tile_streamer.h"
+#include "../include/planet.h"
+#include "../include/profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+namespace
+{
+    // Samples per edge including the one-sample border used for normals.
+    const int kApronSamples = kTileSamples + 2;
+
+    double fade(double t)
+    {
+        return t * t * t * (t * (t * 6.0 - 15.0) + 10.0);
+    }
+
+    double gradient(int hash, double x, double y, double z)
+    {
+        int h = hash & 15;
+        double u = h < 8 ? x : y;
+        double v = h < 4 ? y : (h == 12 || h == 14 ? x : z);
+        return ((h & 1) ? -u : u) + ((h & 2) ? -v : v);
+    }
+
+    /** @brief Improved Perlin gradient noise in [-1, 1] over a 512-entry doubled permutation. */
+    double gradientNoise(const int *perm, double x, double y, double z)
+    {
+        double fx = std::floor(x), fy = std::floor(y), fz = std::floor(z);
+        int X = (int)fx & 255, Y = (int)fy & 255, Z = (int)fz & 255;
+        x -= fx;
+        y -= fy;
+        z -= fz;
+        double u = fade(x), v = fade(y), w = fade(z);
+
+        int A = perm[X] + Y, AA = perm[A] + Z, AB = perm[A + 1] + Z;
+        int B = perm[X + 1] + Y, BA = perm[B] + Z, BB = perm[B + 1] + Z;
+
+        auto lerp = [](double t, double a, double b) { return a + t * (b - a); };
+        return lerp(w,
+                    lerp(v, lerp(u, gradient(perm[AA], x, y, z), gradient(perm[BA], x - 1, y, z)),
+                         lerp(u, gradient(perm[AB], x, y - 1, z), gradient(perm[BB], x - 1, y - 1, z))),
+                    lerp(v, lerp(u, gradient(perm[AA + 1], x, y, z - 1), gradient(perm[BA + 1], x - 1, y, z - 1)),
+                         lerp(u, gradient(perm[AB + 1], x, y - 1, z - 1), gradient(perm[BB + 1], x - 1, y - 1, z - 1))));
+    }
+}
+
+TileStreamer::TileStreamer(const TileSourceSettings &sourceSettings)
+    : settings(sourceSettings)
+{
+    std::mt19937 rng(settings.seed);
+    for (int i = 0; i < 256; ++i)
+        permutation[i] = i;
+    std::shuffle(permutation, permutation + 256, rng);
+    for (int i = 0; i < 256; ++i)
+        permutation[256 + i] = permutation[i];
+
+    worker = std::thread(&TileStreamer::workerLoop, this);
+}
+
+TileStreamer::~TileStreamer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    worker.join();
+}
+
+void TileStreamer::request(const TileKey &key)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!pending.insert(key.packed()).second)
+            return;
+
+        queue.push_back(key);
+        if (queue.size() > kMaxQueued)
+        {
+            pending.erase(queue.front().packed());
+            queue.pop_front();
+        }
+    }
+    wake.notify_one();
+}
+
+std::vector<HeightTile> TileStreamer::takeCompleted(std::size_t maxTiles)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::size_t count = std::min(maxTiles, completed.size());
+    std::vector<HeightTile> tiles(std::make_move_iterator(completed.begin()), std::make_move_iterator(completed.begin() + count));
+    completed.erase(completed.begin(), completed.begin() + count);
+    for (const HeightTile &tile : tiles)
+        pending.erase(tile.key.packed());
+    return tiles;
+}
+
+std::size_t TileStreamer::pendingCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return pending.size() - completed.size();
+}
+
+void TileStreamer::workerLoop()
+{
+    for (;;)
+    {
+        TileKey key;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (stopping)
+                return;
+            key = queue.back();
+            queue.pop_back();
+        }
+
+        HeightTile tile = load(key);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        completed.push_back(std::move(tile));
+    }
+}
+
+bool TileStreamer::readTileFile(const TileKey &key, std::vector<float> &heights) const
+{
+    if (settings.directory.empty())
+        return false;
+
+    std::string path = settings.directory + "/" + std::to_string(key.face) + "/" + std::to_string(key.level) + "/" +
+                       std::to_string(key.x) + "_" + std::to_string(key.y) + ".r16";
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    std::vector<unsigned char> bytes(kApronSamples * kApronSamples * 2);
+    if (!file.read((char *)bytes.data(), bytes.size()))
+    {
+        std::cerr << "ERROR::TILE_STREAMER::SHORT_TILE_FILE: " << path << std::endl;
+        return false;
+    }
+
+    for (std::size_t i = 0; i < heights.size(); ++i)
+    {
+        unsigned int value = bytes[2 * i] | (bytes[2 * i + 1] << 8);
+        heights[i] = (value / 65535.0f * 2.0f - 1.0f) * settings.heightScale;
+    }
+    return true;
+}
+
+float TileStreamer::proceduralHeight(const glm::vec3 &direction) const
+{
+    // fBm evaluated on the sphere itself, so every level samples the same
+    // surface and a sample shared by a parent and its children is identical.
+    // 14 octaves put features down to ~1/30000 of the radius.
+    double sum = 0.0, amplitude = 0.5, frequency = 2.0;
+    for (int octave = 0; octave < 14; ++octave)
+    {
+        sum += amplitude * gradientNoise(permutation, direction.x * frequency + 17.0 * octave,
+                                         direction.y * frequency, direction.z * frequency);
+        amplitude *= 0.5;
+        frequency *= 2.0;
+    }
+    return (float)glm::clamp(sum, -1.0, 1.0) * settings.heightScale;
+}
+
+HeightTile TileStreamer::load(const TileKey &key) const
+{
+    PROFILE_ZONE("TileStreamer::load");
+
+    // Face coordinates of sample i are (key.x + i / kTileQuads) / 2^level,
+    // exact in float, so tiles of every level agree on shared samples.
+    float tilesPerFace = (float)(1 << key.level);
+    std::vector<glm::vec3> directions(kApronSamples * kApronSamples);
+    for (int j = 0; j < kApronSamples; ++j)
+    {
+        for (int i = 0; i < kApronSamples; ++i)
+        {
+            float s = (key.x + (i - 1) / (float)kTileQuads) / tilesPerFace;
+            float t = (key.y + (j - 1) / (float)kTileQuads) / tilesPerFace;
+            directions[j * kApronSamples + i] = cubeSphereDirection(key.face, s, t);
+        }
+    }
+
+    std::vector<float> heights(kApronSamples * kApronSamples);
+    if (!readTileFile(key, heights))
+    {
+        for (std::size_t i = 0; i < heights.size(); ++i)
+            heights[i] = proceduralHeight(directions[i]);
+    }
+
+    HeightTile tile;
+    tile.key = key;
+    tile.texels.resize(kTileSamples * kTileSamples * 4);
+    tile.minHeight = tile.maxHeight = heights[kApronSamples + 1];
+
+    auto surface = [&](int i, int j)
+    {
+        int index = j * kApronSamples + i;
+        return glm::dvec3(directions[index]) * (1.0 + heights[index]);
+    };
+
+    for (int j = 0; j < kTileSamples; ++j)
+    {
+        for (int i = 0; i < kTileSamples; ++i)
+        {
+            // Central differences over the border-extended grid; doubles because
+            // neighbouring samples of deep levels differ by ~1e-5.
+            glm::dvec3 normal = glm::cross(surface(i + 2, j + 1) - surface(i, j + 1), surface(i + 1, j + 2) - surface(i + 1, j));
+            glm::dvec3 up(directions[(j + 1) * kApronSamples + i + 1]);
+            normal = glm::normalize(normal);
+            if (glm::dot(normal, up) < 0.0)
+                normal = -normal;
+
+            float *texel = &tile.texels[(j * kTileSamples + i) * 4];
+            texel[0] = heights[(j + 1) * kApronSamples + i + 1];
+            tile.minHeight = std::min(tile.minHeight, texel[0]);
+            tile.maxHeight = std::max(tile.maxHeight, texel[0]);
+            texel[1] = (float)normal.x;
+            texel[2] = (float)normal.y;
+            texel[3] = (float)normal.z;
+        }
+    }
+    return tile;
+}